@@ -9,10 +9,6 @@ layout (set=0, binding = 0) uniform samplerCube environmentMap;
 
 const float PI = 3.14159265359;
 
-layout (push_constant) uniform CameraBuffer {
-	mat4 viewProj;
-} cameraData;
-
 void main() {
 	vec3 normal = normalize(localPos);
 
@@ -0,0 +1,19 @@
+#version 460
+#extension GL_KHR_vulkan_glsl: enable
+#extension GL_EXT_multiview : require
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+
+layout (location = 0) out vec3 localPos;
+
+// One view per cubemap face, the render pass broadcasts each view to the layer of the same index
+layout (set = 0, binding = 1) uniform CubeViewBuffer {
+	mat4 viewProjections[6];
+} cubeViewData;
+
+void main() {
+    localPos = position;
+    gl_Position = cubeViewData.viewProjections[gl_ViewIndex] * vec4(localPos, 1.0);
+}
@@ -0,0 +1,17 @@
+// Direction through the center of a texel of a cube face, the face is the z of the dispatch and
+// follows the Vulkan face order (+X, -X, +Y, -Y, +Z, -Z) and orientation
+vec3 cubemapDirection(uvec3 texel, vec2 faceSize) {
+    vec2 uv = (vec2(texel.xy) + 0.5) / faceSize * 2.0 - 1.0;
+
+    vec3 direction;
+    switch (texel.z) {
+    case 0: direction = vec3(1.0, -uv.y, -uv.x); break;
+    case 1: direction = vec3(-1.0, -uv.y, uv.x); break;
+    case 2: direction = vec3(uv.x, 1.0, uv.y); break;
+    case 3: direction = vec3(uv.x, -1.0, -uv.y); break;
+    case 4: direction = vec3(uv.x, -uv.y, 1.0); break;
+    default: direction = vec3(-uv.x, -uv.y, -1.0); break;
+    }
+
+    return normalize(direction);
+}
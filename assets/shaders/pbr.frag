@@ -14,6 +14,10 @@ layout (push_constant) uniform constants {
 layout (set=0, binding=1) uniform samplerCube irradianceMap;
 layout (set=0, binding=2) uniform samplerCube prefilterMap;
 layout (set=0, binding=3) uniform sampler2D brdfLUT;
+layout (set=0, binding=4) uniform SHIrradianceBuffer {
+    vec4 coefficients[9]; // L2 SH of irradiance / PI, rgb
+    int enabled;
+} shIrradiance;
 
 layout (set=2, binding=0) uniform sampler2D albedoTex;
 layout (set=2, binding=1) uniform sampler2D materialTex;
@@ -61,6 +65,20 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
     return ggx1 * ggx2;
 }
 
+// Same value the irradiance map stores, evaluated from the SH coefficients
+vec3 irradianceSH(vec3 n) {
+    vec3 result = shIrradiance.coefficients[0].rgb * 0.282095;
+    result += shIrradiance.coefficients[1].rgb * 0.488603 * n.y;
+    result += shIrradiance.coefficients[2].rgb * 0.488603 * n.z;
+    result += shIrradiance.coefficients[3].rgb * 0.488603 * n.x;
+    result += shIrradiance.coefficients[4].rgb * 1.092548 * n.x * n.y;
+    result += shIrradiance.coefficients[5].rgb * 1.092548 * n.y * n.z;
+    result += shIrradiance.coefficients[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0);
+    result += shIrradiance.coefficients[7].rgb * 1.092548 * n.x * n.z;
+    result += shIrradiance.coefficients[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0));
+}
+
 vec3 uncharted2_tonemap_partial(vec3 x)
 {
     float A = 0.15f;
@@ -102,8 +120,10 @@ void main() {
     vec3 f0 = vec3(0.04f);
     f0 = mix(f0, albedo, metallic);
 
-    vec3 n = texture(normalTex, uv).rgb;
-    n = n * 2.0 - 1.0;
+    // BC5 only keeps x and y
+    vec3 n;
+    n.xy = texture(normalTex, uv).rg * 2.0 - 1.0;
+    n.z = sqrt(max(1.0 - dot(n.xy, n.xy), 0.0));
     n = normalize(tbn * n);
 
     vec3 v = normalize(PushConstants.camPos.xyz - worldPosition);
@@ -141,7 +161,7 @@ void main() {
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
 
-    vec3 irradiance = texture(irradianceMap, n).rgb;
+    vec3 irradiance = (shIrradiance.enabled != 0) ? irradianceSH(n) : texture(irradianceMap, n).rgb;
     vec3 diffuse      = irradiance * albedo;
 
     const float MAX_REFLECTION_LOD = 4.0;
@@ -16,8 +16,12 @@ layout (set=0, binding=0) uniform CameraBuffer {
 	mat4 viewProj;
 } cameraData;
 
+// Same layout as CullObject, cull.comp reads the bounds from the same buffer
 struct ObjectData{
 	mat4 model;
+	vec4 boundingSphere;
+	uint meshIndex;
+	uint materialIndex;
 };
 
 layout(std140, set = 1, binding = 0) readonly buffer ObjectBuffer{
@@ -29,11 +33,15 @@ layout (push_constant) uniform constants {
 } PushConstants;
 
 void main() {
+	// Includes the first instance of the draw, so instanced batches and single culled draws both
+	// find their object
+	mat4 model = objectBuffer.objects[gl_InstanceIndex].model;
+
     outUV = uv;
-	outWorldPosition = vec3(objectBuffer.objects[gl_BaseInstance].model * vec4(position, 1.0f));
+	outWorldPosition = vec3(model * vec4(position, 1.0f));
 
-	vec3 t = normalize(vec3(objectBuffer.objects[gl_BaseInstance].model * vec4(tangent, 0.0f)));
-	vec3 n = normalize(vec3(objectBuffer.objects[gl_BaseInstance].model * vec4(normal, 0.0f)));
+	vec3 t = normalize(vec3(model * vec4(tangent, 0.0f)));
+	vec3 n = normalize(vec3(model * vec4(normal, 0.0f)));
 	t = normalize(t - dot(t, n) * n);
 	vec3 b = cross(n, t) * -1;
 	tbn = mat3(t, b, n);
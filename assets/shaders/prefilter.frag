@@ -9,10 +9,9 @@ layout (set=0, binding = 0) uniform samplerCube environmentMap;
 
 const float PI = 3.14159265359;
 
-layout (push_constant) uniform CameraBuffer {
-	mat4 viewProj;
+layout (push_constant) uniform PrefilterBuffer {
 	float roughness;
-} cameraData;
+} prefilterData;
 
 float RadicalInverse_VdC(uint bits) {
     bits = (bits << 16u) | (bits >> 16u);
@@ -60,7 +59,7 @@ void main()
     for(uint i = 0u; i < SAMPLE_COUNT; ++i)
     {
         vec2 Xi = Hammersley(i, SAMPLE_COUNT);
-        vec3 H  = ImportanceSampleGGX(Xi, N, cameraData.roughness);
+        vec3 H  = ImportanceSampleGGX(Xi, N, prefilterData.roughness);
         vec3 L  = normalize(2.0 * dot(V, H) * H - V);
 
         float NdotL = max(dot(N, L), 0.0);
@@ -0,0 +1,103 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/CommandList.hpp"
+#include "../src/renderer/GraphicsContext.hpp"
+#include "../src/Structures/Mesh/vertex.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+constexpr uint32_t DRAW_COUNT = 100000;
+
+// Consecutive draws share a material, as they do once sorted by a DrawQueue
+constexpr uint32_t MATERIAL_COUNT   = 64;
+constexpr uint32_t DRAWS_A_MATERIAL = 16;
+
+constexpr int RUNS = 20;
+
+// Records DRAW_COUNT draws that each bind the pipeline, the camera and material sets and the
+// vertex buffer. First through the shared_ptr calls of GraphicsContext, which bind everything,
+// then through a CommandList, which drops the binds of what is already bound. Only recording is
+// timed, nothing is submitted. Run from the repository root, it needs a window and a device
+int main() {
+    Logger::init();
+
+    auto window          = Window::create("Command list benchmark", 1280, 720);
+    auto graphicsContext = GraphicsContext::create(window);
+
+    PipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.vertexShaderPath   = "assets/shaders/cubemap.vert";
+    pipelineCreateInfo.fragmentShaderPath = "assets/shaders/cubemap.frag";
+    pipelineCreateInfo.viewportWidth      = window->getWidth();
+    pipelineCreateInfo.viewportHeight     = window->getHeight();
+    pipelineCreateInfo.culling            = false;
+    pipelineCreateInfo.depthTesting       = true;
+    pipelineCreateInfo.depthWrite         = true;
+    auto pipeline       = graphicsContext->createPipeline(&pipelineCreateInfo);
+    auto pipelineHandle = graphicsContext->registerPipeline(pipeline);
+
+    auto cameraSet = graphicsContext->createDescriptorSet(pipeline, 0);
+    graphicsContext->descriptorSetAddBuffer(cameraSet, 0, DescriptorType::UNIFORM_BUFFER,
+                                            3 * sizeof(glm::mat4));
+    auto cameraSetHandle = graphicsContext->registerDescriptorSet(cameraSet);
+
+    auto cubemap = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 16, 16);
+    std::vector<std::shared_ptr<DescriptorSet>> materialSets;
+    std::vector<DescriptorSetHandle> materialSetHandles;
+    for (uint32_t material = 0; material < MATERIAL_COUNT; material++) {
+        auto materialSet = graphicsContext->createDescriptorSet(pipeline, 1);
+        graphicsContext->descriptorSetAddImage(materialSet, 0, cubemap);
+        materialSets.push_back(materialSet);
+        materialSetHandles.push_back(graphicsContext->registerDescriptorSet(materialSet));
+    }
+
+    std::array<Vertex, 3> vertices = {};
+    auto vertexBuffer              = graphicsContext->createVertexBuffer(
+        vertices.data(), uint32_t(vertices.size() * sizeof(Vertex)));
+    auto vertexBufferHandle = graphicsContext->registerVertexBuffer(vertexBuffer);
+
+    auto commandBuffer = graphicsContext->createFrameBasedCommandBuffer();
+    glm::vec4 clearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    double sharedPtrMilliseconds = bestMilliseconds(RUNS, [&]() {
+        graphicsContext->beginRecording(commandBuffer);
+        graphicsContext->beginSwapchainRenderPass(commandBuffer, 0, clearColor);
+        for (uint32_t draw = 0; draw < DRAW_COUNT; draw++) {
+            graphicsContext->bindPipeline(commandBuffer, pipeline);
+            graphicsContext->bindDescriptorSet(commandBuffer, 0, cameraSet);
+            graphicsContext->bindDescriptorSet(
+                commandBuffer, 1, materialSets[(draw / DRAWS_A_MATERIAL) % MATERIAL_COUNT]);
+            graphicsContext->bindVertexBuffer(commandBuffer, vertexBuffer);
+            graphicsContext->draw(commandBuffer, (uint32_t)vertices.size(), 1, 0, draw);
+        }
+        graphicsContext->endRenderPass(commandBuffer);
+        graphicsContext->endRecording(commandBuffer);
+    });
+
+    uint32_t skippedBindCount      = 0;
+    double commandListMilliseconds = bestMilliseconds(RUNS, [&]() {
+        graphicsContext->beginRecording(commandBuffer);
+        graphicsContext->beginSwapchainRenderPass(commandBuffer, 0, clearColor);
+        CommandList commandList = graphicsContext->commandList(commandBuffer);
+        for (uint32_t draw = 0; draw < DRAW_COUNT; draw++) {
+            commandList.bindPipeline(pipelineHandle);
+            commandList.bindDescriptorSet(0, cameraSetHandle);
+            commandList.bindDescriptorSet(
+                1, materialSetHandles[(draw / DRAWS_A_MATERIAL) % MATERIAL_COUNT]);
+            commandList.bindVertexBuffer(vertexBufferHandle);
+            commandList.draw((uint32_t)vertices.size(), 1, 0, draw);
+        }
+        skippedBindCount = commandList.getSkippedBindCount();
+        graphicsContext->endRenderPass(commandBuffer);
+        graphicsContext->endRecording(commandBuffer);
+    });
+
+    uint32_t bindCount = 4 * DRAW_COUNT;
+    std::printf("%u draws with shared_ptrs: %.3f ms, %.1f ns a draw, %u binds\n", DRAW_COUNT,
+                sharedPtrMilliseconds, sharedPtrMilliseconds * 1.0e6 / DRAW_COUNT, bindCount);
+    std::printf("%u draws with a CommandList: %.3f ms, %.1f ns a draw, %u binds, %.2fx faster\n",
+                DRAW_COUNT, commandListMilliseconds, commandListMilliseconds * 1.0e6 / DRAW_COUNT,
+                bindCount - skippedBindCount, sharedPtrMilliseconds / commandListMilliseconds);
+
+    return 0;
+}
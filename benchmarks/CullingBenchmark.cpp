@@ -0,0 +1,101 @@
+#include "../src/pch.hpp"
+
+#include "../src/Jobs/JobSystem.hpp"
+#include "../src/renderer/CPUCuller.hpp"
+#include "../src/renderer/Helper/Culling.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+constexpr int RUNS = 20;
+
+const char* cullInstructionsAsString(CullInstructions instructions) {
+    switch (instructions) {
+    case CullInstructions::SCALAR:
+        return "scalar";
+    case CullInstructions::SSE:
+        return "SSE";
+    case CullInstructions::AVX2:
+        return "AVX2";
+    default:
+        return "unknown";
+    }
+}
+
+// Scattered around the camera, about a fifth of them end up in the frustum
+std::vector<CullObject> randomObjects(uint32_t objectCount) {
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 2.0f);
+
+    std::vector<CullObject> objects(objectCount);
+    for (CullObject& object : objects) {
+        object.model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random),
+                                                                 position(random) * 0.1f,
+                                                                 position(random)));
+        object.boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, radius(random));
+    }
+
+    return objects;
+}
+
+// Tests 100k and 1M spheres on one thread with each instruction set the CPU has, then culls the
+// objects with CPUCuller, which also gathers their spheres, over the whole job system. Nothing
+// else is needed, it runs without a window or a device
+int main() {
+    Logger::init();
+
+    JobSystem jobSystem;
+    CPUCuller culler(&jobSystem);
+
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    glm::mat4 view       = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f),
+                                       glm::vec3(0.0f, 1.0f, 0.0f));
+    std::array<glm::vec4, 6> planes = helper::frustumPlanes(projection * view);
+
+    for (uint32_t objectCount : { 100000u, 1000000u }) {
+        std::vector<CullObject> objects = randomObjects(objectCount);
+
+        CullSpheres spheres;
+        spheres.centerX.resize(objectCount);
+        spheres.centerY.resize(objectCount);
+        spheres.centerZ.resize(objectCount);
+        spheres.radius.resize(objectCount);
+        helper::worldSpheres(objects, 0, objectCount, spheres);
+
+        std::vector<uint32_t> visibleIndices;
+        visibleIndices.reserve(objectCount);
+
+        double scalarMilliseconds = 0.0;
+        for (CullInstructions instructions :
+             { CullInstructions::SCALAR, CullInstructions::SSE, CullInstructions::AVX2 }) {
+            if (instructions > helper::supportedCullInstructions()) {
+                continue;
+            }
+
+            double milliseconds = bestMilliseconds(RUNS, [&]() {
+                visibleIndices.clear();
+                helper::cullSpheres(spheres, planes, 0, objectCount, visibleIndices,
+                                    instructions);
+            });
+            if (instructions == CullInstructions::SCALAR) {
+                scalarMilliseconds = milliseconds;
+            }
+
+            std::printf("%u spheres %-6s: %.3f ms, %.2f ns a sphere, %.2fx scalar, %zu visible\n",
+                        objectCount, cullInstructionsAsString(instructions), milliseconds,
+                        milliseconds * 1.0e6 / objectCount, scalarMilliseconds / milliseconds,
+                        visibleIndices.size());
+        }
+
+        glm::mat4 viewProjection  = projection * view;
+        size_t culledVisible      = 0;
+        double cullerMilliseconds = bestMilliseconds(
+            RUNS, [&]() { culledVisible = culler.cull(objects, viewProjection).size(); });
+        std::printf("%u objects CPUCuller on %u threads: %.3f ms, %.2f ns an object, %zu visible\n",
+                    objectCount, jobSystem.getThreadCount(), cullerMilliseconds,
+                    cullerMilliseconds * 1.0e6 / objectCount, culledVisible);
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "../src/pch.hpp"
+
+#include "../src/Jobs/JobSystem.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+// Items of the parallelFor, each a few hundred nanoseconds of arithmetic
+constexpr uint32_t ITEM_COUNT = 1 << 20;
+constexpr uint32_t RANGE_SIZE = 1024;
+
+// Empty jobs, to time the scheduling itself
+constexpr uint32_t JOB_COUNT = 100000;
+
+constexpr int RUNS = 10;
+
+float work(uint32_t item) {
+    float value = (float)item;
+    for (int i = 0; i < 64; i++) {
+        value = value * 0.999f + std::sqrt(value + 1.0f);
+    }
+
+    return value;
+}
+
+// Times a parallelFor over ITEM_COUNT items and JOB_COUNT empty jobs with the main thread alone,
+// then with more and more workers. Nothing else is needed, it runs without a window or a device
+int main() {
+    Logger::init();
+
+    std::vector<float> results(ITEM_COUNT);
+
+    uint32_t maxThreadCount   = std::max(std::thread::hardware_concurrency(), 2u);
+    double singleMilliseconds = 0.0;
+    for (uint32_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+        JobSystem jobSystem(threadCount - 1);
+
+        double parallelForMilliseconds = bestMilliseconds(RUNS, [&]() {
+            jobSystem.parallelFor(ITEM_COUNT, RANGE_SIZE, [&](uint32_t first, uint32_t count) {
+                for (uint32_t item = first; item < first + count; item++) {
+                    results[item] = work(item);
+                }
+            });
+        });
+        if (threadCount == 1) {
+            singleMilliseconds = parallelForMilliseconds;
+        }
+
+        double checksum = 0.0;
+        for (float result : results) {
+            checksum += result;
+        }
+
+        double jobMilliseconds = bestMilliseconds(RUNS, [&]() {
+            JobCounter counter;
+            for (uint32_t job = 0; job < JOB_COUNT; job++) {
+                jobSystem.run([]() {}, &counter);
+            }
+            jobSystem.wait(counter);
+        });
+
+        std::printf("%u threads: parallelFor %.3f ms, %.2fx one thread, checksum %.6e, %u empty "
+                    "jobs %.3f ms, %.1f ns a job\n",
+                    threadCount, parallelForMilliseconds,
+                    singleMilliseconds / parallelForMilliseconds, checksum, JOB_COUNT,
+                    jobMilliseconds, jobMilliseconds * 1.0e6 / JOB_COUNT);
+
+        if (threadCount == maxThreadCount) {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "../src/pch.hpp"
+
+#include "../src/Jobs/JobSystem.hpp"
+#include "../src/Scene/Scene.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+constexpr uint32_t ENTITY_COUNT = 100000;
+
+// Each root is a tree of a few hundred entities, like a building with its furniture
+constexpr uint32_t ROOT_COUNT = 256;
+
+// Every fourth entity is renderable, the rest only group their children
+constexpr uint32_t RENDERABLE_EVERY = 4;
+
+constexpr int RUNS = 20;
+
+// Builds a 100k entity hierarchy and times propagateTransforms with everything, the roots, a
+// scattering of single entities and nothing moved. Nothing else is needed, it runs without a
+// window or a device
+int main() {
+    Logger::init();
+
+    JobSystem jobSystem;
+    Scene scene(&jobSystem);
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+    auto randomTransform = [&]() {
+        TransformComponent transform = {};
+        transform.position = glm::vec3(position(random), position(random), position(random));
+        transform.rotation = glm::angleAxis(angle(random), glm::vec3(0.0f, 1.0f, 0.0f));
+        return transform;
+    };
+
+    // Each entity after the roots hangs below a random earlier one of the same tree
+    std::vector<entt::entity> entities;
+    entities.reserve(ENTITY_COUNT);
+    for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+        entt::entity parent = entt::null;
+        if (i >= ROOT_COUNT) {
+            uint32_t treeSize = i / ROOT_COUNT;
+            uint32_t ancestor = std::uniform_int_distribution<uint32_t>(0, treeSize - 1)(random);
+            parent            = entities[ancestor * ROOT_COUNT + i % ROOT_COUNT];
+        }
+
+        entt::entity entity = scene.createEntity(randomTransform(), parent);
+        if (i % RENDERABLE_EVERY == 0) {
+            scene.addRenderable(entity, 0, 0, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        }
+        entities.push_back(entity);
+    }
+    scene.propagateTransforms();
+
+    std::vector<entt::entity> scattered;
+    for (int i = 0; i < 1000; i++) {
+        scattered.push_back(
+            entities[std::uniform_int_distribution<uint32_t>(0, ENTITY_COUNT - 1)(random)]);
+    }
+
+    struct Case {
+        const char* name;
+        std::function<void()> move;
+    };
+    std::vector<Case> cases = {
+        { "everything", [&]() {
+             for (entt::entity entity : entities) {
+                 scene.setTransform(entity, scene.getTransform(entity));
+             }
+         } },
+        { "roots", [&]() {
+             for (uint32_t i = 0; i < ROOT_COUNT; i++) {
+                 scene.setTransform(entities[i], scene.getTransform(entities[i]));
+             }
+         } },
+        { "1000 scattered", [&]() {
+             for (entt::entity entity : scattered) {
+                 scene.setTransform(entity, scene.getTransform(entity));
+             }
+         } },
+        { "nothing", []() {} },
+    };
+
+    std::printf("%u entities under %u roots, %zu renderable, %u threads\n", ENTITY_COUNT,
+                ROOT_COUNT, scene.getObjects().size(), jobSystem.getThreadCount());
+    for (const Case& benchmarkCase : cases) {
+        // Only the propagation is timed, marking the entities dirty happens before
+        double milliseconds = 1e30;
+        uint32_t updatedCount = 0;
+        for (int run = 0; run < RUNS; run++) {
+            benchmarkCase.move();
+            milliseconds = std::min(milliseconds, bestMilliseconds(1, [&]() {
+                scene.propagateTransforms();
+            }));
+            updatedCount = scene.getTransformStats().updatedCount;
+        }
+
+        std::printf("  %-16s %8.3f ms, %6u updated, %6.2f ns an update\n", benchmarkCase.name,
+                    milliseconds, updatedCount,
+                    updatedCount > 0 ? milliseconds * 1.0e6 / updatedCount : 0.0);
+    }
+
+    return 0;
+}
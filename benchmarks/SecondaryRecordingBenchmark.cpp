@@ -0,0 +1,123 @@
+#include "../src/pch.hpp"
+
+#include "../src/Jobs/JobSystem.hpp"
+#include "../src/renderer/CommandList.hpp"
+#include "../src/renderer/DrawQueue.hpp"
+#include "../src/renderer/GraphicsContext.hpp"
+#include "../src/Structures/Mesh/vertex.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+// Draws recorded into the swapchain pass, each is its own packet
+constexpr uint32_t DRAW_COUNT = 50000;
+
+// Material sets the draws cycle through, so not every bind is filtered away
+constexpr uint32_t MATERIAL_COUNT = 64;
+
+constexpr int RUNS = 20;
+
+// Of the offscreen images the swapchain pass renders to
+constexpr uint32_t WIDTH  = 1280;
+constexpr uint32_t HEIGHT = 720;
+
+// Records DRAW_COUNT draws into the swapchain pass inline on the main thread, then split into
+// secondary command buffers over more and more threads of the job system. Only recording is
+// timed, nothing is submitted. Run from the repository root, it needs a device but no window
+int main() {
+    Logger::init();
+
+    JobSystem jobSystem;
+
+    auto graphicsContext = GraphicsContext::createHeadless(WIDTH, HEIGHT);
+    graphicsContext->useJobSystem(&jobSystem);
+
+    PipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.vertexShaderPath   = "assets/shaders/cubemap.vert";
+    pipelineCreateInfo.fragmentShaderPath = "assets/shaders/cubemap.frag";
+    pipelineCreateInfo.viewportWidth      = WIDTH;
+    pipelineCreateInfo.viewportHeight     = HEIGHT;
+    pipelineCreateInfo.culling            = false;
+    pipelineCreateInfo.depthTesting       = true;
+    pipelineCreateInfo.depthWrite         = true;
+    auto pipeline       = graphicsContext->createPipeline(&pipelineCreateInfo);
+    auto pipelineHandle = graphicsContext->registerPipeline(pipeline);
+
+    auto cameraSet = graphicsContext->createDescriptorSet(pipeline, 0);
+    graphicsContext->descriptorSetAddBuffer(cameraSet, 0, DescriptorType::UNIFORM_BUFFER,
+                                            3 * sizeof(glm::mat4));
+    auto cameraSetHandle = graphicsContext->registerDescriptorSet(cameraSet);
+
+    auto cubemap = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 16, 16);
+    std::vector<DescriptorSetHandle> materialSetHandles;
+    for (uint32_t material = 0; material < MATERIAL_COUNT; material++) {
+        auto materialSet = graphicsContext->createDescriptorSet(pipeline, 1);
+        graphicsContext->descriptorSetAddImage(materialSet, 0, cubemap);
+        materialSetHandles.push_back(graphicsContext->registerDescriptorSet(materialSet));
+    }
+
+    std::array<Vertex, 3> vertices = {};
+    auto vertexBuffer              = graphicsContext->createVertexBuffer(
+        vertices.data(), uint32_t(vertices.size() * sizeof(Vertex)));
+    auto vertexBufferHandle = graphicsContext->registerVertexBuffer(vertexBuffer);
+
+    DrawQueue drawQueue;
+    for (uint32_t draw = 0; draw < DRAW_COUNT; draw++) {
+        DrawPacket packet       = {};
+        packet.pipeline         = pipelineHandle;
+        packet.materialSet      = materialSetHandles[draw % MATERIAL_COUNT];
+        packet.materialSetIndex = 1;
+        packet.vertexBuffer     = vertexBufferHandle;
+        packet.vertexCount      = (uint32_t)vertices.size();
+        packet.instanceCount    = 1;
+        packet.firstInstance    = draw;
+        drawQueue.push(0, 0, (float)draw / DRAW_COUNT, packet);
+    }
+    drawQueue.sort();
+
+    auto bindCamera = [&](CommandList& commandList) {
+        commandList.bindDescriptorSet(0, cameraSetHandle);
+    };
+
+    auto commandBuffer = graphicsContext->createFrameBasedCommandBuffer();
+    glm::vec4 clearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    double inlineMilliseconds = bestMilliseconds(RUNS, [&]() {
+        graphicsContext->beginRecording(commandBuffer);
+        graphicsContext->beginSwapchainRenderPass(commandBuffer, 0, clearColor);
+        CommandList commandList = graphicsContext->commandList(commandBuffer);
+        drawQueue.record(commandList, [&](PipelineHandle) { bindCamera(commandList); });
+        graphicsContext->endRenderPass(commandBuffer);
+        graphicsContext->endRecording(commandBuffer);
+    });
+    std::printf("%u draws inline: %.3f ms\n", DRAW_COUNT, inlineMilliseconds);
+
+    uint32_t maxThreadCount = jobSystem.getThreadCount();
+    for (uint32_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+        auto secondaryBuffers =
+            graphicsContext->createFrameBasedSecondaryCommandBuffers(threadCount);
+
+        double secondaryMilliseconds = bestMilliseconds(RUNS, [&]() {
+            graphicsContext->beginRecording(commandBuffer);
+            graphicsContext->beginSwapchainRenderPass(commandBuffer, 0, clearColor, true);
+            graphicsContext->recordSwapchainSecondary(
+                secondaryBuffers, 0, drawQueue.getPacketCount(),
+                [&](std::shared_ptr<CommandBuffer> secondary, uint32_t first, uint32_t count) {
+                    CommandList commandList = graphicsContext->commandList(secondary);
+                    drawQueue.record(commandList, first, count,
+                                     [&](PipelineHandle) { bindCamera(commandList); });
+                });
+            graphicsContext->executeSecondary(commandBuffer, secondaryBuffers);
+            graphicsContext->endRenderPass(commandBuffer);
+            graphicsContext->endRecording(commandBuffer);
+        });
+        std::printf("%u draws on %u threads: %.3f ms, %.2fx inline\n", DRAW_COUNT, threadCount,
+                    secondaryMilliseconds, inlineMilliseconds / secondaryMilliseconds);
+
+        if (threadCount == maxThreadCount) {
+            break;
+        }
+    }
+
+    return 0;
+}
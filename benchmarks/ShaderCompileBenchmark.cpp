@@ -0,0 +1,60 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/ShaderCompiler.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+constexpr const char* SHADER_DIRECTORY = "assets/shaders";
+
+constexpr int RUNS = 5;
+
+// Compiles every shader in assets/shaders at each optimization level and prints the compile time
+// and the size of the SPIR-V. Only shaderc is needed, it runs without a window or a device
+int main() {
+    Logger::init();
+
+    std::vector<std::string> shaderPaths;
+    for (auto& entry : std::filesystem::directory_iterator(SHADER_DIRECTORY)) {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".vert" || extension == ".frag" || extension == ".comp") {
+            shaderPaths.push_back(helper::normalizeShaderPath(entry.path().string()));
+        }
+    }
+    std::sort(shaderPaths.begin(), shaderPaths.end());
+
+    for (ShaderOptimization optimization :
+         { ShaderOptimization::ZERO, ShaderOptimization::SIZE, ShaderOptimization::PERFORMANCE }) {
+        ShaderCompileOptions compileOptions = {};
+        compileOptions.optimization         = optimization;
+
+        double totalMilliseconds   = 0.0;
+        uint64_t totalInstructions = 0;
+        uint64_t totalBytes        = 0;
+        std::printf("Optimization %s\n", helper::shaderOptimizationAsString(optimization));
+        for (auto& shaderPath : shaderPaths) {
+            std::vector<uint32_t> spvBytes;
+            double milliseconds = bestMilliseconds(RUNS, [&]() {
+                spvBytes = helper::compileShaderFile(shaderPath.c_str(), compileOptions);
+            });
+            if (spvBytes.empty()) {
+                std::printf("  %-32s failed to compile\n", shaderPath.c_str());
+                continue;
+            }
+
+            uint32_t instructions = helper::countSpvInstructions(spvBytes);
+            uint64_t bytes        = spvBytes.size() * sizeof(uint32_t);
+            std::printf("  %-32s %8.3f ms, %6u instructions, %7llu bytes\n", shaderPath.c_str(),
+                        milliseconds, instructions, (unsigned long long)bytes);
+
+            totalMilliseconds += milliseconds;
+            totalInstructions += instructions;
+            totalBytes += bytes;
+        }
+        std::printf("  %-32s %8.3f ms, %6llu instructions, %7llu bytes\n", "total",
+                    totalMilliseconds, (unsigned long long)totalInstructions,
+                    (unsigned long long)totalBytes);
+    }
+
+    return 0;
+}
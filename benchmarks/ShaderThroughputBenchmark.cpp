@@ -0,0 +1,161 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/GraphicsContext.hpp"
+#include "../src/renderer/Helper/Culling.hpp"
+#include "../src/renderer/Helper/ShaderCompiler.hpp"
+#include "../src/Structures/Mesh/mesh_vertex.hpp"
+#include "../src/Logger.hpp"
+
+#include "Benchmark.hpp"
+
+// Of the offscreen images the swapchain pass renders to
+constexpr uint32_t WIDTH  = 1920;
+constexpr uint32_t HEIGHT = 1080;
+
+// Full screen quads drawn over each other without depth testing, so each one shades every pixel
+constexpr uint32_t LAYERS = 16;
+
+constexpr int RUNS = 10;
+
+struct CameraData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+};
+
+struct SHIrradianceData {
+    glm::vec4 coefficients[9];
+    int enabled;
+};
+
+// Compiles pbr.vert and pbr.frag at each optimization level and times frames of LAYERS full screen
+// quads shaded by them, submitted and waited on. The vertex work is six vertices a layer, so the
+// time is that of the fragment shader. Run from the repository root, it needs a device but no
+// window. A software device like lavapipe works too
+int main() {
+    Logger::init();
+
+    auto graphicsContext = GraphicsContext::createHeadless(WIDTH, HEIGHT);
+
+    auto renderFence      = graphicsContext->createFrameBasedFence(false);
+    auto renderSemaphore  = graphicsContext->createFrameBasedSemaphore();
+    auto presentSemaphore = graphicsContext->createFrameBasedSemaphore();
+    auto commandBuffer    = graphicsContext->createFrameBasedCommandBuffer();
+
+    // The lighting textures are left black, what they hold doesn't change the work done
+    auto irradianceMap = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 32, 32);
+    auto prefilterMap  = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 128, 128, true);
+    auto brdfLUT       = graphicsContext->createStorageTexture(Format::RG16_FLOAT, 512, 512);
+
+    std::vector<unsigned char> white(64 * 64 * 4, 255);
+    auto materialTexture =
+        graphicsContext->createTexture(64, 64, 4, ColorSpace::LINEAR, white.data());
+
+    // Clip space, the camera and model matrices are identities
+    std::array<MeshVertex, 6> vertices = {};
+    glm::vec2 corners[]                = { { -1, -1 }, { 1, -1 }, { 1, 1 },
+                                           { -1, -1 }, { 1, 1 },  { -1, 1 } };
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i].position = glm::vec3(corners[i], 0.5f);
+        vertices[i].normal   = glm::vec3(0.0f, 0.0f, -1.0f);
+        vertices[i].tangent  = glm::vec3(1.0f, 0.0f, 0.0f);
+        vertices[i].uv       = corners[i] * 0.5f + 0.5f;
+    }
+    auto vertexBuffer = graphicsContext->createVertexBuffer(
+        vertices.data(), uint32_t(vertices.size() * sizeof(MeshVertex)));
+
+    glm::vec4 cameraPosition(0.0f, 0.0f, -1.0f, 1.0f);
+    glm::vec4 clearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    std::printf("%u layers of %ux%u pixels of pbr.frag\n", LAYERS, WIDTH, HEIGHT);
+    for (ShaderOptimization optimization :
+         { ShaderOptimization::ZERO, ShaderOptimization::SIZE, ShaderOptimization::PERFORMANCE }) {
+        ShaderCompileOptions compileOptions = {};
+        compileOptions.optimization         = optimization;
+        graphicsContext->setShaderCompileOptions(compileOptions);
+
+        PipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.vertexShaderPath   = "assets/shaders/pbr.vert";
+        pipelineCreateInfo.fragmentShaderPath = "assets/shaders/pbr.frag";
+        pipelineCreateInfo.viewportWidth      = WIDTH;
+        pipelineCreateInfo.viewportHeight     = HEIGHT;
+        pipelineCreateInfo.culling            = false;
+        pipelineCreateInfo.depthTesting       = false;
+        pipelineCreateInfo.depthWrite         = false;
+        auto pipeline = graphicsContext->createPipeline(&pipelineCreateInfo);
+
+        auto cameraSet = graphicsContext->createDescriptorSet(pipeline, 0);
+        graphicsContext->descriptorSetAddBuffer(cameraSet, 0, DescriptorType::UNIFORM_BUFFER,
+                                                sizeof(CameraData));
+        graphicsContext->descriptorSetAddImage(cameraSet, 1, irradianceMap);
+        graphicsContext->descriptorSetAddImage(cameraSet, 2, prefilterMap);
+        graphicsContext->descriptorSetAddImage(cameraSet, 3, brdfLUT);
+        graphicsContext->descriptorSetAddBuffer(cameraSet, 4, DescriptorType::UNIFORM_BUFFER,
+                                                sizeof(SHIrradianceData));
+
+        auto objectSet = graphicsContext->createDescriptorSet(pipeline, 1);
+        graphicsContext->descriptorSetAddBuffer(objectSet, 0, DescriptorType::STORAGE_BUFFER,
+                                                sizeof(CullObject) * LAYERS);
+
+        auto materialSet = graphicsContext->createDescriptorSet(pipeline, 2);
+        for (uint32_t binding = 0; binding < 3; binding++) {
+            graphicsContext->descriptorSetAddImage(materialSet, binding, materialTexture);
+        }
+
+        auto renderFrame = [&]() {
+            uint32_t frameIndex = graphicsContext->newFrame(presentSemaphore);
+
+            CameraData cameraData = { glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f) };
+            memcpy(graphicsContext->mapDescriptorBuffer(cameraSet, 0), &cameraData,
+                   sizeof(CameraData));
+            graphicsContext->unmapDescriptorBuffer(cameraSet, 0);
+
+            // The irradiance map path, the heavier of the two
+            SHIrradianceData shData = {};
+            memcpy(graphicsContext->mapDescriptorBuffer(cameraSet, 4), &shData,
+                   sizeof(SHIrradianceData));
+            graphicsContext->unmapDescriptorBuffer(cameraSet, 4);
+
+            CullObject* objects = reinterpret_cast<CullObject*>(
+                graphicsContext->mapDescriptorBuffer(objectSet, 0));
+            for (uint32_t layer = 0; layer < LAYERS; layer++) {
+                objects[layer]       = {};
+                objects[layer].model = glm::mat4(1.0f);
+            }
+            graphicsContext->unmapDescriptorBuffer(objectSet, 0);
+
+            graphicsContext->beginRecording(commandBuffer);
+            graphicsContext->beginSwapchainRenderPass(commandBuffer, frameIndex, clearColor);
+            graphicsContext->bindPipeline(commandBuffer, pipeline);
+            graphicsContext->bindDescriptorSet(commandBuffer, 0, cameraSet);
+            graphicsContext->bindDescriptorSet(commandBuffer, 1, objectSet);
+            graphicsContext->bindDescriptorSet(commandBuffer, 2, materialSet);
+            graphicsContext->pushConstants(commandBuffer, pipeline, 0, sizeof(glm::vec4),
+                                           &cameraPosition);
+            graphicsContext->bindVertexBuffer(commandBuffer, vertexBuffer);
+            graphicsContext->draw(commandBuffer, (uint32_t)vertices.size(), LAYERS, 0, 0);
+            graphicsContext->endRenderPass(commandBuffer);
+            graphicsContext->endRecording(commandBuffer);
+
+            graphicsContext->submit(commandBuffer, presentSemaphore, renderSemaphore,
+                                    renderFence);
+            graphicsContext->present(frameIndex, renderSemaphore);
+
+            // present moved on to the next frame, the fence is the one of the frame just drawn
+            graphicsContext->waitOnFence(renderFence, -1);
+        };
+
+        // The first frames also pay for creating the pipeline on the device
+        renderFrame();
+        double milliseconds = bestMilliseconds(RUNS, renderFrame);
+
+        double fragments = double(WIDTH) * HEIGHT * LAYERS;
+        std::printf("  %-12s %8.3f ms, %6.3f ns a fragment\n",
+                    helper::shaderOptimizationAsString(optimization), milliseconds,
+                    milliseconds * 1e6 / fragments);
+    }
+
+    graphicsContext->waitIdle();
+
+    return 0;
+}
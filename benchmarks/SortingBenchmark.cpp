@@ -0,0 +1,82 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/Sorting.hpp"
+
+#include "Benchmark.hpp"
+
+#include <numeric>
+
+constexpr int RUNS = 20;
+
+struct KeyValue {
+    uint64_t key;
+    uint32_t value;
+};
+
+// Laid out like the keys of DrawQueue: a pass, 64 pipelines, 1024 materials, 4096 meshes and the
+// whole depth bucket range
+std::vector<uint64_t> drawKeys(size_t count) {
+    std::mt19937_64 random(9);
+
+    std::vector<uint64_t> keys(count);
+    for (uint64_t& key : keys) {
+        key = ((random() % 2) << 60) | ((random() % 64) << 48) | ((random() % 1024) << 32) |
+              ((random() % 4096) << 16) | (random() & 0xffff);
+    }
+
+    return keys;
+}
+
+// Sorts 100k and 1M keys shaped like DrawQueue's with helper::radixSort, and as key value pairs
+// with std::sort and std::stable_sort, from the same unsorted keys every run. Nothing else is
+// needed, it runs without a window or a device
+int main() {
+    for (size_t count : { (size_t)100000, (size_t)1000000 }) {
+        std::vector<uint64_t> unsortedKeys = drawKeys(count);
+
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> values;
+        std::vector<uint64_t> keyScratch;
+        std::vector<uint32_t> valueScratch;
+        double radixMilliseconds = bestMilliseconds(RUNS, [&]() {
+            keys = unsortedKeys;
+            values.resize(count);
+            std::iota(values.begin(), values.end(), 0);
+            helper::radixSort(keys, values, keyScratch, valueScratch);
+        });
+
+        std::vector<KeyValue> pairs;
+        auto byKey     = [](const KeyValue& a, const KeyValue& b) { return a.key < b.key; };
+        auto fillPairs = [&]() {
+            pairs.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                pairs[i] = { unsortedKeys[i], (uint32_t)i };
+            }
+        };
+
+        double sortMilliseconds = bestMilliseconds(RUNS, [&]() {
+            fillPairs();
+            std::sort(pairs.begin(), pairs.end(), byKey);
+        });
+
+        double stableSortMilliseconds = bestMilliseconds(RUNS, [&]() {
+            fillPairs();
+            std::stable_sort(pairs.begin(), pairs.end(), byKey);
+        });
+
+        // The same order as the stable sort
+        bool matches = true;
+        for (size_t i = 0; i < count; i++) {
+            matches = matches && keys[i] == pairs[i].key && values[i] == pairs[i].value;
+        }
+
+        std::printf("%zu keys: radixSort %.3f ms, std::sort %.3f ms (%.2fx), std::stable_sort "
+                    "%.3f ms (%.2fx), %s\n",
+                    count, radixMilliseconds, sortMilliseconds,
+                    sortMilliseconds / radixMilliseconds, stableSortMilliseconds,
+                    stableSortMilliseconds / radixMilliseconds,
+                    matches ? "same order" : "ORDER DIFFERS");
+    }
+
+    return 0;
+}
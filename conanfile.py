@@ -19,6 +19,7 @@ class CompressorRecipe(ConanFile):
         self.requires("shaderc/2024.1")
         self.requires("tinyobjloader/2.0.0-rc10")
         self.requires("tinygltf/2.9.0")
+        self.requires("zstd/1.5.5")
 
     def generate(self):
         imgui = self.dependencies["imgui"]
@@ -0,0 +1,223 @@
+#include "../pch.hpp"
+#include "AssetManager.hpp"
+
+#include <stb_image.h>
+
+#include "TextureStreamer.hpp"
+
+#include "../renderer/Helper/Pixels.hpp"
+#include "../Logger.hpp"
+
+AssetManager::AssetManager(GraphicsContext* graphicsContext, JobSystem* jobSystem)
+    : graphicsContext(graphicsContext), jobSystem(jobSystem), textureCooker(jobSystem),
+      pendingCount(std::make_shared<std::atomic<uint32_t>>(0)), decodeStats(),
+      decodeStarted(false) {
+    greyPlaceholder       = createPlaceholder({ 128, 128, 128, 255 });
+    flatNormalPlaceholder = createPlaceholder({ 128, 128, 255, 255 });
+}
+
+AssetManager::~AssetManager() {
+    Logger::renderer_logger->info("Destroying Asset Manager");
+
+    // Uploads already submitted are left to the graphics context
+    jobSystem->wait(loadCounter);
+}
+
+std::shared_ptr<Asset<Texture>> AssetManager::loadTexture(const std::string& path,
+                                                          ColorSpace colorSpace,
+                                                          TextureContent content) {
+    auto texture = std::make_shared<Asset<Texture>>(
+        (content == TextureContent::NORMAL_MAP) ? flatNormalPlaceholder : greyPlaceholder);
+
+    (*pendingCount)++;
+    {
+        std::lock_guard<std::mutex> lock(decodeStatsMutex);
+        if (!decodeStarted) {
+            decodeStart   = std::chrono::high_resolution_clock::now();
+            decodeStarted = true;
+        }
+    }
+
+    jobSystem->run(
+        [this, texture, path, colorSpace, content]() {
+            auto startTime = std::chrono::high_resolution_clock::now();
+
+            auto cooked = std::make_shared<KTX2Texture>();
+            if (!readCookedTexture(path, *cooked)) {
+                int width, height;
+                std::shared_ptr<unsigned char> data = decodeRGBA(path, width, height);
+                if (!data) {
+                    Logger::renderer_logger->error("Failed to load texture: {0}", path);
+                    (*pendingCount)--;
+                    return;
+                }
+
+                auto cookStartTime = std::chrono::high_resolution_clock::now();
+                CookedTexture cookedTexture =
+                    textureCooker.cook(data.get(), width, height, content, colorSpace);
+                data.reset();
+
+                uint64_t cookedSize = 0;
+                for (const auto& mip : cookedTexture.mips) {
+                    cookedSize += mip.size();
+                }
+                std::chrono::duration<double, std::milli> cookTime =
+                    std::chrono::high_resolution_clock::now() - cookStartTime;
+                Logger::renderer_logger->info(
+                    "Cooked texture {0} to format {1} in {2} ms, PSNR {3:.1f} dB, {4:.2f} MB "
+                    "instead of {5:.2f} MB",
+                    path, (int)cookedTexture.format, cookTime.count(), cookedTexture.psnr,
+                    cookedSize / (1024.0 * 1024.0),
+                    cookedTexture.uncompressedSize / (1024.0 * 1024.0));
+
+                cooked->format = cookedTexture.format;
+                cooked->width  = cookedTexture.width;
+                cooked->height = cookedTexture.height;
+                cooked->mips   = std::move(cookedTexture.mips);
+            }
+
+            // The graphics context isn't thread safe, and the upload only records commands. The
+            // blocks are copied to a staging buffer there, so they're freed once it returns
+            jobSystem->runOnMainThread(
+                [this, texture, path, cooked, startTime]() {
+                    std::shared_ptr<std::atomic<uint32_t>> pending = pendingCount;
+                    if (textureStreamer != nullptr) {
+                        textureStreamer->add(texture, path, cooked, [path, startTime, pending]() {
+                            (*pending)--;
+
+                            std::chrono::duration<double, std::milli> loadTime =
+                                std::chrono::high_resolution_clock::now() - startTime;
+                            Logger::renderer_logger->info("Streamed in texture {0} in {1} ms",
+                                                          path, loadTime.count());
+                        });
+                        return;
+                    }
+
+                    bool created = graphicsContext->createCompressedTextureAsync(
+                        cooked->format, cooked->width, cooked->height, cooked->mips,
+                        [texture, path, startTime, pending](std::shared_ptr<Texture> uploaded) {
+                            texture->swap(uploaded);
+                            (*pending)--;
+
+                            std::chrono::duration<double, std::milli> loadTime =
+                                std::chrono::high_resolution_clock::now() - startTime;
+                            Logger::renderer_logger->info("Loaded texture {0} in {1} ms", path,
+                                                          loadTime.count());
+                        });
+                    if (!created) {
+                        Logger::renderer_logger->error("Failed to load texture: {0}", path);
+                        (*pending)--;
+                    }
+                },
+                &loadCounter);
+        },
+        &loadCounter);
+
+    return texture;
+}
+
+void AssetManager::useTextureStreamer(TextureStreamer* textureStreamer) {
+    this->textureStreamer = textureStreamer;
+}
+
+void AssetManager::bindTexture(std::shared_ptr<Asset<Texture>> texture,
+                               std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding) {
+    TextureBinding textureBinding = {};
+    textureBinding.texture        = texture;
+    textureBinding.descriptorSet  = descriptorSet;
+    textureBinding.binding        = binding;
+    textureBinding.boundTextures.fill(texture->get());
+
+    graphicsContext->descriptorSetAddImage(descriptorSet, binding, textureBinding.boundTextures[0]);
+
+    textureBindings.push_back(textureBinding);
+}
+
+void AssetManager::update() {
+    graphicsContext->pollTextureUploads();
+
+    uint32_t frameIndex = graphicsContext->getFrameBasedIndex();
+    for (auto& textureBinding : textureBindings) {
+        std::shared_ptr<Texture> current = textureBinding.texture->get();
+        if (textureBinding.boundTextures[frameIndex] == current) {
+            continue;
+        }
+
+        graphicsContext->descriptorSetAddImage(textureBinding.descriptorSet,
+                                               textureBinding.binding, current, frameIndex);
+        textureBinding.boundTextures[frameIndex] = current;
+    }
+}
+
+uint32_t AssetManager::getPendingCount() { return pendingCount->load(); }
+
+TextureDecodeStats AssetManager::getDecodeStats() {
+    std::lock_guard<std::mutex> lock(decodeStatsMutex);
+    return decodeStats;
+}
+
+std::shared_ptr<unsigned char> AssetManager::decodeRGBA(const std::string& path, int& width,
+                                                        int& height) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // RGB images are decoded as they are and expanded here, stb adds the alpha a pixel at a time
+    int numComponents;
+    if (!stbi_info(path.c_str(), &width, &height, &numComponents)) {
+        return nullptr;
+    }
+    int desiredComponents = (numComponents == 3) ? 3 : 4;
+
+    unsigned char* decoded =
+        stbi_load(path.c_str(), &width, &height, &numComponents, desiredComponents);
+    if (decoded == nullptr) {
+        return nullptr;
+    }
+
+    size_t pixelCount = (size_t)width * height;
+    std::shared_ptr<unsigned char> data;
+    if (desiredComponents == 3) {
+        data = std::shared_ptr<unsigned char>(new unsigned char[pixelCount * 4],
+                                              std::default_delete<unsigned char[]>());
+        helper::expandRGBToRGBA(decoded, data.get(), pixelCount);
+        stbi_image_free(decoded);
+    } else {
+        data = std::shared_ptr<unsigned char>(decoded, stbi_image_free);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    std::lock_guard<std::mutex> lock(decodeStatsMutex);
+    decodeStats.imageCount++;
+    decodeStats.decodedBytes += pixelCount * 4;
+    decodeStats.decodeMilliseconds +=
+        std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    decodeStats.wallMilliseconds =
+        std::chrono::duration<double, std::milli>(endTime - decodeStart).count();
+
+    return data;
+}
+
+bool AssetManager::readCookedTexture(const std::string& path, KTX2Texture& texture) {
+    std::filesystem::path cookedPath = std::filesystem::path(path).replace_extension(".ktx2");
+
+    if (cookedPath != std::filesystem::path(path)) {
+        std::error_code error;
+        auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+        if (error) {
+            return false;
+        }
+
+        auto sourceTime = std::filesystem::last_write_time(path, error);
+        if (!error && cookedTime < sourceTime) {
+            Logger::renderer_logger->warn("Ignoring cooked texture older than its source: {0}",
+                                          cookedPath.generic_string());
+            return false;
+        }
+    }
+
+    return helper::readKTX2(cookedPath.generic_string(), texture);
+}
+
+std::shared_ptr<Texture> AssetManager::createPlaceholder(std::array<unsigned char, 4> color) {
+    return graphicsContext->createTexture(1, 1, 4, ColorSpace::LINEAR, color.data(), false);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../Jobs/JobSystem.hpp"
+#include "../renderer/GraphicsContext.hpp"
+#include "../renderer/Helper/KTX2.hpp"
+#include "TextureCooker.hpp"
+
+class TextureStreamer;
+
+// Of every texture decoded so far
+struct TextureDecodeStats {
+    uint32_t imageCount;
+    // As RGBA
+    uint64_t decodedBytes;
+    // Added up over the workers
+    double decodeMilliseconds;
+    // From the first load to the last decode, what the throughput is measured over
+    double wallMilliseconds;
+};
+
+// Handed out before the resource is loaded. get() returns the placeholder until the loaded
+// resource is swapped in, it's safe to call from any thread
+template <typename T> class Asset {
+public:
+    Asset(std::shared_ptr<T> placeholder) : resource(placeholder), loaded(false) {}
+
+    std::shared_ptr<T> get() { return std::atomic_load(&resource); }
+
+    bool isLoaded() { return loaded.load(); }
+
+private:
+    friend class AssetManager;
+    friend class TextureStreamer;
+
+    void swap(std::shared_ptr<T> loadedResource) {
+        std::atomic_store(&resource, loadedResource);
+        loaded.store(true);
+    }
+
+    std::shared_ptr<T> resource;
+    std::atomic<bool> loaded;
+};
+
+// Loads assets without holding up the first frame. Files are decoded and block compressed on the
+// job system workers in parallel, the uploads are recorded on the main thread and submitted
+// without waiting on them, so frames render with the placeholders until the uploads are done
+class AssetManager {
+public:
+    AssetManager(GraphicsContext* graphicsContext, JobSystem* jobSystem);
+
+    ~AssetManager();
+
+    // KTX2 files are uploaded as they are. Images with a KTX2 file next to them that's at least as
+    // new use that instead, see tools/TextureCooker, the others are cooked here. Normal maps show
+    // a flat normal until they're loaded, everything else grey
+    std::shared_ptr<Asset<Texture>>
+    loadTexture(const std::string& path, ColorSpace colorSpace,
+                TextureContent content = TextureContent::COLOR);
+
+    // Textures loaded afterwards are handed to the streamer once cooked instead of being uploaded
+    // with every mip
+    void useTextureStreamer(TextureStreamer* textureStreamer);
+
+    // Binds what the asset holds now and rebinds it whenever that changes, see update
+    void bindTexture(std::shared_ptr<Asset<Texture>> texture,
+                     std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding);
+
+    // Once per frame on the main thread, after waiting on the frame fence. Finishes the uploads
+    // that are done and rebinds the textures that changed in this frame's sets, the other frames'
+    // sets may still be in use
+    void update();
+
+    // Started but not yet swapped in or failed
+    uint32_t getPendingCount();
+
+    TextureDecodeStats getDecodeStats();
+
+private:
+    struct TextureBinding {
+        std::shared_ptr<Asset<Texture>> texture;
+        std::shared_ptr<DescriptorSet> descriptorSet;
+        uint32_t binding;
+        // What every frame's set was last written with, kept alive while that set may be in use
+        std::array<std::shared_ptr<Texture>, FRAME_OVERLAP> boundTextures;
+    };
+
+    // Always RGBA, null when the file couldn't be decoded. Safe to call from any thread
+    std::shared_ptr<unsigned char> decodeRGBA(const std::string& path, int& width, int& height);
+
+    // Returns false when there's no usable KTX2 file for the path
+    bool readCookedTexture(const std::string& path, KTX2Texture& texture);
+
+    std::shared_ptr<Texture> createPlaceholder(std::array<unsigned char, 4> color);
+
+    GraphicsContext* graphicsContext;
+    JobSystem* jobSystem;
+
+    TextureCooker textureCooker;
+
+    TextureStreamer* textureStreamer = nullptr;
+
+    std::shared_ptr<Texture> greyPlaceholder;
+    std::shared_ptr<Texture> flatNormalPlaceholder;
+
+    std::vector<TextureBinding> textureBindings;
+
+    // Jobs of loads still running, waited on before the manager goes
+    JobCounter loadCounter;
+    // Shared with the upload callbacks, the graphics context may run them after the manager is gone
+    std::shared_ptr<std::atomic<uint32_t>> pendingCount;
+
+    std::mutex decodeStatsMutex;
+    TextureDecodeStats decodeStats;
+    std::chrono::high_resolution_clock::time_point decodeStart;
+    bool decodeStarted;
+};
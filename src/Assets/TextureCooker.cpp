@@ -0,0 +1,410 @@
+#include "../pch.hpp"
+#include "TextureCooker.hpp"
+
+#include "../renderer/Helper/BlockCompression.hpp"
+#include "../renderer/Helper/Pixels.hpp"
+#include "../Logger.hpp"
+
+// Below this many block rows per job handing them out costs more than it saves
+constexpr uint32_t MIN_BLOCK_ROWS_PER_RANGE = 4;
+
+constexpr uint32_t MIN_TEXEL_ROWS_PER_RANGE = 16;
+
+constexpr float LANCZOS_PI = 3.14159265359f;
+
+float srgbToLinear(float value) {
+    return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSRGB(float value) {
+    return (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+float lanczos3(float x) {
+    x = std::abs(x);
+    if (x < 1e-5f) {
+        return 1.0f;
+    }
+    if (x >= 3.0f) {
+        return 0.0f;
+    }
+
+    float scaled = LANCZOS_PI * x;
+    return 3.0f * std::sin(scaled) * std::sin(scaled / 3.0f) / (scaled * scaled);
+}
+
+// Source texels and their weights for one output texel along an axis
+struct FilterTaps {
+    int32_t first;
+    std::vector<float> weights;
+};
+
+// The kernel is stretched over the source texels an output texel covers, the weights are
+// normalized so flat areas stay flat
+std::vector<FilterTaps> lanczos3Taps(uint32_t sourceSize, uint32_t mipSize) {
+    float scale  = (float)sourceSize / mipSize;
+    float radius = 3.0f * scale;
+
+    std::vector<FilterTaps> taps(mipSize);
+    for (uint32_t i = 0; i < mipSize; i++) {
+        float center = (i + 0.5f) * scale;
+
+        taps[i].first = (int32_t)std::ceil(center - radius - 0.5f);
+        int32_t last  = (int32_t)std::floor(center + radius - 0.5f);
+
+        float sum = 0.0f;
+        for (int32_t j = taps[i].first; j <= last; j++) {
+            float weight = lanczos3((j + 0.5f - center) / scale);
+            taps[i].weights.push_back(weight);
+            sum += weight;
+        }
+        for (float& weight : taps[i].weights) {
+            weight /= sum;
+        }
+    }
+
+    return taps;
+}
+
+// Texels of the block at blockX, blockY in row order, blocks past the edge repeat the last texel
+template <typename T, int C>
+void gatherBlock(const T* image, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+                 T texels[16][C]) {
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t x = std::min(blockX * 4 + i % 4, width - 1);
+        uint32_t y = std::min(blockY * 4 + i / 4, height - 1);
+        for (int c = 0; c < C; c++) {
+            texels[i][c] = image[((size_t)y * width + x) * C + c];
+        }
+    }
+}
+
+TextureCooker::TextureCooker(JobSystem* jobSystem, MipFilter mipFilter)
+    : jobSystem(jobSystem), mipFilter(mipFilter) {}
+
+TextureCooker::~TextureCooker() { Logger::renderer_logger->info("Destroying Texture Cooker"); }
+
+CookedTexture TextureCooker::cook(const unsigned char* rgba, uint32_t width, uint32_t height,
+                                  TextureContent content, ColorSpace colorSpace) {
+    CookedTexture cooked    = {};
+    cooked.width            = width;
+    cooked.height           = height;
+    cooked.uncompressedSize = 0;
+
+    uint32_t blockSize = 16;
+    // Channels the format keeps, for the error
+    int keptChannels = 2;
+    switch (content) {
+    case TextureContent::COLOR: {
+        cooked.format = (colorSpace == ColorSpace::SRGB) ? Format::BC7_SRGB : Format::BC7_UNORM;
+        keptChannels  = 4;
+        break;
+    }
+    case TextureContent::NORMAL_MAP:
+    case TextureContent::TWO_CHANNEL: {
+        cooked.format = Format::BC5_UNORM;
+        break;
+    }
+    case TextureContent::ONE_CHANNEL: {
+        cooked.format = Format::BC4_UNORM;
+        blockSize     = 8;
+        keptChannels  = 1;
+        break;
+    }
+    }
+
+    std::array<float, 256> srgbToLinearTable;
+    for (int i = 0; i < 256; i++) {
+        srgbToLinearTable[i] = srgbToLinear(i / 255.0f);
+    }
+
+    // Filtered as floats so mips don't pile up rounding, colours in linear space and normals as
+    // vectors. Alpha is always linear
+    bool isNormalMap = content == TextureContent::NORMAL_MAP;
+    bool isSRGB      = colorSpace == ColorSpace::SRGB && !isNormalMap;
+
+    std::vector<float> image((size_t)width * height * 4);
+    for (size_t i = 0; i < image.size(); i++) {
+        if (isNormalMap) {
+            image[i] = rgba[i] / 127.5f - 1.0f;
+        } else if (isSRGB && i % 4 != 3) {
+            image[i] = srgbToLinearTable[rgba[i]];
+        } else {
+            image[i] = rgba[i] / 255.0f;
+        }
+    }
+
+    // Back to bytes after filtering, which may ring past the valid range
+    auto toTexels = [&](std::vector<float>& mipImage, std::vector<unsigned char>& texels) {
+        texels.resize(mipImage.size());
+        for (size_t i = 0; i < mipImage.size(); i += 4) {
+            float* texel = &mipImage[i];
+            if (isNormalMap) {
+                glm::vec3 normal(texel[0], texel[1], texel[2]);
+                normal =
+                    (glm::length(normal) > 0.0f) ? glm::normalize(normal) : glm::vec3(0, 0, 1);
+                for (int c = 0; c < 3; c++) {
+                    texel[c]      = normal[c];
+                    texels[i + c] = (unsigned char)std::lround((normal[c] + 1.0f) * 127.5f);
+                }
+                texels[i + 3] = 255;
+                continue;
+            }
+
+            for (int c = 0; c < 4; c++) {
+                texel[c]      = std::clamp(texel[c], 0.0f, 1.0f);
+                float value   = (isSRGB && c < 3) ? linearToSRGB(texel[c]) : texel[c];
+                texels[i + c] = (unsigned char)std::lround(value * 255.0f);
+            }
+        }
+    };
+
+    std::vector<unsigned char> mip(rgba, rgba + (size_t)width * height * 4);
+    uint32_t mipWidth  = width;
+    uint32_t mipHeight = height;
+    while (true) {
+        cooked.uncompressedSize += mip.size();
+
+        std::vector<unsigned char> blocks;
+        double squaredError = encodeBlocks(
+            mipWidth, mipHeight, blockSize, blocks,
+            [&](uint32_t blockX, uint32_t blockY, unsigned char* block) {
+                unsigned char texels[16][4];
+                gatherBlock<unsigned char, 4>(mip.data(), mipWidth, mipHeight, blockX, blockY,
+                                              texels);
+
+                unsigned char decoded[16][4] = {};
+                if (content == TextureContent::COLOR) {
+                    helper::encodeBC7(texels, block);
+                    helper::decodeBC7(block, decoded);
+                } else if (content == TextureContent::ONE_CHANNEL) {
+                    helper::encodeBC4(texels, block);
+                    helper::decodeBC4(block, decoded);
+                } else {
+                    helper::encodeBC5(texels, block);
+                    helper::decodeBC5(block, decoded);
+                }
+
+                double error = 0.0;
+                for (int i = 0; i < 16; i++) {
+                    for (int c = 0; c < keptChannels; c++) {
+                        double difference = (double)decoded[i][c] - texels[i][c];
+                        error += difference * difference;
+                    }
+                }
+                return error;
+            });
+
+        if (cooked.mips.empty()) {
+            double meanSquaredError = squaredError / ((double)width * height * keptChannels);
+            cooked.psnr = 10.0 * std::log10(255.0 * 255.0 / std::max(meanSquaredError, 1e-10));
+        }
+        cooked.mips.push_back(std::move(blocks));
+
+        if (mipWidth == 1 && mipHeight == 1) {
+            break;
+        }
+        image     = downsample(image, mipWidth, mipHeight);
+        mipWidth  = std::max(mipWidth / 2, 1u);
+        mipHeight = std::max(mipHeight / 2, 1u);
+        toTexels(image, mip);
+    }
+
+    return cooked;
+}
+
+CookedTexture TextureCooker::cookHDR(const float* rgba, uint32_t width, uint32_t height) {
+    CookedTexture cooked    = {};
+    cooked.format           = Format::BC6H_UFLOAT;
+    cooked.width            = width;
+    cooked.height           = height;
+    cooked.uncompressedSize = 0;
+
+    float brightest = 0.0f;
+    for (size_t i = 0; i < (size_t)width * height * 4; i++) {
+        if (i % 4 != 3 && std::isfinite(rgba[i])) {
+            brightest = std::max(brightest, rgba[i]);
+        }
+    }
+
+    std::vector<float> mip(rgba, rgba + (size_t)width * height * 4);
+    uint32_t mipWidth  = width;
+    uint32_t mipHeight = height;
+    while (true) {
+        cooked.uncompressedSize += mip.size() * sizeof(float);
+
+        std::vector<unsigned char> blocks;
+        double squaredError = encodeBlocks(
+            mipWidth, mipHeight, 16, blocks,
+            [&](uint32_t blockX, uint32_t blockY, unsigned char* block) {
+                float texels[16][4];
+                gatherBlock<float, 4>(mip.data(), mipWidth, mipHeight, blockX, blockY, texels);
+
+                float rgb[16][3];
+                for (int i = 0; i < 16; i++) {
+                    for (int c = 0; c < 3; c++) {
+                        rgb[i][c] = std::max(texels[i][c], 0.0f);
+                    }
+                }
+
+                uint16_t halves[16][3];
+                uint16_t decoded[16][3];
+                helper::floatToHalf(rgb[0], halves[0], 16 * 3);
+                helper::encodeBC6H(halves, block);
+                helper::decodeBC6H(block, decoded);
+
+                // Against the halves, the error of the conversion is the format's not the block's
+                float source[16][3];
+                float result[16][3];
+                helper::halfToFloat(halves[0], source[0], 16 * 3);
+                helper::halfToFloat(decoded[0], result[0], 16 * 3);
+
+                double error = 0.0;
+                for (int i = 0; i < 16; i++) {
+                    for (int c = 0; c < 3; c++) {
+                        double difference = (double)result[i][c] - source[i][c];
+                        error += difference * difference;
+                    }
+                }
+                return error;
+            });
+
+        if (cooked.mips.empty()) {
+            double meanSquaredError = squaredError / ((double)width * height * 3);
+            double peak             = std::max((double)brightest, 1e-6);
+            cooked.psnr = 10.0 * std::log10(peak * peak / std::max(meanSquaredError, 1e-20));
+        }
+        cooked.mips.push_back(std::move(blocks));
+
+        if (mipWidth == 1 && mipHeight == 1) {
+            break;
+        }
+        mip       = downsample(mip, mipWidth, mipHeight);
+        mipWidth  = std::max(mipWidth / 2, 1u);
+        mipHeight = std::max(mipHeight / 2, 1u);
+        // Lanczos rings below zero next to bright texels
+        for (float& value : mip) {
+            value = std::max(value, 0.0f);
+        }
+    }
+
+    return cooked;
+}
+
+std::vector<float> TextureCooker::downsample(const std::vector<float>& image, uint32_t width,
+                                             uint32_t height) {
+    uint32_t mipWidth  = std::max(width / 2, 1u);
+    uint32_t mipHeight = std::max(height / 2, 1u);
+
+    uint32_t threadCount = jobSystem->getThreadCount();
+    auto rangeSize       = [&](uint32_t rows) {
+        return std::max((rows + threadCount - 1) / threadCount, MIN_TEXEL_ROWS_PER_RANGE);
+    };
+
+    std::vector<float> mip((size_t)mipWidth * mipHeight * 4);
+
+    if (mipFilter == MipFilter::BOX) {
+        // Odd sizes repeat their last row or column
+        jobSystem->parallelFor(
+            mipHeight, rangeSize(mipHeight), [&](uint32_t firstRow, uint32_t rowCount) {
+                for (uint32_t y = firstRow; y < firstRow + rowCount; y++) {
+                    uint32_t y0 = std::min(y * 2, height - 1);
+                    uint32_t y1 = std::min(y * 2 + 1, height - 1);
+                    for (uint32_t x = 0; x < mipWidth; x++) {
+                        uint32_t x0 = std::min(x * 2, width - 1);
+                        uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                        for (int c = 0; c < 4; c++) {
+                            mip[((size_t)y * mipWidth + x) * 4 + c] =
+                                (image[((size_t)y0 * width + x0) * 4 + c] +
+                                 image[((size_t)y0 * width + x1) * 4 + c] +
+                                 image[((size_t)y1 * width + x0) * 4 + c] +
+                                 image[((size_t)y1 * width + x1) * 4 + c]) /
+                                4.0f;
+                        }
+                    }
+                }
+            });
+
+        return mip;
+    }
+
+    // Rows first into an image of the mip's width, then columns
+    std::vector<FilterTaps> columnTaps = lanczos3Taps(width, mipWidth);
+    std::vector<FilterTaps> rowTaps    = lanczos3Taps(height, mipHeight);
+
+    std::vector<float> rows((size_t)mipWidth * height * 4);
+    jobSystem->parallelFor(height, rangeSize(height), [&](uint32_t firstRow, uint32_t rowCount) {
+        for (uint32_t y = firstRow; y < firstRow + rowCount; y++) {
+            for (uint32_t x = 0; x < mipWidth; x++) {
+                const FilterTaps& taps = columnTaps[x];
+
+                float sum[4] = {};
+                for (size_t i = 0; i < taps.weights.size(); i++) {
+                    int32_t sourceX = std::clamp(taps.first + (int32_t)i, 0, (int32_t)width - 1);
+                    for (int c = 0; c < 4; c++) {
+                        sum[c] += taps.weights[i] * image[((size_t)y * width + sourceX) * 4 + c];
+                    }
+                }
+                for (int c = 0; c < 4; c++) {
+                    rows[((size_t)y * mipWidth + x) * 4 + c] = sum[c];
+                }
+            }
+        }
+    });
+
+    jobSystem->parallelFor(
+        mipHeight, rangeSize(mipHeight), [&](uint32_t firstRow, uint32_t rowCount) {
+            for (uint32_t y = firstRow; y < firstRow + rowCount; y++) {
+                const FilterTaps& taps = rowTaps[y];
+                for (uint32_t x = 0; x < mipWidth; x++) {
+                    float sum[4] = {};
+                    for (size_t i = 0; i < taps.weights.size(); i++) {
+                        int32_t sourceY =
+                            std::clamp(taps.first + (int32_t)i, 0, (int32_t)height - 1);
+                        for (int c = 0; c < 4; c++) {
+                            sum[c] += taps.weights[i] *
+                                      rows[((size_t)sourceY * mipWidth + x) * 4 + c];
+                        }
+                    }
+                    for (int c = 0; c < 4; c++) {
+                        mip[((size_t)y * mipWidth + x) * 4 + c] = sum[c];
+                    }
+                }
+            }
+        });
+
+    return mip;
+}
+
+double TextureCooker::encodeBlocks(
+    uint32_t width, uint32_t height, uint32_t blockSize, std::vector<unsigned char>& blocks,
+    const std::function<double(uint32_t, uint32_t, unsigned char*)>& encode) {
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+    blocks.resize((size_t)blocksX * blocksY * blockSize);
+
+    uint32_t threadCount = jobSystem->getThreadCount();
+    uint32_t rangeSize   = std::max((blocksY + threadCount - 1) / threadCount,
+                                    MIN_BLOCK_ROWS_PER_RANGE);
+    uint32_t rangeCount  = (blocksY + rangeSize - 1) / rangeSize;
+
+    // One sum per range, added up in order so the result doesn't depend on the scheduling
+    std::vector<double> rangeErrors(rangeCount, 0.0);
+    jobSystem->parallelFor(blocksY, rangeSize, [&](uint32_t firstRow, uint32_t rowCount) {
+        double error = 0.0;
+        for (uint32_t blockY = firstRow; blockY < firstRow + rowCount; blockY++) {
+            for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                error += encode(blockX, blockY,
+                                &blocks[((size_t)blockY * blocksX + blockX) * blockSize]);
+            }
+        }
+        rangeErrors[firstRow / rangeSize] = error;
+    });
+
+    double squaredError = 0.0;
+    for (double error : rangeErrors) {
+        squaredError += error;
+    }
+
+    return squaredError;
+}
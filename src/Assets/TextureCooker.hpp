@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Jobs/JobSystem.hpp"
+#include "../renderer/GraphicsContext.hpp"
+
+// What a texture holds, which decides its block format and how its mips are filtered
+enum class TextureContent {
+    // BC7, filtered in linear space when the texture is SRGB
+    COLOR,
+    // BC5 of x and y, the shader rebuilds z. Mips are renormalized
+    NORMAL_MAP,
+    // BC5 of red and green
+    TWO_CHANNEL,
+    // BC4 of red
+    ONE_CHANNEL
+};
+
+// How each mip is filtered down from the one above it
+enum class MipFilter {
+    // 2x2 average, fast enough to cook at load time
+    BOX,
+    // Separable Lanczos with 3 lobes, sharper mips for cooking offline
+    LANCZOS3
+};
+
+// A texture block compressed on the CPU, for GraphicsContext::createCompressedTexture
+struct CookedTexture {
+    Format format;
+    uint32_t width;
+    uint32_t height;
+    // Full size first, each mip's blocks in row order
+    std::vector<std::vector<unsigned char>> mips;
+    // Of the full size mip against the source, over the channels the format keeps. HDR textures
+    // are measured against their brightest texel
+    double psnr;
+    // What the same mips take uncompressed, RGBA8 or RGBA32F
+    uint64_t uncompressedSize;
+};
+
+// Filters the full mip chain in linear space and block compresses every mip, both spread over the
+// job system by rows
+class TextureCooker {
+public:
+    TextureCooker(JobSystem* jobSystem, MipFilter mipFilter = MipFilter::BOX);
+
+    ~TextureCooker();
+
+    CookedTexture cook(const unsigned char* rgba, uint32_t width, uint32_t height,
+                       TextureContent content, ColorSpace colorSpace);
+
+    // BC6H, negative values are clamped to zero
+    CookedTexture cookHDR(const float* rgba, uint32_t width, uint32_t height);
+
+private:
+    // Filters RGBA floats down to the next mip, edges are clamped
+    std::vector<float> downsample(const std::vector<float>& image, uint32_t width,
+                                  uint32_t height);
+
+    // Calls encode for every block of a mip in parallel, encode returns the squared error of the
+    // block. Returns the summed error
+    double encodeBlocks(uint32_t width, uint32_t height, uint32_t blockSize,
+                        std::vector<unsigned char>& blocks,
+                        const std::function<double(uint32_t, uint32_t, unsigned char*)>& encode);
+
+    JobSystem* jobSystem;
+
+    MipFilter mipFilter;
+};
@@ -0,0 +1,234 @@
+#include "../pch.hpp"
+#include "TextureResidency.hpp"
+
+// Mips with at most this many texels on their larger side are resident from the start
+constexpr uint32_t RESIDENT_TAIL_SIZE = 64;
+
+TextureResidency::TextureResidency(uint64_t budgetBytes)
+    : budgetBytes(budgetBytes), targetBytes(0), frame(1), stats() {}
+
+uint32_t TextureResidency::add(uint32_t width, uint32_t height,
+                               const std::vector<uint64_t>& mipSizes) {
+    ResidentTexture texture = {};
+    texture.width           = width;
+    texture.height          = height;
+
+    uint32_t mipCount = (uint32_t)mipSizes.size();
+    texture.tailSizes.resize(mipCount + 1, 0);
+    for (uint32_t mip = mipCount; mip-- > 0;) {
+        texture.tailSizes[mip] = texture.tailSizes[mip + 1] + mipSizes[mip];
+    }
+
+    // Down to the smallest mip when none is small enough
+    texture.tailMip = 0;
+    while (texture.tailMip + 1 < mipCount &&
+           std::max(width >> texture.tailMip, height >> texture.tailMip) > RESIDENT_TAIL_SIZE) {
+        texture.tailMip++;
+    }
+
+    // Nothing resident until the tail is uploaded
+    texture.residentMip   = mipCount;
+    texture.targetMip     = mipCount;
+    texture.wantedMip     = texture.tailMip;
+    texture.lastUsedFrame = 0;
+    texture.retiredBytes  = 0;
+
+    textures.push_back(texture);
+
+    return (uint32_t)textures.size() - 1;
+}
+
+void TextureResidency::requestTexels(uint32_t texture, float texels) {
+    ResidentTexture& resident = textures[texture];
+
+    // The smallest mip that still has the texels, only the tail for textures that barely show
+    uint32_t mip = resident.tailMip;
+    if (texels >= 1.0f) {
+        float largerSide = (float)std::max(resident.width, resident.height);
+        mip = (uint32_t)std::max(std::floor(std::log2(largerSide / texels)), 0.0f);
+        mip = std::min(mip, resident.tailMip);
+    }
+
+    if (resident.lastUsedFrame != frame) {
+        resident.wantedMip     = mip;
+        resident.lastUsedFrame = frame;
+    } else {
+        resident.wantedMip = std::min(resident.wantedMip, mip);
+    }
+}
+
+std::vector<ResidencyChange> TextureResidency::update(uint64_t availableBytes) {
+    std::vector<ResidencyChange> changes;
+
+    uint64_t budget   = std::min(budgetBytes, committedBytes() + availableBytes);
+    stats.budgetBytes = budget;
+
+    // New textures and the ones whose tail couldn't be created, the tail goes in regardless of the
+    // budget and other mips are evicted to make up for it
+    for (auto& texture : textures) {
+        if (texture.targetMip > texture.tailMip) {
+            change(texture, texture.tailMip, changes);
+        }
+    }
+
+    // The budget may have shrunk since the last update. An eviction creates the smaller image
+    // before the old one goes, so while over the budget they're started one at a time
+    while (targetBytes > budget) {
+        ResidentTexture* evictable = findEvictable(nullptr);
+        if (evictable == nullptr) {
+            break;
+        }
+
+        uint64_t size = evictable->tailSizes[evictable->residentMip + 1];
+        if (committedBytes() + size > budget && committedBytes() > stats.residentBytes) {
+            break;
+        }
+        change(*evictable, evictable->residentMip + 1, changes);
+    }
+
+    // Only what was used this frame, most recently used first and then the furthest from the mip
+    // they want
+    std::vector<ResidentTexture*> requests;
+    for (auto& texture : textures) {
+        if (!isBusy(texture) && texture.lastUsedFrame == frame &&
+            texture.wantedMip < texture.residentMip) {
+            requests.push_back(&texture);
+        }
+    }
+    std::sort(requests.begin(), requests.end(),
+              [](const ResidentTexture* a, const ResidentTexture* b) {
+                  if (a->lastUsedFrame != b->lastUsedFrame) {
+                      return a->lastUsedFrame > b->lastUsedFrame;
+                  }
+                  return a->residentMip - a->wantedMip > b->residentMip - b->wantedMip;
+              });
+
+    for (ResidentTexture* request : requests) {
+        // Evicted for an earlier request
+        if (isBusy(*request)) {
+            continue;
+        }
+
+        // The whole new image, its old one stays alive until the swap
+        uint32_t mip  = request->residentMip - 1;
+        uint64_t size = request->tailSizes[mip];
+
+        // Evictions only give back memory once the old images are freed, so they make room for a
+        // later update. Each has to fit next to what's alive now
+        while (targetBytes + size > budget) {
+            ResidentTexture* evictable = findEvictable(request);
+            if (evictable == nullptr ||
+                committedBytes() + evictable->tailSizes[evictable->residentMip + 1] > budget) {
+                break;
+            }
+            change(*evictable, evictable->residentMip + 1, changes);
+        }
+
+        if (targetBytes + size > budget || committedBytes() + size > budget) {
+            stats.deferredCount++;
+            continue;
+        }
+
+        change(*request, mip, changes);
+    }
+
+    frame++;
+
+    return changes;
+}
+
+void TextureResidency::uploaded(uint32_t texture) {
+    ResidentTexture& resident = textures[texture];
+
+    // Nothing is retired when the upload replaced a placeholder
+    uint64_t replacedBytes = resident.tailSizes[resident.residentMip];
+    stats.uploadingBytes -= resident.tailSizes[resident.targetMip];
+    stats.residentBytes  = stats.residentBytes - replacedBytes +
+                          resident.tailSizes[resident.targetMip];
+    stats.retiredBytes += replacedBytes;
+    resident.retiredBytes += replacedBytes;
+    resident.residentMip = resident.targetMip;
+}
+
+void TextureResidency::uploadFailed(uint32_t texture) {
+    ResidentTexture& resident = textures[texture];
+
+    stats.uploadingBytes -= resident.tailSizes[resident.targetMip];
+    targetBytes = targetBytes - resident.tailSizes[resident.targetMip] +
+                  resident.tailSizes[resident.residentMip];
+    resident.targetMip = resident.residentMip;
+    stats.failedCount++;
+}
+
+void TextureResidency::released(uint32_t texture) {
+    ResidentTexture& resident = textures[texture];
+
+    stats.retiredBytes -= resident.retiredBytes;
+    resident.retiredBytes = 0;
+}
+
+bool TextureResidency::isRetiring(uint32_t texture) { return textures[texture].retiredBytes > 0; }
+
+uint32_t TextureResidency::getResidentMip(uint32_t texture) {
+    return textures[texture].residentMip;
+}
+
+void TextureResidency::setBudget(uint64_t budgetBytes) { this->budgetBytes = budgetBytes; }
+
+TextureStreamStats TextureResidency::getStats() {
+    stats.textureCount = (uint32_t)textures.size();
+
+    return stats;
+}
+
+bool TextureResidency::isBusy(const ResidentTexture& texture) {
+    return texture.targetMip != texture.residentMip || texture.retiredBytes > 0;
+}
+
+uint64_t TextureResidency::committedBytes() {
+    return stats.residentBytes + stats.uploadingBytes + stats.retiredBytes;
+}
+
+TextureResidency::ResidentTexture*
+TextureResidency::findEvictable(const ResidentTexture* requester) {
+    ResidentTexture* evictable = nullptr;
+    bool evictableSurplus      = false;
+    for (auto& texture : textures) {
+        ResidentTexture* candidate = &texture;
+        if (candidate == requester || isBusy(*candidate) ||
+            candidate->residentMip >= candidate->tailMip) {
+            continue;
+        }
+
+        // Holding a finer mip than it was last asked for
+        bool surplus = candidate->residentMip < candidate->wantedMip;
+        if (requester != nullptr && !surplus &&
+            candidate->lastUsedFrame >= requester->lastUsedFrame) {
+            continue;
+        }
+
+        if (evictable == nullptr || (surplus && !evictableSurplus) ||
+            (surplus == evictableSurplus &&
+             candidate->lastUsedFrame < evictable->lastUsedFrame)) {
+            evictable        = candidate;
+            evictableSurplus = surplus;
+        }
+    }
+
+    return evictable;
+}
+
+void TextureResidency::change(ResidentTexture& texture, uint32_t targetMip,
+                              std::vector<ResidencyChange>& changes) {
+    if (targetMip > texture.residentMip) {
+        stats.evictionCount++;
+    } else if (texture.residentMip < texture.tailSizes.size() - 1) {
+        stats.uploadCount++;
+    }
+
+    targetBytes = targetBytes - texture.tailSizes[texture.targetMip] + texture.tailSizes[targetMip];
+    stats.uploadingBytes += texture.tailSizes[targetMip];
+    texture.targetMip = targetMip;
+
+    changes.push_back({ (uint32_t)(&texture - textures.data()), targetMip });
+}
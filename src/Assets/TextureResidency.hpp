@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../pch.hpp"
+
+// What the streamed textures hold and what has been done so far. Device memory taken is the sum
+// of the resident, uploading and retired bytes
+struct TextureStreamStats {
+    uint32_t textureCount;
+    // Of the images swapped into the assets
+    uint64_t residentBytes;
+    // Of the images being uploaded, their memory is taken once the upload is recorded
+    uint64_t uploadingBytes;
+    // Of the images replaced by an upload that the descriptor sets still hold
+    uint64_t retiredBytes;
+    // The configured budget, lowered when the device local heaps run short
+    uint64_t budgetBytes;
+    uint32_t uploadCount;
+    // Mips dropped to make room or to get back under the budget
+    uint32_t evictionCount;
+    // Finer mips that were wanted but didn't fit, counted once per update
+    uint32_t deferredCount;
+    // Images that couldn't be created, the texture keeps what it had
+    uint32_t failedCount;
+};
+
+// A texture to recreate with the mips from residentMip down
+struct ResidencyChange {
+    uint32_t texture;
+    uint32_t residentMip;
+};
+
+// Decides which mips of the streamed textures the GPU holds, see TextureStreamer. Knows nothing
+// of the device, the streamer reports when uploads finish and old images are freed
+//
+// Every change creates a whole new image while the old one lives on until it's freed, so a change
+// only starts when the new image fits next to everything still alive. A texture isn't changed
+// again until the image its last change replaced is freed
+class TextureResidency {
+public:
+    TextureResidency(uint64_t budgetBytes);
+
+    // mipSizes[0] is the full size mip. The tail, the mips with at most RESIDENT_TAIL_SIZE texels
+    // on their larger side, is uploaded on the next update regardless of the budget. Returns the
+    // texture's index
+    uint32_t add(uint32_t width, uint32_t height, const std::vector<uint64_t>& mipSizes);
+
+    // Marks the texture used this frame, needing texels across its larger side. The largest
+    // request of a frame wins
+    void requestTexels(uint32_t texture, float texels);
+
+    // Once per frame. availableBytes is what's left of the device local heaps, whose usage already
+    // counts every image this knows of. Returns the uploads to start, each is reported back with
+    // uploaded or uploadFailed
+    std::vector<ResidencyChange> update(uint64_t availableBytes);
+
+    // The new image was swapped into the asset, the one it replaced is retired until released
+    void uploaded(uint32_t texture);
+
+    // The new image couldn't be created, the texture keeps what it has and asks again later
+    void uploadFailed(uint32_t texture);
+
+    // The image the texture's last upload replaced was freed
+    void released(uint32_t texture);
+
+    bool isRetiring(uint32_t texture);
+
+    // Finest mip of the image swapped into the asset, the mip count while there's none
+    uint32_t getResidentMip(uint32_t texture);
+
+    void setBudget(uint64_t budgetBytes);
+
+    TextureStreamStats getStats();
+
+private:
+    struct ResidentTexture {
+        uint32_t width;
+        uint32_t height;
+        // Bytes of every mip from a mip down, the last entry is zero
+        std::vector<uint64_t> tailSizes;
+        // The mip resident from the start, never evicted
+        uint32_t tailMip;
+        uint32_t residentMip;
+        // Of the image being uploaded, the resident mip otherwise
+        uint32_t targetMip;
+        uint32_t wantedMip;
+        uint64_t lastUsedFrame;
+        uint64_t retiredBytes;
+    };
+
+    bool isBusy(const ResidentTexture& texture);
+
+    // Device memory taken now, counting the images being uploaded and the retired ones
+    uint64_t committedBytes();
+
+    // The texture with the least recently used mip that may go. With a requester only textures
+    // used less recently than it, or holding finer mips than they want, qualify. Null when none do
+    ResidentTexture* findEvictable(const ResidentTexture* requester);
+
+    void change(ResidentTexture& texture, uint32_t targetMip,
+                std::vector<ResidencyChange>& changes);
+
+    uint64_t budgetBytes;
+
+    std::vector<ResidentTexture> textures;
+
+    // What the textures hold once the uploads are done and the retired images freed
+    uint64_t targetBytes;
+
+    uint64_t frame;
+    TextureStreamStats stats;
+};
@@ -0,0 +1,113 @@
+#include "../pch.hpp"
+#include "TextureStreamer.hpp"
+
+#include "../Logger.hpp"
+#include "../renderer/Helper/BlockCompression.hpp"
+
+TextureStreamer::TextureStreamer(GraphicsContext* graphicsContext, uint64_t budgetBytes)
+    : graphicsContext(graphicsContext), residency(budgetBytes) {}
+
+TextureStreamer::~TextureStreamer() {
+    Logger::renderer_logger->info("Destroying Texture Streamer");
+}
+
+void TextureStreamer::add(std::shared_ptr<Asset<Texture>> texture, const std::string& name,
+                          std::shared_ptr<KTX2Texture> mips, std::function<void()> onResident) {
+    auto streamed        = std::make_shared<StreamedTexture>();
+    streamed->texture    = texture;
+    streamed->name       = name;
+    streamed->source     = mips;
+    streamed->onResident = onResident;
+    streamed->swapped    = false;
+
+    // Decoded mips take the device memory when it can't sample the blocks
+    std::vector<uint64_t> mipSizes;
+    for (uint32_t mipLevel = 0; mipLevel < mips->mips.size(); mipLevel++) {
+        if (graphicsContext->supportsTextureCompressionBC()) {
+            mipSizes.push_back(mips->mips[mipLevel].size());
+        } else {
+            mipSizes.push_back((uint64_t)std::max(mips->width >> mipLevel, 1u) *
+                               std::max(mips->height >> mipLevel, 1u) *
+                               helper::decodedTexelBytes(mips->format));
+        }
+    }
+
+    uint32_t index = residency.add(mips->width, mips->height, mipSizes);
+    textures.push_back(streamed);
+    texturesByAsset[texture.get()] = index;
+}
+
+void TextureStreamer::requestTexels(std::shared_ptr<Asset<Texture>> texture, float texels) {
+    auto found = texturesByAsset.find(texture.get());
+    if (found == texturesByAsset.end()) {
+        return;
+    }
+
+    residency.requestTexels(found->second, texels);
+}
+
+void TextureStreamer::update() {
+    for (uint32_t index = 0; index < textures.size(); index++) {
+        StreamedTexture& streamed = *textures[index];
+        if (streamed.swapped) {
+            residency.uploaded(index);
+            streamed.swapped = false;
+        }
+
+        if (residency.isRetiring(index) && streamed.retired.expired()) {
+            residency.released(index);
+        }
+    }
+
+    // The heaps' usage already counts the streamed images
+    DeviceMemoryBudget deviceBudget = graphicsContext->getDeviceMemoryBudget();
+    uint64_t available              = 0;
+    if (deviceBudget.budget > deviceBudget.usage) {
+        available = deviceBudget.budget - deviceBudget.usage;
+    }
+
+    for (const ResidencyChange& change : residency.update(available)) {
+        if (!upload(change.texture, change.residentMip)) {
+            residency.uploadFailed(change.texture);
+        }
+    }
+}
+
+void TextureStreamer::setBudget(uint64_t budgetBytes) { residency.setBudget(budgetBytes); }
+
+TextureStreamStats TextureStreamer::getStats() { return residency.getStats(); }
+
+bool TextureStreamer::upload(uint32_t texture, uint32_t residentMip) {
+    // The callback may run after the streamer is gone, so it holds on to the texture itself
+    std::shared_ptr<StreamedTexture> shared = textures[texture];
+    const KTX2Texture& source               = *shared->source;
+
+    bool created = graphicsContext->createCompressedTextureAsync(
+        source.format, source.width, source.height, source.mips,
+        [shared](std::shared_ptr<Texture> uploaded) {
+            shared->retired = shared->texture->get();
+            shared->texture->swap(uploaded);
+            shared->swapped = true;
+
+            if (shared->onResident) {
+                shared->onResident();
+                shared->onResident = nullptr;
+            }
+        },
+        residentMip);
+    if (!created) {
+        Logger::renderer_logger->warn("Couldn't create texture {0} from mip {1}, trying later",
+                                      shared->name, residentMip);
+        return false;
+    }
+
+    TextureStreamStats stats = residency.getStats();
+    Logger::renderer_logger->info(
+        "Streaming texture {0} from mip {1}, {2}x{3}, {4:.2f} of {5:.2f} MB taken", shared->name,
+        residentMip, std::max(source.width >> residentMip, 1u),
+        std::max(source.height >> residentMip, 1u),
+        (stats.residentBytes + stats.uploadingBytes + stats.retiredBytes) / (1024.0 * 1024.0),
+        stats.budgetBytes / (1024.0 * 1024.0));
+
+    return true;
+}
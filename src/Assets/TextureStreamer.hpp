@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AssetManager.hpp"
+#include "TextureResidency.hpp"
+
+// Keeps more texture data around than the GPU has to hold. Every mip of a streamed texture stays
+// in host memory, the GPU only holds the mips from its resident mip down, starting with the ones of
+// at most RESIDENT_TAIL_SIZE texels. Textures are told how many texels they need each frame, finer
+// mips are uploaded for the ones that need them, a mip at a time. When they don't fit the budget
+// the finest mips of the least recently used textures are evicted first
+//
+// Images can't give back part of their memory without sparse residency, so each change recreates
+// the texture with its new mips and swaps it into the asset. The old one lives on until the
+// descriptor sets stop using it, TextureResidency counts it against the budget until then
+class TextureStreamer {
+public:
+    TextureStreamer(GraphicsContext* graphicsContext, uint64_t budgetBytes);
+
+    ~TextureStreamer();
+
+    // Takes over the texture, its smallest mips are uploaded on the next update and onResident runs
+    // once they're swapped into the asset. On the main thread
+    void add(std::shared_ptr<Asset<Texture>> texture, const std::string& name,
+             std::shared_ptr<KTX2Texture> mips, std::function<void()> onResident);
+
+    // Marks the texture used this frame, needing texels across its larger side. The largest
+    // request of a frame wins, textures that aren't streamed are ignored
+    void requestTexels(std::shared_ptr<Asset<Texture>> texture, float texels);
+
+    // Once per frame on the main thread, after AssetManager::update. Evicts until the textures fit
+    // the budget and uploads the finer mips requested since the last call that fit. Changes that
+    // don't fit next to the images still being freed wait for a later call
+    void update();
+
+    void setBudget(uint64_t budgetBytes);
+
+    TextureStreamStats getStats();
+
+private:
+    struct StreamedTexture {
+        std::shared_ptr<Asset<Texture>> texture;
+        std::string name;
+        std::shared_ptr<KTX2Texture> source;
+        // Runs once the tail is swapped in
+        std::function<void()> onResident;
+        // Set by the upload callback, handed to the residency on the next update
+        bool swapped;
+        // What the last swap replaced, its memory is freed once this expires
+        std::weak_ptr<Texture> retired;
+    };
+
+    // Uploads the mips from residentMip down and swaps them in once they're there. Returns false
+    // when the image couldn't be created
+    bool upload(uint32_t texture, uint32_t residentMip);
+
+    GraphicsContext* graphicsContext;
+
+    TextureResidency residency;
+
+    // Indexed like the residency's textures, shared with the upload callbacks
+    std::vector<std::shared_ptr<StreamedTexture>> textures;
+    std::map<Asset<Texture>*, uint32_t> texturesByAsset;
+};
@@ -0,0 +1,253 @@
+#include "../pch.hpp"
+#include "JobSystem.hpp"
+
+#include "../Logger.hpp"
+
+// Which system and queue the calling thread belongs to
+thread_local JobSystem* threadJobSystem = nullptr;
+thread_local uint32_t threadQueueIndex  = 0;
+
+JobCounter::JobCounter() : pending(0) {}
+
+JobCounter::~JobCounter() {
+    // The last finish may still hold the lock after the count reached zero
+    std::lock_guard<std::mutex> lock(continuationMutex);
+}
+
+bool JobCounter::isDone() { return pending.load() == 0; }
+
+JobSystem::JobSystem(uint32_t workerCount)
+    : mainThreadId(std::this_thread::get_id()), queuedCount(0), stopping(false), nextQueue(0) {
+    for (uint32_t i = 0; i < workerCount + 1; i++) {
+        queues.push_back(std::make_unique<JobQueue>());
+    }
+
+    threadJobSystem  = this;
+    threadQueueIndex = 0;
+
+    for (uint32_t i = 1; i < workerCount + 1; i++) {
+        workers.emplace_back(&JobSystem::work, this, i);
+    }
+
+    Logger::main_logger->info("Job system running on {0} threads", workerCount + 1);
+}
+
+JobSystem::~JobSystem() {
+    Logger::main_logger->info("Destroying Job System");
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (queuedCount > 0) {
+        Logger::main_logger->warn("{0} jobs were never run", queuedCount.load());
+    }
+
+    threadJobSystem = nullptr;
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter* counter) {
+    if (counter != nullptr) {
+        counter->pending++;
+    }
+
+    push({ std::move(job), counter });
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> job,
+                         JobCounter* counter) {
+    if (counter != nullptr) {
+        counter->pending++;
+    }
+
+    // finish counts down and takes the continuations under the same lock, so either it sees this
+    // one or this sees zero
+    {
+        std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+        if (dependency.pending > 0) {
+            dependency.continuations.push_back({ std::move(job), counter });
+            return;
+        }
+    }
+
+    push({ std::move(job), counter });
+}
+
+void JobSystem::runOnMainThread(std::function<void()> job, JobCounter* counter) {
+    if (counter != nullptr) {
+        counter->pending++;
+    }
+
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadJobs.push_back({ std::move(job), counter });
+}
+
+void JobSystem::runMainThreadJobs() {
+    if (!isMainThread()) {
+        Logger::main_logger->error("Running main thread jobs from another thread");
+        return;
+    }
+
+    while (runMainThreadJob()) {
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    bool mainThread = isMainThread();
+    int32_t index   = currentQueueIndex();
+
+    while (!counter.isDone()) {
+        if (mainThread && runMainThreadJob()) {
+            continue;
+        }
+
+        if (index >= 0 && runJob((uint32_t)index)) {
+            continue;
+        }
+
+        // What is left runs elsewhere
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t rangeSize,
+                            const std::function<void(uint32_t, uint32_t)>& function) {
+    if (count == 0) {
+        return;
+    }
+
+    rangeSize = std::max(rangeSize, 1u);
+
+    JobCounter counter;
+    for (uint32_t first = rangeSize; first < count; first += rangeSize) {
+        uint32_t rangeCount = std::min(rangeSize, count - first);
+        run([&function, first, rangeCount]() { function(first, rangeCount); }, &counter);
+    }
+
+    function(0, std::min(rangeSize, count));
+    wait(counter);
+}
+
+uint32_t JobSystem::getThreadCount() { return (uint32_t)queues.size(); }
+
+bool JobSystem::isMainThread() { return std::this_thread::get_id() == mainThreadId; }
+
+void JobSystem::push(QueuedJob job) {
+    int32_t index = currentQueueIndex();
+    if (index < 0) {
+        index = int32_t(nextQueue++ % queues.size());
+    }
+
+    // Counted first, so taking the job can't count below zero
+    queuedCount++;
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(std::move(job));
+    }
+
+    // A worker between checking for jobs and falling asleep holds the mutex, so taking it here
+    // means the notify can't slip in between
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wakeCondition.notify_one();
+}
+
+bool JobSystem::runJob(uint32_t queueIndex) {
+    QueuedJob job;
+    bool found = false;
+
+    {
+        JobQueue& queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    for (uint32_t i = 1; !found && i < queues.size(); i++) {
+        JobQueue& queue = *queues[(queueIndex + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    queuedCount--;
+    job.function();
+    finish(job.counter);
+
+    return true;
+}
+
+bool JobSystem::runMainThreadJob() {
+    QueuedJob job;
+
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        if (mainThreadJobs.empty()) {
+            return false;
+        }
+
+        job = std::move(mainThreadJobs.front());
+        mainThreadJobs.pop_front();
+    }
+
+    job.function();
+    finish(job.counter);
+
+    return true;
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (counter == nullptr) {
+        return;
+    }
+
+    // Counting down under the lock keeps the counter alive until it is released, see ~JobCounter
+    std::vector<std::pair<std::function<void()>, JobCounter*>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->continuationMutex);
+        if (--counter->pending > 0) {
+            return;
+        }
+        continuations.swap(counter->continuations);
+    }
+
+    for (auto& continuation : continuations) {
+        push({ std::move(continuation.first), continuation.second });
+    }
+}
+
+void JobSystem::work(uint32_t queueIndex) {
+    threadJobSystem  = this;
+    threadQueueIndex = queueIndex;
+
+    while (true) {
+        if (runJob(queueIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return stopping || queuedCount > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+int32_t JobSystem::currentQueueIndex() {
+    return (threadJobSystem == this) ? (int32_t)threadQueueIndex : -1;
+}
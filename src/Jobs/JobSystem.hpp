@@ -0,0 +1,101 @@
+#pragma once
+#include "../pch.hpp"
+
+// Counts the unfinished jobs started with it. Has to outlive them, so wait on it before it goes
+class JobCounter {
+public:
+    JobCounter();
+
+    ~JobCounter();
+
+    bool isDone();
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending;
+
+    // Jobs started with runAfter, queued once pending drops to zero
+    std::mutex continuationMutex;
+    std::vector<std::pair<std::function<void()>, JobCounter*>> continuations;
+};
+
+// Work stealing scheduler shared by everything that runs in parallel. Every thread has its own
+// queue, it takes its newest job first and steals the oldest job of another queue when it runs
+// dry. The thread that creates the system is the main thread, it runs jobs whenever it waits and
+// is the only one running the jobs bound to it, like GLFW calls and graphics context uploads
+class JobSystem {
+public:
+    JobSystem(uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    ~JobSystem();
+
+    // counter counts the job until it is done
+    void run(std::function<void()> job, JobCounter* counter = nullptr);
+
+    // Starts the job once dependency has nothing left running
+    void runAfter(JobCounter& dependency, std::function<void()> job,
+                  JobCounter* counter = nullptr);
+
+    // Runs the job on the main thread, next time it waits or calls runMainThreadJobs
+    void runOnMainThread(std::function<void()> job, JobCounter* counter = nullptr);
+
+    // Only on the main thread, once per frame so jobs handed to it don't sit around
+    void runMainThreadJobs();
+
+    // Runs other jobs until the counter is done
+    void wait(JobCounter& counter);
+
+    // Calls function with the first index and the count of every range of at most rangeSize out
+    // of count, in parallel. The calling thread takes the first range and returns once all are done
+    void parallelFor(uint32_t count, uint32_t rangeSize,
+                     const std::function<void(uint32_t, uint32_t)>& function);
+
+    // Workers and the main thread
+    uint32_t getThreadCount();
+
+    bool isMainThread();
+
+private:
+    struct QueuedJob {
+        std::function<void()> function;
+        JobCounter* counter;
+    };
+
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+    };
+
+    void push(QueuedJob job);
+
+    // Own newest first, then the oldest of the others. Returns whether a job ran
+    bool runJob(uint32_t queueIndex);
+
+    bool runMainThreadJob();
+
+    void finish(JobCounter* counter);
+
+    void work(uint32_t queueIndex);
+
+    // Of the calling thread, or -1 for threads outside of this system
+    int32_t currentQueueIndex();
+
+    std::thread::id mainThreadId;
+
+    // The main thread's first, then one per worker
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mainThreadMutex;
+    std::deque<QueuedJob> mainThreadJobs;
+
+    // Workers sleep while nothing is queued
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<uint32_t> queuedCount;
+    std::atomic<bool> stopping;
+
+    // Spreads jobs from threads outside of this system over the queues
+    std::atomic<uint32_t> nextQueue;
+};
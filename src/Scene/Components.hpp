@@ -0,0 +1,44 @@
+#pragma once
+#include "../pch.hpp"
+
+// Relative to the parent, or to the world for roots. Changed through Scene::setTransform so the
+// dirty flags are kept up
+struct TransformComponent {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale    = glm::vec3(1.0f);
+
+    // The world matrix has to be recomputed
+    bool dirty = true;
+    // Somewhere below is dirty, propagation skips subtrees without either flag
+    bool descendantDirty = false;
+};
+
+struct WorldTransformComponent {
+    glm::mat4 matrix = glm::mat4(1.0f);
+};
+
+// Children form a linked list through their siblings
+struct HierarchyComponent {
+    entt::entity parent      = entt::null;
+    entt::entity firstChild  = entt::null;
+    entt::entity nextSibling = entt::null;
+};
+
+struct MeshComponent {
+    uint32_t meshIndex;
+};
+
+struct MaterialComponent {
+    uint32_t materialIndex;
+};
+
+// Object space center in xyz and radius in w
+struct BoundsComponent {
+    glm::vec4 boundingSphere;
+};
+
+// Where the entity sits in the scene's objects
+struct RenderableComponent {
+    uint32_t objectIndex;
+};
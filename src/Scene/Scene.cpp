@@ -0,0 +1,180 @@
+#include "../pch.hpp"
+#include "Scene.hpp"
+
+#include "../Logger.hpp"
+
+// Below this many entities per job handing them out costs more than it saves
+constexpr uint32_t MIN_ENTITIES_PER_JOB = 4096;
+
+glm::mat4 localMatrix(const TransformComponent& transform) {
+    glm::mat4 matrix = glm::mat4_cast(transform.rotation);
+    matrix[0] *= transform.scale.x;
+    matrix[1] *= transform.scale.y;
+    matrix[2] *= transform.scale.z;
+    matrix[3] = glm::vec4(transform.position, 1.0f);
+
+    return matrix;
+}
+
+// Storages are fetched once up front, looking them up in the registry isn't safe from several
+// threads while touching separate components of them is
+struct PropagationStorages {
+    entt::storage_for_t<TransformComponent>& transforms;
+    entt::storage_for_t<WorldTransformComponent>& worldTransforms;
+    entt::storage_for_t<HierarchyComponent>& hierarchies;
+    entt::storage_for_t<RenderableComponent>& renderables;
+    CullObject* objects;
+};
+
+uint32_t propagateSubtree(PropagationStorages& storages, entt::entity entity,
+                          const glm::mat4& parentMatrix, bool parentChanged) {
+    TransformComponent& transform = storages.transforms.get(entity);
+    if (!parentChanged && !transform.dirty && !transform.descendantDirty) {
+        return 0;
+    }
+
+    uint32_t updatedCount = 0;
+
+    glm::mat4& worldMatrix = storages.worldTransforms.get(entity).matrix;
+    bool changed           = parentChanged || transform.dirty;
+    if (changed) {
+        worldMatrix = parentMatrix * localMatrix(transform);
+        if (storages.renderables.contains(entity)) {
+            storages.objects[storages.renderables.get(entity).objectIndex].model = worldMatrix;
+        }
+        updatedCount++;
+    }
+    transform.dirty           = false;
+    transform.descendantDirty = false;
+
+    entt::entity child = storages.hierarchies.get(entity).firstChild;
+    while (child != entt::null) {
+        updatedCount += propagateSubtree(storages, child, worldMatrix, changed);
+        child = storages.hierarchies.get(child).nextSibling;
+    }
+
+    return updatedCount;
+}
+
+Scene::Scene(JobSystem* jobSystem) : jobSystem(jobSystem), transformStats() {}
+
+Scene::~Scene() { Logger::ecs_logger->info("Destroying Scene"); }
+
+entt::entity Scene::createEntity(const TransformComponent& transform, entt::entity parent) {
+    entt::entity entity = registry.create();
+
+    registry.emplace<TransformComponent>(entity, transform);
+    registry.emplace<WorldTransformComponent>(entity);
+
+    HierarchyComponent& hierarchy = registry.emplace<HierarchyComponent>(entity);
+    if (parent == entt::null) {
+        roots.push_back(entity);
+    } else {
+        HierarchyComponent& parentHierarchy = registry.get<HierarchyComponent>(parent);
+        hierarchy.parent                    = parent;
+        hierarchy.nextSibling               = parentHierarchy.firstChild;
+        parentHierarchy.firstChild          = entity;
+    }
+
+    // Let propagation find the new entity below clean ancestors
+    markDirty(entity);
+
+    return entity;
+}
+
+void Scene::addRenderable(entt::entity entity, uint32_t meshIndex, uint32_t materialIndex,
+                          glm::vec4 boundingSphere) {
+    if (registry.all_of<RenderableComponent>(entity)) {
+        Logger::ecs_logger->warn("Entity is already renderable");
+        return;
+    }
+
+    registry.emplace<MeshComponent>(entity, meshIndex);
+    registry.emplace<MaterialComponent>(entity, materialIndex);
+    registry.emplace<BoundsComponent>(entity, boundingSphere);
+    registry.emplace<RenderableComponent>(entity, (uint32_t)objects.size());
+
+    CullObject object     = {};
+    object.model          = registry.get<WorldTransformComponent>(entity).matrix;
+    object.boundingSphere = boundingSphere;
+    object.meshIndex      = meshIndex;
+    object.materialIndex  = materialIndex;
+    objects.push_back(object);
+
+    // The object only gets its matrix from propagation
+    markDirty(entity);
+}
+
+const TransformComponent& Scene::getTransform(entt::entity entity) {
+    return registry.get<TransformComponent>(entity);
+}
+
+void Scene::setTransform(entt::entity entity, const TransformComponent& transform) {
+    TransformComponent& entityTransform = registry.get<TransformComponent>(entity);
+    entityTransform.position            = transform.position;
+    entityTransform.rotation            = transform.rotation;
+    entityTransform.scale               = transform.scale;
+
+    markDirty(entity);
+}
+
+void Scene::markDirty(entt::entity entity) {
+    registry.get<TransformComponent>(entity).dirty = true;
+
+    // Stops at the first ancestor that already knows
+    entt::entity parent = registry.get<HierarchyComponent>(entity).parent;
+    while (parent != entt::null) {
+        TransformComponent& parentTransform = registry.get<TransformComponent>(parent);
+        if (parentTransform.descendantDirty) {
+            break;
+        }
+        parentTransform.descendantDirty = true;
+        parent                          = registry.get<HierarchyComponent>(parent).parent;
+    }
+}
+
+void Scene::propagateTransforms() {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    PropagationStorages storages = {
+        registry.storage<TransformComponent>(), registry.storage<WorldTransformComponent>(),
+        registry.storage<HierarchyComponent>(), registry.storage<RenderableComponent>(),
+        objects.data()
+    };
+
+    dirtyRoots.clear();
+    for (entt::entity root : roots) {
+        const TransformComponent& transform = storages.transforms.get(root);
+        if (transform.dirty || transform.descendantDirty) {
+            dirtyRoots.push_back(root);
+        }
+    }
+
+    // Subtrees can differ in size, the jobs get an even share of roots and steal the rest
+    uint32_t rootCount   = (uint32_t)dirtyRoots.size();
+    uint32_t entityCount = (uint32_t)storages.transforms.size();
+    uint32_t jobCount    = entityCount / MIN_ENTITIES_PER_JOB;
+    jobCount             = std::min(std::min(jobCount, jobSystem->getThreadCount()), rootCount);
+    jobCount             = std::max(jobCount, 1u);
+
+    std::atomic<uint32_t> updatedCount(0);
+    auto propagateRange = [&](uint32_t first, uint32_t count) {
+        uint32_t rangeUpdatedCount = 0;
+        for (uint32_t i = first; i < first + count; i++) {
+            rangeUpdatedCount += propagateSubtree(storages, dirtyRoots[i], glm::mat4(1.0f), false);
+        }
+        updatedCount += rangeUpdatedCount;
+    };
+    jobSystem->parallelFor(rootCount, (rootCount + jobCount - 1) / jobCount, propagateRange);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    transformStats.updatedCount = updatedCount;
+    transformStats.milliseconds = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+const std::vector<CullObject>& Scene::getObjects() { return objects; }
+
+TransformStats Scene::getTransformStats() { return transformStats; }
+
+entt::registry& Scene::getRegistry() { return registry; }
@@ -0,0 +1,59 @@
+#pragma once
+#include "../pch.hpp"
+
+#include "Components.hpp"
+#include "../Jobs/JobSystem.hpp"
+#include "../renderer/Helper/Culling.hpp"
+
+// What the last propagation did
+struct TransformStats {
+    uint32_t updatedCount;
+    float milliseconds;
+};
+
+// Entities in an EnTT registry, ordered into a hierarchy. Renderable entities own an object in a
+// CullObject array the cullers upload from, propagation writes the world matrices straight into it
+class Scene {
+public:
+    Scene(JobSystem* jobSystem);
+
+    ~Scene();
+
+    // Without a parent the entity is a root
+    entt::entity createEntity(const TransformComponent& transform,
+                              entt::entity parent = entt::null);
+
+    // Gives the entity its mesh, material and bounds and an object for them
+    void addRenderable(entt::entity entity, uint32_t meshIndex, uint32_t materialIndex,
+                       glm::vec4 boundingSphere);
+
+    const TransformComponent& getTransform(entt::entity entity);
+
+    // Takes the position, rotation and scale, the flags are kept up by the scene
+    void setTransform(entt::entity entity, const TransformComponent& transform);
+
+    // Recomputes the world matrices below every dirty entity. Roots are independent, so their
+    // subtrees are split between jobs
+    void propagateTransforms();
+
+    // One per renderable entity, in the order they were added
+    const std::vector<CullObject>& getObjects();
+
+    TransformStats getTransformStats();
+
+    entt::registry& getRegistry();
+
+private:
+    // Marks the entity dirty and its ancestors as having a dirty descendant
+    void markDirty(entt::entity entity);
+
+    JobSystem* jobSystem;
+
+    entt::registry registry;
+    std::vector<entt::entity> roots;
+    std::vector<entt::entity> dirtyRoots;
+
+    std::vector<CullObject> objects;
+
+    TransformStats transformStats;
+};
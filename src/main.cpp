@@ -6,9 +6,29 @@
 
 #include "glfw/glfw3.h"
 
+#include "Assets/AssetManager.hpp"
+#include "Assets/TextureStreamer.hpp"
+#include "Jobs/JobSystem.hpp"
+#include "renderer/CommandList.hpp"
+#include "renderer/CPUCuller.hpp"
+#include "renderer/DrawBatcher.hpp"
+#include "renderer/DrawQueue.hpp"
+#include "renderer/GPUCuller.hpp"
 #include "renderer/GraphicsContext.hpp"
+#include "renderer/IBLBaker.hpp"
+#include "renderer/IBLCache.hpp"
+#include "renderer/Helper/SphericalHarmonics.hpp"
+#include "Scene/Scene.hpp"
 #include "Logger.hpp"
 #include "Structures/Mesh/mesh.hpp"
+#include "Structures/Mesh/vertex.hpp"
+
+// Objects the object buffer starts out with, it grows when more are drawn
+constexpr uint32_t INITIAL_OBJECT_CAPACITY = 1024;
+
+// Device memory the streamed textures may take. The material textures need under 3 MB with every
+// mip, a budget below that shows the eviction in the log
+constexpr uint64_t TEXTURE_STREAMING_BUDGET = 256ull * 1024 * 1024;
 
 struct CameraData {
     glm::mat4 view;
@@ -16,18 +36,24 @@ struct CameraData {
     glm::mat4 viewProjection;
 };
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 uv;
+struct SHIrradianceData {
+    SphericalHarmonics irradiance;
+    int enabled;
 };
 
 int main() {
     Logger::init();
 
+    // Created first so this thread is its main thread
+    JobSystem jobSystem;
+
     auto window = Window::create("PBR Demo", 1280, 720);
 
     auto graphicsContext = GraphicsContext::create(window);
+    graphicsContext->useJobSystem(&jobSystem);
+#ifndef NDEBUG
+    graphicsContext->enableShaderHotReload("assets/shaders");
+#endif
 
     auto renderFence      = graphicsContext->createFrameBasedFence(true);
     auto renderSemaphore  = graphicsContext->createFrameBasedSemaphore();
@@ -40,358 +66,49 @@ int main() {
     auto irradianceMap  = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 32, 32);
     auto prefilterMap   = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 128, 128, true);
 
-    {
-        int width, height, numComp;
-        float* hdrData =
-            stbi_loadf("assets/textures/night_stars.hdr", &width, &height, &numComp, 4);
-        auto hdrTexture = graphicsContext->createHDRTexture(width, height, 4, hdrData, false);
-        stbi_image_free(hdrData);
-
-        std::vector<RenderPassAttachmentDescription> equiToCubeAttachments;
-        RenderPassAttachmentDescription equiToCubeAttachment = {};
-        equiToCubeAttachment.loadOp                          = LoadOp::CLEAR;
-        equiToCubeAttachment.storeOp                         = StoreOp::STORE;
-        equiToCubeAttachment.initialLayout                   = ImageLayout::UNDEFINED;
-        equiToCubeAttachment.finalLayout                     = ImageLayout::ATTACHMENT;
-        equiToCubeAttachment.format                          = Format::RGBA16_FLOAT;
-        equiToCubeAttachment.width                           = 512;
-        equiToCubeAttachment.height                          = 512;
-        equiToCubeAttachments.push_back(equiToCubeAttachment);
-        auto equiToCubeRenderPass = graphicsContext->createRenderPass(equiToCubeAttachments, false);
-
-        PipelineCreateInfo equiToCubePipelineCreateInfo = {};
-        equiToCubePipelineCreateInfo.vertexShaderPath   = "assets/shaders/equiToCube.vert";
-        equiToCubePipelineCreateInfo.fragmentShaderPath = "assets/shaders/equiToCube.frag";
-        equiToCubePipelineCreateInfo.viewportWidth      = 512;
-        equiToCubePipelineCreateInfo.viewportHeight     = 512;
-        equiToCubePipelineCreateInfo.culling            = false;
-        equiToCubePipelineCreateInfo.depthTesting       = false;
-        equiToCubePipelineCreateInfo.depthWrite         = true;
-        equiToCubePipelineCreateInfo.renderPass         = equiToCubeRenderPass;
-        auto equiToCubePipeline = graphicsContext->createPipeline(&equiToCubePipelineCreateInfo);
-
-        auto equiTextureSet = graphicsContext->createDescriptorSet(equiToCubePipeline, 0);
-        graphicsContext->descriptorSetAddImage(equiTextureSet, 0, hdrTexture);
-
-        Mesh cubeMesh                    = Mesh::loadFromObj("assets/models/cube.obj");
-        std::vector<Vertex> cubeVertices = std::vector<Vertex>();
-        for (auto vertex : cubeMesh.vertices) {
-            cubeVertices.push_back({ vertex.position, vertex.normal, vertex.uv });
-        }
-
-        auto cubeVertexBuffer = graphicsContext->createVertexBuffer(
-            cubeVertices.data(), uint32_t(cubeVertices.size() * sizeof(Vertex)));
+    auto brdfLUT = graphicsContext->createStorageTexture(Format::RG16_FLOAT, 512, 512);
 
-        auto equiToCubeCommandBuffer = graphicsContext->createCommandBuffer();
-
-        // Environment Map
-        graphicsContext->beginRecording(equiToCubeCommandBuffer);
-
-        for (int i = 0; i < 6; i++) {
-            glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-            captureProjection[1][1] *= -1;
-            glm::mat4 viewMatrix(1.0f);
-            switch (i) {
-            case 0: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            case 1: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            case 2: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
-                                         glm::vec3(0.0f, 0.0f, -1.0f));
-
-                break;
-            }
-            case 3: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
-                                         glm::vec3(0.0f, 0.0f, 1.0f));
-                break;
-            }
-            case 4: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            case 5: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            }
-            viewMatrix = captureProjection * viewMatrix;
-
-            graphicsContext->beginRenderPass(equiToCubeCommandBuffer, equiToCubeRenderPass, 512,
-                                             512);
-            graphicsContext->bindPipeline(equiToCubeCommandBuffer, equiToCubePipeline);
-            graphicsContext->bindVertexBuffer(equiToCubeCommandBuffer, cubeVertexBuffer);
-            graphicsContext->pushConstants(equiToCubeCommandBuffer, equiToCubePipeline, 0,
-                                           sizeof(glm::mat4), &viewMatrix);
-            graphicsContext->bindDescriptorSet(equiToCubeCommandBuffer, 0, equiTextureSet);
-            graphicsContext->draw(equiToCubeCommandBuffer, (uint32_t)cubeVertices.size(), 1, 0, 0);
-            graphicsContext->endRenderPass(equiToCubeCommandBuffer);
-
-            graphicsContext->transitionRenderPassImages(
-                equiToCubeCommandBuffer, equiToCubeRenderPass, ImageLayout::ATTACHMENT,
-                ImageLayout::TRANSFER_SRC);
-
-            graphicsContext->copyRenderPassImageToCubemap(
-                equiToCubeCommandBuffer, equiToCubeRenderPass, 0, environmentMap, i, 0, 512, 512);
-        }
+    // Alternative to the irradiance map, evaluated analytically in pbr.frag
+    SphericalHarmonics irradianceSH = {};
 
-        graphicsContext->endRecording(equiToCubeCommandBuffer);
-        graphicsContext->immediateSubmit(equiToCubeCommandBuffer);
-
-        // Irradiance Map
-        std::vector<RenderPassAttachmentDescription> convolutionRenderPassAttachments;
-        RenderPassAttachmentDescription convolutionMainAttachment = {};
-        convolutionMainAttachment.loadOp                          = LoadOp::CLEAR;
-        convolutionMainAttachment.storeOp                         = StoreOp::STORE;
-        convolutionMainAttachment.initialLayout                   = ImageLayout::UNDEFINED;
-        convolutionMainAttachment.finalLayout                     = ImageLayout::ATTACHMENT;
-        convolutionMainAttachment.format                          = Format::RGBA16_FLOAT;
-        convolutionMainAttachment.width                           = 32;
-        convolutionMainAttachment.height                          = 32;
-        convolutionRenderPassAttachments.push_back(convolutionMainAttachment);
-        auto convolutionRenderPass =
-            graphicsContext->createRenderPass(convolutionRenderPassAttachments, false);
-
-        PipelineCreateInfo convolutionPipelineCreateInfo = {};
-        convolutionPipelineCreateInfo.vertexShaderPath   = "assets/shaders/convolution.vert";
-        convolutionPipelineCreateInfo.fragmentShaderPath = "assets/shaders/convolution.frag";
-        convolutionPipelineCreateInfo.viewportWidth      = 32;
-        convolutionPipelineCreateInfo.viewportHeight     = 32;
-        convolutionPipelineCreateInfo.culling            = false;
-        convolutionPipelineCreateInfo.depthTesting       = true;
-        convolutionPipelineCreateInfo.depthWrite         = true;
-        convolutionPipelineCreateInfo.renderPass         = convolutionRenderPass;
-        auto convolutionPipeline = graphicsContext->createPipeline(&convolutionPipelineCreateInfo);
-
-        auto environmentMapDescriptorSet =
-            graphicsContext->createDescriptorSet(convolutionPipeline, 0);
-        graphicsContext->descriptorSetAddImage(environmentMapDescriptorSet, 0, environmentMap);
-
-        graphicsContext->beginRecording(equiToCubeCommandBuffer);
-
-        for (int i = 0; i < 6; i++) {
-            glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-            glm::mat4 viewMatrix(1.0f);
-            switch (i) {
-            case 0: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            case 1: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            case 2: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
-                                         glm::vec3(0.0f, 0.0f, 1.0f));
-                break;
-            }
-            case 3: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
-                                         glm::vec3(0.0f, 0.0f, -1.0f));
-                break;
-            }
-            case 4: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            case 5: {
-                viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
-                                         glm::vec3(0.0f, -1.0f, 0.0f));
-                break;
-            }
-            }
-
-            viewMatrix = captureProjection * viewMatrix;
-
-            graphicsContext->beginRenderPass(equiToCubeCommandBuffer, convolutionRenderPass, 32,
-                                             32);
-            graphicsContext->bindPipeline(equiToCubeCommandBuffer, convolutionPipeline);
-            graphicsContext->bindDescriptorSet(equiToCubeCommandBuffer, 0,
-                                               environmentMapDescriptorSet);
-            graphicsContext->pushConstants(equiToCubeCommandBuffer, convolutionPipeline, 0,
-                                           sizeof(glm::mat4), &viewMatrix);
-            graphicsContext->bindVertexBuffer(equiToCubeCommandBuffer, cubeVertexBuffer);
-
-            graphicsContext->draw(equiToCubeCommandBuffer, (uint32_t)cubeVertices.size(), 1, 0, 0);
-
-            graphicsContext->endRenderPass(equiToCubeCommandBuffer);
-
-            graphicsContext->transitionRenderPassImages(
-                equiToCubeCommandBuffer, convolutionRenderPass, ImageLayout::ATTACHMENT,
-                ImageLayout::TRANSFER_SRC);
-
-            graphicsContext->copyRenderPassImageToCubemap(
-                equiToCubeCommandBuffer, convolutionRenderPass, 0, irradianceMap, i, 0, 32, 32);
+    // Bake the image based lighting textures, or upload them from the cache of an earlier launch
+    {
+        double iblStartTime = glfwGetTime();
+
+        const char* hdrPath = "assets/textures/night_stars.hdr";
+
+        std::vector<std::shared_ptr<Texture>> iblTextures = { environmentMap, irradianceMap,
+                                                              prefilterMap, brdfLUT };
+
+        IBLCache iblCache(graphicsContext.get());
+        uint64_t iblKey = iblCache.key(hdrPath, iblTextures);
+        std::vector<float> iblValues;
+        bool cached = iblCache.load(iblKey, iblTextures, iblValues) &&
+                      iblValues.size() * sizeof(float) == sizeof(SphericalHarmonics);
+        if (cached) {
+            memcpy(&irradianceSH, iblValues.data(), sizeof(SphericalHarmonics));
+        } else {
+            int width, height, numComp;
+            float* hdrData  = stbi_loadf(hdrPath, &width, &height, &numComp, 4);
+            // Only its RGB is sampled, so the packed format loses nothing but precision
+            auto hdrTexture = graphicsContext->createHDRTexture(width, height, 4, hdrData, false,
+                                                                Format::B10G11R11_UFLOAT);
+            irradianceSH    = helper::irradianceSHFromRadiance(
+                helper::projectEquirectangularToSH(hdrData, width, height));
+            stbi_image_free(hdrData);
+
+            IBLBaker iblBaker(graphicsContext.get());
+            iblBaker.bake(hdrTexture, environmentMap, irradianceMap, prefilterMap);
+            iblBaker.bakeBRDF(brdfLUT);
+
+            const float* shValues = reinterpret_cast<const float*>(&irradianceSH);
+            iblValues.assign(shValues, shValues + sizeof(SphericalHarmonics) / sizeof(float));
+            iblCache.store(iblKey, iblTextures, iblValues);
         }
 
-        graphicsContext->endRecording(equiToCubeCommandBuffer);
-        graphicsContext->immediateSubmit(equiToCubeCommandBuffer);
-
-        // Prefilter Map
-        std::vector<RenderPassAttachmentDescription> prefilterAttachments;
-        RenderPassAttachmentDescription prefilterAttachment = {};
-        prefilterAttachment.loadOp                          = LoadOp::CLEAR;
-        prefilterAttachment.storeOp                         = StoreOp::STORE;
-        prefilterAttachment.initialLayout                   = ImageLayout::UNDEFINED;
-        prefilterAttachment.finalLayout                     = ImageLayout::ATTACHMENT;
-        prefilterAttachment.format                          = Format::RGBA16_FLOAT;
-        prefilterAttachment.width                           = 128;
-        prefilterAttachment.height                          = 128;
-        prefilterAttachments.push_back(prefilterAttachment);
-        auto prefilterRenderPass = graphicsContext->createRenderPass(prefilterAttachments, false);
-
-        PipelineCreateInfo prefilterPipelineCreateInfo = {};
-        prefilterPipelineCreateInfo.vertexShaderPath   = "assets/shaders/prefilter.vert";
-        prefilterPipelineCreateInfo.fragmentShaderPath = "assets/shaders/prefilter.frag";
-        prefilterPipelineCreateInfo.viewportWidth      = 128;
-        prefilterPipelineCreateInfo.viewportHeight     = 128;
-        prefilterPipelineCreateInfo.culling            = false;
-        prefilterPipelineCreateInfo.depthTesting       = true;
-        prefilterPipelineCreateInfo.depthWrite         = true;
-        prefilterPipelineCreateInfo.renderPass         = prefilterRenderPass;
-        auto prefilterPipeline = graphicsContext->createPipeline(&prefilterPipelineCreateInfo);
-        auto environmentDescriptorSetPrefilter =
-            graphicsContext->createDescriptorSet(prefilterPipeline, 0);
-        graphicsContext->descriptorSetAddImage(environmentDescriptorSetPrefilter, 0,
-                                               environmentMap);
-
-        graphicsContext->beginRecording(equiToCubeCommandBuffer);
-
-        struct PrefilterPushConstants {
-            glm::mat4 view;
-            float roughness;
-        };
-
-        unsigned int maxMipLevels = 5;
-        for (unsigned int mipLevel = 0; mipLevel < maxMipLevels; mipLevel++) {
-            for (int cubeFace = 0; cubeFace < 6; cubeFace++) {
-                glm::mat4 captureProjection =
-                    glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-                glm::mat4 viewMatrix(1.0f);
-                switch (cubeFace) {
-                case 0: {
-                    viewMatrix =
-                        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
-                                    glm::vec3(0.0f, -1.0f, 0.0f));
-                    break;
-                }
-                case 1: {
-                    viewMatrix =
-                        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
-                                    glm::vec3(0.0f, -1.0f, 0.0f));
-                    break;
-                }
-                case 2: {
-                    viewMatrix =
-                        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
-                                    glm::vec3(0.0f, 0.0f, 1.0f));
-                    break;
-                }
-                case 3: {
-                    viewMatrix =
-                        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
-                                    glm::vec3(0.0f, 0.0f, -1.0f));
-                    break;
-                }
-                case 4: {
-                    viewMatrix =
-                        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
-                                    glm::vec3(0.0f, -1.0f, 0.0f));
-                    break;
-                }
-                case 5: {
-                    viewMatrix =
-                        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
-                                    glm::vec3(0.0f, -1.0f, 0.0f));
-                    break;
-                }
-                }
-                viewMatrix = captureProjection * viewMatrix;
-                PrefilterPushConstants pushConstants;
-                pushConstants.view      = viewMatrix;
-                pushConstants.roughness = (float)mipLevel / (float)(maxMipLevels - 1);
-
-                graphicsContext->beginRenderPass(equiToCubeCommandBuffer, prefilterRenderPass, 128,
-                                                 128);
-                graphicsContext->bindPipeline(equiToCubeCommandBuffer, prefilterPipeline);
-                graphicsContext->bindDescriptorSet(equiToCubeCommandBuffer, 0,
-                                                   environmentDescriptorSetPrefilter);
-                graphicsContext->pushConstants(equiToCubeCommandBuffer, prefilterPipeline, 0,
-                                               sizeof(PrefilterPushConstants), &pushConstants);
-                graphicsContext->bindVertexBuffer(equiToCubeCommandBuffer, cubeVertexBuffer);
-                graphicsContext->draw(equiToCubeCommandBuffer, (uint32_t)cubeVertices.size(), 1, 0,
-                                      0);
-
-                graphicsContext->endRenderPass(equiToCubeCommandBuffer);
-
-                graphicsContext->transitionRenderPassImages(
-                    equiToCubeCommandBuffer, prefilterRenderPass, ImageLayout::ATTACHMENT,
-                    ImageLayout::TRANSFER_SRC);
-
-                unsigned int mipWidth  = (unsigned int)(128 * std::pow(0.5, mipLevel));
-                unsigned int mipHeight = (unsigned int)(128 * std::pow(0.5, mipLevel));
-
-                graphicsContext->blitRenderPassImageToCubemap(
-                    equiToCubeCommandBuffer, prefilterRenderPass, 0, prefilterMap, cubeFace,
-                    mipLevel, 128, 128, mipWidth, mipHeight);
-            }
-        }
-        graphicsContext->endRecording(equiToCubeCommandBuffer);
-        graphicsContext->immediateSubmit(equiToCubeCommandBuffer);
-    }
-
-    // Create the BRDF Image
-    std::vector<RenderPassAttachmentDescription> brdfAttachments;
-    RenderPassAttachmentDescription brdfAttachment = {};
-    brdfAttachment.loadOp                          = LoadOp::CLEAR;
-    brdfAttachment.storeOp                         = StoreOp::STORE;
-    brdfAttachment.initialLayout                   = ImageLayout::UNDEFINED;
-    brdfAttachment.finalLayout                     = ImageLayout::ATTACHMENT;
-    brdfAttachment.format                          = Format::RG16_FLOAT;
-    brdfAttachment.width                           = 512;
-    brdfAttachment.height                          = 512;
-    brdfAttachments.push_back(brdfAttachment);
-    auto brdfRenderPass = graphicsContext->createRenderPass(brdfAttachments, false);
-
-    {
-        PipelineCreateInfo brdfPipelineCreateInfo = {};
-        brdfPipelineCreateInfo.vertexShaderPath   = "assets/shaders/brdf.vert";
-        brdfPipelineCreateInfo.fragmentShaderPath = "assets/shaders/brdf.frag";
-        brdfPipelineCreateInfo.viewportWidth      = 512;
-        brdfPipelineCreateInfo.viewportHeight     = 512;
-        brdfPipelineCreateInfo.culling            = false;
-        brdfPipelineCreateInfo.depthTesting       = true;
-        brdfPipelineCreateInfo.depthWrite         = true;
-        brdfPipelineCreateInfo.renderPass         = brdfRenderPass;
-        auto brdfPipeline = graphicsContext->createPipeline(&brdfPipelineCreateInfo);
-
-        auto brdfCommandBuffer = graphicsContext->createCommandBuffer();
-
-        graphicsContext->beginRecording(brdfCommandBuffer);
-        graphicsContext->beginRenderPass(brdfCommandBuffer, brdfRenderPass, 512, 512);
-        graphicsContext->bindPipeline(brdfCommandBuffer, brdfPipeline);
-        graphicsContext->draw(brdfCommandBuffer, 3, 1, 0, 0);
-        graphicsContext->endRenderPass(brdfCommandBuffer);
-
-        graphicsContext->transitionRenderPassImages(
-            brdfCommandBuffer, brdfRenderPass, ImageLayout::ATTACHMENT, ImageLayout::SHADER_READ);
-
-        graphicsContext->endRecording(brdfCommandBuffer);
-
-        graphicsContext->immediateSubmit(brdfCommandBuffer);
+        Logger::main_logger->info("IBL textures ready in {0} ms ({1})",
+                                  (glfwGetTime() - iblStartTime) * 1000.0,
+                                  cached ? "cached" : "baked");
     }
 
     // Create the main forward render pass
@@ -429,32 +146,41 @@ int main() {
                                             sizeof(CameraData));
     graphicsContext->descriptorSetAddImage(cameraDescriptorSet, 1, irradianceMap);
     graphicsContext->descriptorSetAddImage(cameraDescriptorSet, 2, prefilterMap);
-    graphicsContext->descriptorSetAddRenderPassAttachment(cameraDescriptorSet, 3, brdfRenderPass,
-                                                          0);
+    graphicsContext->descriptorSetAddImage(cameraDescriptorSet, 3, brdfLUT);
+    graphicsContext->descriptorSetAddBuffer(cameraDescriptorSet, 4, DescriptorType::UNIFORM_BUFFER,
+                                            sizeof(SHIrradianceData));
 
     auto objectsDescriptorSet = graphicsContext->createDescriptorSet(pbrPipeline, 1);
     graphicsContext->descriptorSetAddBuffer(objectsDescriptorSet, 0, DescriptorType::STORAGE_BUFFER,
-                                            sizeof(glm::mat4) * 10000);
+                                            sizeof(CullObject) * INITIAL_OBJECT_CAPACITY);
 
     auto colorDescriptorSet = graphicsContext->createDescriptorSet(pbrPipeline, 2);
-    int width, height, numComponents;
-    unsigned char* grassData =
-        stbi_load("assets/textures/metal.jpg", &width, &height, &numComponents, 4);
-    auto grassTexture =
-        graphicsContext->createTexture(width, height, 4, ColorSpace::SRGB, grassData, true);
-    graphicsContext->descriptorSetAddImage(colorDescriptorSet, 0, grassTexture);
-    unsigned char* materialData =
-        stbi_load("assets/textures/metal_scratch_mat.png", &width, &height, &numComponents, 4);
-    auto materialTexture =
-        graphicsContext->createTexture(width, height, 4, ColorSpace::LINEAR, materialData, true);
-    graphicsContext->descriptorSetAddImage(colorDescriptorSet, 1, materialTexture);
-    unsigned char* normalData =
-        stbi_load("assets/textures/metal_scratch_normal.jpg", &width, &height, &numComponents, 4);
-    auto normalTexture =
-        graphicsContext->createTexture(width, height, 4, ColorSpace::LINEAR, normalData, true);
-    graphicsContext->descriptorSetAddImage(colorDescriptorSet, 2, normalTexture);
-
-    Mesh renderMesh                      = Mesh::loadFromGltf("assets/models/monkey.glb");
+
+    // The textures stream in while the first frames render with placeholders, starting with
+    // their smallest mips. Finer ones follow as the camera gets close
+    AssetManager assetManager(graphicsContext.get(), &jobSystem);
+    TextureStreamer textureStreamer(graphicsContext.get(), TEXTURE_STREAMING_BUDGET);
+    assetManager.useTextureStreamer(&textureStreamer);
+    std::vector<std::shared_ptr<Asset<Texture>>> materialTextures = {
+        assetManager.loadTexture("assets/textures/metal.jpg", ColorSpace::SRGB),
+        assetManager.loadTexture("assets/textures/metal_scratch_mat.png", ColorSpace::LINEAR,
+                                 TextureContent::TWO_CHANNEL),
+        assetManager.loadTexture("assets/textures/metal_scratch_normal.jpg", ColorSpace::LINEAR,
+                                 TextureContent::NORMAL_MAP)
+    };
+    for (uint32_t binding = 0; binding < materialTextures.size(); binding++) {
+        assetManager.bindTexture(materialTextures[binding], colorDescriptorSet, binding);
+    }
+
+    // The meshes are waited on, the culler mesh tables and bounds are built from them
+    JobCounter loadCounter;
+    Mesh renderMesh;
+    Mesh cubeMesh;
+    jobSystem.run([&]() { renderMesh = Mesh::loadFromGltf("assets/models/monkey.glb"); },
+                  &loadCounter);
+    jobSystem.run([&]() { cubeMesh = Mesh::loadFromObj("assets/models/cube.obj"); }, &loadCounter);
+    jobSystem.wait(loadCounter);
+
     std::vector<MeshVertex> meshVertices = std::vector<MeshVertex>();
     for (auto vertex : renderMesh.vertices) {
         MeshVertex vert = {};
@@ -469,7 +195,34 @@ int main() {
     auto vertexBuffer = graphicsContext->createVertexBuffer(
         meshVertices.data(), uint32_t(meshVertices.size() * sizeof(MeshVertex)));
 
-    Mesh cubeMesh                       = Mesh::loadFromObj("assets/models/cube.obj");
+    // A grid of monkeys, culled and drawn on the GPU with one indirect draw
+    std::vector<glm::vec3> meshPositions;
+    for (auto& vertex : meshVertices) {
+        meshPositions.push_back(vertex.position);
+    }
+    glm::vec4 meshBoundingSphere = helper::boundingSphere(meshPositions);
+
+    std::vector<CullMesh> meshes = { { uint32_t(meshVertices.size()), 0 } };
+    GPUCuller gpuCuller(graphicsContext.get(), objectsDescriptorSet, 0, INITIAL_OBJECT_CAPACITY,
+                        meshes);
+    CPUCuller cpuCuller(&jobSystem);
+    DrawBatcher drawBatcher(graphicsContext.get(), objectsDescriptorSet, 0, meshes);
+    DrawQueue drawQueue;
+    // One per thread of the job system, for recording the CPU culled draws in parallel
+    auto forwardSecondaryBuffers =
+        graphicsContext->createFrameBasedSecondaryCommandBuffers(jobSystem.getThreadCount());
+
+    Scene scene(&jobSystem);
+    for (int row = 0; row < 10; row++) {
+        for (int column = 0; column < 10; column++) {
+            TransformComponent transform = {};
+            transform.position           = glm::vec3((column - 4.5f) * 3.0f, 0.0f, -row * 3.0f);
+
+            entt::entity entity = scene.createEntity(transform);
+            scene.addRenderable(entity, 0, 0, meshBoundingSphere);
+        }
+    }
+
     std::vector<Vertex> cubemapVertices = std::vector<Vertex>();
     for (auto vertex : cubeMesh.vertices) {
         cubemapVertices.push_back({ vertex.position, vertex.normal, vertex.uv });
@@ -493,12 +246,39 @@ int main() {
     // graphicsContext->descriptorSetAddImage(envMapDescriptorSet, 0, irradianceMap);
     graphicsContext->descriptorSetAddImage(envMapDescriptorSet, 0, environmentMap);
 
+    // The frame loop records through handles, see CommandList
+    auto pbrPipelineHandle     = graphicsContext->registerPipeline(pbrPipeline);
+    auto cubemapPipelineHandle = graphicsContext->registerPipeline(cubemapPipeline);
+    auto cameraSetHandle       = graphicsContext->registerDescriptorSet(cameraDescriptorSet);
+    auto objectsSetHandle      = graphicsContext->registerDescriptorSet(objectsDescriptorSet);
+    auto colorSetHandle        = graphicsContext->registerDescriptorSet(colorDescriptorSet);
+    auto cubeCameraSetHandle   = graphicsContext->registerDescriptorSet(cubeCameraDescriptorSet);
+    auto envMapSetHandle       = graphicsContext->registerDescriptorSet(envMapDescriptorSet);
+
+    auto vertexBufferHandle        = graphicsContext->registerVertexBuffer(vertexBuffer);
+    auto cubemapVertexBufferHandle = graphicsContext->registerVertexBuffer(cubemapVertexBuffer);
+
     glm::vec3 playerPos = glm::vec3(0.0f, 0.0f, 5.0f);
     glm::vec3 playerRot = glm::vec3(0.0f, 0.0f, 0.0f);
 
+    bool useSHIrradiance = false;
+    bool shToggleHeld    = false;
+
+    bool useCPUCulling        = false;
+    bool cullToggleHeld       = false;
+    uint32_t cpuInstanceCount = 0;
+
+    bool useSecondaryRecording = false;
+    bool secondaryToggleHeld   = false;
+
+    bool firstFrame     = true;
+    bool texturesLoaded = false;
+
+    TextureStreamStats lastStreamStats = {};
     while (!window->shouldClose() && !window->keyDown(GLFW_KEY_ESCAPE)) {
         double startTime = glfwGetTime();
         Window::poll();
+        jobSystem.runMainThreadJobs();
 
         if (window->keyDown(GLFW_KEY_W)) {
             playerPos.z -= 0.1f;
@@ -521,47 +301,69 @@ int main() {
             playerRot.y -= 0.01f;
         }
 
+        // H switches the diffuse ambient between the irradiance map and SH irradiance
+        bool shToggleDown = window->keyDown(GLFW_KEY_H);
+        if (shToggleDown && !shToggleHeld) {
+            useSHIrradiance = !useSHIrradiance;
+            Logger::main_logger->info("Diffuse irradiance from: {0}",
+                                      useSHIrradiance ? "SH" : "irradiance map");
+        }
+        shToggleHeld = shToggleDown;
+
+        // C switches between culling on the GPU and on the CPU
+        bool cullToggleDown = window->keyDown(GLFW_KEY_C);
+        if (cullToggleDown && !cullToggleHeld) {
+            useCPUCulling = !useCPUCulling;
+            Logger::main_logger->info("Culling on the: {0}", useCPUCulling ? "CPU" : "GPU");
+        }
+        cullToggleHeld = cullToggleDown;
+
+        // P records the CPU culled draws on every thread into secondary command buffers
+        bool secondaryToggleDown = window->keyDown(GLFW_KEY_P);
+        if (secondaryToggleDown && !secondaryToggleHeld) {
+            useSecondaryRecording = !useSecondaryRecording;
+            Logger::main_logger->info("Recording CPU culled draws: {0}",
+                                      useSecondaryRecording ? "in parallel" : "inline");
+        }
+        secondaryToggleHeld = secondaryToggleDown;
+
         if (graphicsContext->isSwapchainResized()) {
             // Create the main PBR pipeline for rendering
             pbrPipelineCreateInfo.viewportWidth  = window->getWidth();
             pbrPipelineCreateInfo.viewportHeight = window->getHeight();
             pbrPipeline = graphicsContext->createPipeline(&pbrPipelineCreateInfo);
 
-            cameraDescriptorSet = graphicsContext->createDescriptorSet(pbrPipeline, 0);
-            graphicsContext->descriptorSetAddBuffer(
-                cameraDescriptorSet, 0, DescriptorType::UNIFORM_BUFFER, sizeof(CameraData));
-            graphicsContext->descriptorSetAddImage(cameraDescriptorSet, 1, irradianceMap);
-            graphicsContext->descriptorSetAddImage(cameraDescriptorSet, 2, prefilterMap);
-            graphicsContext->descriptorSetAddRenderPassAttachment(cameraDescriptorSet, 3,
-                                                                  brdfRenderPass, 0);
-
-            objectsDescriptorSet = graphicsContext->createDescriptorSet(pbrPipeline, 1);
-            graphicsContext->descriptorSetAddBuffer(
-                objectsDescriptorSet, 0, DescriptorType::STORAGE_BUFFER, sizeof(glm::mat4) * 10000);
-
-            colorDescriptorSet = graphicsContext->createDescriptorSet(pbrPipeline, 2);
-            graphicsContext->descriptorSetAddImage(colorDescriptorSet, 0, grassTexture);
-            graphicsContext->descriptorSetAddImage(colorDescriptorSet, 1, materialTexture);
-            graphicsContext->descriptorSetAddImage(colorDescriptorSet, 2, normalTexture);
-
             cubemapPipelineCreateInfo.viewportWidth  = window->getWidth();
             cubemapPipelineCreateInfo.viewportHeight = window->getHeight();
-            cubemapPipeline         = graphicsContext->createPipeline(&cubemapPipelineCreateInfo);
-            cubeCameraDescriptorSet = graphicsContext->createDescriptorSet(cubemapPipeline, 0);
-            graphicsContext->descriptorSetAddBuffer(
-                cubeCameraDescriptorSet, 0, DescriptorType::UNIFORM_BUFFER, sizeof(CameraData));
-            envMapDescriptorSet = graphicsContext->createDescriptorSet(cubemapPipeline, 1);
-            graphicsContext->descriptorSetAddImage(envMapDescriptorSet, 0, irradianceMap);
+            cubemapPipeline = graphicsContext->createPipeline(&cubemapPipelineCreateInfo);
+
+            graphicsContext->release(pbrPipelineHandle);
+            graphicsContext->release(cubemapPipelineHandle);
+            pbrPipelineHandle     = graphicsContext->registerPipeline(pbrPipeline);
+            cubemapPipelineHandle = graphicsContext->registerPipeline(cubemapPipeline);
+
+            // The rebuilt pipelines get the cached layouts back, so the existing descriptor sets
+            // are still compatible and don't need to be reallocated
         }
 
+        graphicsContext->applyShaderReloads(renderFence);
+
         graphicsContext->waitOnFence(renderFence);
+        assetManager.update();
+        TextureDecodeStats decodeStats = assetManager.getDecodeStats();
+        if (!texturesLoaded && assetManager.getPendingCount() == 0 &&
+            decodeStats.imageCount > 0) {
+            double decodedMegabytes = decodeStats.decodedBytes / (1024.0 * 1024.0);
+            Logger::main_logger->info(
+                "Decoded {0} textures, {1} MB in {2} ms, {3} MB/s on {4} threads",
+                decodeStats.imageCount, decodedMegabytes, decodeStats.wallMilliseconds,
+                decodedMegabytes / (decodeStats.wallMilliseconds / 1000.0),
+                jobSystem.getThreadCount());
+            texturesLoaded = true;
+        }
+        textureStreamer.update();
         uint32_t swapchainImageIndex = graphicsContext->newFrame(presentSemaphore);
 
-        graphicsContext->beginRecording(mainCommandBuffer);
-        graphicsContext->beginSwapchainRenderPass(mainCommandBuffer, swapchainImageIndex,
-                                                  glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-
-        graphicsContext->bindPipeline(mainCommandBuffer, pbrPipeline);
         glm::vec3 camPos = playerPos;
         glm::mat4 view   = glm::translate(
             glm::rotate(glm::mat4(1.0f), playerRot.y, glm::vec3(0.0, 1.0, 0.0)), camPos);
@@ -575,35 +377,120 @@ int main() {
         camData.projection     = projection;
         camData.view           = viewInverse;
         camData.viewProjection = projection * viewInverse;
-        void* memoryLocation   = graphicsContext->mapDescriptorBuffer(cameraDescriptorSet, 0);
+
+        glm::quat spin = glm::angleAxis((float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+        for (entt::entity entity : scene.getRegistry().view<RenderableComponent>()) {
+            TransformComponent transform = scene.getTransform(entity);
+            transform.rotation           = spin;
+            scene.setTransform(entity, transform);
+        }
+        scene.propagateTransforms();
+        const std::vector<CullObject>& frameObjects = scene.getObjects();
+
+        // The monkey's UVs wrap the material around it about once, so the closest one in view
+        // needs as many texels as it covers pixels
+        std::array<glm::vec4, 6> frustumPlanes = helper::frustumPlanes(camData.viewProjection);
+        float materialTexels                   = 0.0f;
+        for (const CullObject& object : frameObjects) {
+            if (helper::sphereInFrustum(frustumPlanes, object.model, object.boundingSphere)) {
+                materialTexels = std::max(
+                    materialTexels,
+                    helper::sphereScreenDiameter(object.model, object.boundingSphere, viewInverse,
+                                                 projection, window->getHeight()));
+            }
+        }
+        for (auto& materialTexture : materialTextures) {
+            textureStreamer.requestTexels(materialTexture, materialTexels);
+        }
+
+        graphicsContext->beginRecording(mainCommandBuffer);
+        if (useCPUCulling) {
+            const std::vector<uint32_t>& visibleIndices =
+                cpuCuller.cull(frameObjects, camData.viewProjection);
+            cpuInstanceCount = (uint32_t)visibleIndices.size();
+            drawBatcher.build(frameObjects, visibleIndices);
+        } else {
+            gpuCuller.cull(mainCommandBuffer, frameObjects, camData.viewProjection);
+        }
+
+        void* memoryLocation = graphicsContext->mapDescriptorBuffer(cameraDescriptorSet, 0);
         memcpy(memoryLocation, &camData, sizeof(CameraData));
         graphicsContext->unmapDescriptorBuffer(cameraDescriptorSet, 0);
-        void* objectMemoryLocation  = graphicsContext->mapDescriptorBuffer(objectsDescriptorSet, 0);
-        glm::mat4* objectMemoryMats = (glm::mat4*)objectMemoryLocation;
-        objectMemoryMats[0] =
-            glm::rotate(glm::mat4(1.0f), (float)glfwGetTime(), glm::vec3(0, 1, 0));
-        graphicsContext->unmapDescriptorBuffer(objectsDescriptorSet, 0);
-        graphicsContext->bindDescriptorSet(mainCommandBuffer, 0, cameraDescriptorSet);
-        graphicsContext->bindDescriptorSet(mainCommandBuffer, 1, objectsDescriptorSet);
-        graphicsContext->bindDescriptorSet(mainCommandBuffer, 2, colorDescriptorSet);
+        SHIrradianceData shData;
+        shData.irradiance      = irradianceSH;
+        shData.enabled         = useSHIrradiance ? 1 : 0;
+        void* shMemoryLocation = graphicsContext->mapDescriptorBuffer(cameraDescriptorSet, 4);
+        memcpy(shMemoryLocation, &shData, sizeof(SHIrradianceData));
+        graphicsContext->unmapDescriptorBuffer(cameraDescriptorSet, 4);
 
         glm::vec4 outCamPos = view[3];
-        graphicsContext->pushConstants(mainCommandBuffer, pbrPipeline, 0, sizeof(glm::vec4),
-                                       &outCamPos);
 
-        graphicsContext->bindVertexBuffer(mainCommandBuffer, vertexBuffer);
-        graphicsContext->draw(mainCommandBuffer, uint32_t(meshVertices.size()), 1, 0, 0);
+        CommandList commandList = graphicsContext->commandList(mainCommandBuffer);
+        auto bindPBR            = [&](CommandList& list) {
+            list.bindPipeline(pbrPipelineHandle);
+            list.bindDescriptorSet(0, cameraSetHandle);
+            list.bindDescriptorSet(1, objectsSetHandle);
+            list.bindDescriptorSet(2, colorSetHandle);
+            list.pushConstants(0, sizeof(glm::vec4), &outCamPos);
+            list.bindVertexBuffer(vertexBufferHandle);
+        };
+
+        // What was visible last frame is drawn first, the depth it leaves behind is what the rest
+        // is occlusion culled against
+        bool recordSecondary = useCPUCulling && useSecondaryRecording;
+        graphicsContext->beginSwapchainRenderPass(mainCommandBuffer, swapchainImageIndex,
+                                                  glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+                                                  recordSecondary);
+        if (useCPUCulling) {
+            // Every object shares the one material
+            drawQueue.clear();
+            drawBatcher.submit(drawQueue, 0, pbrPipelineHandle, vertexBufferHandle, 2,
+                               [&](uint32_t) { return colorSetHandle; });
+            drawQueue.sort();
+            if (recordSecondary) {
+                // Each range binds everything it needs, the pass itself only executes them
+                graphicsContext->recordSwapchainSecondary(
+                    forwardSecondaryBuffers, swapchainImageIndex, drawQueue.getPacketCount(),
+                    [&](std::shared_ptr<CommandBuffer> commandBuffer, uint32_t first,
+                        uint32_t count) {
+                        CommandList rangeList = graphicsContext->commandList(commandBuffer);
+                        drawQueue.record(rangeList, first, count,
+                                         [&](PipelineHandle) { bindPBR(rangeList); });
+                    });
+                graphicsContext->executeSecondary(mainCommandBuffer, forwardSecondaryBuffers);
+            } else {
+                bindPBR(commandList);
+                drawQueue.record(commandList, [&](PipelineHandle) { bindPBR(commandList); });
+            }
+        } else {
+            bindPBR(commandList);
+            gpuCuller.draw(mainCommandBuffer);
+        }
+        graphicsContext->endRenderPass(mainCommandBuffer);
+
+        graphicsContext->buildDepthPyramid(mainCommandBuffer);
+        if (!useCPUCulling) {
+            gpuCuller.cullLate(mainCommandBuffer);
+        }
+
+        graphicsContext->continueSwapchainRenderPass(mainCommandBuffer, swapchainImageIndex);
+        // The compute dispatches in between bound their own state
+        commandList.invalidate();
+        bindPBR(commandList);
+        if (!useCPUCulling) {
+            gpuCuller.drawLate(mainCommandBuffer);
+        }
 
         // Draw skybox
-        graphicsContext->bindPipeline(mainCommandBuffer, cubemapPipeline);
+        commandList.bindPipeline(cubemapPipelineHandle);
         void* cubeCamMemoryLocation =
             graphicsContext->mapDescriptorBuffer(cubeCameraDescriptorSet, 0);
         memcpy(cubeCamMemoryLocation, &camData, sizeof(CameraData));
         graphicsContext->unmapDescriptorBuffer(cubeCameraDescriptorSet, 0);
-        graphicsContext->bindDescriptorSet(mainCommandBuffer, 0, cubeCameraDescriptorSet);
-        graphicsContext->bindDescriptorSet(mainCommandBuffer, 1, envMapDescriptorSet);
-        graphicsContext->bindVertexBuffer(mainCommandBuffer, cubemapVertexBuffer);
-        graphicsContext->draw(mainCommandBuffer, (uint32_t)cubemapVertices.size(), 1, 0, 0);
+        commandList.bindDescriptorSet(0, cubeCameraSetHandle);
+        commandList.bindDescriptorSet(1, envMapSetHandle);
+        commandList.bindVertexBuffer(cubemapVertexBufferHandle);
+        commandList.draw((uint32_t)cubemapVertices.size(), 1, 0, 0);
 
         graphicsContext->endRenderPass(mainCommandBuffer);
 
@@ -612,7 +499,53 @@ int main() {
         graphicsContext->submit(mainCommandBuffer, presentSemaphore, renderSemaphore, renderFence);
 
         graphicsContext->present(swapchainImageIndex, renderSemaphore);
+        if (firstFrame) {
+            // Time since GLFW was initialized, to compare cold starts with and without the cache
+            Logger::main_logger->info("First frame presented after {0} ms", glfwGetTime() * 1000.0);
+            firstFrame = false;
+        }
         Logger::main_logger->info("FPS: {0}", 1.0f / (glfwGetTime() - startTime));
+
+        TextureStreamStats streamStats = textureStreamer.getStats();
+        if (streamStats.uploadCount != lastStreamStats.uploadCount ||
+            streamStats.evictionCount != lastStreamStats.evictionCount ||
+            streamStats.deferredCount != lastStreamStats.deferredCount) {
+            // Replaced images count until they're freed
+            uint64_t takenBytes = streamStats.residentBytes + streamStats.uploadingBytes +
+                                  streamStats.retiredBytes;
+            Logger::main_logger->info(
+                "Streamed textures take {0} MB of {1} MB, {2} uploads, {3} evictions, {4} deferred",
+                takenBytes / (1024.0 * 1024.0), streamStats.budgetBytes / (1024.0 * 1024.0),
+                streamStats.uploadCount, streamStats.evictionCount, streamStats.deferredCount);
+            lastStreamStats = streamStats;
+        }
+
+        // Every frame, so only at debug level
+        TransformStats transformStats = scene.getTransformStats();
+        Logger::main_logger->debug("Propagated {0} transforms in {1} ms",
+                                   transformStats.updatedCount, transformStats.milliseconds);
+
+        GPUCullStats cullStats = gpuCuller.getStats();
+        if (useCPUCulling) {
+            DrawQueueStats queueStats = drawQueue.getStats();
+            if (!frameObjects.empty()) {
+                Logger::main_logger->debug("Culled {0}% of {1} objects on the CPU",
+                                           100.0f * (frameObjects.size() - cpuInstanceCount) /
+                                               frameObjects.size(),
+                                           frameObjects.size());
+            }
+            Logger::main_logger->debug(
+                "{0} draws with {1} pipeline, {2} material and {3} vertex binds, sorted in {4} ms",
+                queueStats.packetCount, queueStats.pipelineBinds, queueStats.materialBinds,
+                queueStats.vertexBufferBinds, queueStats.sortMilliseconds);
+        } else if (cullStats.objectCount > 0) {
+            uint32_t drawCount = cullStats.earlyDrawCount + cullStats.lateDrawCount;
+            Logger::main_logger->debug(
+                "Culled {0}% of {1} objects, {2} outside the frustum and {3} occluded",
+                100.0f * (cullStats.objectCount - drawCount) / cullStats.objectCount,
+                cullStats.objectCount, cullStats.objectCount - cullStats.frustumVisibleCount,
+                cullStats.occludedCount);
+        }
     }
 
     graphicsContext->waitOnFence(renderFence, -1);
@@ -2,8 +2,12 @@
 
 // Standard libraries
 #include <algorithm>
+#include <atomic>
+#include <cfloat>
 #include <chrono>
+#include <climits>
 #include <cmath>
+#include <condition_variable>
 #include <deque>
 #include <filesystem>
 #include <fstream>
@@ -11,9 +15,11 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <random>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -34,6 +40,9 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <entt/entt.hpp>
 
 #include <imgui.h>
 #include "../build/imgui_impl_glfw.h"
@@ -0,0 +1,57 @@
+#include "../pch.hpp"
+#include "CPUCuller.hpp"
+
+#include "../Logger.hpp"
+
+// Below this many objects per range handing them out costs more than it saves
+constexpr uint32_t MIN_OBJECTS_PER_RANGE = 4096;
+
+// Ranges start on a multiple of this, so only the last one has a scalar tail
+constexpr uint32_t CULL_RANGE_ALIGNMENT = 8;
+
+CPUCuller::CPUCuller(JobSystem* jobSystem) : jobSystem(jobSystem) {}
+
+CPUCuller::~CPUCuller() { Logger::renderer_logger->info("Destroying CPU Culler"); }
+
+const std::vector<uint32_t>& CPUCuller::cull(const std::vector<CullObject>& objects,
+                                             const glm::mat4& viewProjection) {
+    uint32_t objectCount = (uint32_t)objects.size();
+
+    spheres.centerX.resize(objectCount);
+    spheres.centerY.resize(objectCount);
+    spheres.centerZ.resize(objectCount);
+    spheres.radius.resize(objectCount);
+
+    std::array<glm::vec4, 6> planes = helper::frustumPlanes(viewProjection);
+
+    uint32_t threadCount = jobSystem->getThreadCount();
+    uint32_t rangeSize   = std::max((objectCount + threadCount - 1) / threadCount,
+                                    MIN_OBJECTS_PER_RANGE);
+    rangeSize            = (rangeSize + CULL_RANGE_ALIGNMENT - 1) / CULL_RANGE_ALIGNMENT;
+    rangeSize *= CULL_RANGE_ALIGNMENT;
+    uint32_t rangeCount = std::max((objectCount + rangeSize - 1) / rangeSize, 1u);
+
+    if (rangeVisibleIndices.size() < rangeCount) {
+        rangeVisibleIndices.resize(rangeCount);
+    }
+
+    jobSystem->parallelFor(rangeCount, 1, [&](uint32_t rangeIndex, uint32_t) {
+        uint32_t first = std::min(rangeIndex * rangeSize, objectCount);
+        uint32_t count = std::min(rangeSize, objectCount - first);
+
+        std::vector<uint32_t>& rangeVisible = rangeVisibleIndices[rangeIndex];
+        rangeVisible.clear();
+
+        helper::worldSpheres(objects, first, count, spheres);
+        helper::cullSpheres(spheres, planes, first, count, rangeVisible);
+    });
+
+    // Ranges are in object order, so appending them keeps the indices sorted
+    visibleIndices.clear();
+    for (uint32_t rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++) {
+        visibleIndices.insert(visibleIndices.end(), rangeVisibleIndices[rangeIndex].begin(),
+                              rangeVisibleIndices[rangeIndex].end());
+    }
+
+    return visibleIndices;
+}
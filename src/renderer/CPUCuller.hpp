@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Helper/Culling.hpp"
+#include "../Jobs/JobSystem.hpp"
+
+// Frustum culls on the CPU, for when GPUCuller can't be used. The objects are split into one
+// contiguous range per job system thread, each job gathers the bounds of its range into structure
+// of arrays and tests them with helper::cullSpheres
+class CPUCuller {
+public:
+    CPUCuller(JobSystem* jobSystem);
+
+    ~CPUCuller();
+
+    // Indices of the objects in the frustum in object order, valid until the next call
+    const std::vector<uint32_t>& cull(const std::vector<CullObject>& objects,
+                                      const glm::mat4& viewProjection);
+
+private:
+    JobSystem* jobSystem;
+
+    CullSpheres spheres;
+    std::vector<std::vector<uint32_t>> rangeVisibleIndices;
+    std::vector<uint32_t> visibleIndices;
+};
@@ -0,0 +1,99 @@
+#include "../pch.hpp"
+#include "CommandList.hpp"
+
+#include "../Logger.hpp"
+
+CommandList::CommandList(GraphicsContext* graphicsContext, VkCommandBuffer commandBuffer,
+                         uint32_t frameIndex)
+    : graphicsContext(graphicsContext), commandBuffer(commandBuffer), frameIndex(frameIndex),
+      skippedBindCount(0) {
+    invalidate();
+}
+
+void CommandList::bindPipeline(PipelineHandle pipeline) {
+    Pipeline* resolved = graphicsContext->resolve(pipeline);
+    if (resolved == nullptr) {
+        Logger::renderer_logger->error("Binding a released pipeline handle");
+        return;
+    }
+
+    // Compared by Vulkan handle, a hot reload swaps the pipeline under the same object
+    boundPipeline = resolved;
+    if (resolved->pipeline == boundVkPipeline) {
+        skippedBindCount++;
+        return;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, resolved->pipeline);
+    boundVkPipeline = resolved->pipeline;
+}
+
+void CommandList::bindDescriptorSet(uint32_t setIndex, DescriptorSetHandle descriptorSet) {
+    DescriptorSet* resolved = graphicsContext->resolve(descriptorSet);
+    if (resolved == nullptr) {
+        Logger::renderer_logger->error("Binding a released descriptor set handle");
+        return;
+    }
+
+    // Sets bound through another layout may have been disturbed, so only trust them within one
+    if (resolved->pipelineLayout != boundLayout) {
+        boundSets.fill(VK_NULL_HANDLE);
+        boundLayout = resolved->pipelineLayout;
+    }
+
+    VkDescriptorSet set = resolved->descriptorSets[frameIndex];
+    if (setIndex < MAX_TRACKED_SETS) {
+        if (boundSets[setIndex] == set) {
+            skippedBindCount++;
+            return;
+        }
+        boundSets[setIndex] = set;
+    }
+
+    vkCmdBindDescriptorSets(commandBuffer, resolved->bindPoint, resolved->pipelineLayout, setIndex,
+                            1, &set, 0, nullptr);
+}
+
+void CommandList::pushConstants(uint32_t offset, uint32_t size, const void* data) {
+    if (boundPipeline == nullptr) {
+        Logger::renderer_logger->error("Pushing constants without a bound pipeline");
+        return;
+    }
+
+    vkCmdPushConstants(commandBuffer, boundPipeline->layout,
+                       pushConstantStages(*boundPipeline, offset, size), offset, size, data);
+}
+
+void CommandList::bindVertexBuffer(VertexBufferHandle vertexBuffer) {
+    VertexBuffer* resolved = graphicsContext->resolve(vertexBuffer);
+    if (resolved == nullptr) {
+        Logger::renderer_logger->error("Binding a released vertex buffer handle");
+        return;
+    }
+
+    if (resolved->buffer == boundVertexBuffer) {
+        skippedBindCount++;
+        return;
+    }
+
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &resolved->buffer, &offset);
+    boundVertexBuffer = resolved->buffer;
+}
+
+void CommandList::draw(uint32_t vertexCount, uint32_t numInstances, uint32_t firstVertex,
+                       uint32_t firstInstance) {
+    vkCmdDraw(commandBuffer, vertexCount, numInstances, firstVertex, firstInstance);
+}
+
+void CommandList::invalidate() {
+    boundPipeline     = nullptr;
+    boundVkPipeline   = VK_NULL_HANDLE;
+    boundLayout       = VK_NULL_HANDLE;
+    boundVertexBuffer = VK_NULL_HANDLE;
+    boundSets.fill(VK_NULL_HANDLE);
+}
+
+VkCommandBuffer CommandList::getCommandBuffer() { return commandBuffer; }
+
+uint32_t CommandList::getSkippedBindCount() { return skippedBindCount; }
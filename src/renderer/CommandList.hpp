@@ -0,0 +1,48 @@
+#pragma once
+
+#include "GraphicsContext.hpp"
+
+// Records into a command buffer through handles instead of shared_ptrs, and skips binding a
+// pipeline, set or vertex buffer that is already bound. Cheap to make, use one per command buffer
+// per frame and keep it on the thread recording that buffer
+class CommandList {
+public:
+    CommandList(GraphicsContext* graphicsContext, VkCommandBuffer commandBuffer,
+                uint32_t frameIndex);
+
+    void bindPipeline(PipelineHandle pipeline);
+
+    void bindDescriptorSet(uint32_t setIndex, DescriptorSetHandle descriptorSet);
+
+    // Pushes to the layout of the bound pipeline
+    void pushConstants(uint32_t offset, uint32_t size, const void* data);
+
+    void bindVertexBuffer(VertexBufferHandle vertexBuffer);
+
+    void draw(uint32_t vertexCount, uint32_t numInstances, uint32_t firstVertex,
+              uint32_t firstInstance);
+
+    // Forgets what is bound, needed after recording into the same buffer by other means
+    void invalidate();
+
+    VkCommandBuffer getCommandBuffer();
+
+    // Binds that were dropped for already being bound
+    uint32_t getSkippedBindCount();
+
+private:
+    static constexpr uint32_t MAX_TRACKED_SETS = 4;
+
+    GraphicsContext* graphicsContext;
+
+    VkCommandBuffer commandBuffer;
+    uint32_t frameIndex;
+
+    Pipeline* boundPipeline;
+    VkPipeline boundVkPipeline;
+    VkPipelineLayout boundLayout;
+    std::array<VkDescriptorSet, MAX_TRACKED_SETS> boundSets;
+    VkBuffer boundVertexBuffer;
+
+    uint32_t skippedBindCount;
+};
@@ -0,0 +1,58 @@
+#include "../pch.hpp"
+#include "DrawBatcher.hpp"
+
+#include "../Logger.hpp"
+
+DrawBatcher::DrawBatcher(GraphicsContext* graphicsContext,
+                         std::shared_ptr<DescriptorSet> objectsDescriptorSet,
+                         uint32_t objectsBinding, std::vector<CullMesh> meshes)
+    : graphicsContext(graphicsContext), objectsDescriptorSet(objectsDescriptorSet),
+      objectsBinding(objectsBinding), meshes(meshes) {}
+
+DrawBatcher::~DrawBatcher() { Logger::renderer_logger->info("Destroying Draw Batcher"); }
+
+const std::vector<DrawBatch>& DrawBatcher::build(const std::vector<CullObject>& objects,
+                                                 const std::vector<uint32_t>& visibleIndices) {
+    uint32_t visibleCount = (uint32_t)visibleIndices.size();
+
+    helper::buildDrawBatches(objects, visibleIndices, sortedObjects, batches, keys, keyScratch,
+                             objectScratch);
+
+    // Every object is written below, nothing has to survive the growth
+    if (graphicsContext->descriptorSetGrowBuffer(
+            objectsDescriptorSet, objectsBinding, DescriptorType::STORAGE_BUFFER,
+            uint32_t(sizeof(CullObject) * std::max(visibleCount, 1u)))) {
+        Logger::renderer_logger->info("Grew the object buffer for {0} batched objects",
+                                      visibleCount);
+    }
+
+    CullObject* objectData = static_cast<CullObject*>(
+        graphicsContext->mapDescriptorBuffer(objectsDescriptorSet, objectsBinding));
+    for (uint32_t i = 0; i < visibleCount; i++) {
+        objectData[i] = objects[sortedObjects[i]];
+    }
+    graphicsContext->unmapDescriptorBuffer(objectsDescriptorSet, objectsBinding);
+
+    return batches;
+}
+
+void DrawBatcher::submit(DrawQueue& drawQueue, uint32_t pass, PipelineHandle pipeline,
+                         VertexBufferHandle vertexBuffer, uint32_t materialSetIndex,
+                         std::function<DescriptorSetHandle(uint32_t)> materialSet) {
+    for (const DrawBatch& batch : batches) {
+        const CullMesh& mesh = meshes[batch.meshIndex];
+
+        DrawPacket packet       = {};
+        packet.pipeline         = pipeline;
+        packet.materialSet      = materialSet(batch.materialIndex);
+        packet.materialSetIndex = materialSetIndex;
+        packet.vertexBuffer     = vertexBuffer;
+        packet.vertexCount      = mesh.vertexCount;
+        packet.instanceCount    = batch.instanceCount;
+        packet.firstVertex      = mesh.firstVertex;
+        packet.firstInstance    = batch.firstInstance;
+
+        // A batch spreads over the scene, no one depth stands for it
+        drawQueue.push(pass, batch.meshIndex, 0.0f, packet);
+    }
+}
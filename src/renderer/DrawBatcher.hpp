@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DrawQueue.hpp"
+#include "GraphicsContext.hpp"
+#include "Helper/Batching.hpp"
+
+// Draws every group of objects sharing a mesh and material with one instanced draw. The objects of
+// a group are written next to each other into the object buffer, so the shader finds them through
+// gl_InstanceIndex. Every mesh has to live in the one vertex buffer bound when drawing
+class DrawBatcher {
+public:
+    // objectsDescriptorSet owns the object buffer at objectsBinding, it grows when the objects
+    // don't fit
+    DrawBatcher(GraphicsContext* graphicsContext,
+                std::shared_ptr<DescriptorSet> objectsDescriptorSet, uint32_t objectsBinding,
+                std::vector<CullMesh> meshes);
+
+    ~DrawBatcher();
+
+    // Groups and uploads the objects at visibleIndices, ordered by material and then mesh so the
+    // material changes as rarely as possible, see helper::buildDrawBatches. Valid until the next
+    // call. Once per frame, after newFrame and before the object set is bound
+    const std::vector<DrawBatch>& build(const std::vector<CullObject>& objects,
+                                        const std::vector<uint32_t>& visibleIndices);
+
+    // Queues a packet per batch. materialSet gives the set of a material, bound at
+    // materialSetIndex
+    void submit(DrawQueue& drawQueue, uint32_t pass, PipelineHandle pipeline,
+                VertexBufferHandle vertexBuffer, uint32_t materialSetIndex,
+                std::function<DescriptorSetHandle(uint32_t)> materialSet);
+
+private:
+    GraphicsContext* graphicsContext;
+
+    std::shared_ptr<DescriptorSet> objectsDescriptorSet;
+    uint32_t objectsBinding;
+    std::vector<CullMesh> meshes;
+
+    std::vector<uint32_t> sortedObjects;
+    std::vector<DrawBatch> batches;
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> objectScratch;
+};
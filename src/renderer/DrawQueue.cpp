@@ -0,0 +1,105 @@
+#include "../pch.hpp"
+#include "DrawQueue.hpp"
+
+#include "Helper/Sorting.hpp"
+
+#include "../Logger.hpp"
+
+constexpr uint32_t PASS_KEY_BITS     = 4;
+constexpr uint32_t PIPELINE_KEY_BITS = 12;
+constexpr uint32_t MATERIAL_KEY_BITS = 16;
+constexpr uint32_t MESH_KEY_BITS     = 16;
+constexpr uint32_t DEPTH_KEY_BITS    = 16;
+
+uint64_t keyField(uint64_t key, uint32_t value, uint32_t bits) {
+    return (key << bits) | (value & ((1u << bits) - 1));
+}
+
+DrawQueue::DrawQueue() : stats() {}
+
+DrawQueue::~DrawQueue() { Logger::renderer_logger->info("Destroying Draw Queue"); }
+
+void DrawQueue::clear() {
+    packets.clear();
+    keys.clear();
+    order.clear();
+
+    stats.packetCount       = 0;
+    stats.pipelineBinds     = 0;
+    stats.materialBinds     = 0;
+    stats.vertexBufferBinds = 0;
+}
+
+void DrawQueue::push(uint32_t pass, uint32_t meshId, float viewDepth, const DrawPacket& packet) {
+    uint32_t depthBucket =
+        uint32_t(std::clamp(viewDepth, 0.0f, 1.0f) * float((1u << DEPTH_KEY_BITS) - 1));
+
+    uint64_t key = 0;
+    key          = keyField(key, pass, PASS_KEY_BITS);
+    key          = keyField(key, packet.pipeline.index, PIPELINE_KEY_BITS);
+    key          = keyField(key, packet.materialSet.index, MATERIAL_KEY_BITS);
+    key          = keyField(key, meshId, MESH_KEY_BITS);
+    key          = keyField(key, depthBucket, DEPTH_KEY_BITS);
+
+    keys.push_back(key);
+    order.push_back((uint32_t)packets.size());
+    packets.push_back(packet);
+}
+
+void DrawQueue::sort() {
+    auto start = std::chrono::high_resolution_clock::now();
+    helper::radixSort(keys, order, keyScratch, orderScratch);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    stats.sortMilliseconds = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void DrawQueue::record(CommandList& commandList,
+                       std::function<void(PipelineHandle pipeline)> bindPipelineState) {
+    record(commandList, 0, (uint32_t)order.size(), bindPipelineState);
+}
+
+void DrawQueue::record(CommandList& commandList, uint32_t first, uint32_t count,
+                       std::function<void(PipelineHandle pipeline)> bindPipelineState) {
+    uint32_t pipelineBinds     = 0;
+    uint32_t materialBinds     = 0;
+    uint32_t vertexBufferBinds = 0;
+
+    const DrawPacket* previous = nullptr;
+    for (uint32_t i = first; i < first + count; i++) {
+        const DrawPacket& packet = packets[order[i]];
+
+        // Another pipeline may lay its sets out differently, so the material is bound again
+        bool pipelineChanged = previous == nullptr || packet.pipeline != previous->pipeline;
+        if (pipelineChanged) {
+            commandList.bindPipeline(packet.pipeline);
+            bindPipelineState(packet.pipeline);
+            pipelineBinds++;
+        }
+
+        if (pipelineChanged || packet.materialSet != previous->materialSet ||
+            packet.materialSetIndex != previous->materialSetIndex) {
+            commandList.bindDescriptorSet(packet.materialSetIndex, packet.materialSet);
+            materialBinds++;
+        }
+
+        if (previous == nullptr || packet.vertexBuffer != previous->vertexBuffer) {
+            commandList.bindVertexBuffer(packet.vertexBuffer);
+            vertexBufferBinds++;
+        }
+
+        commandList.draw(packet.vertexCount, packet.instanceCount, packet.firstVertex,
+                         packet.firstInstance);
+        previous = &packet;
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.packetCount = (uint32_t)packets.size();
+    stats.pipelineBinds += pipelineBinds;
+    stats.materialBinds += materialBinds;
+    stats.vertexBufferBinds += vertexBufferBinds;
+}
+
+uint32_t DrawQueue::getPacketCount() { return (uint32_t)packets.size(); }
+
+DrawQueueStats DrawQueue::getStats() { return stats; }
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CommandList.hpp"
+
+// Everything one draw needs bound besides the sets every draw of its pipeline shares
+struct DrawPacket {
+    PipelineHandle pipeline;
+    // Bound at materialSetIndex
+    DescriptorSetHandle materialSet;
+    uint32_t materialSetIndex;
+    VertexBufferHandle vertexBuffer;
+    uint32_t vertexCount;
+    uint32_t instanceCount;
+    uint32_t firstVertex;
+    uint32_t firstInstance;
+};
+
+// State changes the recording since the last clear made, and what sorting it cost
+struct DrawQueueStats {
+    uint32_t packetCount;
+    uint32_t pipelineBinds;
+    uint32_t materialBinds;
+    uint32_t vertexBufferBinds;
+    float sortMilliseconds;
+};
+
+// Collects the draws of a frame and records them ordered by a 64 bit key, so draws sharing a
+// pipeline, material or mesh end up next to each other. From the top the key holds the pass in 4
+// bits, the pipeline in 12, the material set in 16, the mesh in 16 and a depth bucket in 16, so
+// draws of the same state go front to back. Handles that don't fit their bits only group worse
+class DrawQueue {
+public:
+    DrawQueue();
+
+    ~DrawQueue();
+
+    // Forgets the packets of the last frame
+    void clear();
+
+    // Passes are recorded in increasing order. meshId tells meshes in the same vertex buffer
+    // apart, viewDepth is clamped to zero to one
+    void push(uint32_t pass, uint32_t meshId, float viewDepth, const DrawPacket& packet);
+
+    void sort();
+
+    // Records the sorted packets, binding only what changes between them. bindPipelineState is
+    // called after each pipeline change to bind what every draw of that pipeline shares
+    void record(CommandList& commandList,
+                std::function<void(PipelineHandle pipeline)> bindPipelineState);
+
+    // Records count of the sorted packets from first, which starts with nothing bound. Ranges of
+    // one queue may be recorded on several threads at once, into command buffers of their own
+    void record(CommandList& commandList, uint32_t first, uint32_t count,
+                std::function<void(PipelineHandle pipeline)> bindPipelineState);
+
+    uint32_t getPacketCount();
+
+    DrawQueueStats getStats();
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> orderScratch;
+
+    // Ranges recorded in parallel add their binds to it
+    std::mutex statsMutex;
+    DrawQueueStats stats;
+};
@@ -0,0 +1,272 @@
+#include "../pch.hpp"
+#include "GPUCuller.hpp"
+
+#include "../Logger.hpp"
+
+constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+
+constexpr uint32_t EARLY_CULL_PHASE = 0;
+constexpr uint32_t LATE_CULL_PHASE  = 1;
+
+// Matches CullBuffer in cull.comp
+struct CullData {
+    glm::mat4 viewProjection;
+    glm::vec4 frustumPlanes[6];
+    glm::vec2 depthPyramidSize;
+    uint32_t objectCount;
+    uint32_t depthPyramidLevels;
+};
+
+// Counts header of DrawBuffer and LateDrawBuffer in cull.comp, then the draws
+uint32_t drawBufferSize(uint32_t maxDraws) {
+    return uint32_t(4 * sizeof(uint32_t) + sizeof(VkDrawIndirectCommand) * maxDraws);
+}
+
+GPUCuller::GPUCuller(GraphicsContext* graphicsContext,
+                     std::shared_ptr<DescriptorSet> objectsDescriptorSet, uint32_t objectsBinding,
+                     uint32_t objectCapacity, std::vector<CullMesh> meshes)
+    : graphicsContext(graphicsContext), objectsDescriptorSet(objectsDescriptorSet),
+      objectsBinding(objectsBinding), objectCapacity(std::max(objectCapacity, 1u)),
+      meshes(meshes), objectCount(0), stats() {
+    graphicsContext->descriptorSetGrowBuffer(objectsDescriptorSet, objectsBinding,
+                                             DescriptorType::STORAGE_BUFFER,
+                                             uint32_t(sizeof(CullObject) * this->objectCapacity));
+
+    cullPipeline      = graphicsContext->createComputePipeline("assets/shaders/cull.comp");
+    cullDescriptorSet = graphicsContext->createDescriptorSet(cullPipeline, 0);
+    graphicsContext->descriptorSetShareBuffer(cullDescriptorSet, 0, objectsDescriptorSet,
+                                              objectsBinding, DescriptorType::STORAGE_BUFFER);
+    graphicsContext->descriptorSetAddBuffer(cullDescriptorSet, 1, DescriptorType::STORAGE_BUFFER,
+                                            uint32_t(sizeof(CullMesh) * meshes.size()));
+    graphicsContext->descriptorSetAddBuffer(cullDescriptorSet, 2, DescriptorType::INDIRECT_BUFFER,
+                                            drawBufferSize(this->objectCapacity));
+    graphicsContext->descriptorSetAddBuffer(cullDescriptorSet, 3, DescriptorType::UNIFORM_BUFFER,
+                                            sizeof(CullData));
+    graphicsContext->descriptorSetAddBuffer(cullDescriptorSet, 4, DescriptorType::INDIRECT_BUFFER,
+                                            drawBufferSize(this->objectCapacity));
+    // Never cleared, whatever is left in them only makes the first frames draw more early
+    graphicsContext->descriptorSetAddBuffer(cullDescriptorSet, 5, DescriptorType::STORAGE_BUFFER,
+                                            uint32_t(sizeof(uint32_t) * this->objectCapacity));
+    graphicsContext->descriptorSetShareBuffer(cullDescriptorSet, 6, cullDescriptorSet, 5,
+                                              DescriptorType::STORAGE_BUFFER, -1);
+
+    frameObjectCounts.fill(0);
+    frameRecorded.fill(false);
+
+    if (!graphicsContext->supportsDrawIndirectCount()) {
+        Logger::renderer_logger->warn(
+            "No VK_KHR_draw_indirect_count, culled draws are issued for every object");
+    }
+}
+
+GPUCuller::~GPUCuller() { Logger::renderer_logger->info("Destroying GPU Culler"); }
+
+void GPUCuller::cull(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                     const std::vector<CullObject>& objects, const glm::mat4& viewProjection) {
+    uint32_t frameIndex = graphicsContext->getFrameBasedIndex();
+
+    readStats(frameIndex);
+#ifndef NDEBUG
+    validate(frameIndex);
+#endif
+
+    objectCount = (uint32_t)objects.size();
+    if (objectCount > objectCapacity) {
+        grow(objectCount);
+    }
+    frameObjectCounts[frameIndex] = objectCount;
+    frameRecorded[frameIndex]     = true;
+
+    void* objectMemory = graphicsContext->mapDescriptorBuffer(objectsDescriptorSet, objectsBinding);
+    memcpy(objectMemory, objects.data(), sizeof(CullObject) * objectCount);
+    graphicsContext->unmapDescriptorBuffer(objectsDescriptorSet, objectsBinding);
+
+    void* meshMemory = graphicsContext->mapDescriptorBuffer(cullDescriptorSet, 1);
+    memcpy(meshMemory, meshes.data(), sizeof(CullMesh) * meshes.size());
+    graphicsContext->unmapDescriptorBuffer(cullDescriptorSet, 1);
+
+    // The pyramid is only recreated with the swapchain, after the device went idle
+    std::shared_ptr<Texture> depthPyramid = graphicsContext->getDepthPyramid();
+    if (boundDepthPyramid.lock() != depthPyramid) {
+        graphicsContext->descriptorSetAddImage(cullDescriptorSet, 7, depthPyramid);
+        boundDepthPyramid = depthPyramid;
+    }
+
+    std::array<glm::vec4, 6> planes = helper::frustumPlanes(viewProjection);
+
+    CullData cullData       = {};
+    cullData.viewProjection = viewProjection;
+    for (uint32_t i = 0; i < 6; i++) {
+        cullData.frustumPlanes[i] = planes[i];
+    }
+    cullData.depthPyramidSize   = glm::vec2(depthPyramid->width, depthPyramid->height);
+    cullData.objectCount        = objectCount;
+    cullData.depthPyramidLevels = depthPyramid->mipLevels;
+    void* cullMemory            = graphicsContext->mapDescriptorBuffer(cullDescriptorSet, 3);
+    memcpy(cullMemory, &cullData, sizeof(CullData));
+    graphicsContext->unmapDescriptorBuffer(cullDescriptorSet, 3);
+
+#ifndef NDEBUG
+    expectedDraws[frameIndex] = helper::cullObjects(objects, meshes, planes);
+#endif
+
+    // Clearing resets the counts and, for devices without draw indirect count, every stale draw
+    for (uint32_t binding : { 2, 4 }) {
+        graphicsContext->clearDescriptorBuffer(commandBuffer, cullDescriptorSet, binding);
+        graphicsContext->descriptorBufferBarrier(
+            commandBuffer, cullDescriptorSet, binding, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+
+    uint32_t phase = EARLY_CULL_PHASE;
+    graphicsContext->bindPipeline(commandBuffer, cullPipeline);
+    graphicsContext->bindDescriptorSet(commandBuffer, 0, cullDescriptorSet);
+    graphicsContext->pushConstants(commandBuffer, cullPipeline, 0, sizeof(uint32_t), &phase);
+    graphicsContext->dispatch(commandBuffer,
+                              (objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    // The host reads the draws back for validation once the frame fence signals
+    graphicsContext->descriptorBufferBarrier(
+        commandBuffer, cullDescriptorSet, 2, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT);
+}
+
+void GPUCuller::draw(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer) {
+    graphicsContext->drawIndirectCount(commandBuffer, cullDescriptorSet, 2, objectCapacity);
+}
+
+void GPUCuller::cullLate(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer) {
+    // Building the depth pyramid bound its own pipeline and set
+    uint32_t phase = LATE_CULL_PHASE;
+    graphicsContext->bindPipeline(commandBuffer, cullPipeline);
+    graphicsContext->bindDescriptorSet(commandBuffer, 0, cullDescriptorSet);
+    graphicsContext->pushConstants(commandBuffer, cullPipeline, 0, sizeof(uint32_t), &phase);
+    graphicsContext->dispatch(commandBuffer,
+                              (objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    graphicsContext->descriptorBufferBarrier(
+        commandBuffer, cullDescriptorSet, 4, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT);
+
+    // Read by both phases of the next frame, which is recorded into another command buffer but
+    // runs after this one on the queue
+    graphicsContext->descriptorBufferBarrier(
+        commandBuffer, cullDescriptorSet, 5, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+}
+
+void GPUCuller::drawLate(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer) {
+    graphicsContext->drawIndirectCount(commandBuffer, cullDescriptorSet, 4, objectCapacity);
+}
+
+GPUCullStats GPUCuller::getStats() { return stats; }
+
+std::vector<VkDrawIndirectCommand> GPUCuller::readBackDraws() {
+    std::vector<VkDrawIndirectCommand> draws     = readDraws(2);
+    std::vector<VkDrawIndirectCommand> lateDraws = readDraws(4);
+    draws.insert(draws.end(), lateDraws.begin(), lateDraws.end());
+
+    // Invocations append in whatever order they finish, the reference is in object order
+    std::sort(draws.begin(), draws.end(),
+              [](const VkDrawIndirectCommand& a, const VkDrawIndirectCommand& b) {
+                  return a.firstInstance < b.firstInstance;
+              });
+
+    return draws;
+}
+
+void GPUCuller::grow(uint32_t objectCount) {
+    uint32_t oldCapacity = objectCapacity;
+    while (objectCapacity < objectCount) {
+        objectCapacity *= 2;
+    }
+
+    Logger::renderer_logger->info("Growing GPU culling to {0} objects", objectCapacity);
+
+    // The object buffer may already have grown for someone else
+    graphicsContext->descriptorSetGrowBuffer(objectsDescriptorSet, objectsBinding,
+                                             DescriptorType::STORAGE_BUFFER,
+                                             uint32_t(sizeof(CullObject) * objectCapacity));
+    graphicsContext->descriptorSetGrowBuffer(cullDescriptorSet, 2, DescriptorType::INDIRECT_BUFFER,
+                                             drawBufferSize(objectCapacity));
+    graphicsContext->descriptorSetGrowBuffer(cullDescriptorSet, 4, DescriptorType::INDIRECT_BUFFER,
+                                             drawBufferSize(objectCapacity));
+    // The objects keep their indices, so their visibility carries over
+    graphicsContext->descriptorSetGrowBuffer(cullDescriptorSet, 5, DescriptorType::STORAGE_BUFFER,
+                                             uint32_t(sizeof(uint32_t) * objectCapacity),
+                                             uint32_t(sizeof(uint32_t) * oldCapacity));
+
+    // Whatever the other frames wrote to the draw buffers went with the old buffers
+    frameRecorded.fill(false);
+}
+
+std::vector<VkDrawIndirectCommand> GPUCuller::readDraws(uint32_t binding) {
+    uint32_t* drawMemory =
+        static_cast<uint32_t*>(graphicsContext->mapDescriptorBuffer(cullDescriptorSet, binding));
+    uint32_t drawCount = std::min(drawMemory[0], objectCapacity);
+    VkDrawIndirectCommand* drawCommands = reinterpret_cast<VkDrawIndirectCommand*>(drawMemory + 4);
+    std::vector<VkDrawIndirectCommand> draws(drawCommands, drawCommands + drawCount);
+    graphicsContext->unmapDescriptorBuffer(cullDescriptorSet, binding);
+
+    return draws;
+}
+
+void GPUCuller::readStats(uint32_t frameIndex) {
+    if (!frameRecorded[frameIndex]) {
+        return;
+    }
+
+    uint32_t* earlyMemory =
+        static_cast<uint32_t*>(graphicsContext->mapDescriptorBuffer(cullDescriptorSet, 2));
+    stats.earlyDrawCount = std::min(earlyMemory[0], objectCapacity);
+    graphicsContext->unmapDescriptorBuffer(cullDescriptorSet, 2);
+
+    uint32_t* lateMemory =
+        static_cast<uint32_t*>(graphicsContext->mapDescriptorBuffer(cullDescriptorSet, 4));
+    stats.lateDrawCount       = std::min(lateMemory[0], objectCapacity);
+    stats.frustumVisibleCount = lateMemory[1];
+    stats.occludedCount       = lateMemory[2];
+    graphicsContext->unmapDescriptorBuffer(cullDescriptorSet, 4);
+
+    stats.objectCount = frameObjectCounts[frameIndex];
+}
+
+void GPUCuller::validate(uint32_t frameIndex) {
+    if (!frameRecorded[frameIndex]) {
+        return;
+    }
+
+    std::vector<VkDrawIndirectCommand> draws = readBackDraws();
+
+    // The CPU can't test occlusion, so the frustum test has to match exactly and the draws of
+    // both phases together have to be a subset of the reference, each object drawn at most once
+    const std::vector<VkDrawIndirectCommand>& expected = expectedDraws[frameIndex];
+
+    bool matches         = stats.frustumVisibleCount == expected.size();
+    size_t expectedIndex = 0;
+    for (size_t i = 0; matches && i < draws.size(); i++) {
+        while (expectedIndex < expected.size() &&
+               expected[expectedIndex].firstInstance < draws[i].firstInstance) {
+            expectedIndex++;
+        }
+
+        matches = expectedIndex < expected.size() &&
+                  draws[i].vertexCount == expected[expectedIndex].vertexCount &&
+                  draws[i].instanceCount == expected[expectedIndex].instanceCount &&
+                  draws[i].firstVertex == expected[expectedIndex].firstVertex &&
+                  draws[i].firstInstance == expected[expectedIndex].firstInstance;
+        expectedIndex++;
+    }
+
+    if (!matches) {
+        Logger::renderer_logger->warn(
+            "GPU culling drew {0} of {1} objects in the frustum, the CPU reference kept {2}",
+            draws.size(), stats.frustumVisibleCount, expected.size());
+    }
+}
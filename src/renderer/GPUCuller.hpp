@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GraphicsContext.hpp"
+#include "Helper/Culling.hpp"
+
+// What the culling of a frame kept, read back once the frame is done on the GPU
+struct GPUCullStats {
+    uint32_t objectCount;
+    uint32_t frustumVisibleCount;
+    // In the frustum but behind the depth pyramid
+    uint32_t occludedCount;
+    uint32_t earlyDrawCount;
+    uint32_t lateDrawCount;
+};
+
+// Frustum and occlusion culls the objects of an object buffer in a compute shader that writes one
+// indirect draw per visible object, so the scene is drawn with an indirect call per phase. Every
+// mesh has to live in the one vertex buffer bound when drawing
+//
+// Culling runs in two phases. The early phase draws what was visible last frame, those draws fill
+// the depth buffer the depth pyramid is built from. The late phase tests every object against the
+// pyramid and draws the visible ones the early phase missed
+//
+// Every object is its own draw, materials are ignored
+class GPUCuller {
+public:
+    // objectsDescriptorSet owns the object buffer at objectsBinding. The graphics pipeline reads
+    // the objects from it. The buffers start out sized for objectCapacity objects and grow when
+    // more are culled
+    GPUCuller(GraphicsContext* graphicsContext, std::shared_ptr<DescriptorSet> objectsDescriptorSet,
+              uint32_t objectsBinding, uint32_t objectCapacity, std::vector<CullMesh> meshes);
+
+    ~GPUCuller();
+
+    // Uploads this frame's objects and records the early culling dispatch. Once per frame, after
+    // waiting on the frame fence and outside of a render pass
+    void cull(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+              const std::vector<CullObject>& objects, const glm::mat4& viewProjection);
+
+    // Inside the render pass, with the pipeline, its sets and the vertex buffer bound
+    void draw(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
+
+    // Records the late culling dispatch, after GraphicsContext::buildDepthPyramid
+    void cullLate(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
+
+    void drawLate(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
+
+    // Of the last frame read back, which is FRAME_OVERLAP frames behind the one being recorded
+    GPUCullStats getStats();
+
+    // The draws of both phases, in object order, of the last frame that used this frame's
+    // buffers. After waiting on this frame's fence and before cull
+    std::vector<VkDrawIndirectCommand> readBackDraws();
+
+private:
+    // Doubles the capacity until objectCount fits, the results of earlier frames are lost
+    void grow(uint32_t objectCount);
+
+    std::vector<VkDrawIndirectCommand> readDraws(uint32_t binding);
+
+    void readStats(uint32_t frameIndex);
+
+    // Compares what the GPU wrote the last time this frame's buffers were used with the CPU
+    // reference for the same objects
+    void validate(uint32_t frameIndex);
+
+    GraphicsContext* graphicsContext;
+
+    std::shared_ptr<DescriptorSet> objectsDescriptorSet;
+    uint32_t objectsBinding;
+    uint32_t objectCapacity;
+    std::vector<CullMesh> meshes;
+
+    std::shared_ptr<ComputePipeline> cullPipeline;
+    std::shared_ptr<DescriptorSet> cullDescriptorSet;
+    // Recreated with the swapchain, rebound when that happens
+    std::weak_ptr<Texture> boundDepthPyramid;
+
+    uint32_t objectCount;
+    std::array<uint32_t, FRAME_OVERLAP> frameObjectCounts;
+    std::array<bool, FRAME_OVERLAP> frameRecorded;
+    GPUCullStats stats;
+
+    // Only filled in debug builds
+    std::array<std::vector<VkDrawIndirectCommand>, FRAME_OVERLAP> expectedDraws;
+};
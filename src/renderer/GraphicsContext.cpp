@@ -1,9 +1,14 @@
 #include "../pch.hpp"
 #include "GraphicsContext.hpp"
 
+#include "CommandList.hpp"
 #include "Helper/Conversions.hpp"
 #include "Helper/Debug.hpp"
 #include "Helper/Initializers.hpp"
+#include "Helper/KTX2.hpp"
+#include "Helper/Pixels.hpp"
+#include "Helper/ShaderCompiler.hpp"
+#include "../Jobs/JobSystem.hpp"
 #include "../Logger.hpp"
 
 GraphicsContext::GraphicsContext(std::shared_ptr<Window> windowRef, VkInstance instance,
@@ -12,15 +17,21 @@ GraphicsContext::GraphicsContext(std::shared_ptr<Window> windowRef, VkInstance i
                                  VkPhysicalDeviceProperties physicalDeviceProperties,
                                  VkQueue graphicsQueue, uint32_t graphicsQueueFamily,
                                  VkQueue transferQueue, uint32_t transferQueueFamily,
-                                 VkSurfaceKHR surface)
+                                 VkSurfaceKHR surface,
+                                 PFN_vkCmdDrawIndirectCountKHR drawIndirectCountFunction,
+                                 bool textureCompressionBC, VkExtent2D headlessExtent)
     : windowRef(windowRef), instance(instance), device(device), physicalDevice(physicalDevice),
       debugMessenger(debugMessenger), physicalDeviceProperties(physicalDeviceProperties),
       graphicsQueue(graphicsQueue), graphicsQueueFamily(graphicsQueueFamily),
-      transferQueue(transferQueue), transferQueueFamily(transferQueueFamily), surface(surface) {
+      transferQueue(transferQueue), transferQueueFamily(transferQueueFamily), surface(surface),
+      headlessExtent(headlessExtent), drawIndirectCountFunction(drawIndirectCountFunction),
+      textureCompressionBC(textureCompressionBC) {
 
     numFrames = 0;
 
-    glfwSetWindowUserPointer(windowRef->get(), this);
+    if (windowRef) {
+        glfwSetWindowUserPointer(windowRef->get(), this);
+    }
 
     initDescriptorPool();
 
@@ -33,6 +44,11 @@ GraphicsContext::GraphicsContext(std::shared_ptr<Window> windowRef, VkInstance i
     initUploadStructures();
 
     initSamplers();
+
+    // Reduces the swapchain depth for occlusion culling, see buildDepthPyramid
+    depthPyramidPipeline = createComputePipeline("assets/shaders/depthPyramid.comp");
+
+    initDepthPyramid();
 }
 
 GraphicsContext::~GraphicsContext() { destroy(); }
@@ -40,18 +56,67 @@ GraphicsContext::~GraphicsContext() { destroy(); }
 void GraphicsContext::destroy() {
     Logger::renderer_logger->info("Destroying Graphics Context");
 
+    shaderWatcher.reset();
+
+    // Objects only kept alive by their handles have to go while the device is still around
+    pipelineHandles      = HandlePool<Pipeline>();
+    descriptorSetHandles = HandlePool<DescriptorSet>();
+    vertexBufferHandles  = HandlePool<VertexBuffer>();
+
+    depthPyramidDescriptorSets.clear();
+    depthPyramidPipeline.reset();
+
     vkDestroySampler(device, mainSampler, nullptr);
+    vkDestroySampler(device, nearestSampler, nullptr);
 
     vkDestroyFence(device, uploadFence, nullptr);
 
     vkDestroyCommandPool(device, uploadCommandPool, nullptr);
 
+    // Uploads still in flight are waited on, their callbacks are dropped
+    if (!pendingTextureUploads.empty()) {
+        vkDeviceWaitIdle(device);
+    }
+    for (auto& pending : pendingTextureUploads) {
+        vmaDestroyBuffer(allocator, pending.upload.stagingBuffer, pending.upload.stagingAllocation);
+        vkDestroyFence(device, pending.fence, nullptr);
+    }
+    pendingTextureUploads.clear();
+
+    vkDestroyCommandPool(device, asyncUploadCommandPool, nullptr);
+
+    if (!retiredBuffers.empty() || !pendingBufferGrowths.empty()) {
+        vkDeviceWaitIdle(device);
+    }
+    for (auto& retiredBuffer : retiredBuffers) {
+        vmaDestroyBuffer(allocator, retiredBuffer.buffer, retiredBuffer.allocation);
+    }
+    retiredBuffers.clear();
+    for (auto& growth : pendingBufferGrowths) {
+        for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+            if (growth.buffers[i]) {
+                vmaDestroyBuffer(allocator, growth.buffers[i], growth.allocations[i]);
+            }
+        }
+    }
+    pendingBufferGrowths.clear();
+
+    for (auto& pipelineLayout : pipelineLayoutCache) {
+        vkDestroyPipelineLayout(device, pipelineLayout.second, nullptr);
+    }
+
+    for (auto& descriptorSetLayout : descriptorSetLayoutCache) {
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout.second, nullptr);
+    }
+
     for (auto& swapchainFramebuffer : swapchainFramebuffers) {
         vkDestroyFramebuffer(device, swapchainFramebuffer, nullptr);
     }
 
     vkDestroyRenderPass(device, swapchainRenderPass, nullptr);
+    vkDestroyRenderPass(device, swapchainLoadRenderPass, nullptr);
 
+    depthPyramid.reset();
     vkDestroyImageView(device, depthImageView, nullptr);
     vmaDestroyImage(allocator, depthImage.image, depthImage.allocation);
 
@@ -59,11 +124,19 @@ void GraphicsContext::destroy() {
         vkDestroyImageView(device, swapchainImageViews[i], nullptr);
     }
 
-    vkDestroySwapchainKHR(device, swapchain, nullptr);
+    if (windowRef) {
+        vkDestroySwapchainKHR(device, swapchain, nullptr);
+    } else {
+        for (auto& headlessImage : headlessImages) {
+            vmaDestroyImage(allocator, headlessImage.image, headlessImage.allocation);
+        }
+    }
 
     vmaDestroyAllocator(allocator);
 
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (windowRef) {
+        vkDestroySurfaceKHR(instance, surface, nullptr);
+    }
 
     vkDestroyDescriptorPool(device, globalDescriptorPool, nullptr);
 
@@ -86,6 +159,20 @@ uint32_t GraphicsContext::newFrame(std::shared_ptr<FrameBasedSemaphore> signalSe
         swapchainResized = false;
     }
 
+    applyBufferGrowths();
+
+    if (!windowRef) {
+        // Nothing to acquire, the semaphore is still signalled for the submit that waits on it
+        VkSubmitInfo submit         = {};
+        submit.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.pNext                = nullptr;
+        submit.signalSemaphoreCount = 1;
+        submit.pSignalSemaphores    = &signalSemaphore->semaphores[getCurrentFrameBasedIndex()];
+        VK_CHECK(vkQueueSubmit(graphicsQueue, 1, &submit, VK_NULL_HANDLE));
+
+        return numFrames % (uint32_t)swapchainImages.size();
+    }
+
     uint32_t swapchainImageIndex;
     VkResult getSwapchainResult = vkAcquireNextImageKHR(
         device, swapchain, 1000000000, signalSemaphore->semaphores[getCurrentFrameBasedIndex()],
@@ -101,7 +188,9 @@ uint32_t GraphicsContext::newFrame(std::shared_ptr<FrameBasedSemaphore> signalSe
         }
 
         vkDestroyRenderPass(device, swapchainRenderPass, nullptr);
+        vkDestroyRenderPass(device, swapchainLoadRenderPass, nullptr);
 
+        depthPyramid.reset();
         vkDestroyImageView(device, depthImageView, nullptr);
         vmaDestroyImage(allocator, depthImage.image, depthImage.allocation);
 
@@ -115,12 +204,16 @@ uint32_t GraphicsContext::newFrame(std::shared_ptr<FrameBasedSemaphore> signalSe
 
         initSwapchainRenderPass();
 
+        initDepthPyramid();
+
         swapchainResized = true;
     }
 
     return swapchainImageIndex;
 }
 
+uint32_t GraphicsContext::getFrameBasedIndex() { return getCurrentFrameBasedIndex(); }
+
 void GraphicsContext::beginRecording(std::shared_ptr<CommandBuffer> commandBuffer) {
     VK_CHECK(vkResetCommandBuffer(commandBuffer->commandBuffer, 0));
     VkCommandBufferBeginInfo cmdBeginInfo =
@@ -139,7 +232,7 @@ void GraphicsContext::beginRecording(std::shared_ptr<FrameBasedCommandBuffer> co
 
 void GraphicsContext::beginSwapchainRenderPass(
     std::shared_ptr<FrameBasedCommandBuffer> commandBuffer, uint32_t frameIndex,
-    glm::vec4 clearColor) {
+    glm::vec4 clearColor, bool secondaryContents) {
     VkClearValue clearValue;
     clearValue.color = { { clearColor.r, clearColor.g, clearColor.b, clearColor.a } };
 
@@ -160,12 +253,120 @@ void GraphicsContext::beginSwapchainRenderPass(
     rpBeginInfo.pClearValues          = &clearValues[0];
 
     vkCmdBeginRenderPass(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()], &rpBeginInfo,
-                         VK_SUBPASS_CONTENTS_INLINE);
+                         secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                           : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void GraphicsContext::continueSwapchainRenderPass(
+    std::shared_ptr<FrameBasedCommandBuffer> commandBuffer, uint32_t frameIndex,
+    bool secondaryContents) {
+    VkRenderPassBeginInfo rpBeginInfo = {};
+    rpBeginInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    rpBeginInfo.pNext                 = nullptr;
+    rpBeginInfo.renderPass            = swapchainLoadRenderPass;
+    rpBeginInfo.renderArea.offset.x   = 0;
+    rpBeginInfo.renderArea.offset.y   = 0;
+    rpBeginInfo.renderArea.extent     = currentSwapchainExtent;
+    rpBeginInfo.framebuffer           = swapchainFramebuffers[frameIndex];
+    rpBeginInfo.clearValueCount       = 0;
+    rpBeginInfo.pClearValues          = nullptr;
+
+    vkCmdBeginRenderPass(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()], &rpBeginInfo,
+                         secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                           : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void GraphicsContext::buildDepthPyramid(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer) {
+    VkCommandBuffer cmd = commandBuffer->commandBuffers[getCurrentFrameBasedIndex()];
+
+    VkImageSubresourceRange depthRange   = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+    VkImageSubresourceRange pyramidRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, depthPyramid->mipLevels,
+                                             0, 1 };
+
+    std::array<VkImageMemoryBarrier, 2> barriers = {};
+    for (auto& barrier : barriers) {
+        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext               = nullptr;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    barriers[0].srcAccessMask    = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].oldLayout        = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[0].image            = depthImage.image;
+    barriers[0].subresourceRange = depthRange;
+
+    // Whatever read the pyramid last is done with it, every level gets rewritten
+    barriers[1].srcAccessMask    = 0;
+    barriers[1].dstAccessMask    = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barriers[1].oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout        = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].image            = depthPyramid->image;
+    barriers[1].subresourceRange = pyramidRange;
+
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                         (uint32_t)barriers.size(), barriers.data());
+
+    bindPipeline(commandBuffer, depthPyramidPipeline);
+    for (uint32_t level = 0; level < depthPyramid->mipLevels; level++) {
+        bindDescriptorSet(commandBuffer, 0, depthPyramidDescriptorSets[level]);
+        pushConstants(commandBuffer, depthPyramidPipeline, 0, sizeof(uint32_t), &level);
+
+        uint32_t levelWidth  = std::max(depthPyramid->width >> level, 1u);
+        uint32_t levelHeight = std::max(depthPyramid->height >> level, 1u);
+        dispatch(commandBuffer, (levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+
+        // The next level is reduced from this one
+        VkImageMemoryBarrier levelBarrier          = barriers[1];
+        levelBarrier.srcAccessMask                 = VK_ACCESS_SHADER_WRITE_BIT;
+        levelBarrier.dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
+        levelBarrier.oldLayout                     = VK_IMAGE_LAYOUT_GENERAL;
+        levelBarrier.subresourceRange.baseMipLevel = level;
+        levelBarrier.subresourceRange.levelCount   = 1;
+
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &levelBarrier);
+    }
+
+    // Depth goes back to being an attachment for the pass that continues the frame, which also
+    // loads the color the pass before wrote
+    barriers[0].srcAccessMask = 0;
+    barriers[0].dstAccessMask =
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    barriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[1].oldLayout     = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkMemoryBarrier colorBarrier = {};
+    colorBarrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    colorBarrier.pNext           = nullptr;
+    colorBarrier.srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    colorBarrier.dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0, 1, &colorBarrier, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
 }
 
+std::shared_ptr<Texture> GraphicsContext::getDepthPyramid() { return depthPyramid; }
+
 void GraphicsContext::beginRenderPass(std::shared_ptr<CommandBuffer> commandBuffer,
                                       std::shared_ptr<RenderPass> renderPass, uint32_t width,
-                                      uint32_t height) {
+                                      uint32_t height, bool secondaryContents) {
     std::vector<VkClearValue> clearValues(renderPass->images.size());
     for (auto& clearValue : clearValues) {
         clearValue.color              = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -186,12 +387,44 @@ void GraphicsContext::beginRenderPass(std::shared_ptr<CommandBuffer> commandBuff
     rpBeginInfo.clearValueCount   = (uint32_t)clearValues.size();
     rpBeginInfo.pClearValues      = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer->commandBuffer, &rpBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer->commandBuffer, &rpBeginInfo,
+                         secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                           : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void GraphicsContext::recordSwapchainSecondary(
+    std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers,
+    uint32_t frameIndex, uint32_t itemCount,
+    std::function<void(std::shared_ptr<CommandBuffer>, uint32_t, uint32_t)> record) {
+    recordSecondary(secondaryCommandBuffers, swapchainRenderPass, swapchainFramebuffers[frameIndex],
+                    itemCount, record);
+}
+
+void GraphicsContext::recordSecondary(
+    std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers,
+    std::shared_ptr<RenderPass> renderPass, uint32_t itemCount,
+    std::function<void(std::shared_ptr<CommandBuffer>, uint32_t, uint32_t)> record) {
+    recordSecondary(secondaryCommandBuffers, renderPass->renderPass, renderPass->framebuffer,
+                    itemCount, record);
+}
+
+void GraphicsContext::executeSecondary(
+    std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+    std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers) {
+    uint32_t frameIndex = getCurrentFrameBasedIndex();
+
+    std::vector<VkCommandBuffer> commandBuffers;
+    for (auto& threadCommandBuffers : secondaryCommandBuffers->threadCommandBuffers) {
+        commandBuffers.push_back(threadCommandBuffers[frameIndex]->commandBuffer);
+    }
+
+    vkCmdExecuteCommands(commandBuffer->commandBuffers[frameIndex],
+                         (uint32_t)commandBuffers.size(), commandBuffers.data());
 }
 
 void GraphicsContext::beginRenderPass(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
                                       std::shared_ptr<RenderPass> renderPass, uint32_t width,
-                                      uint32_t height) {
+                                      uint32_t height, bool secondaryContents) {
     std::vector<VkClearValue> clearValues(renderPass->images.size());
     for (auto& clearValue : clearValues) {
         clearValue.color              = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -213,7 +446,8 @@ void GraphicsContext::beginRenderPass(std::shared_ptr<FrameBasedCommandBuffer> c
     rpBeginInfo.pClearValues      = clearValues.data();
 
     vkCmdBeginRenderPass(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()], &rpBeginInfo,
-                         VK_SUBPASS_CONTENTS_INLINE);
+                         secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                           : VK_SUBPASS_CONTENTS_INLINE);
 }
 
 void GraphicsContext::bindPipeline(std::shared_ptr<CommandBuffer> commandBuffer,
@@ -228,6 +462,18 @@ void GraphicsContext::bindPipeline(std::shared_ptr<FrameBasedCommandBuffer> comm
                       VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
 }
 
+void GraphicsContext::bindPipeline(std::shared_ptr<CommandBuffer> commandBuffer,
+                                   std::shared_ptr<ComputePipeline> pipeline) {
+    vkCmdBindPipeline(commandBuffer->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      pipeline->pipeline);
+}
+
+void GraphicsContext::bindPipeline(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                                   std::shared_ptr<ComputePipeline> pipeline) {
+    vkCmdBindPipeline(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()],
+                      VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+}
+
 void* GraphicsContext::mapDescriptorBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
                                            uint32_t binding) {
     uint32_t index           = getCurrentFrameBasedIndex();
@@ -246,7 +492,7 @@ void GraphicsContext::unmapDescriptorBuffer(std::shared_ptr<DescriptorSet> descr
 void GraphicsContext::bindDescriptorSet(std::shared_ptr<CommandBuffer> commandBuffer,
                                         uint32_t setIndex,
                                         std::shared_ptr<DescriptorSet> descriptorSet) {
-    vkCmdBindDescriptorSets(commandBuffer->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+    vkCmdBindDescriptorSets(commandBuffer->commandBuffer, descriptorSet->bindPoint,
                             descriptorSet->pipelineLayout, setIndex, 1,
                             &descriptorSet->descriptorSets[getCurrentFrameBasedIndex()], 0,
                             nullptr);
@@ -256,23 +502,37 @@ void GraphicsContext::bindDescriptorSet(std::shared_ptr<FrameBasedCommandBuffer>
                                         uint32_t setIndex,
                                         std::shared_ptr<DescriptorSet> descriptorSet) {
     uint32_t frameIndex = getCurrentFrameBasedIndex();
-    vkCmdBindDescriptorSets(commandBuffer->commandBuffers[frameIndex],
-                            VK_PIPELINE_BIND_POINT_GRAPHICS, descriptorSet->pipelineLayout,
-                            setIndex, 1, &descriptorSet->descriptorSets[frameIndex], 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer->commandBuffers[frameIndex], descriptorSet->bindPoint,
+                            descriptorSet->pipelineLayout, setIndex, 1,
+                            &descriptorSet->descriptorSets[frameIndex], 0, nullptr);
 }
 
 void GraphicsContext::pushConstants(std::shared_ptr<CommandBuffer> commandBuffer,
                                     std::shared_ptr<Pipeline> pipeline, uint32_t offset,
                                     uint32_t size, void* data) {
     vkCmdPushConstants(commandBuffer->commandBuffer, pipeline->layout,
-                       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, size, data);
+                       pushConstantStages(*pipeline, offset, size), offset, size, data);
 }
 
 void GraphicsContext::pushConstants(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
                                     std::shared_ptr<Pipeline> pipeline, uint32_t offset,
                                     uint32_t size, void* data) {
     vkCmdPushConstants(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()], pipeline->layout,
-                       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, size, data);
+                       pushConstantStages(*pipeline, offset, size), offset, size, data);
+}
+
+void GraphicsContext::pushConstants(std::shared_ptr<CommandBuffer> commandBuffer,
+                                    std::shared_ptr<ComputePipeline> pipeline, uint32_t offset,
+                                    uint32_t size, void* data) {
+    vkCmdPushConstants(commandBuffer->commandBuffer, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                       offset, size, data);
+}
+
+void GraphicsContext::pushConstants(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                                    std::shared_ptr<ComputePipeline> pipeline, uint32_t offset,
+                                    uint32_t size, void* data) {
+    vkCmdPushConstants(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()], pipeline->layout,
+                       VK_SHADER_STAGE_COMPUTE_BIT, offset, size, data);
 }
 
 void GraphicsContext::bindVertexBuffer(std::shared_ptr<CommandBuffer> commandBuffer,
@@ -300,6 +560,70 @@ void GraphicsContext::draw(std::shared_ptr<FrameBasedCommandBuffer> commandBuffe
               firstVertex, firstInstance);
 }
 
+void GraphicsContext::dispatch(std::shared_ptr<CommandBuffer> commandBuffer, uint32_t groupCountX,
+                               uint32_t groupCountY, uint32_t groupCountZ) {
+    vkCmdDispatch(commandBuffer->commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void GraphicsContext::dispatch(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                               uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+    vkCmdDispatch(commandBuffer->commandBuffers[getCurrentFrameBasedIndex()], groupCountX,
+                  groupCountY, groupCountZ);
+}
+
+void GraphicsContext::drawIndirectCount(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                                        std::shared_ptr<DescriptorSet> descriptorSet,
+                                        uint32_t binding, uint32_t maxDrawCount) {
+    uint32_t frameIndex = getCurrentFrameBasedIndex();
+    VkBuffer buffer     = descriptorSet->buffers[frameIndex][binding];
+
+    // The commands start after the count, which is padded out to 16 bytes
+    VkDeviceSize commandsOffset = 4 * sizeof(uint32_t);
+    if (drawIndirectCountFunction != nullptr) {
+        drawIndirectCountFunction(commandBuffer->commandBuffers[frameIndex], buffer, commandsOffset,
+                                  buffer, 0, maxDrawCount, sizeof(VkDrawIndirectCommand));
+    } else {
+        // Without the count the whole buffer is drawn, commands past it have no instances as long
+        // as the buffer was cleared before being written
+        vkCmdDrawIndirect(commandBuffer->commandBuffers[frameIndex], buffer, commandsOffset,
+                          maxDrawCount, sizeof(VkDrawIndirectCommand));
+    }
+}
+
+void GraphicsContext::clearDescriptorBuffer(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                                            std::shared_ptr<DescriptorSet> descriptorSet,
+                                            uint32_t binding) {
+    uint32_t frameIndex = getCurrentFrameBasedIndex();
+
+    vkCmdFillBuffer(commandBuffer->commandBuffers[frameIndex],
+                    descriptorSet->buffers[frameIndex][binding], 0, VK_WHOLE_SIZE, 0);
+}
+
+void GraphicsContext::descriptorBufferBarrier(
+    std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+    std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding, VkPipelineStageFlags srcStages,
+    VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) {
+    uint32_t frameIndex = getCurrentFrameBasedIndex();
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext                 = nullptr;
+    barrier.srcAccessMask         = srcAccess;
+    barrier.dstAccessMask         = dstAccess;
+    barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer                = descriptorSet->buffers[frameIndex][binding];
+    barrier.offset                = 0;
+    barrier.size                  = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer->commandBuffers[frameIndex], srcStages, dstStages, 0, 0,
+                         nullptr, 1, &barrier, 0, nullptr);
+}
+
+bool GraphicsContext::supportsDrawIndirectCount() { return drawIndirectCountFunction != nullptr; }
+
+bool GraphicsContext::supportsTextureCompressionBC() { return textureCompressionBC; }
+
 void GraphicsContext::endRenderPass(std::shared_ptr<CommandBuffer> commandBuffer) {
     vkCmdEndRenderPass(commandBuffer->commandBuffer);
 }
@@ -338,6 +662,38 @@ void GraphicsContext::transitionRenderPassImages(std::shared_ptr<CommandBuffer>
                          &imageBarrier_toTransfer);
 }
 
+void GraphicsContext::transitionTexture(std::shared_ptr<CommandBuffer> commandBuffer,
+                                        std::shared_ptr<Texture> texture,
+                                        ImageLayout initialLayout, ImageLayout finalLayout) {
+    VkImageSubresourceRange range;
+    range.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel   = 0;
+    range.levelCount     = texture->mipLevels;
+    range.baseArrayLayer = 0;
+    range.layerCount     = texture->arrayLayers;
+
+    VkImageMemoryBarrier imageBarrier = {};
+    imageBarrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.pNext                = nullptr;
+    imageBarrier.oldLayout            = helper::getVkImageLayout(initialLayout);
+    imageBarrier.newLayout            = helper::getVkImageLayout(finalLayout);
+    imageBarrier.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image                = texture->image;
+    imageBarrier.subresourceRange     = range;
+
+    // Undefined contents are discarded, so there are no earlier writes to make available
+    imageBarrier.srcAccessMask =
+        (initialLayout == ImageLayout::UNDEFINED)
+            ? 0
+            : helper::getVkAccessFlags(initialLayout, AccessType::SRC, false);
+    imageBarrier.dstAccessMask = helper::getVkAccessFlags(finalLayout, AccessType::DST, false);
+
+    vkCmdPipelineBarrier(commandBuffer->commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                         &imageBarrier);
+}
+
 void GraphicsContext::copyRenderPassImageToCubemap(std::shared_ptr<CommandBuffer> commandBuffer,
                                                    std::shared_ptr<RenderPass> renderPass,
                                                    uint32_t attachmentIndex,
@@ -607,8 +963,71 @@ void GraphicsContext::immediateSubmit(std::shared_ptr<CommandBuffer> commandBuff
     vkResetCommandPool(device, commandBuffer->commandPool, 0);
 }
 
+CommandList
+GraphicsContext::commandList(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer) {
+    uint32_t frameIndex = getCurrentFrameBasedIndex();
+
+    return CommandList(this, commandBuffer->commandBuffers[frameIndex], frameIndex);
+}
+
+CommandList GraphicsContext::commandList(std::shared_ptr<CommandBuffer> commandBuffer) {
+    return CommandList(this, commandBuffer->commandBuffer, getCurrentFrameBasedIndex());
+}
+
+PipelineHandle GraphicsContext::registerPipeline(std::shared_ptr<Pipeline> pipeline) {
+    return pipelineHandles.insert(pipeline);
+}
+
+DescriptorSetHandle
+GraphicsContext::registerDescriptorSet(std::shared_ptr<DescriptorSet> descriptorSet) {
+    return descriptorSetHandles.insert(descriptorSet);
+}
+
+VertexBufferHandle
+GraphicsContext::registerVertexBuffer(std::shared_ptr<VertexBuffer> vertexBuffer) {
+    return vertexBufferHandles.insert(vertexBuffer);
+}
+
+void GraphicsContext::release(PipelineHandle pipeline) { pipelineHandles.release(pipeline); }
+
+void GraphicsContext::release(DescriptorSetHandle descriptorSet) {
+    descriptorSetHandles.release(descriptorSet);
+}
+
+void GraphicsContext::release(VertexBufferHandle vertexBuffer) {
+    vertexBufferHandles.release(vertexBuffer);
+}
+
+Pipeline* GraphicsContext::resolve(PipelineHandle pipeline) {
+    return pipelineHandles.get(pipeline);
+}
+
+DescriptorSet* GraphicsContext::resolve(DescriptorSetHandle descriptorSet) {
+    return descriptorSetHandles.get(descriptorSet);
+}
+
+VertexBuffer* GraphicsContext::resolve(VertexBufferHandle vertexBuffer) {
+    return vertexBufferHandles.get(vertexBuffer);
+}
+
 void GraphicsContext::present(uint32_t frameIndex,
                               std::shared_ptr<FrameBasedSemaphore> waitSemaphore) {
+    if (!windowRef) {
+        // Nothing to present, the semaphore is only waited on so it can be signalled again
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo submit       = {};
+        submit.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.pNext              = nullptr;
+        submit.waitSemaphoreCount = 1;
+        submit.pWaitSemaphores    = &waitSemaphore->semaphores[getCurrentFrameBasedIndex()];
+        submit.pWaitDstStageMask  = &waitStage;
+        VK_CHECK(vkQueueSubmit(graphicsQueue, 1, &submit, VK_NULL_HANDLE));
+
+        numFrames++;
+        return;
+    }
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.pNext            = nullptr;
@@ -633,7 +1052,9 @@ void GraphicsContext::present(uint32_t frameIndex,
         }
 
         vkDestroyRenderPass(device, swapchainRenderPass, nullptr);
+        vkDestroyRenderPass(device, swapchainLoadRenderPass, nullptr);
 
+        depthPyramid.reset();
         vkDestroyImageView(device, depthImageView, nullptr);
         vmaDestroyImage(allocator, depthImage.image, depthImage.allocation);
 
@@ -647,6 +1068,8 @@ void GraphicsContext::present(uint32_t frameIndex,
 
         initSwapchainRenderPass();
 
+        initDepthPyramid();
+
         swapchainResized = true;
     }
 
@@ -691,6 +1114,36 @@ std::shared_ptr<FrameBasedCommandBuffer> GraphicsContext::createFrameBasedComman
     return std::make_shared<FrameBasedCommandBuffer>(device, commandPools, commandBuffers);
 }
 
+std::shared_ptr<FrameBasedSecondaryCommandBuffers>
+GraphicsContext::createFrameBasedSecondaryCommandBuffers(uint32_t threadCount) {
+    // recordSecondary splits the items over the buffers, so there is always at least one
+    threadCount = std::max(threadCount, 1u);
+
+    // The pools are reset whole every frame rather than per buffer
+    VkCommandPoolCreateInfo commandPoolCreateInfo =
+        helper::commandPoolCreateInfo(graphicsQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+    std::vector<std::array<std::shared_ptr<CommandBuffer>, FRAME_OVERLAP>> threadCommandBuffers(
+        threadCount);
+    for (auto& frameCommandBuffers : threadCommandBuffers) {
+        for (int i = 0; i < FRAME_OVERLAP; i++) {
+            VkCommandPool commandPool;
+            VK_CHECK(vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
+
+            VkCommandBufferAllocateInfo commandAllocInfo = helper::commandBufferAllocateInfo(
+                commandPool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+            VkCommandBuffer commandBuffer;
+            VK_CHECK(vkAllocateCommandBuffers(device, &commandAllocInfo, &commandBuffer));
+
+            frameCommandBuffers[i] =
+                std::make_shared<CommandBuffer>(device, commandPool, commandBuffer);
+        }
+    }
+
+    return std::make_shared<FrameBasedSecondaryCommandBuffers>(threadCommandBuffers);
+}
+
 std::shared_ptr<FrameBasedFence> GraphicsContext::createFrameBasedFence(bool createSignaled) {
     VkFenceCreateInfo fenceCreateInfo =
         helper::fenceCreateInfo(createSignaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0U);
@@ -719,7 +1172,8 @@ std::shared_ptr<FrameBasedSemaphore> GraphicsContext::createFrameBasedSemaphore(
 
 std::shared_ptr<RenderPass> GraphicsContext::createRenderPass(
     std::vector<RenderPassAttachmentDescription> renderPassAttachmentDescriptions,
-    bool useDepthAttachment, RenderPassAttachmentDescription depthAttachmentDescription) {
+    bool useDepthAttachment, RenderPassAttachmentDescription depthAttachmentDescription,
+    uint32_t viewCount) {
 
     std::vector<VkAttachmentDescription> colorDescriptions;
     std::vector<VkAttachmentReference> colorReferences;
@@ -796,18 +1250,59 @@ std::shared_ptr<RenderPass> GraphicsContext::createRenderPass(
     renderPassCreateInfo.dependencyCount        = 0;
     renderPassCreateInfo.pDependencies          = nullptr;
 
+    // Every view of the subpass is broadcast to the layer of the same index, gl_ViewIndex picks
+    // the per view data in the shaders
+    uint32_t viewMask = (1u << viewCount) - 1;
+
+    VkRenderPassMultiviewCreateInfo multiviewCreateInfo = {};
+    multiviewCreateInfo.sType                = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+    multiviewCreateInfo.pNext                = nullptr;
+    multiviewCreateInfo.subpassCount         = 1;
+    multiviewCreateInfo.pViewMasks           = &viewMask;
+    multiviewCreateInfo.correlationMaskCount = 1;
+    multiviewCreateInfo.pCorrelationMasks    = &viewMask;
+
+    if (viewCount > 1) {
+        renderPassCreateInfo.pNext = &multiviewCreateInfo;
+    }
+
     VkRenderPass renderPass;
     VK_CHECK(vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, &renderPass));
 
     std::vector<VkImage> framebufferImages;
     std::vector<VmaAllocation> framebufferImageAllocations;
     std::vector<VkImageView> framebufferImageViews;
+    std::vector<std::shared_ptr<Texture>> framebufferTargets;
     for (int i = 0; i < allAttachmentDescriptions.size(); i++) {
         bool isColorAttachment = true;
         if (i >= renderPassAttachmentDescriptions.size()) {
             isColorAttachment = false;
         }
 
+        RenderPassAttachmentDescription& attachmentDescription =
+            isColorAttachment ? renderPassAttachmentDescriptions[i] : depthAttachmentDescription;
+        VkImageAspectFlags aspect =
+            isColorAttachment ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+
+        if (attachmentDescription.target) {
+            VkImageViewCreateInfo targetViewCreateInfo = helper::imageViewCreateInfo(
+                allAttachmentDescriptions[i].format, attachmentDescription.target->image, aspect);
+            targetViewCreateInfo.viewType =
+                viewCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            targetViewCreateInfo.subresourceRange.baseMipLevel =
+                attachmentDescription.targetMipLevel;
+            targetViewCreateInfo.subresourceRange.layerCount = viewCount;
+            VkImageView targetView;
+            VK_CHECK(vkCreateImageView(device, &targetViewCreateInfo, nullptr, &targetView));
+
+            // A null allocation keeps the attachment indices lined up with the owned images
+            framebufferImages.push_back(attachmentDescription.target->image);
+            framebufferImageAllocations.push_back(VK_NULL_HANDLE);
+            framebufferImageViews.push_back(targetView);
+            framebufferTargets.push_back(attachmentDescription.target);
+            continue;
+        }
+
         VkImageCreateInfo imageCreateInfo = {};
         imageCreateInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         imageCreateInfo.pNext             = nullptr;
@@ -819,7 +1314,7 @@ std::shared_ptr<RenderPass> GraphicsContext::createRenderPass(
                           renderPassAttachmentDescriptions[i].height, 1 }
                        : VkExtent3D{ depthAttachmentDescription.width, depthAttachmentDescription.height, 1 };
         imageCreateInfo.mipLevels         = 1;
-        imageCreateInfo.arrayLayers       = 1;
+        imageCreateInfo.arrayLayers       = viewCount;
         imageCreateInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
         imageCreateInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
         imageCreateInfo.usage       = isColorAttachment ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
@@ -831,21 +1326,41 @@ std::shared_ptr<RenderPass> GraphicsContext::createRenderPass(
         imageCreateInfo.pQueueFamilyIndices   = nullptr;
         imageCreateInfo.initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED;
 
+        // Contents that are neither loaded nor stored never leave the pass, so on tiled GPUs they
+        // can stay in tile memory and the image needs no real backing
+        bool transient = attachmentDescription.loadOp != LoadOp::LOAD &&
+                         attachmentDescription.storeOp == StoreOp::DONT_CARE;
+        if (transient) {
+            imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT |
+                                    (isColorAttachment
+                                         ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                                         : VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        }
+
         VmaAllocationCreateInfo imageAllocationInfo = {};
-        imageAllocationInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+        imageAllocationInfo.usage =
+            transient ? VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED : VMA_MEMORY_USAGE_GPU_ONLY;
 
         VkImage image;
         VmaAllocation allocation;
 
-        VK_CHECK(vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo, &image,
-                                &allocation, nullptr));
+        // Desktop GPUs have no lazily allocated memory type
+        if (vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo, &image, &allocation,
+                           nullptr) != VK_SUCCESS) {
+            imageAllocationInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+            VK_CHECK(vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo, &image,
+                                    &allocation, nullptr));
+        }
 
         framebufferImages.push_back(image);
         framebufferImageAllocations.push_back(allocation);
 
-        VkImageViewCreateInfo imageViewCreateInfo = helper::imageViewCreateInfo(
-            allAttachmentDescriptions[i].format, image,
-            isColorAttachment ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT);
+        VkImageViewCreateInfo imageViewCreateInfo =
+            helper::imageViewCreateInfo(allAttachmentDescriptions[i].format, image, aspect);
+        if (viewCount > 1) {
+            imageViewCreateInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+            imageViewCreateInfo.subresourceRange.layerCount = viewCount;
+        }
         VkImageView imageView;
         VK_CHECK(vkCreateImageView(device, &imageViewCreateInfo, nullptr, &imageView));
 
@@ -868,7 +1383,7 @@ std::shared_ptr<RenderPass> GraphicsContext::createRenderPass(
 
     return std::make_shared<RenderPass>(device, allocator, renderPass, framebuffer,
                                         framebufferImages, framebufferImageAllocations,
-                                        framebufferImageViews);
+                                        framebufferImageViews, framebufferTargets);
 }
 
 int getDescriptorSetIndex(ShaderModule& shaderModule, uint32_t setNumber) {
@@ -936,11 +1451,6 @@ std::shared_ptr<Pipeline> GraphicsContext::createPipeline(PipelineCreateInfo* pi
 
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
     for (unsigned int i = 0; i < maxDescriptorSetCount; i++) {
-        VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
-        setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        setLayoutInfo.pNext = nullptr;
-        setLayoutInfo.flags = 0;
-
         uint32_t maxBindingCount = 0;
         maxBindingCount          = getMaxBinding(maxBindingCount, vertexShaderModule, i);
         maxBindingCount          = getMaxBinding(maxBindingCount, fragmentShaderModule, i);
@@ -981,25 +1491,31 @@ std::shared_ptr<Pipeline> GraphicsContext::createPipeline(PipelineCreateInfo* pi
             }
         }
 
-        setLayoutInfo.pBindings    = bindings.data();
-        setLayoutInfo.bindingCount = (uint32_t)bindings.size();
+        descriptorSetLayouts.push_back(getDescriptorSetLayout(bindings));
+    }
+
+    VkPipelineLayout pipelineLayout =
+        getPipelineLayout(descriptorSetLayouts, combinedPushConstants);
 
-        VkDescriptorSetLayout layout;
-        VK_CHECK(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &layout));
-        descriptorSetLayouts.push_back(layout);
+    VkPipeline pipeline = buildGraphicsPipeline(pipelineCreateInfo, vertexShaderModule,
+                                                fragmentShaderModule, pipelineLayout);
+    if (pipeline == VK_NULL_HANDLE) {
+        return nullptr;
     }
 
-    // Create Pipeline Layout
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = helper::pipelineLayoutCreateInfo();
+    auto createdPipeline =
+        std::make_shared<Pipeline>(device, pipeline, pipelineLayout, descriptorSetLayouts,
+                                   combinedPushConstants, *pipelineCreateInfo);
 
-    pipelineLayoutCreateInfo.pPushConstantRanges    = combinedPushConstants.data();
-    pipelineLayoutCreateInfo.pushConstantRangeCount = (uint32_t)combinedPushConstants.size();
-    pipelineLayoutCreateInfo.pSetLayouts            = descriptorSetLayouts.data();
-    pipelineLayoutCreateInfo.setLayoutCount         = (uint32_t)descriptorSetLayouts.size();
+    hotReloadPipelines.push_back(createdPipeline);
 
-    VkPipelineLayout pipelineLayout;
-    VK_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
+    return createdPipeline;
+}
 
+VkPipeline GraphicsContext::buildGraphicsPipeline(PipelineCreateInfo* pipelineCreateInfo,
+                                                  ShaderModule& vertexShaderModule,
+                                                  ShaderModule& fragmentShaderModule,
+                                                  VkPipelineLayout pipelineLayout) {
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
     pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.pNext                        = nullptr;
@@ -1117,103 +1633,643 @@ std::shared_ptr<Pipeline> GraphicsContext::createPipeline(PipelineCreateInfo* pi
         return VK_NULL_HANDLE;
     }
 
-    return std::make_shared<Pipeline>(device, pipeline, pipelineLayout, descriptorSetLayouts);
+    return pipeline;
 }
 
-std::shared_ptr<DescriptorSet>
-GraphicsContext::createDescriptorSet(std::shared_ptr<Pipeline> pipeline, uint32_t setLayoutIndex) {
+std::shared_ptr<ComputePipeline>
+GraphicsContext::createComputePipeline(const char* computeShaderPath) {
+    ShaderModule computeShaderModule = loadShaderModule(computeShaderPath);
 
-    VkDescriptorSetAllocateInfo allocateInfo = {};
-    allocateInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocateInfo.pNext                       = nullptr;
-    allocateInfo.descriptorPool              = globalDescriptorPool;
-    allocateInfo.descriptorSetCount          = 1;
-    if (pipeline->descriptorSetLayouts.size() > setLayoutIndex) {
-        allocateInfo.pSetLayouts = &pipeline->descriptorSetLayouts[setLayoutIndex];
-    } else {
-        Logger::renderer_logger->error("Invalid descriptor set index specified");
+    uint32_t maxDescriptorSetCount = getMaxSet(computeShaderModule.reflectionData.descriptorSets);
+
+    // A single stage, so the reflected bindings are the layout as is
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+    for (unsigned int i = 0; i < maxDescriptorSetCount; i++) {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+        int setIndex = getDescriptorSetIndex(computeShaderModule, i);
+        if (setIndex != -1) {
+            bindings = computeShaderModule.reflectionData.descriptorSets[setIndex].bindings;
+        }
+
+        descriptorSetLayouts.push_back(getDescriptorSetLayout(bindings));
     }
 
-    std::array<VkDescriptorSet, FRAME_OVERLAP> descriptorSets;
-    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
-        vkAllocateDescriptorSets(device, &allocateInfo, &descriptorSets[i]);
+    VkPipelineLayout pipelineLayout =
+        getPipelineLayout(descriptorSetLayouts, computeShaderModule.reflectionData.pushConstants);
+
+    VkPipeline pipeline = buildComputePipeline(computeShaderModule, pipelineLayout);
+    if (pipeline == VK_NULL_HANDLE) {
+        return nullptr;
     }
 
-    return std::make_shared<DescriptorSet>(allocator, descriptorSets, pipeline->layout);
+    auto createdPipeline = std::make_shared<ComputePipeline>(
+        device, pipeline, pipelineLayout, descriptorSetLayouts, computeShaderPath);
+
+    hotReloadComputePipelines.push_back(createdPipeline);
+
+    return createdPipeline;
 }
 
-void GraphicsContext::descriptorSetAddBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
-                                             uint32_t binding, DescriptorType type,
-                                             uint32_t bufferSize) {
+VkPipeline GraphicsContext::buildComputePipeline(ShaderModule& computeShaderModule,
+                                                 VkPipelineLayout pipelineLayout) {
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext                       = nullptr;
+    pipelineInfo.stage                       = computeShaderModule.shaderStageInfo;
+    pipelineInfo.layout                      = pipelineLayout;
 
-    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
-        VkBufferCreateInfo bufferCreateInfo = {};
-        bufferCreateInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferCreateInfo.pNext              = nullptr;
-        bufferCreateInfo.size               = bufferSize;
-        if (type == DescriptorType::UNIFORM_BUFFER) {
-            bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        } else if (type == DescriptorType::STORAGE_BUFFER) {
-            bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) !=
+        VK_SUCCESS) {
+        Logger::renderer_logger->error("Failed to create compute pipeline");
+        return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+}
+
+void GraphicsContext::setShaderCompileOptions(ShaderCompileOptions compileOptions) {
+    shaderCompileOptions = compileOptions;
+}
+
+void GraphicsContext::enableShaderHotReload(const char* shaderDirectory) {
+    shaderWatcher = std::make_unique<ShaderWatcher>(shaderDirectory, shaderCompileOptions);
+}
+
+void GraphicsContext::useJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+
+void GraphicsContext::applyShaderReloads(std::shared_ptr<FrameBasedFence> inFlightFence) {
+    if (!shaderWatcher) {
+        return;
+    }
+
+    std::vector<CompiledShader> compiledShaders = shaderWatcher->takeCompiledShaders();
+    if (compiledShaders.empty()) {
+        return;
+    }
+
+    std::set<std::string> changedPaths;
+    for (auto& compiledShader : compiledShaders) {
+        if (compiledShader.spvBytes.empty()) {
+            Logger::renderer_logger->error("Keeping previous pipelines for shader: {0}",
+                                           compiledShader.path);
+            continue;
         }
 
-        VmaAllocationCreateInfo vmaallocInfo = {};
-        vmaallocInfo.usage                   = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        shaderSpvCache[compiledShader.path] = compiledShader.spvBytes;
+        changedPaths.insert(compiledShader.path);
+    }
 
-        VmaAllocation allocation;
-        VkBuffer buffer;
+    hotReloadPipelines.erase(
+        std::remove_if(hotReloadPipelines.begin(), hotReloadPipelines.end(),
+                       [](std::weak_ptr<Pipeline>& pipeline) { return pipeline.expired(); }),
+        hotReloadPipelines.end());
+
+    std::vector<std::shared_ptr<Pipeline>> affectedPipelines;
+    for (auto& weakPipeline : hotReloadPipelines) {
+        std::shared_ptr<Pipeline> pipeline = weakPipeline.lock();
+        if (changedPaths.count(helper::normalizeShaderPath(pipeline->vertexShaderPath)) ||
+            changedPaths.count(helper::normalizeShaderPath(pipeline->fragmentShaderPath))) {
+            affectedPipelines.push_back(pipeline);
+        }
+    }
 
-        // allocate the buffer
-        VK_CHECK(vmaCreateBuffer(allocator, &bufferCreateInfo, &vmaallocInfo, &buffer, &allocation,
-                                 nullptr));
+    hotReloadComputePipelines.erase(
+        std::remove_if(
+            hotReloadComputePipelines.begin(), hotReloadComputePipelines.end(),
+            [](std::weak_ptr<ComputePipeline>& pipeline) { return pipeline.expired(); }),
+        hotReloadComputePipelines.end());
+
+    std::vector<std::shared_ptr<ComputePipeline>> affectedComputePipelines;
+    for (auto& weakPipeline : hotReloadComputePipelines) {
+        std::shared_ptr<ComputePipeline> pipeline = weakPipeline.lock();
+        if (changedPaths.count(helper::normalizeShaderPath(pipeline->computeShaderPath))) {
+            affectedComputePipelines.push_back(pipeline);
+        }
+    }
 
-        descriptorSet->buffers[i][binding]     = buffer;
-        descriptorSet->allocations[i][binding] = allocation;
+    if (affectedPipelines.empty() && affectedComputePipelines.empty()) {
+        return;
+    }
 
-        assert(descriptorSet->allocations[i][binding]);
+    // The old pipelines may still be referenced by in flight frames. No timeout, a slow frame
+    // mustn't abort the reload
+    VK_CHECK(vkWaitForFences(device, FRAME_OVERLAP, inFlightFence->fences.data(), VK_TRUE,
+                             UINT64_MAX));
+
+    for (auto& pipeline : affectedPipelines) {
+        auto vertexSpv =
+            shaderSpvCache.find(helper::normalizeShaderPath(pipeline->vertexShaderPath));
+        auto fragmentSpv =
+            shaderSpvCache.find(helper::normalizeShaderPath(pipeline->fragmentShaderPath));
+        if (vertexSpv == shaderSpvCache.end() || fragmentSpv == shaderSpvCache.end()) {
+            continue;
+        }
 
-        VkDescriptorBufferInfo bufferInfo = {};
-        bufferInfo.buffer                 = descriptorSet->buffers[i][binding];
-        bufferInfo.offset                 = 0;
-        bufferInfo.range                  = bufferSize;
+        ShaderModule vertexShaderModule =
+            createShaderModule(pipeline->vertexShaderPath.c_str(), vertexSpv->second);
+        ShaderModule fragmentShaderModule =
+            createShaderModule(pipeline->fragmentShaderPath.c_str(), fragmentSpv->second);
+
+        // The existing layout is reused so descriptor sets stay valid. Changing the descriptor or
+        // push constant interface of a shader still needs a restart
+        VkPipeline rebuiltPipeline = buildGraphicsPipeline(
+            &pipeline->createInfo, vertexShaderModule, fragmentShaderModule, pipeline->layout);
+        if (rebuiltPipeline == VK_NULL_HANDLE) {
+            Logger::renderer_logger->error("Keeping previous pipeline for: {0}, {1}",
+                                           pipeline->vertexShaderPath,
+                                           pipeline->fragmentShaderPath);
+            continue;
+        }
 
-        VkWriteDescriptorSet setWrite = {};
-        setWrite.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        setWrite.pNext                = nullptr;
-        setWrite.dstBinding           = binding;
-        setWrite.dstSet               = descriptorSet->descriptorSets[i];
-        setWrite.descriptorCount      = 1;
-        setWrite.descriptorType       = helper::getVkDescriptorType(type);
-        setWrite.pBufferInfo          = &bufferInfo;
+        vkDestroyPipeline(device, pipeline->pipeline, nullptr);
+        pipeline->pipeline = rebuiltPipeline;
 
-        vkUpdateDescriptorSets(device, 1, &setWrite, 0, nullptr);
+        Logger::renderer_logger->info("Reloaded pipeline: {0}, {1}", pipeline->vertexShaderPath,
+                                      pipeline->fragmentShaderPath);
     }
-}
 
-void GraphicsContext::descriptorSetAddImage(std::shared_ptr<DescriptorSet> descriptorSet,
-                                            uint32_t binding, std::shared_ptr<Texture> image) {
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.sampler               = mainSampler;
-    imageInfo.imageView             = image->imageView;
-    imageInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    for (auto& pipeline : affectedComputePipelines) {
+        auto computeSpv =
+            shaderSpvCache.find(helper::normalizeShaderPath(pipeline->computeShaderPath));
+        if (computeSpv == shaderSpvCache.end()) {
+            continue;
+        }
 
-    for (int i = 0; i < FRAME_OVERLAP; i++) {
-        VkWriteDescriptorSet write = {};
-        write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.pNext                = nullptr;
+        ShaderModule computeShaderModule =
+            createShaderModule(pipeline->computeShaderPath.c_str(), computeSpv->second);
 
-        write.dstBinding      = binding;
-        write.dstSet          = descriptorSet->descriptorSets[i];
-        write.descriptorCount = 1;
-        write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        write.pImageInfo      = &imageInfo;
+        VkPipeline rebuiltPipeline = buildComputePipeline(computeShaderModule, pipeline->layout);
+        if (rebuiltPipeline == VK_NULL_HANDLE) {
+            Logger::renderer_logger->error("Keeping previous compute pipeline for: {0}",
+                                           pipeline->computeShaderPath);
+            continue;
+        }
 
-        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        vkDestroyPipeline(device, pipeline->pipeline, nullptr);
+        pipeline->pipeline = rebuiltPipeline;
+
+        Logger::renderer_logger->info("Reloaded compute pipeline: {0}",
+                                      pipeline->computeShaderPath);
     }
 }
 
-void GraphicsContext::descriptorSetAddRenderPassAttachment(
-    std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+VkDescriptorSetLayout
+GraphicsContext::getDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    std::vector<VkDescriptorSetLayoutBinding> sortedBindings = bindings;
+    std::sort(sortedBindings.begin(), sortedBindings.end(),
+              [](VkDescriptorSetLayoutBinding a, VkDescriptorSetLayoutBinding b) {
+                  return a.binding < b.binding;
+              });
+
+    // Reflection never produces immutable samplers, so these fields fully describe a layout
+    std::vector<uint32_t> key;
+    for (auto& binding : sortedBindings) {
+        key.push_back(binding.binding);
+        key.push_back((uint32_t)binding.descriptorType);
+        key.push_back(binding.descriptorCount);
+        key.push_back(binding.stageFlags);
+    }
+
+    auto cached = descriptorSetLayoutCache.find(key);
+    if (cached != descriptorSetLayoutCache.end()) {
+        return cached->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.pNext        = nullptr;
+    setLayoutInfo.flags        = 0;
+    setLayoutInfo.pBindings    = sortedBindings.data();
+    setLayoutInfo.bindingCount = (uint32_t)sortedBindings.size();
+
+    VkDescriptorSetLayout layout;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &layout));
+
+    descriptorSetLayoutCache[key] = layout;
+
+    return layout;
+}
+
+VkPipelineLayout
+GraphicsContext::getPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+                                   std::vector<VkPushConstantRange>& pushConstants) {
+    // Set layouts are already deduplicated, so their handles identify them
+    std::vector<uint64_t> key;
+    for (auto& setLayout : descriptorSetLayouts) {
+        key.push_back((uint64_t)setLayout);
+    }
+    key.push_back(pushConstants.size());
+    for (auto& pushConstant : pushConstants) {
+        key.push_back(pushConstant.stageFlags);
+        key.push_back(pushConstant.offset);
+        key.push_back(pushConstant.size);
+    }
+
+    auto cached = pipelineLayoutCache.find(key);
+    if (cached != pipelineLayoutCache.end()) {
+        return cached->second;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = helper::pipelineLayoutCreateInfo();
+
+    pipelineLayoutCreateInfo.pPushConstantRanges    = pushConstants.data();
+    pipelineLayoutCreateInfo.pushConstantRangeCount = (uint32_t)pushConstants.size();
+    pipelineLayoutCreateInfo.pSetLayouts            = descriptorSetLayouts.data();
+    pipelineLayoutCreateInfo.setLayoutCount         = (uint32_t)descriptorSetLayouts.size();
+
+    VkPipelineLayout pipelineLayout;
+    VK_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
+
+    pipelineLayoutCache[key] = pipelineLayout;
+
+    return pipelineLayout;
+}
+
+std::shared_ptr<DescriptorSet>
+GraphicsContext::createDescriptorSet(std::shared_ptr<Pipeline> pipeline, uint32_t setLayoutIndex) {
+    return allocateDescriptorSet(pipeline->descriptorSetLayouts, setLayoutIndex, pipeline->layout,
+                                 VK_PIPELINE_BIND_POINT_GRAPHICS);
+}
+
+std::shared_ptr<DescriptorSet>
+GraphicsContext::createDescriptorSet(std::shared_ptr<ComputePipeline> pipeline,
+                                     uint32_t setLayoutIndex) {
+    return allocateDescriptorSet(pipeline->descriptorSetLayouts, setLayoutIndex, pipeline->layout,
+                                 VK_PIPELINE_BIND_POINT_COMPUTE);
+}
+
+std::shared_ptr<DescriptorSet>
+GraphicsContext::allocateDescriptorSet(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+                                       uint32_t setLayoutIndex, VkPipelineLayout pipelineLayout,
+                                       VkPipelineBindPoint bindPoint) {
+
+    VkDescriptorSetAllocateInfo allocateInfo = {};
+    allocateInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext                       = nullptr;
+    allocateInfo.descriptorPool              = globalDescriptorPool;
+    allocateInfo.descriptorSetCount          = 1;
+    if (descriptorSetLayouts.size() > setLayoutIndex) {
+        allocateInfo.pSetLayouts = &descriptorSetLayouts[setLayoutIndex];
+    } else {
+        Logger::renderer_logger->error("Invalid descriptor set index specified");
+    }
+
+    std::array<VkDescriptorSet, FRAME_OVERLAP> descriptorSets;
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+        vkAllocateDescriptorSets(device, &allocateInfo, &descriptorSets[i]);
+    }
+
+    return std::make_shared<DescriptorSet>(allocator, descriptorSets, pipelineLayout, bindPoint);
+}
+
+void GraphicsContext::descriptorSetAddBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
+                                             uint32_t binding, DescriptorType type,
+                                             uint32_t bufferSize) {
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+        createDescriptorBuffer(type, bufferSize, descriptorSet->buffers[i][binding],
+                               descriptorSet->allocations[i][binding]);
+
+        assert(descriptorSet->allocations[i][binding]);
+
+        writeDescriptorBuffer(descriptorSet, binding, type, i, bufferSize);
+    }
+
+    descriptorSet->bufferSizes[binding] = bufferSize;
+}
+
+void GraphicsContext::createDescriptorBuffer(DescriptorType type, uint32_t bufferSize,
+                                             VkBuffer& buffer, VmaAllocation& allocation) {
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext              = nullptr;
+    bufferCreateInfo.size               = bufferSize;
+    if (type == DescriptorType::UNIFORM_BUFFER) {
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    } else if (type == DescriptorType::STORAGE_BUFFER) {
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    } else if (type == DescriptorType::INDIRECT_BUFFER) {
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+
+    VmaAllocationCreateInfo vmaallocInfo = {};
+    vmaallocInfo.usage                   = VMA_MEMORY_USAGE_CPU_TO_GPU;
+
+    // allocate the buffer
+    VK_CHECK(vmaCreateBuffer(allocator, &bufferCreateInfo, &vmaallocInfo, &buffer, &allocation,
+                             nullptr));
+}
+
+void GraphicsContext::writeDescriptorBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
+                                            uint32_t binding, DescriptorType type,
+                                            uint32_t frameIndex, uint32_t bufferSize) {
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer                 = descriptorSet->buffers[frameIndex][binding];
+    bufferInfo.offset                 = 0;
+    bufferInfo.range                  = bufferSize;
+
+    VkWriteDescriptorSet setWrite = {};
+    setWrite.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    setWrite.pNext                = nullptr;
+    setWrite.dstBinding           = binding;
+    setWrite.dstSet               = descriptorSet->descriptorSets[frameIndex];
+    setWrite.descriptorCount      = 1;
+    setWrite.descriptorType       = helper::getVkDescriptorType(type);
+    setWrite.pBufferInfo          = &bufferInfo;
+
+    vkUpdateDescriptorSets(device, 1, &setWrite, 0, nullptr);
+}
+
+bool GraphicsContext::descriptorSetGrowBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
+                                              uint32_t binding, DescriptorType type,
+                                              uint32_t bufferSize, uint32_t preserveSize) {
+    uint32_t currentSize = getDescriptorBufferSize(descriptorSet, binding);
+    if (bufferSize <= currentSize) {
+        return false;
+    }
+
+    uint32_t newSize = std::max(currentSize, 1u);
+    while (newSize < bufferSize) {
+        newSize *= 2;
+    }
+
+    // Nothing to replace or keep, no frame can be using the binding yet
+    if (currentSize == 0) {
+        descriptorSetAddBuffer(descriptorSet, binding, type, newSize);
+
+        for (auto& share : descriptorSet->bufferShares) {
+            std::shared_ptr<DescriptorSet> sharingDescriptorSet = share.descriptorSet.lock();
+            if (sharingDescriptorSet && share.sourceBinding == binding) {
+                writeSharedBuffer(sharingDescriptorSet, share.binding, descriptorSet,
+                                  share.sourceBinding, share.type, share.frameOffset);
+            }
+        }
+
+        return true;
+    }
+
+    descriptorSet->bufferSizes[binding] = newSize;
+
+    auto growth = std::find_if(pendingBufferGrowths.begin(), pendingBufferGrowths.end(),
+                               [&](const PendingBufferGrowth& pending) {
+                                   return pending.descriptorSet.lock() == descriptorSet &&
+                                          pending.binding == binding;
+                               });
+    if (growth == pendingBufferGrowths.end()) {
+        pendingBufferGrowths.push_back({ descriptorSet, binding, type, 0, {}, {} });
+        growth = std::prev(pendingBufferGrowths.end());
+    }
+    growth->preserveSize = std::max(growth->preserveSize, preserveSize);
+
+    // Every frame's replacement exists from now on, so a set sharing the buffer of another frame
+    // never binds one smaller than the binding
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+        // Growing again before the last growth reached every frame, sets in flight may share it
+        if (growth->buffers[i]) {
+            retiredBuffers.push_back({ growth->buffers[i], growth->allocations[i], numFrames });
+        }
+
+        createDescriptorBuffer(type, newSize, growth->buffers[i], growth->allocations[i]);
+    }
+
+    applyBufferGrowth(*growth, getCurrentFrameBasedIndex());
+
+    return true;
+}
+
+void GraphicsContext::applyBufferGrowth(PendingBufferGrowth& growth, uint32_t frameIndex) {
+    std::shared_ptr<DescriptorSet> descriptorSet = growth.descriptorSet.lock();
+    if (!descriptorSet || !growth.buffers[frameIndex]) {
+        return;
+    }
+
+    VkBuffer& buffer          = descriptorSet->buffers[frameIndex][growth.binding];
+    VmaAllocation& allocation = descriptorSet->allocations[frameIndex][growth.binding];
+    uint32_t newSize          = descriptorSet->bufferSizes[growth.binding];
+
+    if (growth.preserveSize > 0) {
+        VmaAllocationInfo oldAllocationInfo;
+        vmaGetAllocationInfo(allocator, allocation, &oldAllocationInfo);
+        VkDeviceSize copySize = std::min<VkDeviceSize>(
+            std::min<VkDeviceSize>(growth.preserveSize, oldAllocationInfo.size), newSize);
+
+        void* oldData;
+        void* newData;
+        VK_CHECK(vmaMapMemory(allocator, allocation, &oldData));
+        VK_CHECK(vmaMapMemory(allocator, growth.allocations[frameIndex], &newData));
+        memcpy(newData, oldData, copySize);
+        vmaUnmapMemory(allocator, growth.allocations[frameIndex]);
+        vmaUnmapMemory(allocator, allocation);
+    }
+
+    // Sets of frames still in flight may share it
+    retiredBuffers.push_back({ buffer, allocation, numFrames });
+
+    buffer                         = growth.buffers[frameIndex];
+    allocation                     = growth.allocations[frameIndex];
+    growth.buffers[frameIndex]     = VK_NULL_HANDLE;
+    growth.allocations[frameIndex] = nullptr;
+
+    writeDescriptorBuffer(descriptorSet, growth.binding, growth.type, frameIndex, newSize);
+
+    // Only this frame's sets, the other frames may still be in flight
+    for (auto& share : descriptorSet->bufferShares) {
+        std::shared_ptr<DescriptorSet> sharingDescriptorSet = share.descriptorSet.lock();
+        if (sharingDescriptorSet && share.sourceBinding == growth.binding) {
+            writeSharedBuffer(sharingDescriptorSet, share.binding, descriptorSet,
+                              share.sourceBinding, share.type, share.frameOffset, frameIndex);
+        }
+    }
+}
+
+void GraphicsContext::applyBufferGrowths() {
+    uint32_t frameIndex = getCurrentFrameBasedIndex();
+
+    for (auto& growth : pendingBufferGrowths) {
+        applyBufferGrowth(growth, frameIndex);
+    }
+
+    for (size_t i = 0; i < pendingBufferGrowths.size();) {
+        PendingBufferGrowth& growth = pendingBufferGrowths[i];
+        bool pending                = false;
+        for (unsigned int j = 0; j < FRAME_OVERLAP; j++) {
+            pending = pending || growth.buffers[j];
+        }
+        if (pending && !growth.descriptorSet.expired()) {
+            i++;
+            continue;
+        }
+
+        // Never swapped in, only this growth knows of them
+        for (unsigned int j = 0; j < FRAME_OVERLAP; j++) {
+            if (growth.buffers[j]) {
+                retiredBuffers.push_back({ growth.buffers[j], growth.allocations[j], numFrames });
+            }
+        }
+        pendingBufferGrowths.erase(pendingBufferGrowths.begin() + i);
+    }
+
+    // Frames that started before it was retired may still use it
+    for (size_t i = 0; i < retiredBuffers.size();) {
+        RetiredBuffer& retiredBuffer = retiredBuffers[i];
+        if (retiredBuffer.frame + FRAME_OVERLAP > numFrames) {
+            i++;
+            continue;
+        }
+
+        vmaDestroyBuffer(allocator, retiredBuffer.buffer, retiredBuffer.allocation);
+        retiredBuffers.erase(retiredBuffers.begin() + i);
+    }
+}
+
+uint32_t GraphicsContext::getDescriptorBufferSize(std::shared_ptr<DescriptorSet> descriptorSet,
+                                                  uint32_t binding) {
+    auto bufferSize = descriptorSet->bufferSizes.find(binding);
+    return (bufferSize != descriptorSet->bufferSizes.end()) ? bufferSize->second : 0;
+}
+
+void GraphicsContext::descriptorSetShareBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
+                                               uint32_t binding,
+                                               std::shared_ptr<DescriptorSet> sourceDescriptorSet,
+                                               uint32_t sourceBinding, DescriptorType type,
+                                               int frameOffset) {
+    writeSharedBuffer(descriptorSet, binding, sourceDescriptorSet, sourceBinding, type,
+                      frameOffset);
+
+    sourceDescriptorSet->bufferShares.push_back(
+        { descriptorSet, binding, sourceBinding, type, frameOffset });
+
+    // A set sharing its own buffers across frames would keep itself alive
+    if (sourceDescriptorSet != descriptorSet) {
+        descriptorSet->sharedBufferSources.push_back(sourceDescriptorSet);
+    }
+}
+
+void GraphicsContext::writeSharedBuffer(std::shared_ptr<DescriptorSet> descriptorSet,
+                                        uint32_t binding,
+                                        std::shared_ptr<DescriptorSet> sourceDescriptorSet,
+                                        uint32_t sourceBinding, DescriptorType type,
+                                        int frameOffset, int frameIndex) {
+    for (int i = 0; i < FRAME_OVERLAP; i++) {
+        if (frameIndex >= 0 && i != frameIndex) {
+            continue;
+        }
+
+        uint32_t sourceFrame  = ((int)i + frameOffset + FRAME_OVERLAP) % FRAME_OVERLAP;
+        VkBuffer sourceBuffer = sourceDescriptorSet->buffers[sourceFrame][sourceBinding];
+
+        // The source frame's buffer grew but isn't swapped in yet, its replacement is the one
+        // that fits the binding
+        for (auto& growth : pendingBufferGrowths) {
+            if (growth.binding == sourceBinding && growth.buffers[sourceFrame] &&
+                growth.descriptorSet.lock() == sourceDescriptorSet) {
+                sourceBuffer = growth.buffers[sourceFrame];
+            }
+        }
+
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer                 = sourceBuffer;
+        bufferInfo.offset                 = 0;
+        bufferInfo.range                  = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet setWrite = {};
+        setWrite.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        setWrite.pNext                = nullptr;
+        setWrite.dstBinding           = binding;
+        setWrite.dstSet               = descriptorSet->descriptorSets[i];
+        setWrite.descriptorCount      = 1;
+        setWrite.descriptorType       = helper::getVkDescriptorType(type);
+        setWrite.pBufferInfo          = &bufferInfo;
+
+        vkUpdateDescriptorSets(device, 1, &setWrite, 0, nullptr);
+    }
+}
+
+void GraphicsContext::descriptorSetAddImage(std::shared_ptr<DescriptorSet> descriptorSet,
+                                            uint32_t binding, std::shared_ptr<Texture> image,
+                                            int frameIndex) {
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler               = mainSampler;
+    imageInfo.imageView             = image->imageView;
+    imageInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    for (int i = 0; i < FRAME_OVERLAP; i++) {
+        if (frameIndex >= 0 && i != frameIndex) {
+            continue;
+        }
+
+        VkWriteDescriptorSet write = {};
+        write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.pNext                = nullptr;
+
+        write.dstBinding      = binding;
+        write.dstSet          = descriptorSet->descriptorSets[i];
+        write.descriptorCount = 1;
+        write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo      = &imageInfo;
+
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+}
+
+void GraphicsContext::descriptorSetAddStorageImage(std::shared_ptr<DescriptorSet> descriptorSet,
+                                                   uint32_t binding,
+                                                   std::shared_ptr<Texture> texture,
+                                                   uint32_t mipLevel) {
+    if (mipLevel >= texture->mipLevels) {
+        Logger::renderer_logger->error("Invalid storage image mip level specified: {0}", mipLevel);
+        return;
+    }
+
+    auto storageImageView = texture->storageImageViews.find(mipLevel);
+    if (storageImageView == texture->storageImageViews.end()) {
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType                 = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.pNext                 = nullptr;
+        imageViewCreateInfo.flags                 = 0;
+        imageViewCreateInfo.image                 = texture->image;
+        // Storage images can't be cube views, so cubemap faces are addressed as array layers
+        imageViewCreateInfo.viewType =
+            (texture->arrayLayers > 1) ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format                          = texture->format;
+        imageViewCreateInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCreateInfo.subresourceRange.baseMipLevel   = mipLevel;
+        imageViewCreateInfo.subresourceRange.levelCount     = 1;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount     = texture->arrayLayers;
+
+        VkImageView imageView;
+        VK_CHECK(vkCreateImageView(device, &imageViewCreateInfo, nullptr, &imageView));
+
+        storageImageView =
+            texture->storageImageViews.insert(std::make_pair(mipLevel, imageView)).first;
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler               = VK_NULL_HANDLE;
+    imageInfo.imageView             = storageImageView->second;
+    imageInfo.imageLayout           = VK_IMAGE_LAYOUT_GENERAL;
+
+    for (int i = 0; i < FRAME_OVERLAP; i++) {
+        VkWriteDescriptorSet write = {};
+        write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.pNext                = nullptr;
+
+        write.dstBinding      = binding;
+        write.dstSet          = descriptorSet->descriptorSets[i];
+        write.descriptorCount = 1;
+        write.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        write.pImageInfo      = &imageInfo;
+
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+}
+
+void GraphicsContext::descriptorSetAddRenderPassAttachment(
+    std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
     std::shared_ptr<RenderPass> renderPass,
     uint32_t attachmentIndex) { // TODO: Check that the index is within correct range
     VkDescriptorImageInfo imageInfo = {};
@@ -1262,9 +2318,9 @@ std::shared_ptr<VertexBuffer> GraphicsContext::createVertexBuffer(void* data, ui
     return std::make_shared<VertexBuffer>(allocator, buffer, allocation);
 }
 
-std::shared_ptr<Texture> GraphicsContext::createTexture(int width, int height, int numComponents,
-                                                        ColorSpace colorSpace, unsigned char* data,
-                                                        bool genMipmaps) {
+GraphicsContext::TextureUpload
+GraphicsContext::prepareTextureUpload(int width, int height, int numComponents,
+                                      ColorSpace colorSpace, unsigned char* data, bool genMipmaps) {
     VkDeviceSize imageSize = width * height * numComponents;
     VkFormat imageFormat;
     if (numComponents == 3) {
@@ -1284,6 +2340,14 @@ std::shared_ptr<Texture> GraphicsContext::createTexture(int width, int height, i
         assert(false);
     }
 
+    return prepareTextureUpload(imageFormat, width, height, data, imageSize, genMipmaps);
+}
+
+GraphicsContext::TextureUpload GraphicsContext::prepareTextureUpload(VkFormat imageFormat,
+                                                                     int width, int height,
+                                                                     const void* data,
+                                                                     VkDeviceSize imageSize,
+                                                                     bool genMipmaps) {
     VkBufferCreateInfo cpuTransferBufferInfo = {};
     cpuTransferBufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     cpuTransferBufferInfo.pNext              = nullptr;
@@ -1332,136 +2396,137 @@ std::shared_ptr<Texture> GraphicsContext::createTexture(int width, int height, i
     vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo, &transferImage,
                    &transferAllocation, nullptr);
 
-    immediateSubmit([&](VkCommandBuffer cmd) {
-        VkImageSubresourceRange range;
-        range.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        range.baseMipLevel   = 0;
-        range.levelCount     = (genMipmaps) ? mipLevels : 1;
-        range.baseArrayLayer = 0;
-        range.layerCount     = 1;
-
-        VkImageMemoryBarrier imageBarrierForTransfer = {};
-        imageBarrierForTransfer.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageBarrierForTransfer.pNext                = nullptr;
-        imageBarrierForTransfer.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageBarrierForTransfer.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageBarrierForTransfer.image                = transferImage;
-        imageBarrierForTransfer.subresourceRange     = range;
-        imageBarrierForTransfer.srcAccessMask        = 0;
-        imageBarrierForTransfer.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0, 0, nullptr, 0, nullptr, 1, &imageBarrierForTransfer);
+    VkImageView imageView;
+    VkImageViewCreateInfo imageViewInfo           = {};
+    imageViewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    imageViewInfo.pNext                           = nullptr;
+    imageViewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    imageViewInfo.image                           = transferImage;
+    imageViewInfo.format                          = imageFormat;
+    imageViewInfo.subresourceRange.baseMipLevel   = 0;
+    imageViewInfo.subresourceRange.levelCount     = (genMipmaps) ? mipLevels : 1;
+    imageViewInfo.subresourceRange.baseArrayLayer = 0;
+    imageViewInfo.subresourceRange.layerCount     = 1;
+    imageViewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    vkCreateImageView(device, &imageViewInfo, nullptr, &imageView);
+
+    VkBufferImageCopy copyRegion               = {};
+    copyRegion.bufferOffset                    = 0;
+    copyRegion.bufferRowLength                 = 0;
+    copyRegion.bufferImageHeight               = 0;
+    copyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    copyRegion.imageSubresource.mipLevel       = 0;
+    copyRegion.imageSubresource.baseArrayLayer = 0;
+    copyRegion.imageSubresource.layerCount     = 1;
+    copyRegion.imageExtent                     = imageExtent;
+
+    TextureUpload upload     = {};
+    upload.stagingBuffer     = cpuTransferBuffer;
+    upload.stagingAllocation = cpuTransferAllocation;
+    upload.copyRegions       = { copyRegion };
+    upload.generateMips      = genMipmaps;
+    upload.texture = std::make_shared<Texture>(device, allocator, transferAllocation, transferImage,
+                                               imageView, imageFormat, width, height,
+                                               (genMipmaps) ? mipLevels : 1, 1);
+
+    return upload;
+}
+
+GraphicsContext::TextureUpload GraphicsContext::prepareCompressedTextureUpload(
+    Format format, uint32_t width, uint32_t height,
+    const std::vector<std::vector<unsigned char>>& mips, uint32_t firstMip) {
+    VkFormat imageFormat = helper::getVkFormat(format);
+    uint32_t mipLevels   = (uint32_t)mips.size() - firstMip;
+
+    width  = std::max(width >> firstMip, 1u);
+    height = std::max(height >> firstMip, 1u);
+
+    // Without BC support the blocks are decoded here and the texels uploaded instead
+    std::vector<std::vector<unsigned char>> decodedMips;
+    const std::vector<std::vector<unsigned char>>* uploadedMips = &mips;
+    if (!textureCompressionBC) {
+        imageFormat = helper::getDecodedVkFormat(format);
+        decodedMips.resize(mips.size());
+        for (uint32_t mipLevel = firstMip; mipLevel < mips.size(); mipLevel++) {
+            decodedMips[mipLevel] = helper::decodeBlocks(
+                format, std::max(width >> (mipLevel - firstMip), 1u),
+                std::max(height >> (mipLevel - firstMip), 1u), mips[mipLevel]);
+        }
+        uploadedMips = &decodedMips;
+    }
+
+    VkDeviceSize imageSize = 0;
+    for (uint32_t mipLevel = firstMip; mipLevel < mips.size(); mipLevel++) {
+        imageSize += (*uploadedMips)[mipLevel].size();
+    }
+
+    VkBufferCreateInfo cpuTransferBufferInfo = {};
+    cpuTransferBufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    cpuTransferBufferInfo.pNext              = nullptr;
+    cpuTransferBufferInfo.size               = imageSize;
+    cpuTransferBufferInfo.usage              = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo vmaAllocCreateInfo = {};
+    vmaAllocCreateInfo.usage                   = VMA_MEMORY_USAGE_CPU_ONLY;
+
+    VmaAllocation cpuTransferAllocation;
+    VkBuffer cpuTransferBuffer;
+    VK_CHECK(vmaCreateBuffer(allocator, &cpuTransferBufferInfo, &vmaAllocCreateInfo,
+                             &cpuTransferBuffer, &cpuTransferAllocation, nullptr));
+
+    // Every mip back to back, each one a whole number of blocks so the offsets stay block aligned
+    std::vector<VkBufferImageCopy> copyRegions;
+    void* cpuTransferDataDest;
+    vmaMapMemory(allocator, cpuTransferAllocation, &cpuTransferDataDest);
+    VkDeviceSize offset = 0;
+    for (uint32_t mipLevel = 0; mipLevel < mipLevels; mipLevel++) {
+        const std::vector<unsigned char>& mip = (*uploadedMips)[firstMip + mipLevel];
+        memcpy(static_cast<unsigned char*>(cpuTransferDataDest) + offset, mip.data(), mip.size());
 
         VkBufferImageCopy copyRegion               = {};
-        copyRegion.bufferOffset                    = 0;
+        copyRegion.bufferOffset                    = offset;
         copyRegion.bufferRowLength                 = 0;
         copyRegion.bufferImageHeight               = 0;
         copyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyRegion.imageSubresource.mipLevel       = 0;
+        copyRegion.imageSubresource.mipLevel       = mipLevel;
         copyRegion.imageSubresource.baseArrayLayer = 0;
         copyRegion.imageSubresource.layerCount     = 1;
-        copyRegion.imageExtent                     = imageExtent;
-
-        vkCmdCopyBufferToImage(cmd, cpuTransferBuffer, transferImage,
-                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
-
-        // Do mips here
-        if (genMipmaps) {
-            VkImageSubresourceRange singleMipRange = {};
-            singleMipRange.aspectMask              = VK_IMAGE_ASPECT_COLOR_BIT;
-            singleMipRange.baseArrayLayer          = 0;
-            singleMipRange.layerCount              = 1;
-            singleMipRange.levelCount              = 1;
-
-            int32_t mipWidth  = width;
-            int32_t mipHeight = height;
-
-            for (unsigned int i = 1; i < mipLevels; i++) {
-                singleMipRange.baseMipLevel = i - 1;
-
-                VkImageMemoryBarrier
-                    singleMipBarrier = {}; // TODO: Pull out of loop and just set the image resource
-                                           // range already inside the struct instead of making new
-                                           // one
-                singleMipBarrier.sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                singleMipBarrier.pNext            = nullptr;
-                singleMipBarrier.image            = transferImage;
-                singleMipBarrier.subresourceRange = singleMipRange;
-                singleMipBarrier.srcAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
-                singleMipBarrier.dstAccessMask    = VK_ACCESS_TRANSFER_READ_BIT;
-                singleMipBarrier.oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                singleMipBarrier.newLayout        = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-
-                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                     VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                                     &singleMipBarrier);
-
-                VkImageBlit mipBlit                   = {};
-                mipBlit.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-                mipBlit.srcSubresource.mipLevel       = i - 1;
-                mipBlit.srcSubresource.baseArrayLayer = 0;
-                mipBlit.srcSubresource.layerCount     = 1;
-                mipBlit.srcOffsets[0]                 = { 0, 0, 0 };
-                mipBlit.srcOffsets[1]                 = { mipWidth, mipHeight, 1 };
-                mipBlit.dstSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-                mipBlit.dstSubresource.mipLevel       = i;
-                mipBlit.dstSubresource.baseArrayLayer = 0;
-                mipBlit.dstSubresource.layerCount     = 1;
-                mipBlit.dstOffsets[0]                 = { 0, 0, 0 };
-                mipBlit.dstOffsets[1]                 = { (mipWidth > 1) ? mipWidth / 2 : 1,
-                                          (mipHeight > 1) ? mipHeight / 2 : 1, 1 };
-
-                vkCmdBlitImage(cmd, transferImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                               transferImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &mipBlit,
-                               VK_FILTER_LINEAR);
-
-                singleMipBarrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                singleMipBarrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                singleMipBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                singleMipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
-                                     nullptr, 1, &singleMipBarrier);
-
-                if (mipWidth > 1)
-                    mipWidth /= 2;
-                if (mipHeight > 1)
-                    mipHeight /= 2;
-            }
-
-            singleMipRange.baseMipLevel = mipLevels - 1;
-
-            VkImageMemoryBarrier singleMipBarrier = {}; // TODO: Pull out of loop and just set the
-                                                        // image resource range already inside the
-                                                        // struct instead of making new one
-            singleMipBarrier.sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            singleMipBarrier.pNext            = nullptr;
-            singleMipBarrier.image            = transferImage;
-            singleMipBarrier.subresourceRange = singleMipRange;
-            singleMipBarrier.srcAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
-            singleMipBarrier.dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
-            singleMipBarrier.oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            singleMipBarrier.newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        copyRegion.imageExtent                     = { std::max(width >> mipLevel, 1u),
+                                                       std::max(height >> mipLevel, 1u), 1 };
+        copyRegions.push_back(copyRegion);
 
-            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
-                                 1, &singleMipBarrier);
-        } else {
-            VkImageMemoryBarrier imageBarrierToFinal = imageBarrierForTransfer;
-            imageBarrierToFinal.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            imageBarrierToFinal.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            imageBarrierToFinal.srcAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
-            imageBarrierToFinal.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
+        offset += mip.size();
+    }
+    vmaUnmapMemory(allocator, cpuTransferAllocation);
 
-            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
-                                 1, &imageBarrierToFinal);
-        }
-    });
+    VkImageCreateInfo imageCreateInfo = {};
+    imageCreateInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext             = nullptr;
+    imageCreateInfo.flags             = 0;
+    imageCreateInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format            = imageFormat;
+    imageCreateInfo.extent            = { width, height, 1 };
+    imageCreateInfo.mipLevels         = mipLevels;
+    imageCreateInfo.arrayLayers       = 1;
+    imageCreateInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageCreateInfo.initialLayout               = VK_IMAGE_LAYOUT_UNDEFINED;
+    VmaAllocationCreateInfo imageAllocationInfo = {};
+    imageAllocationInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
 
-    vmaDestroyBuffer(allocator, cpuTransferBuffer, cpuTransferAllocation);
+    // Streamed textures are recreated while the device may be short on memory, the caller defers
+    // them instead of failing
+    VkImage transferImage;
+    VmaAllocation transferAllocation;
+    VkResult imageResult = vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo,
+                                          &transferImage, &transferAllocation, nullptr);
+    if (imageResult != VK_SUCCESS) {
+        Logger::renderer_logger->warn("Failed to create a {0}x{1} compressed texture: {2}", width,
+                                      height, (int)imageResult);
+        vmaDestroyBuffer(allocator, cpuTransferBuffer, cpuTransferAllocation);
+        return {};
+    }
 
     VkImageView imageView;
     VkImageViewCreateInfo imageViewInfo           = {};
@@ -1471,190 +2536,317 @@ std::shared_ptr<Texture> GraphicsContext::createTexture(int width, int height, i
     imageViewInfo.image                           = transferImage;
     imageViewInfo.format                          = imageFormat;
     imageViewInfo.subresourceRange.baseMipLevel   = 0;
-    imageViewInfo.subresourceRange.levelCount     = (genMipmaps) ? mipLevels : 1;
+    imageViewInfo.subresourceRange.levelCount     = mipLevels;
     imageViewInfo.subresourceRange.baseArrayLayer = 0;
     imageViewInfo.subresourceRange.layerCount     = 1;
     imageViewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
     vkCreateImageView(device, &imageViewInfo, nullptr, &imageView);
 
-    return std::make_shared<Texture>(device, allocator, transferAllocation, transferImage,
-                                     imageView);
+    TextureUpload upload     = {};
+    upload.stagingBuffer     = cpuTransferBuffer;
+    upload.stagingAllocation = cpuTransferAllocation;
+    upload.copyRegions       = copyRegions;
+    upload.generateMips      = false;
+    upload.texture = std::make_shared<Texture>(device, allocator, transferAllocation, transferImage,
+                                               imageView, imageFormat, width, height, mipLevels, 1);
+
+    return upload;
 }
 
-std::shared_ptr<Texture> GraphicsContext::createHDRTexture(int width, int height, int numComponents,
-                                                           float* data, bool genMipmaps) {
-    VkDeviceSize imageSize = width * height * numComponents * sizeof(float);
-    VkFormat imageFormat;
-    if (numComponents == 3) {
-        imageFormat = VK_FORMAT_R32G32B32_SFLOAT;
-    } else if (numComponents == 4) {
-        imageFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+void GraphicsContext::recordTextureUpload(VkCommandBuffer cmd, const TextureUpload& upload) {
+    VkImage transferImage      = upload.texture->image;
+    VkBuffer cpuTransferBuffer = upload.stagingBuffer;
+    uint32_t mipLevels         = upload.texture->mipLevels;
+    int32_t width              = (int32_t)upload.texture->width;
+    int32_t height             = (int32_t)upload.texture->height;
+
+    VkImageSubresourceRange range;
+    range.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel   = 0;
+    range.levelCount     = mipLevels;
+    range.baseArrayLayer = 0;
+    range.layerCount     = 1;
+
+    VkImageMemoryBarrier imageBarrierForTransfer = {};
+    imageBarrierForTransfer.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrierForTransfer.pNext                = nullptr;
+    imageBarrierForTransfer.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageBarrierForTransfer.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    imageBarrierForTransfer.image                = transferImage;
+    imageBarrierForTransfer.subresourceRange     = range;
+    imageBarrierForTransfer.srcAccessMask        = 0;
+    imageBarrierForTransfer.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &imageBarrierForTransfer);
+
+    vkCmdCopyBufferToImage(cmd, cpuTransferBuffer, transferImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           (uint32_t)upload.copyRegions.size(), upload.copyRegions.data());
+
+    // Do mips here
+    if (upload.generateMips) {
+        VkImageSubresourceRange singleMipRange = {};
+        singleMipRange.aspectMask              = VK_IMAGE_ASPECT_COLOR_BIT;
+        singleMipRange.baseArrayLayer          = 0;
+        singleMipRange.layerCount              = 1;
+        singleMipRange.levelCount              = 1;
+
+        int32_t mipWidth  = width;
+        int32_t mipHeight = height;
+
+        for (unsigned int i = 1; i < mipLevels; i++) {
+            singleMipRange.baseMipLevel = i - 1;
+
+            VkImageMemoryBarrier singleMipBarrier = {}; // TODO: Pull out of loop and just set
+                                                        // the image resource range already inside
+                                                        // the struct instead of making new one
+            singleMipBarrier.sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            singleMipBarrier.pNext            = nullptr;
+            singleMipBarrier.image            = transferImage;
+            singleMipBarrier.subresourceRange = singleMipRange;
+            singleMipBarrier.srcAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
+            singleMipBarrier.dstAccessMask    = VK_ACCESS_TRANSFER_READ_BIT;
+            singleMipBarrier.oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            singleMipBarrier.newLayout        = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                                 &singleMipBarrier);
+
+            VkImageBlit mipBlit                   = {};
+            mipBlit.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            mipBlit.srcSubresource.mipLevel       = i - 1;
+            mipBlit.srcSubresource.baseArrayLayer = 0;
+            mipBlit.srcSubresource.layerCount     = 1;
+            mipBlit.srcOffsets[0]                 = { 0, 0, 0 };
+            mipBlit.srcOffsets[1]                 = { mipWidth, mipHeight, 1 };
+            mipBlit.dstSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            mipBlit.dstSubresource.mipLevel       = i;
+            mipBlit.dstSubresource.baseArrayLayer = 0;
+            mipBlit.dstSubresource.layerCount     = 1;
+            mipBlit.dstOffsets[0]                 = { 0, 0, 0 };
+            mipBlit.dstOffsets[1]                 = { (mipWidth > 1) ? mipWidth / 2 : 1,
+                                      (mipHeight > 1) ? mipHeight / 2 : 1, 1 };
+
+            vkCmdBlitImage(cmd, transferImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           transferImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &mipBlit,
+                           VK_FILTER_LINEAR);
+
+            singleMipBarrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            singleMipBarrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            singleMipBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            singleMipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
+                                 nullptr, 1, &singleMipBarrier);
+
+            if (mipWidth > 1)
+                mipWidth /= 2;
+            if (mipHeight > 1)
+                mipHeight /= 2;
+        }
+
+        singleMipRange.baseMipLevel = mipLevels - 1;
+
+        VkImageMemoryBarrier singleMipBarrier = {}; // TODO: Pull out of loop and just set the
+                                                    // image resource range already inside the
+                                                    // struct instead of making new one
+        singleMipBarrier.sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        singleMipBarrier.pNext            = nullptr;
+        singleMipBarrier.image            = transferImage;
+        singleMipBarrier.subresourceRange = singleMipRange;
+        singleMipBarrier.srcAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
+        singleMipBarrier.dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
+        singleMipBarrier.oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        singleMipBarrier.newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                             1, &singleMipBarrier);
     } else {
-        Logger::renderer_logger->error("Invalid number of components for texture");
-        assert(false);
+        VkImageMemoryBarrier imageBarrierToFinal = imageBarrierForTransfer;
+        imageBarrierToFinal.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageBarrierToFinal.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageBarrierToFinal.srcAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrierToFinal.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                             1, &imageBarrierToFinal);
     }
+}
 
-    VkBufferCreateInfo cpuTransferBufferInfo = {};
-    cpuTransferBufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    cpuTransferBufferInfo.pNext              = nullptr;
-    cpuTransferBufferInfo.size               = imageSize;
-    cpuTransferBufferInfo.usage              = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+std::shared_ptr<Texture> GraphicsContext::createTexture(int width, int height, int numComponents,
+                                                        ColorSpace colorSpace, unsigned char* data,
+                                                        bool genMipmaps) {
+    TextureUpload upload =
+        prepareTextureUpload(width, height, numComponents, colorSpace, data, genMipmaps);
 
-    VmaAllocationCreateInfo vmaAllocCreateInfo = {};
-    vmaAllocCreateInfo.usage                   = VMA_MEMORY_USAGE_CPU_ONLY;
+    immediateSubmit([&](VkCommandBuffer cmd) { recordTextureUpload(cmd, upload); });
 
-    VmaAllocation cpuTransferAllocation;
-    VkBuffer cpuTransferBuffer;
-    VK_CHECK(vmaCreateBuffer(allocator, &cpuTransferBufferInfo, &vmaAllocCreateInfo,
-                             &cpuTransferBuffer, &cpuTransferAllocation, nullptr));
+    vmaDestroyBuffer(allocator, upload.stagingBuffer, upload.stagingAllocation);
+
+    return upload.texture;
+}
+
+std::shared_ptr<Texture> GraphicsContext::createTexture(const std::string& ktx2Path) {
+    KTX2Texture ktx2Texture = {};
+    if (!helper::readKTX2(ktx2Path, ktx2Texture)) {
+        return nullptr;
+    }
+
+    return createCompressedTexture(ktx2Texture.format, ktx2Texture.width, ktx2Texture.height,
+                                   ktx2Texture.mips);
+}
+
+void GraphicsContext::createTextureAsync(
+    int width, int height, int numComponents, ColorSpace colorSpace, unsigned char* data,
+    bool genMipmaps, std::function<void(std::shared_ptr<Texture>)> onUploaded) {
+    submitTextureUpload(
+        prepareTextureUpload(width, height, numComponents, colorSpace, data, genMipmaps),
+        onUploaded);
+}
+
+std::shared_ptr<Texture>
+GraphicsContext::createCompressedTexture(Format format, uint32_t width, uint32_t height,
+                                         const std::vector<std::vector<unsigned char>>& mips) {
+    TextureUpload upload = prepareCompressedTextureUpload(format, width, height, mips);
+    if (upload.texture == nullptr) {
+        return nullptr;
+    }
+
+    immediateSubmit([&](VkCommandBuffer cmd) { recordTextureUpload(cmd, upload); });
+
+    vmaDestroyBuffer(allocator, upload.stagingBuffer, upload.stagingAllocation);
+
+    return upload.texture;
+}
+
+bool GraphicsContext::createCompressedTextureAsync(
+    Format format, uint32_t width, uint32_t height,
+    const std::vector<std::vector<unsigned char>>& mips,
+    std::function<void(std::shared_ptr<Texture>)> onUploaded, uint32_t firstMip) {
+    TextureUpload upload = prepareCompressedTextureUpload(format, width, height, mips, firstMip);
+    if (upload.texture == nullptr) {
+        return false;
+    }
+
+    submitTextureUpload(upload, onUploaded);
+    return true;
+}
+
+void GraphicsContext::submitTextureUpload(
+    const TextureUpload& upload, std::function<void(std::shared_ptr<Texture>)> onUploaded) {
+    PendingTextureUpload pending = {};
+    pending.upload               = upload;
+    pending.onUploaded           = onUploaded;
+
+    VkCommandBufferAllocateInfo cmdAllocInfo =
+        helper::commandBufferAllocateInfo(asyncUploadCommandPool, 1);
+    VK_CHECK(vkAllocateCommandBuffers(device, &cmdAllocInfo, &pending.commandBuffer));
+
+    VkCommandBufferBeginInfo cmdBeginInfo =
+        helper::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK(vkBeginCommandBuffer(pending.commandBuffer, &cmdBeginInfo));
+    recordTextureUpload(pending.commandBuffer, pending.upload);
+    VK_CHECK(vkEndCommandBuffer(pending.commandBuffer));
+
+    VkFenceCreateInfo fenceCreateInfo = helper::fenceCreateInfo();
+    VK_CHECK(vkCreateFence(device, &fenceCreateInfo, nullptr, &pending.fence));
+
+    // Mip generation blits, so this goes to the graphics queue rather than the transfer queue
+    VkSubmitInfo submit = helper::submitInfo(&pending.commandBuffer);
+    VK_CHECK(vkQueueSubmit(graphicsQueue, 1, &submit, pending.fence));
+
+    pendingTextureUploads.push_back(pending);
+}
+
+void GraphicsContext::pollTextureUploads() {
+    for (size_t i = 0; i < pendingTextureUploads.size();) {
+        PendingTextureUpload& pending = pendingTextureUploads[i];
+        if (vkGetFenceStatus(device, pending.fence) != VK_SUCCESS) {
+            i++;
+            continue;
+        }
+
+        vmaDestroyBuffer(allocator, pending.upload.stagingBuffer, pending.upload.stagingAllocation);
+        vkFreeCommandBuffers(device, asyncUploadCommandPool, 1, &pending.commandBuffer);
+        vkDestroyFence(device, pending.fence, nullptr);
+
+        // The callback may start more uploads, so it runs once this one is out of the list
+        std::function<void(std::shared_ptr<Texture>)> onUploaded = pending.onUploaded;
+        std::shared_ptr<Texture> texture                          = pending.upload.texture;
+        pendingTextureUploads.erase(pendingTextureUploads.begin() + i);
 
-    void* cpuTransferDataDest;
-    vmaMapMemory(allocator, cpuTransferAllocation, &cpuTransferDataDest);
-    memcpy(cpuTransferDataDest, data, imageSize);
-    vmaUnmapMemory(allocator, cpuTransferAllocation);
+        onUploaded(texture);
+    }
+}
 
-    VkExtent3D imageExtent = {};
-    imageExtent.width      = width;
-    imageExtent.height     = height;
-    imageExtent.depth      = 1;
+std::shared_ptr<Texture> GraphicsContext::createHDRTexture(int width, int height, int numComponents,
+                                                           float* data, bool genMipmaps,
+                                                           Format format) {
+    if (numComponents != 3 && numComponents != 4) {
+        Logger::renderer_logger->error("Invalid number of components for texture");
+        assert(false);
+    }
+    if (format != Format::RGBA16_FLOAT && format != Format::B10G11R11_UFLOAT) {
+        Logger::renderer_logger->error("HDR textures are either RGBA16_FLOAT or B10G11R11_UFLOAT");
+        assert(false);
+    }
 
-    VkImageCreateInfo imageCreateInfo =
-        helper::imageCreateInfo(imageFormat,
-                                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
-                                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-                                imageExtent);
-    imageCreateInfo.tiling                      = VK_IMAGE_TILING_OPTIMAL;
-    VmaAllocationCreateInfo imageAllocationInfo = {};
-    imageAllocationInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+    size_t pixelCount = (size_t)width * height;
 
-    VkImage transferImage;
-    VmaAllocation transferAllocation;
-    vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo, &transferImage,
-                   &transferAllocation, nullptr);
+    // Both conversions take RGBA
+    std::vector<float> expanded;
+    const float* rgba = data;
+    if (numComponents == 3) {
+        expanded.resize(pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; i++) {
+            expanded[i * 4 + 0] = data[i * 3 + 0];
+            expanded[i * 4 + 1] = data[i * 3 + 1];
+            expanded[i * 4 + 2] = data[i * 3 + 2];
+            expanded[i * 4 + 3] = 1.0f;
+        }
+        rgba = expanded.data();
+    }
 
-    VkImage realFinalImage;
-    VmaAllocation realFinalAllocation;
+    auto conversionStart = std::chrono::high_resolution_clock::now();
 
-    immediateSubmit([&](VkCommandBuffer cmd) {
-        VkImageSubresourceRange range;
-        range.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        range.baseMipLevel   = 0;
-        range.levelCount     = 1;
-        range.baseArrayLayer = 0;
-        range.layerCount     = 1;
-
-        VkImageMemoryBarrier imageBarrierForTransfer = {};
-        imageBarrierForTransfer.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageBarrierForTransfer.pNext                = nullptr;
-        imageBarrierForTransfer.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageBarrierForTransfer.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageBarrierForTransfer.image                = transferImage;
-        imageBarrierForTransfer.subresourceRange     = range;
-        imageBarrierForTransfer.srcAccessMask        = 0;
-        imageBarrierForTransfer.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0, 0, nullptr, 0, nullptr, 1, &imageBarrierForTransfer);
+    std::vector<uint32_t> packed;
+    std::vector<uint16_t> halves;
+    if (format == Format::RGBA16_FLOAT) {
+        halves.resize(pixelCount * 4);
+        helper::floatToHalf(rgba, halves.data(), halves.size());
+    } else {
+        packed.resize(pixelCount);
+        helper::floatToB10G11R11(rgba, packed.data(), pixelCount);
+    }
 
-        VkBufferImageCopy copyRegion               = {};
-        copyRegion.bufferOffset                    = 0;
-        copyRegion.bufferRowLength                 = 0;
-        copyRegion.bufferImageHeight               = 0;
-        copyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyRegion.imageSubresource.mipLevel       = 0;
-        copyRegion.imageSubresource.baseArrayLayer = 0;
-        copyRegion.imageSubresource.layerCount     = 1;
-        copyRegion.imageExtent                     = imageExtent;
+    std::chrono::duration<double, std::milli> conversionTime =
+        std::chrono::high_resolution_clock::now() - conversionStart;
 
-        vkCmdCopyBufferToImage(cmd, cpuTransferBuffer, transferImage,
-                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+    bool isHalf = format == Format::RGBA16_FLOAT;
+    const void* texels = isHalf ? (const void*)halves.data() : (const void*)packed.data();
+    VkDeviceSize imageSize =
+        isHalf ? halves.size() * sizeof(uint16_t) : packed.size() * sizeof(uint32_t);
 
-        VkImageMemoryBarrier imageBarrierToFinal = imageBarrierForTransfer;
-        imageBarrierToFinal.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        // imageBarrierToFinal.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageBarrierToFinal.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        imageBarrierToFinal.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        // imageBarrierToFinal.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
-        imageBarrierToFinal.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr, 0, nullptr, 1, &imageBarrierToFinal);
-
-        VkImageCreateInfo realFinalImageCreateInfo = {};
-        realFinalImageCreateInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        realFinalImageCreateInfo.pNext             = nullptr;
-        realFinalImageCreateInfo.imageType         = VK_IMAGE_TYPE_2D;
-        realFinalImageCreateInfo.format            = (imageFormat == VK_FORMAT_R32G32B32A32_SFLOAT)
-                       ? VK_FORMAT_R16G16B16A16_SFLOAT
-                       : VK_FORMAT_R16G16B16_SFLOAT;
-        realFinalImageCreateInfo.extent            = imageExtent;
-        realFinalImageCreateInfo.mipLevels         = 1;
-        realFinalImageCreateInfo.arrayLayers       = 1;
-        realFinalImageCreateInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
-        realFinalImageCreateInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
-        realFinalImageCreateInfo.usage =
-            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-
-        vmaCreateImage(allocator, &realFinalImageCreateInfo, &imageAllocationInfo, &realFinalImage,
-                       &realFinalAllocation, nullptr);
-
-        VkImageMemoryBarrier finalImageToTransferDst = {};
-        finalImageToTransferDst.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        finalImageToTransferDst.pNext                = nullptr;
-        finalImageToTransferDst.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
-        finalImageToTransferDst.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        finalImageToTransferDst.image                = realFinalImage;
-        finalImageToTransferDst.subresourceRange     = range;
-        finalImageToTransferDst.srcAccessMask        = 0;
-        finalImageToTransferDst.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr, 0, nullptr, 1, &finalImageToTransferDst);
-
-        VkImageBlit imageBlit               = {};
-        imageBlit.srcOffsets[1].x           = width;
-        imageBlit.srcOffsets[1].y           = height;
-        imageBlit.srcOffsets[1].z           = 1;
-        imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.srcSubresource.layerCount = 1;
-        imageBlit.srcSubresource.mipLevel   = 0;
-        imageBlit.dstOffsets[1].x           = width;
-        imageBlit.dstOffsets[1].y           = height;
-        imageBlit.dstOffsets[1].z           = 1;
-        imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.dstSubresource.layerCount = 1;
-        imageBlit.dstSubresource.mipLevel   = 0;
-
-        vkCmdBlitImage(cmd, transferImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, realFinalImage,
-                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, VK_FILTER_LINEAR);
-
-        VkImageMemoryBarrier finalImageToShaderReadDst = {};
-        finalImageToShaderReadDst.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        finalImageToShaderReadDst.pNext                = nullptr;
-        finalImageToShaderReadDst.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        finalImageToShaderReadDst.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        finalImageToShaderReadDst.image                = realFinalImage;
-        finalImageToShaderReadDst.subresourceRange     = range;
-        finalImageToShaderReadDst.srcAccessMask        = 0;
-        finalImageToShaderReadDst.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
+    TextureUpload upload = prepareTextureUpload(helper::getVkFormat(format), width, height, texels,
+                                                imageSize, genMipmaps);
 
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &finalImageToShaderReadDst);
-    });
+    immediateSubmit([&](VkCommandBuffer cmd) { recordTextureUpload(cmd, upload); });
 
-    vmaDestroyBuffer(allocator, cpuTransferBuffer, cpuTransferAllocation);
-    vmaDestroyImage(allocator, transferImage, transferAllocation);
+    vmaDestroyBuffer(allocator, upload.stagingBuffer, upload.stagingAllocation);
 
-    VkImageView imageView;
-    VkImageViewCreateInfo imageinfo = helper::imageViewCreateInfo(
-        (imageFormat == VK_FORMAT_R32G32B32A32_SFLOAT) ? VK_FORMAT_R16G16B16A16_SFLOAT
-                                                       : VK_FORMAT_R16G16B16_SFLOAT,
-        realFinalImage, VK_IMAGE_ASPECT_COLOR_BIT);
-    vkCreateImageView(device, &imageinfo, nullptr, &imageView);
+    VkDeviceSize floatSize = pixelCount * 4 * sizeof(float);
+    Logger::renderer_logger->info(
+        "Uploaded {0}x{1} HDR texture as {2}, {3:.2f} MB instead of {4:.2f} MB as RGBA32F, "
+        "converted in {5:.1f} ms",
+        width, height, isHalf ? "RGBA16F" : "B10G11R11", imageSize / (1024.0 * 1024.0),
+        floatSize / (1024.0 * 1024.0), conversionTime.count());
 
-    return std::make_shared<Texture>(device, allocator, realFinalAllocation, realFinalImage,
-                                     imageView);
+    return upload.texture;
 }
 
 std::shared_ptr<Texture> GraphicsContext::createCubemap(Format format, uint32_t width,
@@ -1676,7 +2868,10 @@ std::shared_ptr<Texture> GraphicsContext::createCubemap(Format format, uint32_t
     cubemapCreateInfo.arrayLayers       = 6;
     cubemapCreateInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
     cubemapCreateInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
-    cubemapCreateInfo.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    cubemapCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                              VK_IMAGE_USAGE_SAMPLED_BIT |
+                              VK_IMAGE_USAGE_STORAGE_BIT | // Storage so compute can write faces
+                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; // Multiview renders into faces
     cubemapCreateInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
     cubemapCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
@@ -1700,15 +2895,17 @@ std::shared_ptr<Texture> GraphicsContext::createCubemap(Format format, uint32_t
         cubemapBarrierInfo.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         cubemapBarrierInfo.pNext                = nullptr;
         cubemapBarrierInfo.srcAccessMask        = 0;
-        cubemapBarrierInfo.dstAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
-        cubemapBarrierInfo.oldLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
-        cubemapBarrierInfo.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        cubemapBarrierInfo.image         = cubemapImage;
-        cubemapBarrierInfo.subresourceRange = cubemapSubresourceRange;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &cubemapBarrierInfo);
+        cubemapBarrierInfo.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
+        cubemapBarrierInfo.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+        cubemapBarrierInfo.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        cubemapBarrierInfo.image                = cubemapImage;
+        cubemapBarrierInfo.subresourceRange     = cubemapSubresourceRange;
+
+        // Nothing has touched the new image, anything after the submission only samples it
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &cubemapBarrierInfo);
     });
 
     VkImageViewCreateInfo cubemapImageViewCreateInfo = {};
@@ -1728,10 +2925,304 @@ std::shared_ptr<Texture> GraphicsContext::createCubemap(Format format, uint32_t
     vkCreateImageView(device, &cubemapImageViewCreateInfo, nullptr, &cubemapImageView);
 
     return std::make_shared<Texture>(device, allocator, cubemapAllocation, cubemapImage,
-                                     cubemapImageView);
+                                     cubemapImageView, helper::getVkFormat(format), width, height,
+                                     (reserveMipMaps) ? mipLevels : 1, 6);
+}
+
+std::shared_ptr<Texture> GraphicsContext::createStorageTexture(Format format, uint32_t width,
+                                                               uint32_t height) {
+    VkExtent3D extent = { width, height, 1 };
+
+    VkImageCreateInfo imageCreateInfo =
+        helper::imageCreateInfo(helper::getVkFormat(format),
+                                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                                    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+                                extent);
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+
+    VmaAllocationCreateInfo imageAllocationInfo = {};
+    imageAllocationInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkImage image;
+    VmaAllocation allocation;
+    VK_CHECK(vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationInfo, &image, &allocation,
+                            nullptr));
+
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        VkImageMemoryBarrier imageBarrier            = {};
+        imageBarrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.pNext                           = nullptr;
+        imageBarrier.srcAccessMask                   = 0;
+        imageBarrier.dstAccessMask                   = VK_ACCESS_SHADER_READ_BIT;
+        imageBarrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageBarrier.newLayout                       = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageBarrier.image                           = image;
+        imageBarrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel   = 0;
+        imageBarrier.subresourceRange.levelCount     = 1;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount     = 1;
+
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &imageBarrier);
+    });
+
+    VkImageView imageView;
+    VkImageViewCreateInfo imageViewInfo =
+        helper::imageViewCreateInfo(helper::getVkFormat(format), image, VK_IMAGE_ASPECT_COLOR_BIT);
+    vkCreateImageView(device, &imageViewInfo, nullptr, &imageView);
+
+    return std::make_shared<Texture>(device, allocator, allocation, image, imageView,
+                                     helper::getVkFormat(format), width, height, 1, 1);
+}
+
+std::shared_ptr<Texture> GraphicsContext::createUnboundTexture(Format format, uint32_t width,
+                                                               uint32_t height,
+                                                               uint32_t arrayLayers,
+                                                               VkImageUsageFlags usage) {
+    VkExtent3D extent = { width, height, 1 };
+
+    VkImageCreateInfo imageCreateInfo =
+        helper::imageCreateInfo(helper::getVkFormat(format), usage, extent);
+    imageCreateInfo.arrayLayers = arrayLayers;
+    imageCreateInfo.tiling      = VK_IMAGE_TILING_OPTIMAL;
+
+    VkImage image;
+    VK_CHECK(vkCreateImage(device, &imageCreateInfo, nullptr, &image));
+
+    return std::make_shared<Texture>(device, allocator, VK_NULL_HANDLE, image, VK_NULL_HANDLE,
+                                     helper::getVkFormat(format), width, height, 1, arrayLayers);
+}
+
+VkMemoryRequirements
+GraphicsContext::getTextureMemoryRequirements(std::shared_ptr<Texture> texture) {
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, texture->image, &requirements);
+
+    return requirements;
+}
+
+VmaAllocation GraphicsContext::allocateTextureMemory(VkMemoryRequirements requirements,
+                                                     bool lazilyAllocated) {
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.usage =
+        lazilyAllocated ? VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED : VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VmaAllocation allocation;
+    if (vmaAllocateMemory(allocator, &requirements, &allocationInfo, &allocation, nullptr) !=
+        VK_SUCCESS) {
+        if (!lazilyAllocated) {
+            Logger::renderer_logger->error("Failed to allocate {0} bytes of texture memory",
+                                           requirements.size);
+        }
+        return VK_NULL_HANDLE;
+    }
+
+    return allocation;
+}
+
+void GraphicsContext::bindTextureMemory(std::shared_ptr<Texture> texture, VmaAllocation allocation,
+                                        VkDeviceSize offset) {
+    VK_CHECK(vmaBindImageMemory2(allocator, allocation, offset, texture->image, nullptr));
+
+    VkImageViewCreateInfo imageViewInfo =
+        helper::imageViewCreateInfo(texture->format, texture->image, VK_IMAGE_ASPECT_COLOR_BIT);
+    if (texture->arrayLayers > 1) {
+        imageViewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        imageViewInfo.subresourceRange.layerCount = texture->arrayLayers;
+    }
+    VK_CHECK(vkCreateImageView(device, &imageViewInfo, nullptr, &texture->imageView));
+}
+
+void GraphicsContext::freeTextureMemory(VmaAllocation allocation) {
+    vmaFreeMemory(allocator, allocation);
+}
+
+DeviceMemoryBudget GraphicsContext::getDeviceMemoryBudget() {
+    const VkPhysicalDeviceMemoryProperties* memoryProperties;
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+
+    std::vector<VmaBudget> heapBudgets(memoryProperties->memoryHeapCount);
+    vmaGetHeapBudgets(allocator, heapBudgets.data());
+
+    DeviceMemoryBudget deviceBudget = {};
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+        if (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            deviceBudget.usage += heapBudgets[i].usage;
+            deviceBudget.budget += heapBudgets[i].budget;
+        }
+    }
+
+    return deviceBudget;
+}
+
+// Regions that copy a whole texture to or from a buffer laid out mip by mip, with the layers of a
+// mip packed together. Returns the buffer size needed
+VkDeviceSize textureCopyRegions(Texture& texture, std::vector<VkBufferImageCopy>& regions) {
+    VkDeviceSize offset = 0;
+    for (uint32_t mipLevel = 0; mipLevel < texture.mipLevels; mipLevel++) {
+        uint32_t mipWidth  = std::max(texture.width >> mipLevel, 1u);
+        uint32_t mipHeight = std::max(texture.height >> mipLevel, 1u);
+
+        VkBufferImageCopy region               = {};
+        region.bufferOffset                    = offset;
+        region.bufferRowLength                 = 0;
+        region.bufferImageHeight               = 0;
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = mipLevel;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount     = texture.arrayLayers;
+        region.imageExtent                     = { mipWidth, mipHeight, 1 };
+        regions.push_back(region);
+
+        offset += VkDeviceSize(mipWidth) * mipHeight * texture.arrayLayers *
+                  helper::vkFormatAsBytes(texture.format);
+    }
+
+    return offset;
+}
+
+VkImageMemoryBarrier textureBarrier(Texture& texture, VkImageLayout oldLayout,
+                                    VkImageLayout newLayout, VkAccessFlags srcAccessMask,
+                                    VkAccessFlags dstAccessMask) {
+    VkImageMemoryBarrier barrier            = {};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext                           = nullptr;
+    barrier.srcAccessMask                   = srcAccessMask;
+    barrier.dstAccessMask                   = dstAccessMask;
+    barrier.oldLayout                       = oldLayout;
+    barrier.newLayout                       = newLayout;
+    barrier.image                           = texture.image;
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = texture.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = texture.arrayLayers;
+
+    return barrier;
+}
+
+std::vector<unsigned char> GraphicsContext::readTexture(std::shared_ptr<Texture> texture) {
+    std::vector<VkBufferImageCopy> regions;
+    VkDeviceSize size = textureCopyRegions(*texture, regions);
+
+    VkBufferCreateInfo readbackBufferInfo = {};
+    readbackBufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    readbackBufferInfo.pNext              = nullptr;
+    readbackBufferInfo.size               = size;
+    readbackBufferInfo.usage              = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    VmaAllocationCreateInfo vmaAllocCreateInfo = {};
+    vmaAllocCreateInfo.usage                   = VMA_MEMORY_USAGE_GPU_TO_CPU;
+
+    VkBuffer readbackBuffer;
+    VmaAllocation readbackAllocation;
+    VK_CHECK(vmaCreateBuffer(allocator, &readbackBufferInfo, &vmaAllocCreateInfo, &readbackBuffer,
+                             &readbackAllocation, nullptr));
+
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        VkImageMemoryBarrier toTransfer =
+            textureBarrier(*texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, VK_ACCESS_TRANSFER_READ_BIT);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &toTransfer);
+
+        vkCmdCopyImageToBuffer(cmd, texture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               readbackBuffer, (uint32_t)regions.size(), regions.data());
+
+        VkImageMemoryBarrier toShaderRead =
+            textureBarrier(*texture, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &toShaderRead);
+
+        // Make the copy visible to the host before the fence signals
+        VkMemoryBarrier hostBarrier = {};
+        hostBarrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask   = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+                             &hostBarrier, 0, nullptr, 0, nullptr);
+    });
+
+    std::vector<unsigned char> data(size);
+
+    void* readbackData;
+    vmaMapMemory(allocator, readbackAllocation, &readbackData);
+    vmaInvalidateAllocation(allocator, readbackAllocation, 0, VK_WHOLE_SIZE);
+    memcpy(data.data(), readbackData, size);
+    vmaUnmapMemory(allocator, readbackAllocation);
+
+    vmaDestroyBuffer(allocator, readbackBuffer, readbackAllocation);
+
+    return data;
+}
+
+void GraphicsContext::writeTexture(std::shared_ptr<Texture> texture, const unsigned char* data,
+                                   size_t size) {
+    std::vector<VkBufferImageCopy> regions;
+    if (textureCopyRegions(*texture, regions) != size) {
+        Logger::renderer_logger->error("Texture data size does not match the texture: {0}", size);
+        return;
+    }
+
+    VkBufferCreateInfo cpuTransferBufferInfo = {};
+    cpuTransferBufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    cpuTransferBufferInfo.pNext              = nullptr;
+    cpuTransferBufferInfo.size               = size;
+    cpuTransferBufferInfo.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo vmaAllocCreateInfo = {};
+    vmaAllocCreateInfo.usage                   = VMA_MEMORY_USAGE_CPU_ONLY;
+
+    VkBuffer cpuTransferBuffer;
+    VmaAllocation cpuTransferAllocation;
+    VK_CHECK(vmaCreateBuffer(allocator, &cpuTransferBufferInfo, &vmaAllocCreateInfo,
+                             &cpuTransferBuffer, &cpuTransferAllocation, nullptr));
+
+    void* cpuTransferDataDest;
+    vmaMapMemory(allocator, cpuTransferAllocation, &cpuTransferDataDest);
+    memcpy(cpuTransferDataDest, data, size);
+    vmaUnmapMemory(allocator, cpuTransferAllocation);
+
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        VkImageMemoryBarrier toTransfer = textureBarrier(
+            *texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+            VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &toTransfer);
+
+        vkCmdCopyBufferToImage(cmd, cpuTransferBuffer, texture->image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(),
+                               regions.data());
+
+        VkImageMemoryBarrier toShaderRead =
+            textureBarrier(*texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &toShaderRead);
+    });
+
+    vmaDestroyBuffer(allocator, cpuTransferBuffer, cpuTransferAllocation);
 }
 
 std::unique_ptr<GraphicsContext> GraphicsContext::create(std::shared_ptr<Window> windowRef) {
+    return create(windowRef, {});
+}
+
+std::unique_ptr<GraphicsContext> GraphicsContext::createHeadless(uint32_t width,
+                                                                 uint32_t height) {
+    return create(nullptr, { width, height });
+}
+
+std::unique_ptr<GraphicsContext> GraphicsContext::create(std::shared_ptr<Window> windowRef,
+                                                         VkExtent2D headlessExtent) {
     Logger::renderer_logger->info("Creating Graphics Context");
 #ifdef _DEBUG
     Logger::renderer_logger->info(" - validation layers: true");
@@ -1742,10 +3233,14 @@ std::unique_ptr<GraphicsContext> GraphicsContext::create(std::shared_ptr<Window>
     vkb::InstanceBuilder builder;
     auto instanceReturned = builder
                                 .set_app_name("VkPBR")
+                                // Without a window no surface extensions are needed
+                                .set_headless(windowRef == nullptr)
 #ifdef _DEBUG
                                 .request_validation_layers(true)
 #endif
                                 .require_api_version(1, 1, 0)
+                                // Where there is, for the core vkCmdDrawIndirectCount
+                                .desire_api_version(1, 2, 0)
                                 .set_debug_callback(Logger::debugUtilsMessengerCallback)
                                 .build();
 
@@ -1758,26 +3253,112 @@ std::unique_ptr<GraphicsContext> GraphicsContext::create(std::shared_ptr<Window>
     VkInstance instance                     = vkbInstance.instance;
     VkDebugUtilsMessengerEXT debugMessenger = vkbInstance.debug_messenger;
 
-    VkSurfaceKHR surface;
-    VK_CHECK(glfwCreateWindowSurface(instance, windowRef->get(), nullptr, &surface));
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    if (windowRef) {
+        VK_CHECK(glfwCreateWindowSurface(instance, windowRef->get(), nullptr, &surface));
+    }
+
+    // Indirect draws are written by compute shaders, one per visible object with the object index
+    // as the first instance
+    VkPhysicalDeviceFeatures requiredFeatures  = {};
+    requiredFeatures.multiDrawIndirect         = VK_TRUE;
+    requiredFeatures.drawIndirectFirstInstance = VK_TRUE;
+    // Textures are cooked to BC formats. Devices without them are still picked when no other
+    // device fits, createCompressedTexture decodes the blocks for those
+    requiredFeatures.textureCompressionBC = VK_TRUE;
 
     vkb::PhysicalDeviceSelector selector{ vkbInstance };
-    vkb::PhysicalDevice vkbPhysicalDevice =
-        selector.set_minimum_version(1, 1)
-            .set_surface(surface)
-            .prefer_gpu_device_type(vkb::PreferredDeviceType::discrete)
-            .select()
-            .value();
+    selector.set_minimum_version(1, 1)
+        .add_desired_extension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)
+        .add_desired_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+        .prefer_gpu_device_type(vkb::PreferredDeviceType::discrete);
+    if (windowRef) {
+        selector.set_surface(surface);
+    } else {
+        selector.require_present(false);
+    }
+
+    auto selected = selector.set_required_features(requiredFeatures).select();
+    if (!selected) {
+        requiredFeatures.textureCompressionBC = VK_FALSE;
+        selected = selector.set_required_features(requiredFeatures).select();
+    }
+    vkb::PhysicalDevice vkbPhysicalDevice = selected.value();
+    bool textureCompressionBC             = requiredFeatures.textureCompressionBC == VK_TRUE;
 
     Logger::renderer_logger->info(" - using Physical Device: {0}",
                                   vkbPhysicalDevice.properties.deviceName);
+    if (!textureCompressionBC) {
+        Logger::renderer_logger->warn("  - No BC texture support, textures are decoded on upload");
+    }
+
+    // Core in 1.1, lets a single render pass fill every face of a cubemap
+    VkPhysicalDeviceMultiviewFeatures multiviewFeatures = {};
+    multiviewFeatures.sType     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+    multiviewFeatures.pNext     = nullptr;
+    multiviewFeatures.multiview = VK_TRUE;
+
+    // Core in 1.1, the vertex shaders index the object buffer with gl_BaseInstance
+    VkPhysicalDeviceShaderDrawParametersFeatures drawParametersFeatures = {};
+    drawParametersFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES;
+    drawParametersFeatures.pNext                = nullptr;
+    drawParametersFeatures.shaderDrawParameters = VK_TRUE;
+
+    // GPU culling draws with a count when the device can, from VK_KHR_draw_indirect_count or from
+    // Vulkan 1.2 with the drawIndirectCount feature. The extension is desired above, so it's
+    // enabled whenever the device has it
+    bool drawIndirectCountExtension = false;
+    for (const auto& extension : vkbPhysicalDevice.get_extensions()) {
+        if (std::string(extension) == VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) {
+            drawIndirectCountExtension = true;
+        }
+    }
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.pNext = nullptr;
+
+    bool drawIndirectCountCore = false;
+    if (!drawIndirectCountExtension && vkbInstance.instance_version >= VK_API_VERSION_1_2 &&
+        vkbPhysicalDevice.properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext                     = &vulkan12Features;
+        vkGetPhysicalDeviceFeatures2(vkbPhysicalDevice.physical_device, &features);
+
+        drawIndirectCountCore = vulkan12Features.drawIndirectCount == VK_TRUE;
+
+        // Only the one feature is enabled
+        vulkan12Features                   = {};
+        vulkan12Features.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.pNext             = nullptr;
+        vulkan12Features.drawIndirectCount = VK_TRUE;
+    }
 
     vkb::DeviceBuilder deviceBuilder{ vkbPhysicalDevice };
+    deviceBuilder.add_pNext(&multiviewFeatures).add_pNext(&drawParametersFeatures);
+    if (drawIndirectCountCore) {
+        deviceBuilder.add_pNext(&vulkan12Features);
+    }
     vkb::Device vkbDevice = deviceBuilder.build().value();
 
     VkDevice device                 = vkbDevice.device;
     VkPhysicalDevice physicalDevice = vkbPhysicalDevice.physical_device;
 
+    PFN_vkCmdDrawIndirectCountKHR drawIndirectCountFunction = nullptr;
+    if (drawIndirectCountExtension) {
+        drawIndirectCountFunction = reinterpret_cast<PFN_vkCmdDrawIndirectCountKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCountKHR"));
+    } else if (drawIndirectCountCore) {
+        drawIndirectCountFunction = reinterpret_cast<PFN_vkCmdDrawIndirectCountKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCount"));
+    }
+    Logger::renderer_logger->info("  - Draw indirect count: {0}",
+                                  drawIndirectCountExtension ? "extension"
+                                  : drawIndirectCountCore    ? "Vulkan 1.2"
+                                                             : "unsupported");
+
     VkPhysicalDeviceProperties physicalDeviceProperties;
     vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
 
@@ -1807,7 +3388,8 @@ std::unique_ptr<GraphicsContext> GraphicsContext::create(std::shared_ptr<Window>
 
     return std::make_unique<GraphicsContext>(
         windowRef, instance, device, physicalDevice, debugMessenger, physicalDeviceProperties,
-        graphicsQueue, graphicsQueueFamily, transferQueue, transferQueueFamily, surface);
+        graphicsQueue, graphicsQueueFamily, transferQueue, transferQueueFamily, surface,
+        drawIndirectCountFunction, textureCompressionBC, headlessExtent);
 }
 
 uint32_t GraphicsContext::getCurrentFrameBasedIndex(int frameOffset) {
@@ -1815,6 +3397,7 @@ uint32_t GraphicsContext::getCurrentFrameBasedIndex(int frameOffset) {
 }
 
 void GraphicsContext::windowResize(int width, int height) {
+    depthPyramid.reset();
     vkDestroyImageView(device, depthImageView, nullptr);
     vmaDestroyImage(allocator, depthImage.image, depthImage.allocation);
 
@@ -1825,6 +3408,8 @@ void GraphicsContext::windowResize(int width, int height) {
     vkDestroySwapchainKHR(device, swapchain, nullptr);
 
     initSwapchain();
+
+    initDepthPyramid();
 }
 
 void GraphicsContext::initDescriptorPool() {
@@ -1832,12 +3417,13 @@ void GraphicsContext::initDescriptorPool() {
     std::vector<VkDescriptorPoolSize> sizes = { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100 },
                                                 { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100 },
                                                 { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                                  1000 } };
+                                                  1000 },
+                                                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 200 } };
 
     VkDescriptorPoolCreateInfo pool_info = {};
     pool_info.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.flags                      = 0;
-    pool_info.maxSets                    = 100; // TODO: Add better numbers here
+    pool_info.maxSets                    = 200; // TODO: Add better numbers here
     pool_info.poolSizeCount              = (uint32_t)sizes.size();
     pool_info.pPoolSizes                 = sizes.data();
 
@@ -1849,44 +3435,69 @@ void GraphicsContext::initAllocators() {
     allocatorInfo.physicalDevice         = physicalDevice;
     allocatorInfo.device                 = device;
     allocatorInfo.instance               = instance;
+    allocatorInfo.vulkanApiVersion       = VK_API_VERSION_1_1;
+
+    // Desired when the device is picked, so it's enabled whenever the device has it. Lets
+    // vmaGetHeapBudgets report what the driver says, see getDeviceMemoryBudget
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount,
+                                         extensions.data());
+    for (auto& extension : extensions) {
+        if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+            allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
+    }
 
     VK_CHECK(vmaCreateAllocator(&allocatorInfo, &allocator));
 }
 
 void GraphicsContext::initSwapchain() {
-    vkb::SwapchainBuilder swapchainBuilder{ physicalDevice, device, surface };
+    if (windowRef) {
+        currentSwapchainExtent.width  = windowRef->getWidth();
+        currentSwapchainExtent.height = windowRef->getHeight();
+    } else {
+        currentSwapchainExtent = headlessExtent;
+    }
 
     Logger::renderer_logger->info("Graphics context creating swapchain with size: {0} {1}",
-                                  windowRef->getWidth(), windowRef->getHeight());
-    currentSwapchainExtent.width  = windowRef->getWidth();
-    currentSwapchainExtent.height = windowRef->getHeight();
+                                  currentSwapchainExtent.width, currentSwapchainExtent.height);
 
-    auto swapchainBuildResult =
-        swapchainBuilder
-            .use_default_format_selection()
-            //.set_desired_present_mode(VK_PRESENT_MODE_MAILBOX_KHR)
-            .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
-            .set_desired_extent(currentSwapchainExtent.width, currentSwapchainExtent.height)
-            .build();
+    if (windowRef) {
+        vkb::SwapchainBuilder swapchainBuilder{ physicalDevice, device, surface };
 
-    if (!swapchainBuildResult || !swapchainBuildResult.has_value()) {
-        Logger::renderer_logger->error("Failed to create swapchain");
-    }
+        auto swapchainBuildResult =
+            swapchainBuilder
+                .use_default_format_selection()
+                //.set_desired_present_mode(VK_PRESENT_MODE_MAILBOX_KHR)
+                .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
+                .set_desired_extent(currentSwapchainExtent.width, currentSwapchainExtent.height)
+                .build();
+
+        if (!swapchainBuildResult || !swapchainBuildResult.has_value()) {
+            Logger::renderer_logger->error("Failed to create swapchain");
+        }
 
-    vkb::Swapchain vkbSwapchain = swapchainBuildResult.value();
+        vkb::Swapchain vkbSwapchain = swapchainBuildResult.value();
 
-    swapchain            = vkbSwapchain.swapchain;
-    swapchainImages      = vkbSwapchain.get_images().value();
-    swapchainImageViews  = vkbSwapchain.get_image_views().value();
-    swapchainImageFormat = vkbSwapchain.image_format;
+        swapchain            = vkbSwapchain.swapchain;
+        swapchainImages      = vkbSwapchain.get_images().value();
+        swapchainImageViews  = vkbSwapchain.get_image_views().value();
+        swapchainImageFormat = vkbSwapchain.image_format;
+    } else {
+        initHeadlessImages();
+    }
 
-    VkExtent3D depthImageExtent = { (uint32_t)windowRef->getWidth(),
-                                    (uint32_t)windowRef->getHeight(), 1 };
+    VkExtent3D depthImageExtent = { currentSwapchainExtent.width, currentSwapchainExtent.height,
+                                    1 };
 
     depthFormat = VK_FORMAT_D32_SFLOAT;
 
+    // Sampled to build the depth pyramid
     VkImageCreateInfo depthImageInfo = helper::imageCreateInfo(
-        depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, depthImageExtent);
+        depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        depthImageExtent);
 
     VmaAllocationCreateInfo depthImageAllocInfo = {};
     depthImageAllocInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
@@ -1901,13 +3512,47 @@ void GraphicsContext::initSwapchain() {
     VK_CHECK(vkCreateImageView(device, &depthViewInfo, nullptr, &depthImageView));
 }
 
+void GraphicsContext::initHeadlessImages() {
+    // The format a swapchain gets by default, so pipelines and passes look the same either way
+    swapchainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+
+    VkExtent3D imageExtent = { currentSwapchainExtent.width, currentSwapchainExtent.height, 1 };
+
+    VkImageCreateInfo imageInfo = helper::imageCreateInfo(
+        swapchainImageFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        imageExtent);
+
+    VmaAllocationCreateInfo imageAllocInfo = {};
+    imageAllocInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    // One per frame in flight, like the images of a swapchain
+    headlessImages = std::vector<AllocatedImage>(FRAME_OVERLAP);
+    swapchainImages.clear();
+    swapchainImageViews.clear();
+    for (auto& headlessImage : headlessImages) {
+        VK_CHECK(vmaCreateImage(allocator, &imageInfo, &imageAllocInfo, &headlessImage.image,
+                                &headlessImage.allocation, nullptr));
+
+        VkImageViewCreateInfo viewInfo = helper::imageViewCreateInfo(
+            swapchainImageFormat, headlessImage.image, VK_IMAGE_ASPECT_COLOR_BIT);
+
+        VkImageView imageView;
+        VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &imageView));
+
+        swapchainImages.push_back(headlessImage.image);
+        swapchainImageViews.push_back(imageView);
+    }
+}
+
 void GraphicsContext::initSwapchainRenderPass() {
     std::vector<RenderPassAttachmentDescription> renderPassAttachmentDescriptions;
     RenderPassAttachmentDescription colorAttachmentDescription = {};
     colorAttachmentDescription.loadOp                          = LoadOp::CLEAR;
     colorAttachmentDescription.storeOp                         = StoreOp::STORE;
     colorAttachmentDescription.initialLayout                   = ImageLayout::UNDEFINED;
-    colorAttachmentDescription.finalLayout                     = ImageLayout::PRESENT;
+    // Without a swapchain there is no presenting, the image is left to be copied from instead
+    colorAttachmentDescription.finalLayout =
+        windowRef ? ImageLayout::PRESENT : ImageLayout::TRANSFER_SRC;
     renderPassAttachmentDescriptions.push_back(colorAttachmentDescription);
 
     RenderPassAttachmentDescription depthAttachmentDescription = {};
@@ -1976,6 +3621,19 @@ void GraphicsContext::initSwapchainRenderPass() {
 
     VK_CHECK(vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, &swapchainRenderPass));
 
+    // Same attachments loaded instead of cleared, for the passes after the first one of a frame.
+    // Compatible with the first pass, so it uses the same framebuffers
+    for (size_t i = 0; i < attachmentDescriptions.size(); i++) {
+        allAttachmentDescriptions[i].loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+        allAttachmentDescriptions[i].initialLayout = allAttachmentDescriptions[i].finalLayout;
+    }
+    allAttachmentDescriptions.back().loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+    allAttachmentDescriptions.back().stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    allAttachmentDescriptions.back().initialLayout =
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VK_CHECK(vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, &swapchainLoadRenderPass));
+
     swapchainFramebuffers = std::vector<VkFramebuffer>(swapchainImages.size());
 
     VkFramebufferCreateInfo fbCreateInfo = {};
@@ -1983,8 +3641,8 @@ void GraphicsContext::initSwapchainRenderPass() {
     fbCreateInfo.pNext                   = nullptr;
     fbCreateInfo.renderPass              = swapchainRenderPass;
     fbCreateInfo.attachmentCount         = (uint32_t)allAttachmentDescriptions.size();
-    fbCreateInfo.width                   = windowRef->getWidth();
-    fbCreateInfo.height                  = windowRef->getHeight();
+    fbCreateInfo.width                   = currentSwapchainExtent.width;
+    fbCreateInfo.height                  = currentSwapchainExtent.height;
     fbCreateInfo.layers                  = 1;
 
     for (int i = 0; i < swapchainFramebuffers.size();
@@ -1998,11 +3656,104 @@ void GraphicsContext::initSwapchainRenderPass() {
     }
 }
 
+void GraphicsContext::initDepthPyramid() {
+    // Powers of two so every texel of a level covers exactly 2x2 texels of the level below
+    uint32_t width  = 1;
+    uint32_t height = 1;
+    while (width * 2 <= currentSwapchainExtent.width) {
+        width *= 2;
+    }
+    while (height * 2 <= currentSwapchainExtent.height) {
+        height *= 2;
+    }
+    uint32_t mipLevels = 1;
+    while ((std::max(width, height) >> mipLevels) > 0) {
+        mipLevels++;
+    }
+
+    VkFormat format             = helper::getVkFormat(Format::R32_FLOAT);
+    VkImageCreateInfo imageInfo = helper::imageCreateInfo(
+        format, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, { width, height, 1 });
+    imageInfo.mipLevels = mipLevels;
+
+    VmaAllocationCreateInfo imageAllocationInfo = {};
+    imageAllocationInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkImage image;
+    VmaAllocation allocation;
+    VK_CHECK(
+        vmaCreateImage(allocator, &imageInfo, &imageAllocationInfo, &image, &allocation, nullptr));
+
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        VkImageMemoryBarrier imageBarrier            = {};
+        imageBarrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.pNext                           = nullptr;
+        imageBarrier.srcAccessMask                   = 0;
+        imageBarrier.dstAccessMask                   = VK_ACCESS_SHADER_READ_BIT;
+        imageBarrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageBarrier.newLayout                       = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageBarrier.image                           = image;
+        imageBarrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel   = 0;
+        imageBarrier.subresourceRange.levelCount     = mipLevels;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount     = 1;
+
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &imageBarrier);
+    });
+
+    VkImageView imageView;
+    VkImageViewCreateInfo imageViewInfo =
+        helper::imageViewCreateInfo(format, image, VK_IMAGE_ASPECT_COLOR_BIT);
+    imageViewInfo.subresourceRange.levelCount = mipLevels;
+    VK_CHECK(vkCreateImageView(device, &imageViewInfo, nullptr, &imageView));
+
+    depthPyramid = std::make_shared<Texture>(device, allocator, allocation, image, imageView,
+                                             format, width, height, mipLevels, 1);
+
+    while (depthPyramidDescriptorSets.size() < mipLevels) {
+        depthPyramidDescriptorSets.push_back(createDescriptorSet(depthPyramidPipeline, 0));
+    }
+
+    VkDescriptorImageInfo depthInfo = {};
+    depthInfo.sampler               = nearestSampler;
+    depthInfo.imageView             = depthImageView;
+    depthInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    for (uint32_t level = 0; level < mipLevels; level++) {
+        std::shared_ptr<DescriptorSet> descriptorSet = depthPyramidDescriptorSets[level];
+
+        for (int i = 0; i < FRAME_OVERLAP; i++) {
+            VkWriteDescriptorSet write = {};
+            write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.pNext                = nullptr;
+
+            write.dstBinding      = 0;
+            write.dstSet          = descriptorSet->descriptorSets[i];
+            write.descriptorCount = 1;
+            write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo      = &depthInfo;
+
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        }
+
+        // Level 0 reads the depth image instead of a source level
+        descriptorSetAddStorageImage(descriptorSet, 1, depthPyramid, (level == 0) ? 0 : level - 1);
+        descriptorSetAddStorageImage(descriptorSet, 2, depthPyramid, level);
+    }
+}
+
 void GraphicsContext::initUploadStructures() {
     VkCommandPoolCreateInfo uploadCommandPoolInfo =
         helper::commandPoolCreateInfo(graphicsQueueFamily);
     VK_CHECK(vkCreateCommandPool(device, &uploadCommandPoolInfo, nullptr, &uploadCommandPool));
 
+    // Async uploads free their own command buffers, immediateSubmit resets the whole pool
+    VK_CHECK(vkCreateCommandPool(device, &uploadCommandPoolInfo, nullptr,
+                                 &asyncUploadCommandPool));
+
     VkFenceCreateInfo uploadFenceCreateInfo = helper::fenceCreateInfo();
     VK_CHECK(vkCreateFence(device, &uploadFenceCreateInfo, nullptr, &uploadFence));
 }
@@ -2023,63 +3774,16 @@ void GraphicsContext::initSamplers() {
     info.maxLod       = VK_LOD_CLAMP_NONE;
 
     vkCreateSampler(device, &info, nullptr, &mainSampler);
-}
-
-std::string readFileToString(const char* filePath) {
-    std::ifstream inFile;
-    inFile.open(filePath);
-    if (!inFile.is_open()) {
-        Logger::renderer_logger->error("Shader file missing: {0}", filePath);
-    }
-
-    return std::string((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
-}
-
-shaderc_shader_kind shaderKindFromExtension(std::string& fileExtension) {
-    if (fileExtension == ".vert") {
-        return shaderc_shader_kind::shaderc_vertex_shader;
-    } else if (fileExtension == ".frag") {
-        return shaderc_shader_kind::shaderc_fragment_shader;
-    } else {
-        Logger::renderer_logger->error("Invalid shader extension: {0}", fileExtension);
-        return shaderc_shader_kind::shaderc_vertex_shader;
-    }
-}
-
-std::string preprocessGLSL(std::string& inputGLSL, shaderc_shader_kind shaderKind,
-                           const char* shaderFilePath) {
-    shaderc::Compiler compiler;
-    shaderc::CompileOptions options;
-
-    shaderc::PreprocessedSourceCompilationResult result =
-        compiler.PreprocessGlsl(inputGLSL, shaderKind, "shader", options);
-
-    if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-        Logger::renderer_logger->error("Failed to preprocess glsl shader: {0}. {1}", shaderFilePath,
-                                       result.GetErrorMessage());
-    }
-
-    return std::string(result.cbegin(), result.cend());
-}
-
-std::vector<uint32_t> spvBytesFromGLSL(std::string& glsl, shaderc_shader_kind shaderKind,
-                                       const char* shaderFilePath) {
-    shaderc::Compiler compiler;
-    shaderc::CompileOptions options;
 
-    if (false) { // Bool optimize
-        options.SetOptimizationLevel(shaderc_optimization_level_performance);
-    }
-
-    shaderc::SpvCompilationResult spv_module =
-        compiler.CompileGlslToSpv(glsl, shaderKind, "name", options);
-
-    if (spv_module.GetCompilationStatus() != shaderc_compilation_status_success) {
-        Logger::renderer_logger->error("Failed to compile shader: {0}, {1}", shaderFilePath,
-                                       spv_module.GetErrorMessage());
-    }
+    // For formats without linear filtering, like the swapchain depth
+    info.magFilter    = VK_FILTER_NEAREST;
+    info.minFilter    = VK_FILTER_NEAREST;
+    info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
 
-    return std::vector<uint32_t>(spv_module.cbegin(), spv_module.cend());
+    vkCreateSampler(device, &info, nullptr, &nearestSampler);
 }
 
 VkShaderStageFlags vkShaderStageFromShaderCStage(shaderc_shader_kind shaderKind) {
@@ -2087,6 +3791,8 @@ VkShaderStageFlags vkShaderStageFromShaderCStage(shaderc_shader_kind shaderKind)
         return VK_SHADER_STAGE_VERTEX_BIT;
     } else if (shaderKind == shaderc_shader_kind::shaderc_fragment_shader) {
         return VK_SHADER_STAGE_FRAGMENT_BIT;
+    } else if (shaderKind == shaderc_shader_kind::shaderc_compute_shader) {
+        return VK_SHADER_STAGE_COMPUTE_BIT;
     }
 
     return VK_SHADER_STAGE_VERTEX_BIT;
@@ -2218,13 +3924,26 @@ ShaderModuleReflectionData parseReflectionDataFromSpvBytes(std::vector<uint32_t>
 }
 
 ShaderModule GraphicsContext::loadShaderModule(const char* shaderFilePath) {
-    std::string glslString         = readFileToString(shaderFilePath);
-    std::string extension          = std::filesystem::path(shaderFilePath).extension().string();
-    shaderc_shader_kind shaderKind = shaderKindFromExtension(extension);
+    std::set<std::string> includedFiles;
+    std::vector<uint32_t> spvBytes =
+        helper::compileShaderFile(shaderFilePath, shaderCompileOptions, &includedFiles);
+
+    // So editing an included file reloads the shader
+    if (shaderWatcher) {
+        shaderWatcher->setIncludedFiles(shaderFilePath, includedFiles);
+    }
+
+    if (!spvBytes.empty()) {
+        shaderSpvCache[helper::normalizeShaderPath(shaderFilePath)] = spvBytes;
+    }
 
-    std::string preprocessedGLSL = preprocessGLSL(glslString, shaderKind, shaderFilePath);
+    return createShaderModule(shaderFilePath, spvBytes);
+}
 
-    std::vector<uint32_t> spvBytes = spvBytesFromGLSL(preprocessedGLSL, shaderKind, shaderFilePath);
+ShaderModule GraphicsContext::createShaderModule(const char* shaderFilePath,
+                                                 std::vector<uint32_t>& spvBytes) {
+    std::string extension          = std::filesystem::path(shaderFilePath).extension().string();
+    shaderc_shader_kind shaderKind = helper::shaderKindFromExtension(extension);
 
     ShaderModuleReflectionData reflectionData =
         parseReflectionDataFromSpvBytes(spvBytes, vkShaderStageFromShaderCStage(shaderKind));
@@ -2248,6 +3967,8 @@ ShaderModule GraphicsContext::loadShaderModule(const char* shaderFilePath) {
         shaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
     } else if (shaderKind == shaderc_fragment_shader) {
         shaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    } else if (shaderKind == shaderc_compute_shader) {
+        shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
     }
     shaderStageInfo.module = shaderModule;
     shaderStageInfo.pName  = "main";
@@ -2255,6 +3976,57 @@ ShaderModule GraphicsContext::loadShaderModule(const char* shaderFilePath) {
     return ShaderModule(device, shaderModule, shaderStageInfo, reflectionData);
 }
 
+void GraphicsContext::recordSecondary(
+    std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers,
+    VkRenderPass renderPass, VkFramebuffer framebuffer, uint32_t itemCount,
+    std::function<void(std::shared_ptr<CommandBuffer>, uint32_t, uint32_t)>& record) {
+    uint32_t frameIndex  = getCurrentFrameBasedIndex();
+    uint32_t threadCount = (uint32_t)secondaryCommandBuffers->threadCommandBuffers.size();
+    uint32_t rangeSize   = (itemCount + threadCount - 1) / threadCount;
+
+    auto recordRange = [&](uint32_t threadIndex) {
+        std::shared_ptr<CommandBuffer> commandBuffer =
+            secondaryCommandBuffers->threadCommandBuffers[threadIndex][frameIndex];
+
+        VK_CHECK(vkResetCommandPool(device, commandBuffer->commandPool, 0));
+
+        VkCommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.pNext = nullptr;
+        inheritanceInfo.renderPass  = renderPass;
+        inheritanceInfo.subpass     = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo cmdBeginInfo =
+            helper::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                           VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+        cmdBeginInfo.pInheritanceInfo = &inheritanceInfo;
+        VK_CHECK(vkBeginCommandBuffer(commandBuffer->commandBuffer, &cmdBeginInfo));
+
+        // Threads past the end of the items still end up with an empty buffer to execute
+        uint32_t first = std::min(threadIndex * rangeSize, itemCount);
+        uint32_t count = std::min(rangeSize, itemCount - first);
+        if (count > 0) {
+            record(commandBuffer, first, count);
+        }
+
+        VK_CHECK(vkEndCommandBuffer(commandBuffer->commandBuffer));
+    };
+
+    // Every range has its own command pool, so the jobs never share one
+    auto recordRanges = [&](uint32_t firstThread, uint32_t count) {
+        for (uint32_t threadIndex = firstThread; threadIndex < firstThread + count; threadIndex++) {
+            recordRange(threadIndex);
+        }
+    };
+
+    if (jobSystem != nullptr) {
+        jobSystem->parallelFor(threadCount, 1, recordRanges);
+    } else {
+        recordRanges(0, threadCount);
+    }
+}
+
 void GraphicsContext::immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function) {
     VkCommandBufferAllocateInfo cmdAllocInfo =
         helper::commandBufferAllocateInfo(uploadCommandPool, 1);
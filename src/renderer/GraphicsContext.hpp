@@ -3,20 +3,34 @@
 #include "Config.hpp"
 #include "Types/Buffer.hpp"
 #include "Types/Commands.hpp"
+#include "Types/Handle.hpp"
 #include "Types/Image.hpp"
 #include "Types/Pipeline.hpp"
 #include "Types/Renderpass.hpp"
 #include "Types/Synchronization.hpp"
 #include "Types/Texture.hpp"
+#include "ShaderWatcher.hpp"
 #include "Window.hpp"
 
+class CommandList;
+class JobSystem;
+
+// Summed over the device local heaps, from vmaGetHeapBudgets. Without VK_EXT_memory_budget the
+// usage only counts VMA's own allocations and the budget is a fixed share of the heaps
+struct DeviceMemoryBudget {
+    VkDeviceSize usage;
+    VkDeviceSize budget;
+};
+
 class GraphicsContext {
 public:
     GraphicsContext(std::shared_ptr<Window> windowRef, VkInstance instance, VkDevice device,
                     VkPhysicalDevice physicalDevice, VkDebugUtilsMessengerEXT debugMessenger,
                     VkPhysicalDeviceProperties physicalDeviceProperties, VkQueue graphicsQueue,
                     uint32_t graphicsQueueFamily, VkQueue transferQueue,
-                    uint32_t transferQueueFamily, VkSurfaceKHR surface);
+                    uint32_t transferQueueFamily, VkSurfaceKHR surface,
+                    PFN_vkCmdDrawIndirectCountKHR drawIndirectCountFunction,
+                    bool textureCompressionBC, VkExtent2D headlessExtent);
 
     ~GraphicsContext();
 
@@ -28,18 +42,58 @@ public:
 
     uint32_t newFrame(std::shared_ptr<FrameBasedSemaphore> signalSemaphore);
 
+    // Which copy of every FrameBased resource this frame uses
+    uint32_t getFrameBasedIndex();
+
     void beginRecording(std::shared_ptr<CommandBuffer> commandBuffer);
 
     void beginRecording(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
 
+    // With secondaryContents the pass may only be filled by executeSecondary
     void beginSwapchainRenderPass(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
-                                  uint32_t frameIndex, glm::vec4 clearColor);
+                                  uint32_t frameIndex, glm::vec4 clearColor,
+                                  bool secondaryContents = false);
+
+    // Begins the swapchain pass again without clearing, keeping what an earlier swapchain pass
+    // this frame drew
+    void continueSwapchainRenderPass(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                                     uint32_t frameIndex, bool secondaryContents = false);
+
+    // Reduces the swapchain depth into the depth pyramid. Between two swapchain passes of a frame,
+    // the next one has to be a continueSwapchainRenderPass
+    void buildDepthPyramid(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
+
+    // R32 float with a full mip chain, each texel holds the farthest depth it covers. Level 0 is
+    // the swapchain extent rounded down to powers of two. Recreated with the swapchain, and in
+    // ImageLayout::SHADER_READ outside of buildDepthPyramid
+    std::shared_ptr<Texture> getDepthPyramid();
 
     void beginRenderPass(std::shared_ptr<CommandBuffer> commandBuffer,
-                         std::shared_ptr<RenderPass> renderPass, uint32_t width, uint32_t height);
+                         std::shared_ptr<RenderPass> renderPass, uint32_t width, uint32_t height,
+                         bool secondaryContents = false);
 
     void beginRenderPass(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
-                         std::shared_ptr<RenderPass> renderPass, uint32_t width, uint32_t height);
+                         std::shared_ptr<RenderPass> renderPass, uint32_t width, uint32_t height,
+                         bool secondaryContents = false);
+
+    // Splits itemCount items into one contiguous range per thread of secondaryCommandBuffers and
+    // records each range as a job of the job system, record gets the range's command buffer, the
+    // first item and the item count. Returns once every range is done. Each buffer starts with no
+    // state bound, so record has to bind its pipeline and sets, and may only record commands
+    void recordSwapchainSecondary(
+        std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers,
+        uint32_t frameIndex, uint32_t itemCount,
+        std::function<void(std::shared_ptr<CommandBuffer>, uint32_t, uint32_t)> record);
+
+    void recordSecondary(
+        std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers,
+        std::shared_ptr<RenderPass> renderPass, uint32_t itemCount,
+        std::function<void(std::shared_ptr<CommandBuffer>, uint32_t, uint32_t)> record);
+
+    // Executes this frame's secondary command buffers of every thread, in thread order
+    void
+    executeSecondary(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                     std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers);
 
     void bindPipeline(std::shared_ptr<CommandBuffer> commandBuffer,
                       std::shared_ptr<Pipeline> pipeline);
@@ -47,6 +101,12 @@ public:
     void bindPipeline(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
                       std::shared_ptr<Pipeline> pipeline);
 
+    void bindPipeline(std::shared_ptr<CommandBuffer> commandBuffer,
+                      std::shared_ptr<ComputePipeline> pipeline);
+
+    void bindPipeline(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                      std::shared_ptr<ComputePipeline> pipeline);
+
     void* mapDescriptorBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding);
 
     void unmapDescriptorBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding);
@@ -65,6 +125,14 @@ public:
                        std::shared_ptr<Pipeline> pipeline, uint32_t offset, uint32_t size,
                        void* data);
 
+    void pushConstants(std::shared_ptr<CommandBuffer> commandBuffer,
+                       std::shared_ptr<ComputePipeline> pipeline, uint32_t offset, uint32_t size,
+                       void* data);
+
+    void pushConstants(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                       std::shared_ptr<ComputePipeline> pipeline, uint32_t offset, uint32_t size,
+                       void* data);
+
     void bindVertexBuffer(std::shared_ptr<CommandBuffer> commandBuffer,
                           std::shared_ptr<VertexBuffer> vertexBuffer);
 
@@ -77,6 +145,33 @@ public:
     void draw(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer, uint32_t vertexCount,
               uint32_t numInstances, uint32_t firstVertex, uint32_t firstInstance);
 
+    // Draws the commands in an indirect buffer laid out as a uint count padded to 16 bytes and then
+    // VkDrawIndirectCommands. Devices without VK_KHR_draw_indirect_count draw all maxDrawCount
+    // commands, so the buffer has to be cleared before the commands are written
+    void drawIndirectCount(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                           std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+                           uint32_t maxDrawCount);
+
+    bool supportsDrawIndirectCount();
+
+    // Compressed textures are decoded before the upload when false, and take that much more memory
+    bool supportsTextureCompressionBC();
+
+    // Zeroes this frame's buffer at the binding, outside of a render pass
+    void clearDescriptorBuffer(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                               std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding);
+
+    void descriptorBufferBarrier(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer,
+                                 std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+                                 VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+                                 VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+
+    void dispatch(std::shared_ptr<CommandBuffer> commandBuffer, uint32_t groupCountX,
+                  uint32_t groupCountY, uint32_t groupCountZ);
+
+    void dispatch(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer, uint32_t groupCountX,
+                  uint32_t groupCountY, uint32_t groupCountZ);
+
     void endRenderPass(std::shared_ptr<CommandBuffer> commandBuffer);
 
     void endRenderPass(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
@@ -85,6 +180,11 @@ public:
                                     std::shared_ptr<RenderPass> renderPass,
                                     ImageLayout initialLayout, ImageLayout finalLayout);
 
+    // Transitions every mip and layer of the texture
+    void transitionTexture(std::shared_ptr<CommandBuffer> commandBuffer,
+                           std::shared_ptr<Texture> texture, ImageLayout initialLayout,
+                           ImageLayout finalLayout);
+
     void copyRenderPassImageToCubemap(std::shared_ptr<CommandBuffer> commandBuffer,
                                       std::shared_ptr<RenderPass> renderPass,
                                       uint32_t attachmentIndex, std::shared_ptr<Texture> cubemap,
@@ -109,6 +209,32 @@ public:
 
     void immediateSubmit(std::shared_ptr<CommandBuffer> commandBuffer);
 
+    // Records into the buffer of the current frame, see CommandList
+    CommandList commandList(std::shared_ptr<FrameBasedCommandBuffer> commandBuffer);
+
+    CommandList commandList(std::shared_ptr<CommandBuffer> commandBuffer);
+
+    // Handles keep their object alive until released. Registering and releasing must not happen
+    // while another thread is recording with handles
+    PipelineHandle registerPipeline(std::shared_ptr<Pipeline> pipeline);
+
+    DescriptorSetHandle registerDescriptorSet(std::shared_ptr<DescriptorSet> descriptorSet);
+
+    VertexBufferHandle registerVertexBuffer(std::shared_ptr<VertexBuffer> vertexBuffer);
+
+    void release(PipelineHandle pipeline);
+
+    void release(DescriptorSetHandle descriptorSet);
+
+    void release(VertexBufferHandle vertexBuffer);
+
+    // Null once the handle is released
+    Pipeline* resolve(PipelineHandle pipeline);
+
+    DescriptorSet* resolve(DescriptorSetHandle descriptorSet);
+
+    VertexBuffer* resolve(VertexBufferHandle vertexBuffer);
+
     void present(uint32_t frameIndex, std::shared_ptr<FrameBasedSemaphore> waitSemaphore);
 
     void waitIdle();
@@ -117,25 +243,79 @@ public:
 
     std::shared_ptr<FrameBasedCommandBuffer> createFrameBasedCommandBuffer();
 
+    std::shared_ptr<FrameBasedSecondaryCommandBuffers>
+    createFrameBasedSecondaryCommandBuffers(uint32_t threadCount);
+
     std::shared_ptr<FrameBasedFence> createFrameBasedFence(bool createSignaled);
 
     std::shared_ptr<FrameBasedSemaphore> createFrameBasedSemaphore();
 
+    // A view count above one makes a multiview render pass, each attachment then has that many
+    // layers and view i of a draw lands in layer i
     std::shared_ptr<RenderPass>
     createRenderPass(std::vector<RenderPassAttachmentDescription> renderPassAttachmentDescriptions,
                      bool useDepthAttachment,
-                     RenderPassAttachmentDescription depthAttachmentDescription = {});
+                     RenderPassAttachmentDescription depthAttachmentDescription = {},
+                     uint32_t viewCount                                         = 1);
 
     std::shared_ptr<Pipeline> createPipeline(PipelineCreateInfo* pipelineInfo);
 
+    std::shared_ptr<ComputePipeline> createComputePipeline(const char* computeShaderPath);
+
+    // Applies to shaders compiled after the call, including hot reloads started afterwards
+    void setShaderCompileOptions(ShaderCompileOptions compileOptions);
+
+    // Shaders loaded after the call are also recompiled when a file they include changes
+    void enableShaderHotReload(const char* shaderDirectory);
+
+    // Secondary command buffers are recorded on its threads, without one on the calling thread
+    void useJobSystem(JobSystem* jobSystem);
+
+    // Rebuilds pipelines whose shaders changed on disk. Call at a frame boundary, before waiting on
+    // the frame fence. Blocks until every frame of inFlightFence has signaled when there is work,
+    // so none of its fences may be reset without a submit pending on it
+    void applyShaderReloads(std::shared_ptr<FrameBasedFence> inFlightFence);
+
     std::shared_ptr<DescriptorSet> createDescriptorSet(std::shared_ptr<Pipeline> pipeline,
                                                        uint32_t setLayoutIndex);
 
+    std::shared_ptr<DescriptorSet> createDescriptorSet(std::shared_ptr<ComputePipeline> pipeline,
+                                                       uint32_t setLayoutIndex);
+
     void descriptorSetAddBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
                                 DescriptorType type, uint32_t bufferSize);
 
+    // Makes the buffers at the binding hold at least bufferSize bytes, at least doubling them when
+    // they have to grow. Only the current frame's buffer is replaced right away, so call it after
+    // waiting on this frame's fence and before the set is bound. The other frames' buffers are
+    // swapped in by newFrame once their fences were waited on, and the sets sharing the buffers
+    // are rebound the same way. The first preserveSize bytes of each buffer are copied over when
+    // it is swapped in, the rest starts out undefined. Returns whether the buffers grew
+    bool descriptorSetGrowBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+                                 DescriptorType type, uint32_t bufferSize,
+                                 uint32_t preserveSize = 0);
+
+    uint32_t getDescriptorBufferSize(std::shared_ptr<DescriptorSet> descriptorSet,
+                                     uint32_t binding);
+
+    // Binds the buffers another set owns at sourceBinding, so a compute and a graphics pipeline can
+    // work on the same data. With a frameOffset each frame binds the buffer of the frame that many
+    // frames away, -1 reads what the previous frame wrote
+    void descriptorSetShareBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+                                  std::shared_ptr<DescriptorSet> sourceDescriptorSet,
+                                  uint32_t sourceBinding, DescriptorType type,
+                                  int frameOffset = 0);
+
+    // With a frameIndex only that frame's set is written, for swapping the image of a set in use
+    // once that frame's fence has been waited on
     void descriptorSetAddImage(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
-                               std::shared_ptr<Texture> image);
+                               std::shared_ptr<Texture> image, int frameIndex = -1);
+
+    // Binds a single mip of the texture, all layers, for imageLoad/imageStore. The texture must be
+    // in ImageLayout::GENERAL when the set is used
+    void descriptorSetAddStorageImage(std::shared_ptr<DescriptorSet> descriptorSet,
+                                      uint32_t binding, std::shared_ptr<Texture> texture,
+                                      uint32_t mipLevel = 0);
 
     void descriptorSetAddRenderPassAttachment(std::shared_ptr<DescriptorSet> descriptorSet,
                                               uint32_t binding,
@@ -148,16 +328,85 @@ public:
                                            ColorSpace colorSpace, unsigned char* data,
                                            bool genMipmaps = false); // TODO: RGB Textures broken
 
+    // From a KTX2 file with its mips stored, see helper::readKTX2. Null when it can't be read
+    std::shared_ptr<Texture> createTexture(const std::string& ktx2Path);
+
+    // Records the upload without waiting for it, data can be freed once this returns. onUploaded
+    // gets the texture from pollTextureUploads once the GPU is done with it
+    void createTextureAsync(int width, int height, int numComponents, ColorSpace colorSpace,
+                            unsigned char* data, bool genMipmaps,
+                            std::function<void(std::shared_ptr<Texture>)> onUploaded);
+
+    // Uploads prebuilt mips of a block compressed format, mips[0] being the full size one. Each
+    // mip holds its blocks in row order. Devices without textureCompressionBC get them decoded to
+    // helper::getDecodedVkFormat. Null when the image can't be created
+    std::shared_ptr<Texture>
+    createCompressedTexture(Format format, uint32_t width, uint32_t height,
+                            const std::vector<std::vector<unsigned char>>& mips);
+
+    // With a firstMip only the mips from there down are uploaded, the texture's full size is then
+    // that of mips[firstMip]. Returns false without calling onUploaded when the image can't be
+    // created, for instance when device memory runs out
+    bool createCompressedTextureAsync(Format format, uint32_t width, uint32_t height,
+                                      const std::vector<std::vector<unsigned char>>& mips,
+                                      std::function<void(std::shared_ptr<Texture>)> onUploaded,
+                                      uint32_t firstMip = 0);
+
+    // Finishes the async uploads that are done, once per frame on the main thread
+    void pollTextureUploads();
+
+    // Converts the floats to format on the CPU and uploads that, RGBA16_FLOAT or B10G11R11_UFLOAT.
+    // The latter takes half the memory but drops alpha and negative values. RGB data gets an alpha
+    // of one. Logs the memory saved and the conversion time, tests/PixelsTest checks the error
     std::shared_ptr<Texture> createHDRTexture(int width, int height, int numComponents, float* data,
-                                              bool genMipmaps = false); // TODO: RGB Texture broken
+                                              bool genMipmaps = false,
+                                              Format format   = Format::RGBA16_FLOAT);
 
     std::shared_ptr<Texture> createCubemap(Format format, uint32_t width, uint32_t height,
                                            bool reserveMipMaps = false);
 
+    // Single mip 2D texture for compute shaders to write, starts in ImageLayout::SHADER_READ
+    std::shared_ptr<Texture> createStorageTexture(Format format, uint32_t width, uint32_t height);
+
+    // Single mip texture with no memory behind it yet, see bindTextureMemory. The texture only
+    // destroys its image, the memory stays with whoever allocated it
+    std::shared_ptr<Texture> createUnboundTexture(Format format, uint32_t width, uint32_t height,
+                                                  uint32_t arrayLayers, VkImageUsageFlags usage);
+
+    VkMemoryRequirements getTextureMemoryRequirements(std::shared_ptr<Texture> texture);
+
+    // Memory that one or more unbound textures get placed into. Lazily allocated memory only gets
+    // physical backing if a tiled GPU has to spill the attachment, VK_NULL_HANDLE is returned when
+    // the device has no such memory type
+    VmaAllocation allocateTextureMemory(VkMemoryRequirements requirements, bool lazilyAllocated);
+
+    // Binds the texture at offset into memory from allocateTextureMemory and creates its view
+    void bindTextureMemory(std::shared_ptr<Texture> texture, VmaAllocation allocation,
+                           VkDeviceSize offset);
+
+    void freeTextureMemory(VmaAllocation allocation);
+
+    DeviceMemoryBudget getDeviceMemoryBudget();
+
+    // Copies every mip and layer to host memory, mip by mip with the layers of each mip packed
+    // together. The texture must be in ImageLayout::SHADER_READ and is left there
+    std::vector<unsigned char> readTexture(std::shared_ptr<Texture> texture);
+
+    // Fills every mip and layer from data laid out as readTexture returns it, leaving the texture
+    // in ImageLayout::SHADER_READ
+    void writeTexture(std::shared_ptr<Texture> texture, const unsigned char* data, size_t size);
+
     static std::unique_ptr<GraphicsContext> create(std::shared_ptr<Window> windowRef);
 
+    // Without a window or surface. The swapchain passes render to offscreen images of the given
+    // size, newFrame and present only pass the semaphores along. For tests and benchmarks
+    static std::unique_ptr<GraphicsContext> createHeadless(uint32_t width, uint32_t height);
+
 protected:
 private:
+    static std::unique_ptr<GraphicsContext> create(std::shared_ptr<Window> windowRef,
+                                                   VkExtent2D headlessExtent);
+
     uint32_t getCurrentFrameBasedIndex(int indexOffset = 0);
 
     void windowResize(int width, int height);
@@ -168,16 +417,121 @@ private:
 
     void initSwapchain();
 
+    void initHeadlessImages();
+
     void initSwapchainRenderPass();
 
+    void initDepthPyramid();
+
     void initUploadStructures();
 
     void initSamplers();
 
     ShaderModule loadShaderModule(const char* shaderFilePath);
 
+    ShaderModule createShaderModule(const char* shaderFilePath, std::vector<uint32_t>& spvBytes);
+
+    VkPipeline buildGraphicsPipeline(PipelineCreateInfo* pipelineCreateInfo,
+                                     ShaderModule& vertexShaderModule,
+                                     ShaderModule& fragmentShaderModule,
+                                     VkPipelineLayout pipelineLayout);
+
+    VkPipeline buildComputePipeline(ShaderModule& computeShaderModule,
+                                    VkPipelineLayout pipelineLayout);
+
+    std::shared_ptr<DescriptorSet>
+    allocateDescriptorSet(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+                          uint32_t setLayoutIndex, VkPipelineLayout pipelineLayout,
+                          VkPipelineBindPoint bindPoint);
+
+    // Layouts are shared between every pipeline with the same bindings and push constants, so sets
+    // allocated for a pipeline stay usable with its rebuilds and other pipelines of that layout
+    VkDescriptorSetLayout
+    getDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    VkPipelineLayout getPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+                                       std::vector<VkPushConstantRange>& pushConstants);
+
     void immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function);
 
+    struct TextureUpload {
+        VkBuffer stagingBuffer;
+        VmaAllocation stagingAllocation;
+        std::vector<VkBufferImageCopy> copyRegions;
+        // Blits the rest of the mips from the first, otherwise every mip has a copy region
+        bool generateMips;
+        std::shared_ptr<Texture> texture;
+    };
+
+    struct PendingTextureUpload {
+        TextureUpload upload;
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        std::function<void(std::shared_ptr<Texture>)> onUploaded;
+    };
+
+    // Creates the image and fills the staging buffer, the copy is left for recordTextureUpload
+    TextureUpload prepareTextureUpload(int width, int height, int numComponents,
+                                       ColorSpace colorSpace, unsigned char* data, bool genMipmaps);
+
+    // data holds the full size mip in imageFormat
+    TextureUpload prepareTextureUpload(VkFormat imageFormat, int width, int height,
+                                       const void* data, VkDeviceSize imageSize, bool genMipmaps);
+
+    // The texture is null when the image can't be created, nothing is left to free then
+    TextureUpload
+    prepareCompressedTextureUpload(Format format, uint32_t width, uint32_t height,
+                                   const std::vector<std::vector<unsigned char>>& mips,
+                                   uint32_t firstMip = 0);
+
+    // Copies the staging buffer in, generates the mips and leaves the image ready to sample
+    void recordTextureUpload(VkCommandBuffer cmd, const TextureUpload& upload);
+
+    // Records and submits the upload without waiting for it, see pollTextureUploads
+    void submitTextureUpload(const TextureUpload& upload,
+                             std::function<void(std::shared_ptr<Texture>)> onUploaded);
+
+    void writeSharedBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+                           std::shared_ptr<DescriptorSet> sourceDescriptorSet,
+                           uint32_t sourceBinding, DescriptorType type, int frameOffset,
+                           int frameIndex = -1);
+
+    void createDescriptorBuffer(DescriptorType type, uint32_t bufferSize, VkBuffer& buffer,
+                                VmaAllocation& allocation);
+
+    // Points the set of the frame at the buffer it owns at the binding
+    void writeDescriptorBuffer(std::shared_ptr<DescriptorSet> descriptorSet, uint32_t binding,
+                               DescriptorType type, uint32_t frameIndex, uint32_t bufferSize);
+
+    // A binding that grew. Holds the replacements of the frames that didn't start since, null
+    // once swapped in
+    struct PendingBufferGrowth {
+        std::weak_ptr<DescriptorSet> descriptorSet;
+        uint32_t binding;
+        DescriptorType type;
+        uint32_t preserveSize;
+        std::array<VkBuffer, FRAME_OVERLAP> buffers;
+        std::array<VmaAllocation, FRAME_OVERLAP> allocations;
+    };
+
+    // A buffer replaced by a growth, sets of frames still in flight may use it
+    struct RetiredBuffer {
+        VkBuffer buffer;
+        VmaAllocation allocation;
+        uint32_t frame;
+    };
+
+    // Swaps in the replacement of the frame if it has one and rebinds that frame's sharing sets
+    void applyBufferGrowth(PendingBufferGrowth& growth, uint32_t frameIndex);
+
+    // At the start of a frame, its fence has been waited on
+    void applyBufferGrowths();
+
+    void recordSecondary(
+        std::shared_ptr<FrameBasedSecondaryCommandBuffers> secondaryCommandBuffers,
+        VkRenderPass renderPass, VkFramebuffer framebuffer, uint32_t itemCount,
+        std::function<void(std::shared_ptr<CommandBuffer>, uint32_t, uint32_t)>& record);
+
     std::shared_ptr<Window> windowRef;
 
     uint32_t numFrames;
@@ -199,8 +553,14 @@ private:
     VkFence uploadFence;
     VkCommandPool uploadCommandPool;
 
+    VkCommandPool asyncUploadCommandPool;
+    std::vector<PendingTextureUpload> pendingTextureUploads;
+
     VkDescriptorPool globalDescriptorPool;
 
+    std::vector<PendingBufferGrowth> pendingBufferGrowths;
+    std::vector<RetiredBuffer> retiredBuffers;
+
     VmaAllocator allocator;
 
     VkSurfaceKHR surface;
@@ -212,11 +572,43 @@ private:
     AllocatedImage depthImage;
     VkImageView depthImageView;
     VkRenderPass swapchainRenderPass;
+    VkRenderPass swapchainLoadRenderPass;
     std::vector<VkFramebuffer> swapchainFramebuffers;
     VkExtent2D currentSwapchainExtent;
     bool swapchainResized = false;
 
+    // Stand in for the swapchain images of a headless context, see initHeadlessImages
+    VkExtent2D headlessExtent;
+    std::vector<AllocatedImage> headlessImages;
+
+    std::shared_ptr<Texture> depthPyramid;
+    std::shared_ptr<ComputePipeline> depthPyramidPipeline;
+    // One per level, only ever grows since the descriptor pool can't free sets
+    std::vector<std::shared_ptr<DescriptorSet>> depthPyramidDescriptorSets;
+
     VkSampler mainSampler;
+    VkSampler nearestSampler;
+
+    // From VK_KHR_draw_indirect_count or core Vulkan 1.2, null when the device has neither
+    PFN_vkCmdDrawIndirectCountKHR drawIndirectCountFunction;
+
+    bool textureCompressionBC;
+
+    std::map<std::vector<uint32_t>, VkDescriptorSetLayout> descriptorSetLayoutCache;
+    std::map<std::vector<uint64_t>, VkPipelineLayout> pipelineLayoutCache;
+
+    ShaderCompileOptions shaderCompileOptions;
+
+    std::unique_ptr<ShaderWatcher> shaderWatcher;
+    std::vector<std::weak_ptr<Pipeline>> hotReloadPipelines;
+    std::vector<std::weak_ptr<ComputePipeline>> hotReloadComputePipelines;
+    std::map<std::string, std::vector<uint32_t>> shaderSpvCache;
+
+    JobSystem* jobSystem = nullptr;
+
+    HandlePool<Pipeline> pipelineHandles;
+    HandlePool<DescriptorSet> descriptorSetHandles;
+    HandlePool<VertexBuffer> vertexBufferHandles;
 
     friend class Window;
 };
@@ -0,0 +1,31 @@
+#include "../../pch.hpp"
+#include "Batching.hpp"
+
+#include "Sorting.hpp"
+
+uint64_t helper::drawBatchKey(const CullObject& object) {
+    return ((uint64_t)object.materialIndex << 32) | (uint64_t)object.meshIndex;
+}
+
+void helper::buildDrawBatches(const std::vector<CullObject>& objects,
+                              const std::vector<uint32_t>& visibleIndices,
+                              std::vector<uint32_t>& sortedObjects,
+                              std::vector<DrawBatch>& batches, std::vector<uint64_t>& keys,
+                              std::vector<uint64_t>& keyScratch,
+                              std::vector<uint32_t>& objectScratch) {
+    keys.clear();
+    for (uint32_t objectIndex : visibleIndices) {
+        keys.push_back(drawBatchKey(objects[objectIndex]));
+    }
+    sortedObjects = visibleIndices;
+    radixSort(keys, sortedObjects, keyScratch, objectScratch);
+
+    batches.clear();
+    for (uint32_t i = 0; i < (uint32_t)sortedObjects.size(); i++) {
+        if (i == 0 || keys[i] != keys[i - 1]) {
+            const CullObject& object = objects[sortedObjects[i]];
+            batches.push_back({ object.meshIndex, object.materialIndex, i, 0 });
+        }
+        batches.back().instanceCount++;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "../../pch.hpp"
+
+#include "Culling.hpp"
+
+// Objects of one mesh and material, stored next to each other in the object buffer
+struct DrawBatch {
+    uint32_t meshIndex;
+    uint32_t materialIndex;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+namespace helper {
+    // Material in the upper and mesh in the lower half, so sorting by it changes the material as
+    // rarely as possible
+    uint64_t drawBatchKey(const CullObject& object);
+
+    // Orders the objects at visibleIndices by drawBatchKey into sortedObjects and groups each run
+    // of equal keys into a batch, whose firstInstance indexes sortedObjects. The sort is stable,
+    // so objects keep their order within a batch. The other vectors are scratch kept between calls
+    void buildDrawBatches(const std::vector<CullObject>& objects,
+                          const std::vector<uint32_t>& visibleIndices,
+                          std::vector<uint32_t>& sortedObjects, std::vector<DrawBatch>& batches,
+                          std::vector<uint64_t>& keys, std::vector<uint64_t>& keyScratch,
+                          std::vector<uint32_t>& objectScratch);
+} // namespace helper
@@ -0,0 +1,689 @@
+#include "../../pch.hpp"
+#include "BlockCompression.hpp"
+
+// Interpolation weights out of 64 of the 4 bit index modes of BC6H and BC7
+constexpr int BC_INDEX_WEIGHTS[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                        34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Largest finite half float as bits, the most BC6H_UFLOAT can hold
+constexpr int BC6H_MAX_HALF = 0x7bff;
+
+// BC6H and BC7 lay out their fields least significant bit first
+struct BlockBitWriter {
+    unsigned char* block;
+    uint32_t position;
+
+    void write(uint32_t value, uint32_t bitCount) {
+        for (uint32_t i = 0; i < bitCount; i++, position++) {
+            block[position / 8] |= ((value >> i) & 1) << (position % 8);
+        }
+    }
+};
+
+struct BlockBitReader {
+    const unsigned char* block;
+    uint32_t position;
+
+    uint32_t read(uint32_t bitCount) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bitCount; i++, position++) {
+            value |= ((block[position / 8] >> (position % 8)) & 1) << i;
+        }
+
+        return value;
+    }
+};
+
+// Endpoints at the extremes of the texels along the axis they vary the most on, found by power
+// iteration on their covariance
+template <int C>
+void principalAxisEndpoints(const float texels[16][C], float endpoint0[C], float endpoint1[C]) {
+    float mean[C] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < C; c++) {
+            mean[c] += texels[i][c] / 16.0f;
+        }
+    }
+
+    float covariance[C][C] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int a = 0; a < C; a++) {
+            for (int b = 0; b < C; b++) {
+                covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // Starting from the row of the widest channel keeps the start off the axes orthogonal to it
+    int widest = 0;
+    for (int c = 1; c < C; c++) {
+        if (covariance[c][c] > covariance[widest][widest]) {
+            widest = c;
+        }
+    }
+
+    float axis[C];
+    for (int c = 0; c < C; c++) {
+        axis[c] = covariance[widest][c];
+    }
+
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[C] = {};
+        float largest = 0.0f;
+        for (int a = 0; a < C; a++) {
+            for (int b = 0; b < C; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            largest = std::max(largest, std::abs(next[a]));
+        }
+
+        if (largest == 0.0f) {
+            break;
+        }
+        for (int c = 0; c < C; c++) {
+            axis[c] = next[c] / largest;
+        }
+    }
+
+    float axisLengthSquared = 0.0f;
+    for (int c = 0; c < C; c++) {
+        axisLengthSquared += axis[c] * axis[c];
+    }
+
+    // Every texel the same
+    if (axisLengthSquared == 0.0f) {
+        for (int c = 0; c < C; c++) {
+            endpoint0[c] = mean[c];
+            endpoint1[c] = mean[c];
+        }
+        return;
+    }
+
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        float projection = 0.0f;
+        for (int c = 0; c < C; c++) {
+            projection += (texels[i][c] - mean[c]) * axis[c];
+        }
+        minimum = std::min(minimum, projection / axisLengthSquared);
+        maximum = std::max(maximum, projection / axisLengthSquared);
+    }
+
+    for (int c = 0; c < C; c++) {
+        endpoint0[c] = mean[c] + axis[c] * minimum;
+        endpoint1[c] = mean[c] + axis[c] * maximum;
+    }
+}
+
+// The endpoints with the least squared error for fixed positions between them, 0 being endpoint0.
+// Returns false when every texel sits at the same position and there's no single answer
+template <int C>
+bool leastSquaresEndpoints(const float texels[16][C], const float positions[16],
+                           float endpoint0[C], float endpoint1[C]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[C] = {};
+    float bx[C] = {};
+    for (int i = 0; i < 16; i++) {
+        float a = 1.0f - positions[i];
+        float b = positions[i];
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < C; c++) {
+            ax[c] += a * texels[i][c];
+            bx[c] += b * texels[i][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+
+    for (int c = 0; c < C; c++) {
+        endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+        endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+    }
+
+    return true;
+}
+
+// Picks the closest palette entry for every texel, returns the summed squared error
+template <int C>
+float selectIndices(const float texels[16][C], const float palette[][C], int paletteSize,
+                    int indices[16]) {
+    float totalError = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float bestError = FLT_MAX;
+        for (int entry = 0; entry < paletteSize; entry++) {
+            float error = 0.0f;
+            for (int c = 0; c < C; c++) {
+                float difference = texels[i][c] - palette[entry][c];
+                error += difference * difference;
+            }
+
+            if (error < bestError) {
+                bestError  = error;
+                indices[i] = entry;
+            }
+        }
+        totalError += bestError;
+    }
+
+    return totalError;
+}
+
+int interpolateBC(int endpoint0, int endpoint1, int weight) {
+    return ((64 - weight) * endpoint0 + weight * endpoint1 + 32) >> 6;
+}
+
+uint16_t packRGB565(const float color[3]) {
+    int r = std::clamp((int)std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+    int g = std::clamp((int)std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+    int b = std::clamp((int)std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void unpackRGB565(uint16_t packed, int color[3]) {
+    int r    = (packed >> 11) & 31;
+    int g    = (packed >> 5) & 63;
+    int b    = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Four entries when color0 is the larger, three and transparent black otherwise
+void paletteBC1(uint16_t color0, uint16_t color1, int palette[4][4]) {
+    int endpoint0[3], endpoint1[3];
+    unpackRGB565(color0, endpoint0);
+    unpackRGB565(color1, endpoint1);
+
+    for (int c = 0; c < 3; c++) {
+        palette[0][c] = endpoint0[c];
+        palette[1][c] = endpoint1[c];
+        if (color0 > color1) {
+            palette[2][c] = (2 * endpoint0[c] + endpoint1[c] + 1) / 3;
+            palette[3][c] = (endpoint0[c] + 2 * endpoint1[c] + 1) / 3;
+        } else {
+            palette[2][c] = (endpoint0[c] + endpoint1[c] + 1) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = 255;
+    palette[1][3] = 255;
+    palette[2][3] = 255;
+    palette[3][3] = (color0 > color1) ? 255 : 0;
+}
+
+// Eight entries when value0 is the larger, six and the extremes otherwise
+void paletteBC4(int value0, int value1, int palette[8]) {
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1) {
+        for (int i = 2; i < 8; i++) {
+            palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+        }
+    } else {
+        for (int i = 2; i < 6; i++) {
+            palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// The 7 bit endpoint and shared bit whose 8 bit value is closest
+void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pBit) {
+    float bestError = FLT_MAX;
+    for (int bit = 0; bit < 2; bit++) {
+        int candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            candidate[c]     = std::clamp((int)std::lround((endpoint[c] - bit) / 2.0f), 0, 127);
+            float difference = (float)((candidate[c] << 1) | bit) - endpoint[c];
+            error += difference * difference;
+        }
+
+        if (error < bestError) {
+            bestError = error;
+            pBit      = bit;
+            for (int c = 0; c < 4; c++) {
+                quantized[c] = candidate[c];
+            }
+        }
+    }
+}
+
+// Endpoint as BC6H_UFLOAT expands it before interpolating
+int unquantizeBC6H(int quantized) {
+    if (quantized == 0) {
+        return 0;
+    }
+    if (quantized == 1023) {
+        return 0xffff;
+    }
+
+    return ((quantized << 16) + 0x8000) >> 10;
+}
+
+// Interpolated value back to half float bits
+int finishBC6H(int unquantized) { return (unquantized * 31) >> 6; }
+
+// The 10 bit endpoint that comes out closest to the half float bits
+int quantizeBC6H(float half) {
+    int estimate  = std::clamp((int)std::lround((half - 15.0f) / 31.0f), 0, 1023);
+    int best      = estimate;
+    float closest = FLT_MAX;
+    for (int candidate = std::max(estimate - 1, 0); candidate <= std::min(estimate + 1, 1023);
+         candidate++) {
+        float difference = std::abs((float)finishBC6H(unquantizeBC6H(candidate)) - half);
+        if (difference < closest) {
+            closest = difference;
+            best    = candidate;
+        }
+    }
+
+    return best;
+}
+
+void helper::encodeBC1(const unsigned char texels[16][4], unsigned char* block) {
+    float values[16][3];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            values[i][c] = texels[i][c];
+        }
+    }
+
+    float endpoint0[3], endpoint1[3];
+    principalAxisEndpoints<3>(values, endpoint0, endpoint1);
+
+    // Positions of the four colour palette entries between the endpoints
+    const float entryPositions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    uint16_t bestColor0 = 0, bestColor1 = 0;
+    int bestIndices[16] = {};
+    float bestError     = FLT_MAX;
+    for (int iteration = 0; iteration < 2; iteration++) {
+        // The larger colour first selects the four colour mode
+        uint16_t color0 = packRGB565(endpoint1);
+        uint16_t color1 = packRGB565(endpoint0);
+        if (color0 < color1) {
+            std::swap(color0, color1);
+        }
+
+        int palette[4][4];
+        paletteBC1(color0, color1, palette);
+        float floatPalette[4][3];
+        for (int entry = 0; entry < 4; entry++) {
+            for (int c = 0; c < 3; c++) {
+                floatPalette[entry][c] = (float)palette[entry][c];
+            }
+        }
+
+        // Equal colours select the three colour mode, where the last entry is black
+        int indices[16];
+        float error = selectIndices<3>(values, floatPalette, (color0 == color1) ? 1 : 4, indices);
+        if (error < bestError) {
+            bestError  = error;
+            bestColor0 = color0;
+            bestColor1 = color1;
+            std::copy(indices, indices + 16, bestIndices);
+        }
+
+        float positions[16];
+        for (int i = 0; i < 16; i++) {
+            positions[i] = entryPositions[indices[i]];
+        }
+        if (color0 == color1 ||
+            !leastSquaresEndpoints<3>(values, positions, endpoint0, endpoint1)) {
+            break;
+        }
+        // endpoint0 is color0's side of the line from here on
+        std::swap(endpoint0, endpoint1);
+    }
+
+    uint32_t packedIndices = 0;
+    for (int i = 0; i < 16; i++) {
+        packedIndices |= (uint32_t)bestIndices[i] << (i * 2);
+    }
+
+    block[0] = bestColor0 & 0xff;
+    block[1] = bestColor0 >> 8;
+    block[2] = bestColor1 & 0xff;
+    block[3] = bestColor1 >> 8;
+    for (int i = 0; i < 4; i++) {
+        block[4 + i] = (packedIndices >> (i * 8)) & 0xff;
+    }
+}
+
+void helper::encodeBC4(const unsigned char texels[16][4], unsigned char* block, int channel) {
+    int minimum = 255;
+    int maximum = 0;
+    for (int i = 0; i < 16; i++) {
+        minimum = std::min(minimum, (int)texels[i][channel]);
+        maximum = std::max(maximum, (int)texels[i][channel]);
+    }
+
+    // The larger value first selects the eight value mode
+    int palette[8];
+    paletteBC4(maximum, minimum, palette);
+
+    uint64_t packedIndices = 0;
+    for (int i = 0; i < 16; i++) {
+        int bestIndex = 0;
+        int bestError = INT_MAX;
+        for (int entry = 0; entry < ((maximum == minimum) ? 1 : 8); entry++) {
+            int error = std::abs(palette[entry] - texels[i][channel]);
+            if (error < bestError) {
+                bestError = error;
+                bestIndex = entry;
+            }
+        }
+        packedIndices |= (uint64_t)bestIndex << (i * 3);
+    }
+
+    block[0] = (unsigned char)maximum;
+    block[1] = (unsigned char)minimum;
+    for (int i = 0; i < 6; i++) {
+        block[2 + i] = (packedIndices >> (i * 8)) & 0xff;
+    }
+}
+
+void helper::encodeBC5(const unsigned char texels[16][4], unsigned char* block) {
+    encodeBC4(texels, block, 0);
+    encodeBC4(texels, block + 8, 1);
+}
+
+void helper::encodeBC7(const unsigned char texels[16][4], unsigned char* block) {
+    float values[16][4];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++) {
+            values[i][c] = texels[i][c];
+        }
+    }
+
+    float endpoint0[4], endpoint1[4];
+    principalAxisEndpoints<4>(values, endpoint0, endpoint1);
+
+    int bestQuantized[2][4] = {};
+    int bestPBits[2]        = {};
+    int bestIndices[16]     = {};
+    float bestError         = FLT_MAX;
+    for (int iteration = 0; iteration < 2; iteration++) {
+        int quantized[2][4];
+        int pBits[2];
+        quantizeBC7Endpoint(endpoint0, quantized[0], pBits[0]);
+        quantizeBC7Endpoint(endpoint1, quantized[1], pBits[1]);
+
+        float palette[16][4];
+        for (int entry = 0; entry < 16; entry++) {
+            for (int c = 0; c < 4; c++) {
+                palette[entry][c] = (float)interpolateBC((quantized[0][c] << 1) | pBits[0],
+                                                         (quantized[1][c] << 1) | pBits[1],
+                                                         BC_INDEX_WEIGHTS[entry]);
+            }
+        }
+
+        int indices[16];
+        float error = selectIndices<4>(values, palette, 16, indices);
+        if (error < bestError) {
+            bestError = error;
+            std::copy(&quantized[0][0], &quantized[0][0] + 8, &bestQuantized[0][0]);
+            std::copy(pBits, pBits + 2, bestPBits);
+            std::copy(indices, indices + 16, bestIndices);
+        }
+
+        float positions[16];
+        for (int i = 0; i < 16; i++) {
+            positions[i] = BC_INDEX_WEIGHTS[indices[i]] / 64.0f;
+        }
+        if (!leastSquaresEndpoints<4>(values, positions, endpoint0, endpoint1)) {
+            break;
+        }
+    }
+
+    // The first index is stored without its top bit, so it has to be in the lower half
+    if (bestIndices[0] >= 8) {
+        std::swap(bestQuantized[0], bestQuantized[1]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (int i = 0; i < 16; i++) {
+            bestIndices[i] = 15 - bestIndices[i];
+        }
+    }
+
+    std::fill(block, block + 16, 0);
+    BlockBitWriter writer = { block, 0 };
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        writer.write(bestQuantized[0][c], 7);
+        writer.write(bestQuantized[1][c], 7);
+    }
+    writer.write(bestPBits[0], 1);
+    writer.write(bestPBits[1], 1);
+    writer.write(bestIndices[0], 3);
+    for (int i = 1; i < 16; i++) {
+        writer.write(bestIndices[i], 4);
+    }
+}
+
+void helper::encodeBC6H(const uint16_t texels[16][3], unsigned char* block) {
+    // Interpolation happens on the half float bits, so that's the space the fit happens in too
+    float values[16][3];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            uint16_t half = texels[i][c];
+            values[i][c]  = (half & 0x8000) ? 0.0f : (float)std::min((int)half, BC6H_MAX_HALF);
+        }
+    }
+
+    float endpoint0[3], endpoint1[3];
+    principalAxisEndpoints<3>(values, endpoint0, endpoint1);
+
+    int bestQuantized[2][3] = {};
+    int bestIndices[16]     = {};
+    float bestError         = FLT_MAX;
+    for (int iteration = 0; iteration < 2; iteration++) {
+        int quantized[2][3];
+        for (int c = 0; c < 3; c++) {
+            quantized[0][c] = quantizeBC6H(endpoint0[c]);
+            quantized[1][c] = quantizeBC6H(endpoint1[c]);
+        }
+
+        float palette[16][3];
+        for (int entry = 0; entry < 16; entry++) {
+            for (int c = 0; c < 3; c++) {
+                palette[entry][c] = (float)finishBC6H(
+                    interpolateBC(unquantizeBC6H(quantized[0][c]), unquantizeBC6H(quantized[1][c]),
+                                  BC_INDEX_WEIGHTS[entry]));
+            }
+        }
+
+        int indices[16];
+        float error = selectIndices<3>(values, palette, 16, indices);
+        if (error < bestError) {
+            bestError = error;
+            std::copy(&quantized[0][0], &quantized[0][0] + 6, &bestQuantized[0][0]);
+            std::copy(indices, indices + 16, bestIndices);
+        }
+
+        float positions[16];
+        for (int i = 0; i < 16; i++) {
+            positions[i] = BC_INDEX_WEIGHTS[indices[i]] / 64.0f;
+        }
+        if (!leastSquaresEndpoints<3>(values, positions, endpoint0, endpoint1)) {
+            break;
+        }
+    }
+
+    if (bestIndices[0] >= 8) {
+        std::swap(bestQuantized[0], bestQuantized[1]);
+        for (int i = 0; i < 16; i++) {
+            bestIndices[i] = 15 - bestIndices[i];
+        }
+    }
+
+    std::fill(block, block + 16, 0);
+    BlockBitWriter writer = { block, 0 };
+    writer.write(0x03, 5);
+    for (int endpoint = 0; endpoint < 2; endpoint++) {
+        for (int c = 0; c < 3; c++) {
+            writer.write(bestQuantized[endpoint][c], 10);
+        }
+    }
+    writer.write(bestIndices[0], 3);
+    for (int i = 1; i < 16; i++) {
+        writer.write(bestIndices[i], 4);
+    }
+}
+
+void helper::decodeBC1(const unsigned char* block, unsigned char texels[16][4]) {
+    uint16_t color0 = block[0] | (block[1] << 8);
+    uint16_t color1 = block[2] | (block[3] << 8);
+
+    int palette[4][4];
+    paletteBC1(color0, color1, palette);
+
+    for (int i = 0; i < 16; i++) {
+        int index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+        for (int c = 0; c < 4; c++) {
+            texels[i][c] = (unsigned char)palette[index][c];
+        }
+    }
+}
+
+void helper::decodeBC4(const unsigned char* block, unsigned char texels[16][4], int channel) {
+    int palette[8];
+    paletteBC4(block[0], block[1], palette);
+
+    uint64_t packedIndices = 0;
+    for (int i = 0; i < 6; i++) {
+        packedIndices |= (uint64_t)block[2 + i] << (i * 8);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        texels[i][channel] = (unsigned char)palette[(packedIndices >> (i * 3)) & 7];
+    }
+}
+
+void helper::decodeBC5(const unsigned char* block, unsigned char texels[16][4]) {
+    decodeBC4(block, texels, 0);
+    decodeBC4(block + 8, texels, 1);
+}
+
+void helper::decodeBC7(const unsigned char* block, unsigned char texels[16][4]) {
+    BlockBitReader reader = { block, 0 };
+    if (reader.read(7) != (1 << 6)) {
+        std::fill(&texels[0][0], &texels[0][0] + 64, 0);
+        return;
+    }
+
+    int endpoints[2][4];
+    for (int c = 0; c < 4; c++) {
+        endpoints[0][c] = reader.read(7) << 1;
+        endpoints[1][c] = reader.read(7) << 1;
+    }
+    int pBit0 = reader.read(1);
+    int pBit1 = reader.read(1);
+    for (int c = 0; c < 4; c++) {
+        endpoints[0][c] |= pBit0;
+        endpoints[1][c] |= pBit1;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        int index = reader.read((i == 0) ? 3 : 4);
+        for (int c = 0; c < 4; c++) {
+            texels[i][c] = (unsigned char)interpolateBC(endpoints[0][c], endpoints[1][c],
+                                                        BC_INDEX_WEIGHTS[index]);
+        }
+    }
+}
+
+void helper::decodeBC6H(const unsigned char* block, uint16_t texels[16][3]) {
+    BlockBitReader reader = { block, 0 };
+    if (reader.read(5) != 0x03) {
+        std::fill(&texels[0][0], &texels[0][0] + 48, 0);
+        return;
+    }
+
+    int endpoints[2][3];
+    for (int endpoint = 0; endpoint < 2; endpoint++) {
+        for (int c = 0; c < 3; c++) {
+            endpoints[endpoint][c] = unquantizeBC6H(reader.read(10));
+        }
+    }
+
+    for (int i = 0; i < 16; i++) {
+        int index = reader.read((i == 0) ? 3 : 4);
+        for (int c = 0; c < 3; c++) {
+            texels[i][c] = (uint16_t)finishBC6H(
+                interpolateBC(endpoints[0][c], endpoints[1][c], BC_INDEX_WEIGHTS[index]));
+        }
+    }
+}
+
+uint32_t helper::decodedTexelBytes(Format format) {
+    return (format == Format::BC6H_UFLOAT) ? 4 * sizeof(uint16_t) : 4;
+}
+
+std::vector<unsigned char> helper::decodeBlocks(Format format, uint32_t width, uint32_t height,
+                                                const std::vector<unsigned char>& blocks) {
+    uint32_t texelBytes = decodedTexelBytes(format);
+    uint32_t blockBytes = (format == Format::BC1_UNORM || format == Format::BC1_SRGB ||
+                           format == Format::BC4_UNORM)
+                              ? 8
+                              : 16;
+    uint32_t blocksWide = (width + 3) / 4;
+    uint32_t blocksHigh = (height + 3) / 4;
+
+    std::vector<unsigned char> image((size_t)width * height * texelBytes);
+    for (uint32_t blockY = 0; blockY < blocksHigh; blockY++) {
+        for (uint32_t blockX = 0; blockX < blocksWide; blockX++) {
+            const unsigned char* block =
+                &blocks[((size_t)blockY * blocksWide + blockX) * blockBytes];
+
+            // As RGBA8, or as the halves of RGBA16F
+            unsigned char texels[16][8];
+            if (format == Format::BC6H_UFLOAT) {
+                uint16_t rgb[16][3];
+                decodeBC6H(block, rgb);
+                for (int i = 0; i < 16; i++) {
+                    uint16_t rgba[4] = { rgb[i][0], rgb[i][1], rgb[i][2], 0x3c00 };
+                    memcpy(texels[i], rgba, sizeof(rgba));
+                }
+            } else {
+                unsigned char rgba[16][4];
+                for (int i = 0; i < 16; i++) {
+                    rgba[i][0] = rgba[i][1] = rgba[i][2] = 0;
+                    rgba[i][3]                           = 255;
+                }
+
+                if (format == Format::BC1_UNORM || format == Format::BC1_SRGB) {
+                    decodeBC1(block, rgba);
+                } else if (format == Format::BC4_UNORM) {
+                    decodeBC4(block, rgba);
+                } else if (format == Format::BC5_UNORM) {
+                    decodeBC5(block, rgba);
+                } else {
+                    decodeBC7(block, rgba);
+                }
+                for (int i = 0; i < 16; i++) {
+                    memcpy(texels[i], rgba[i], 4);
+                }
+            }
+
+            // Blocks past the edge of the mip are padding
+            for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++) {
+                for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++) {
+                    size_t texel = (size_t)(blockY * 4 + y) * width + blockX * 4 + x;
+                    memcpy(&image[texel * texelBytes], texels[y * 4 + x], texelBytes);
+                }
+            }
+        }
+    }
+
+    return image;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "../../pch.hpp"
+
+#include "../Types/Renderpass.hpp"
+
+// Every function works on one 4x4 block, its texels in row order. The encoders fit the texels with
+// a single pair of endpoints, the principal axis of the texels refined by least squares, so BC7
+// and BC6H only use their one subset modes
+namespace helper {
+    // 8 bytes, four colour mode, alpha is dropped
+    void encodeBC1(const unsigned char texels[16][4], unsigned char* block);
+
+    // 8 bytes from one channel of the texels
+    void encodeBC4(const unsigned char texels[16][4], unsigned char* block, int channel = 0);
+
+    // 16 bytes, red then green as two BC4 blocks
+    void encodeBC5(const unsigned char texels[16][4], unsigned char* block);
+
+    // 16 bytes, mode 6: RGBA endpoints of 7 bits and a shared bit each, 16 weights
+    void encodeBC7(const unsigned char texels[16][4], unsigned char* block);
+
+    // 16 bytes from the half float bits of RGB, mode 11: unsigned 10 bit endpoints, 16 weights.
+    // Negative values become zero and infinities the largest half
+    void encodeBC6H(const uint16_t texels[16][3], unsigned char* block);
+
+    // Inverses of the encoders for measuring their error. BC7 and BC6H only decode the modes
+    // written above, other blocks come out black
+    void decodeBC1(const unsigned char* block, unsigned char texels[16][4]);
+
+    void decodeBC4(const unsigned char* block, unsigned char texels[16][4], int channel = 0);
+
+    void decodeBC5(const unsigned char* block, unsigned char texels[16][4]);
+
+    void decodeBC7(const unsigned char* block, unsigned char texels[16][4]);
+
+    void decodeBC6H(const unsigned char* block, uint16_t texels[16][3]);
+
+    // Bytes of a texel decodeBlocks writes, four halves for BC6H and four bytes otherwise
+    uint32_t decodedTexelBytes(Format format);
+
+    // Every block of a width by height mip to RGBA8, or to RGBA16F for BC6H, for devices that
+    // can't sample the format. Channels the format lacks are zero and alpha is opaque
+    std::vector<unsigned char> decodeBlocks(Format format, uint32_t width, uint32_t height,
+                                            const std::vector<unsigned char>& blocks);
+} // namespace helper
@@ -54,6 +54,9 @@ VkImageLayout helper::getVkImageLayout(ImageLayout imageLayout, bool isDepthImag
     case ImageLayout::TRANSFER_DST:
         return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         break;
+    case ImageLayout::GENERAL:
+        return VK_IMAGE_LAYOUT_GENERAL;
+        break;
     }
 
     return VK_IMAGE_LAYOUT_UNDEFINED;
@@ -89,6 +92,9 @@ VkAccessFlagBits helper::getVkAccessFlags(ImageLayout imageLayout, AccessType ac
     case ImageLayout::TRANSFER_DST:
         return VK_ACCESS_TRANSFER_WRITE_BIT;
         break;
+    case ImageLayout::GENERAL:
+        return VK_ACCESS_SHADER_WRITE_BIT;
+        break;
     }
 
     return VK_ACCESS_FLAG_BITS_MAX_ENUM;
@@ -510,18 +516,69 @@ VkFormat helper::getVkFormat(Format format) {
         return VK_FORMAT_R32G32B32A32_SFLOAT;
         break;
     }
+    case Format::B10G11R11_UFLOAT: {
+        return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+        break;
+    }
+    case Format::BC1_UNORM: {
+        return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        break;
+    }
+    case Format::BC1_SRGB: {
+        return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        break;
+    }
+    case Format::BC4_UNORM: {
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+        break;
+    }
+    case Format::BC5_UNORM: {
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+        break;
+    }
+    case Format::BC6H_UFLOAT: {
+        return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        break;
+    }
+    case Format::BC7_UNORM: {
+        return VK_FORMAT_BC7_UNORM_BLOCK;
+        break;
+    }
+    case Format::BC7_SRGB: {
+        return VK_FORMAT_BC7_SRGB_BLOCK;
+        break;
+    }
     }
 
     return VK_FORMAT_UNDEFINED;
 }
 
+VkFormat helper::getDecodedVkFormat(Format format) {
+    switch (format) {
+    case Format::BC1_SRGB:
+    case Format::BC7_SRGB: {
+        return VK_FORMAT_R8G8B8A8_SRGB;
+        break;
+    }
+    case Format::BC6H_UFLOAT: {
+        return VK_FORMAT_R16G16B16A16_SFLOAT;
+        break;
+    }
+    default: {
+        return VK_FORMAT_R8G8B8A8_UNORM;
+        break;
+    }
+    }
+}
+
 VkDescriptorType helper::getVkDescriptorType(DescriptorType type) {
     switch (type) {
     case DescriptorType::UNIFORM_BUFFER: {
         return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         break;
     }
-    case DescriptorType::STORAGE_BUFFER: {
+    case DescriptorType::STORAGE_BUFFER:
+    case DescriptorType::INDIRECT_BUFFER: {
         return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         break;
     }
@@ -18,5 +18,8 @@ namespace helper {
 
     VkFormat getVkFormat(Format format);
 
+    // What decodeBlocks turns a block compressed format into
+    VkFormat getDecodedVkFormat(Format format);
+
     VkDescriptorType getVkDescriptorType(DescriptorType type);
 } // namespace helper
@@ -0,0 +1,265 @@
+#include "../../pch.hpp"
+#include "Culling.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CULLING_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 in functions marked for it, MSVC takes the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CULLING_TARGET_AVX2
+#endif
+
+// The largest axis scale keeps the sphere conservative under non uniform scaling
+glm::vec4 worldSphere(const glm::mat4& model, glm::vec4 boundingSphere) {
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(boundingSphere), 1.0f));
+    float scale      = std::max(std::max(glm::length(glm::vec3(model[0])),
+                                         glm::length(glm::vec3(model[1]))),
+                                glm::length(glm::vec3(model[2])));
+
+    return glm::vec4(center, boundingSphere.w * scale);
+}
+
+std::array<glm::vec4, 6> helper::frustumPlanes(const glm::mat4& viewProjection) {
+    // Rows of the matrix, glm indexes columns first
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i],
+                            viewProjection[3][i]);
+    }
+
+    std::array<glm::vec4, 6> planes = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                                        rows[3] - rows[1], rows[2],           rows[3] - rows[2] };
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return planes;
+}
+
+glm::vec4 helper::boundingSphere(const std::vector<glm::vec3>& positions) {
+    if (positions.empty()) {
+        return glm::vec4(0.0f);
+    }
+
+    glm::vec3 minimum = positions[0];
+    glm::vec3 maximum = positions[0];
+    for (auto& position : positions) {
+        minimum = glm::min(minimum, position);
+        maximum = glm::max(maximum, position);
+    }
+
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius     = 0.0f;
+    for (auto& position : positions) {
+        radius = std::max(radius, glm::length(position - center));
+    }
+
+    return glm::vec4(center, radius);
+}
+
+bool helper::sphereInFrustum(const std::array<glm::vec4, 6>& planes, const glm::mat4& model,
+                             glm::vec4 boundingSphere) {
+    glm::vec4 sphere = worldSphere(model, boundingSphere);
+
+    for (auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+float helper::sphereScreenDiameter(const glm::mat4& model, glm::vec4 boundingSphere,
+                                   const glm::mat4& view, const glm::mat4& projection,
+                                   uint32_t viewportHeight) {
+    glm::vec4 sphere = worldSphere(model, boundingSphere);
+    // The camera looks down negative z
+    float distance = -(view * glm::vec4(glm::vec3(sphere), 1.0f)).z;
+    if (distance <= sphere.w) {
+        return (float)viewportHeight;
+    }
+
+    // Flipped for Vulkan's y axis, the scale is what matters
+    float focalScale = std::abs(projection[1][1]);
+
+    return std::min(sphere.w * focalScale * viewportHeight / distance, (float)viewportHeight);
+}
+
+void helper::worldSpheres(const std::vector<CullObject>& objects, uint32_t first, uint32_t count,
+                          CullSpheres& spheres) {
+    for (uint32_t i = first; i < first + count; i++) {
+        glm::vec4 sphere   = worldSphere(objects[i].model, objects[i].boundingSphere);
+        spheres.centerX[i] = sphere.x;
+        spheres.centerY[i] = sphere.y;
+        spheres.centerZ[i] = sphere.z;
+        spheres.radius[i]  = sphere.w;
+    }
+}
+
+#ifdef CULLING_X86
+bool cpuSupportsAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // The OS has to save the AVX registers too
+    __cpuid(info, 1);
+    bool osSavesAVX = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+    __cpuidex(info, 7, 0);
+    return osSavesAVX && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Each returns where it stopped, the rest is left for the narrower paths
+CULLING_TARGET_AVX2
+uint32_t cullSpheresAVX2(const CullSpheres& spheres, const std::array<glm::vec4, 6>& planes,
+                         uint32_t first, uint32_t end, std::vector<uint32_t>& visibleIndices) {
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++) {
+        planeX[p] = _mm256_set1_ps(planes[p].x);
+        planeY[p] = _mm256_set1_ps(planes[p].y);
+        planeZ[p] = _mm256_set1_ps(planes[p].z);
+        planeW[p] = _mm256_set1_ps(planes[p].w);
+    }
+
+    uint32_t i = first;
+    for (; i + 8 <= end; i += 8) {
+        __m256 centerX        = _mm256_loadu_ps(&spheres.centerX[i]);
+        __m256 centerY        = _mm256_loadu_ps(&spheres.centerY[i]);
+        __m256 centerZ        = _mm256_loadu_ps(&spheres.centerZ[i]);
+        __m256 radius         = _mm256_loadu_ps(&spheres.radius[i]);
+        __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+
+        // Same operation order as sphereInFrustum, so both agree on spheres touching a plane
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], centerX),
+                                            _mm256_mul_ps(planeY[p], centerY)),
+                              _mm256_mul_ps(planeZ[p], centerZ)),
+                planeW[p]);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1) {
+            if (mask & 1) {
+                visibleIndices.push_back(i + lane);
+            }
+        }
+    }
+
+    return i;
+}
+
+uint32_t cullSpheresSSE(const CullSpheres& spheres, const std::array<glm::vec4, 6>& planes,
+                        uint32_t first, uint32_t end, std::vector<uint32_t>& visibleIndices) {
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++) {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+    }
+
+    uint32_t i = first;
+    for (; i + 4 <= end; i += 4) {
+        __m128 centerX        = _mm_loadu_ps(&spheres.centerX[i]);
+        __m128 centerY        = _mm_loadu_ps(&spheres.centerY[i]);
+        __m128 centerZ        = _mm_loadu_ps(&spheres.centerZ[i]);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX),
+                                      _mm_mul_ps(planeY[p], centerY)),
+                           _mm_mul_ps(planeZ[p], centerZ)),
+                planeW[p]);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1) {
+            if (mask & 1) {
+                visibleIndices.push_back(i + lane);
+            }
+        }
+    }
+
+    return i;
+}
+#endif
+
+void helper::cullSpheres(const CullSpheres& spheres, const std::array<glm::vec4, 6>& planes,
+                         uint32_t first, uint32_t count, std::vector<uint32_t>& visibleIndices,
+                         CullInstructions widest) {
+    uint32_t end = first + count;
+    uint32_t i   = first;
+
+#ifdef CULLING_X86
+    CullInstructions instructions = std::min(widest, supportedCullInstructions());
+    if (instructions == CullInstructions::AVX2) {
+        i = cullSpheresAVX2(spheres, planes, i, end, visibleIndices);
+    }
+    if (instructions >= CullInstructions::SSE) {
+        i = cullSpheresSSE(spheres, planes, i, end, visibleIndices);
+    }
+#endif
+
+    for (; i < end; i++) {
+        glm::vec3 center = glm::vec3(spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i]);
+
+        bool inside = true;
+        for (auto& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -spheres.radius[i]) {
+                inside = false;
+                break;
+            }
+        }
+
+        if (inside) {
+            visibleIndices.push_back(i);
+        }
+    }
+}
+
+CullInstructions helper::supportedCullInstructions() {
+#ifdef CULLING_X86
+    static const bool supportsAVX2 = cpuSupportsAVX2();
+    return supportsAVX2 ? CullInstructions::AVX2 : CullInstructions::SSE;
+#else
+    return CullInstructions::SCALAR;
+#endif
+}
+
+std::vector<VkDrawIndirectCommand> helper::cullObjects(const std::vector<CullObject>& objects,
+                                                       const std::vector<CullMesh>& meshes,
+                                                       const std::array<glm::vec4, 6>& planes) {
+    std::vector<VkDrawIndirectCommand> draws;
+    for (uint32_t objectIndex = 0; objectIndex < objects.size(); objectIndex++) {
+        const CullObject& object = objects[objectIndex];
+        if (!sphereInFrustum(planes, object.model, object.boundingSphere)) {
+            continue;
+        }
+
+        const CullMesh& mesh = meshes[object.meshIndex];
+        draws.push_back({ mesh.vertexCount, 1, mesh.firstVertex, objectIndex });
+    }
+
+    return draws;
+}
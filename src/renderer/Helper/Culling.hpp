@@ -0,0 +1,69 @@
+#pragma once
+#include "../../pch.hpp"
+
+// Matches ObjectData in cull.comp and pbr.vert
+struct CullObject {
+    glm::mat4 model;
+    // Object space center in xyz and radius in w
+    glm::vec4 boundingSphere;
+    uint32_t meshIndex;
+    // Objects are only batched together with others of the same mesh and material
+    uint32_t materialIndex;
+    uint32_t padding[2];
+};
+
+// Where a mesh sits in the vertex buffer every culled object is drawn from
+struct CullMesh {
+    uint32_t vertexCount;
+    uint32_t firstVertex;
+};
+
+// World space bounding spheres as structure of arrays, so consecutive objects load straight into
+// SIMD lanes
+struct CullSpheres {
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+};
+
+// Instruction sets cullSpheres can test with, widest last
+enum class CullInstructions { SCALAR, SSE, AVX2 };
+
+namespace helper {
+    // Normalized and facing inwards, for projections with zero to one depth
+    std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& viewProjection);
+
+    // Not the tightest sphere, centered on the bounding box
+    glm::vec4 boundingSphere(const std::vector<glm::vec3>& positions);
+
+    bool sphereInFrustum(const std::array<glm::vec4, 6>& planes, const glm::mat4& model,
+                         glm::vec4 boundingSphere);
+
+    // Pixels the sphere spans vertically on screen for a perspective projection, the viewport
+    // height once the camera is inside it
+    float sphereScreenDiameter(const glm::mat4& model, glm::vec4 boundingSphere,
+                               const glm::mat4& view, const glm::mat4& projection,
+                               uint32_t viewportHeight);
+
+    // Fills [first, first + count) of spheres, which has to be sized for the objects already. As
+    // conservative as sphereInFrustum
+    void worldSpheres(const std::vector<CullObject>& objects, uint32_t first, uint32_t count,
+                      CullSpheres& spheres);
+
+    // Appends the indices in [first, first + count) whose sphere is in the frustum, in order. Tests
+    // eight spheres at a time with AVX2 when the CPU has it, four with SSE otherwise on x86.
+    // widest holds it to narrower paths, which the tests and benchmarks compare
+    void cullSpheres(const CullSpheres& spheres, const std::array<glm::vec4, 6>& planes,
+                     uint32_t first, uint32_t count, std::vector<uint32_t>& visibleIndices,
+                     CullInstructions widest = CullInstructions::AVX2);
+
+    // The widest cullSpheres can use on this CPU
+    CullInstructions supportedCullInstructions();
+
+    // Reference for cull.comp. One draw per visible object in object order, with the object index
+    // as the first instance
+    std::vector<VkDrawIndirectCommand> cullObjects(const std::vector<CullObject>& objects,
+                                                   const std::vector<CullMesh>& meshes,
+                                                   const std::array<glm::vec4, 6>& planes);
+} // namespace helper
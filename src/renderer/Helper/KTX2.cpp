@@ -0,0 +1,356 @@
+#include "../../pch.hpp"
+#include "KTX2.hpp"
+
+#include <zstd.h>
+
+#include "Conversions.hpp"
+#include "../../Logger.hpp"
+
+constexpr unsigned char KTX2_IDENTIFIER[12] = { 0xab, 0x4b, 0x54, 0x58, 0x20, 0x32,
+                                                0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+
+constexpr uint32_t KTX2_SUPERCOMPRESSION_NONE = 0;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZSTD = 2;
+
+constexpr char KTX2_WRITER[] = "KTXwriter\0cpp_vulkan_conan_template";
+
+// Data format descriptor values, from the Khronos Data Format Specification
+constexpr uint32_t DFD_VERSION            = 2;
+constexpr uint8_t DFD_PRIMARIES_BT709     = 1;
+constexpr uint8_t DFD_TRANSFER_LINEAR     = 1;
+constexpr uint8_t DFD_TRANSFER_SRGB       = 2;
+constexpr uint8_t DFD_MODEL_BC1A          = 128;
+constexpr uint8_t DFD_MODEL_BC4           = 131;
+constexpr uint8_t DFD_MODEL_BC5           = 132;
+constexpr uint8_t DFD_MODEL_BC6H          = 133;
+constexpr uint8_t DFD_MODEL_BC7           = 134;
+constexpr uint8_t DFD_CHANNEL_ALPHA_FLAG  = 1;
+constexpr uint8_t DFD_CHANNEL_GREEN       = 1;
+constexpr uint8_t DFD_SAMPLE_FLOAT        = 0x80;
+constexpr uint32_t DFD_FLOAT_ONE          = 0x3f800000;
+
+// All little endian, followed by a KTX2LevelIndex per mip
+struct KTX2Header {
+    unsigned char identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert(sizeof(KTX2Header) == 80, "KTX2Header has to match the file layout");
+
+struct KTX2LevelIndex {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+struct KTX2FormatInfo {
+    Format format;
+    uint32_t blockBytes;
+    uint8_t colorModel;
+    uint8_t transferFunction;
+    // One sample per 64 bits of the block for BC5, a single one covering the block otherwise
+    std::vector<uint8_t> channelTypes;
+    bool isFloat;
+};
+
+const std::vector<KTX2FormatInfo>& ktx2Formats() {
+    static const std::vector<KTX2FormatInfo> formats = {
+        { Format::BC1_UNORM, 8, DFD_MODEL_BC1A, DFD_TRANSFER_LINEAR, { DFD_CHANNEL_ALPHA_FLAG },
+          false },
+        { Format::BC1_SRGB, 8, DFD_MODEL_BC1A, DFD_TRANSFER_SRGB, { DFD_CHANNEL_ALPHA_FLAG },
+          false },
+        { Format::BC4_UNORM, 8, DFD_MODEL_BC4, DFD_TRANSFER_LINEAR, { 0 }, false },
+        { Format::BC5_UNORM, 16, DFD_MODEL_BC5, DFD_TRANSFER_LINEAR, { 0, DFD_CHANNEL_GREEN },
+          false },
+        { Format::BC6H_UFLOAT, 16, DFD_MODEL_BC6H, DFD_TRANSFER_LINEAR, { DFD_SAMPLE_FLOAT },
+          true },
+        { Format::BC7_UNORM, 16, DFD_MODEL_BC7, DFD_TRANSFER_LINEAR, { 0 }, false },
+        { Format::BC7_SRGB, 16, DFD_MODEL_BC7, DFD_TRANSFER_SRGB, { 0 }, false }
+    };
+
+    return formats;
+}
+
+const KTX2FormatInfo* findKTX2Format(Format format) {
+    for (auto& info : ktx2Formats()) {
+        if (info.format == format) {
+            return &info;
+        }
+    }
+
+    return nullptr;
+}
+
+const KTX2FormatInfo* findKTX2Format(uint32_t vkFormat) {
+    for (auto& info : ktx2Formats()) {
+        if ((uint32_t)helper::getVkFormat(info.format) == vkFormat) {
+            return &info;
+        }
+    }
+
+    return nullptr;
+}
+
+uint64_t ktx2MipSize(const KTX2FormatInfo& info, uint32_t width, uint32_t height, uint32_t level) {
+    uint64_t blocksX = (std::max(width >> level, 1u) + 3) / 4;
+    uint64_t blocksY = (std::max(height >> level, 1u) + 3) / 4;
+
+    return blocksX * blocksY * info.blockBytes;
+}
+
+// The basic descriptor block, 4x4 texel blocks with every sample at the block origin
+std::vector<uint32_t> ktx2DataFormatDescriptor(const KTX2FormatInfo& info) {
+    uint32_t sampleCount = (uint32_t)info.channelTypes.size();
+    uint32_t blockSize   = 24 + 16 * sampleCount;
+    uint32_t sampleBits  = info.blockBytes * 8 / sampleCount;
+
+    std::vector<uint32_t> words;
+    words.push_back(4 + blockSize);
+    words.push_back(0); // Khronos vendor, basic descriptor type
+    words.push_back(DFD_VERSION | (blockSize << 16));
+    words.push_back(info.colorModel | (DFD_PRIMARIES_BT709 << 8) | (info.transferFunction << 16));
+    words.push_back(3 | (3 << 8));
+    words.push_back(info.blockBytes);
+    words.push_back(0);
+
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        words.push_back((i * sampleBits) | ((sampleBits - 1) << 16) |
+                        ((uint32_t)info.channelTypes[i] << 24));
+        words.push_back(0);
+        words.push_back(0);
+        words.push_back(info.isFloat ? DFD_FLOAT_ONE : UINT32_MAX);
+    }
+
+    return words;
+}
+
+bool helper::readKTX2(const std::string& path, KTX2Texture& texture) {
+    std::ifstream inFile(path, std::ios::binary | std::ios::ate);
+    if (!inFile.is_open()) {
+        Logger::renderer_logger->error("Failed to open KTX2 file: {0}", path);
+        return false;
+    }
+
+    std::vector<unsigned char> file((size_t)inFile.tellg());
+    inFile.seekg(0);
+    inFile.read(reinterpret_cast<char*>(file.data()), file.size());
+
+    KTX2Header header = {};
+    if (!inFile || file.size() < sizeof(header)) {
+        Logger::renderer_logger->error("Truncated KTX2 file: {0}", path);
+        return false;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        Logger::renderer_logger->error("Not a KTX2 file: {0}", path);
+        return false;
+    }
+
+    const KTX2FormatInfo* info = findKTX2Format(header.vkFormat);
+    if (info == nullptr) {
+        Logger::renderer_logger->error("Unsupported KTX2 format {0}: {1}", header.vkFormat, path);
+        return false;
+    }
+
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 ||
+        header.layerCount != 0 || header.faceCount != 1 || header.levelCount == 0) {
+        Logger::renderer_logger->error("Only 2D KTX2 textures with stored mips are supported: {0}",
+                                       path);
+        return false;
+    }
+
+    // No more than a full chain down to 1x1, further mips would shift past the size's width
+    uint32_t largerSide    = std::max(header.pixelWidth, header.pixelHeight);
+    uint32_t maxLevelCount = 1;
+    while (maxLevelCount < 32 && (largerSide >> maxLevelCount) > 0) {
+        maxLevelCount++;
+    }
+    if (header.levelCount > maxLevelCount) {
+        Logger::renderer_logger->error(
+            "KTX2 file has {0} mips, a {1}x{2} texture has at most {3}: {4}", header.levelCount,
+            header.pixelWidth, header.pixelHeight, maxLevelCount, path);
+        return false;
+    }
+
+    if (header.supercompressionScheme != KTX2_SUPERCOMPRESSION_NONE &&
+        header.supercompressionScheme != KTX2_SUPERCOMPRESSION_ZSTD) {
+        Logger::renderer_logger->error("Unsupported KTX2 supercompression scheme {0}: {1}",
+                                       header.supercompressionScheme, path);
+        return false;
+    }
+
+    if (file.size() < sizeof(header) + header.levelCount * sizeof(KTX2LevelIndex)) {
+        Logger::renderer_logger->error("Truncated KTX2 file: {0}", path);
+        return false;
+    }
+
+    texture.format = info->format;
+    texture.width  = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.mips.assign(header.levelCount, {});
+
+    for (uint32_t level = 0; level < header.levelCount; level++) {
+        KTX2LevelIndex levelIndex = {};
+        memcpy(&levelIndex, file.data() + sizeof(header) + level * sizeof(KTX2LevelIndex),
+               sizeof(levelIndex));
+
+        uint64_t mipSize = ktx2MipSize(*info, header.pixelWidth, header.pixelHeight, level);
+        if (levelIndex.byteOffset > file.size() ||
+            levelIndex.byteLength > file.size() - levelIndex.byteOffset ||
+            levelIndex.uncompressedByteLength != mipSize) {
+            Logger::renderer_logger->error("Corrupt KTX2 mip {0}: {1}", level, path);
+            return false;
+        }
+
+        const unsigned char* levelData = file.data() + levelIndex.byteOffset;
+        std::vector<unsigned char>& mip = texture.mips[level];
+        if (header.supercompressionScheme == KTX2_SUPERCOMPRESSION_NONE) {
+            if (levelIndex.byteLength != mipSize) {
+                Logger::renderer_logger->error("Corrupt KTX2 mip {0}: {1}", level, path);
+                return false;
+            }
+            mip.assign(levelData, levelData + mipSize);
+        } else {
+            mip.resize(mipSize);
+            size_t result = ZSTD_decompress(mip.data(), mip.size(), levelData,
+                                            (size_t)levelIndex.byteLength);
+            if (ZSTD_isError(result) || result != mipSize) {
+                Logger::renderer_logger->error("Failed to decompress KTX2 mip {0}: {1}", level,
+                                               path);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool helper::writeKTX2(const std::string& path, const KTX2Texture& texture, int zstdLevel) {
+    const KTX2FormatInfo* info = findKTX2Format(texture.format);
+    if (info == nullptr || texture.mips.empty()) {
+        Logger::renderer_logger->error("Only block compressed mips can be written to KTX2: {0}",
+                                       path);
+        return false;
+    }
+
+    uint32_t levelCount = (uint32_t)texture.mips.size();
+    for (uint32_t level = 0; level < levelCount; level++) {
+        if (texture.mips[level].size() !=
+            ktx2MipSize(*info, texture.width, texture.height, level)) {
+            Logger::renderer_logger->error("KTX2 mip {0} has the wrong size: {1}", level, path);
+            return false;
+        }
+    }
+
+    // Stored mips are aligned to their block size, supercompressed ones aren't aligned at all
+    std::vector<std::vector<unsigned char>> levelData(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++) {
+        const std::vector<unsigned char>& mip = texture.mips[level];
+        if (zstdLevel == 0) {
+            levelData[level] = mip;
+            continue;
+        }
+
+        levelData[level].resize(ZSTD_compressBound(mip.size()));
+        size_t result = ZSTD_compress(levelData[level].data(), levelData[level].size(),
+                                      mip.data(), mip.size(), zstdLevel);
+        if (ZSTD_isError(result)) {
+            Logger::renderer_logger->error("Failed to compress KTX2 mip {0}: {1}, {2}", level,
+                                           path, ZSTD_getErrorName(result));
+            return false;
+        }
+        levelData[level].resize(result);
+    }
+    uint64_t alignment = (zstdLevel == 0) ? info->blockBytes : 1;
+
+    std::vector<uint32_t> dfd = ktx2DataFormatDescriptor(*info);
+
+    KTX2Header header = {};
+    memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    header.vkFormat               = (uint32_t)getVkFormat(texture.format);
+    header.typeSize               = 1;
+    header.pixelWidth             = texture.width;
+    header.pixelHeight            = texture.height;
+    header.faceCount              = 1;
+    header.levelCount             = levelCount;
+    header.supercompressionScheme =
+        (zstdLevel == 0) ? KTX2_SUPERCOMPRESSION_NONE : KTX2_SUPERCOMPRESSION_ZSTD;
+    header.dfdByteOffset = (uint32_t)(sizeof(header) + levelCount * sizeof(KTX2LevelIndex));
+    header.dfdByteLength = (uint32_t)(dfd.size() * sizeof(uint32_t));
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    // Key and value including the terminator of each, padded to 4 bytes
+    header.kvdByteLength = (uint32_t)(sizeof(uint32_t) + sizeof(KTX2_WRITER) + 3) & ~3u;
+
+    // The smallest mip comes first in the file
+    std::vector<KTX2LevelIndex> levelIndices(levelCount);
+    uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+    for (uint32_t level = levelCount; level-- > 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+
+        levelIndices[level].byteOffset             = offset;
+        levelIndices[level].byteLength             = levelData[level].size();
+        levelIndices[level].uncompressedByteLength = texture.mips[level].size();
+        offset += levelData[level].size();
+    }
+
+    std::string temporaryPath = path + ".tmp";
+
+    // Written to a temporary file and renamed so an interrupted write never leaves a valid
+    // looking file behind
+    {
+        std::ofstream outFile(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            Logger::renderer_logger->error("Failed to open KTX2 file for writing: {0}",
+                                           temporaryPath);
+            return false;
+        }
+
+        outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outFile.write(reinterpret_cast<const char*>(levelIndices.data()),
+                      levelIndices.size() * sizeof(KTX2LevelIndex));
+        outFile.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+
+        uint32_t writerLength = sizeof(KTX2_WRITER);
+        outFile.write(reinterpret_cast<const char*>(&writerLength), sizeof(writerLength));
+        outFile.write(KTX2_WRITER, sizeof(KTX2_WRITER));
+
+        uint64_t written = header.kvdByteOffset + sizeof(writerLength) + sizeof(KTX2_WRITER);
+        for (uint32_t level = levelCount; level-- > 0;) {
+            for (; written < levelIndices[level].byteOffset; written++) {
+                outFile.put(0);
+            }
+            outFile.write(reinterpret_cast<const char*>(levelData[level].data()),
+                          levelData[level].size());
+            written += levelData[level].size();
+        }
+
+        if (!outFile) {
+            Logger::renderer_logger->error("Failed to write KTX2 file: {0}", temporaryPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        Logger::renderer_logger->error("Failed to write KTX2 file: {0}, {1}", path,
+                                       error.message());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "../../pch.hpp"
+
+#include "../Types/Renderpass.hpp"
+
+// Mips of a 2D texture in a block compressed format, as a KTX2 file holds them
+struct KTX2Texture {
+    Format format;
+    uint32_t width;
+    uint32_t height;
+    // Full size first, each mip's blocks in row order
+    std::vector<std::vector<unsigned char>> mips;
+};
+
+namespace helper {
+    // Reads files with every mip stored, plain or Zstandard supercompressed. Arrays, cubemaps,
+    // Basis Universal and files that leave the mips to be generated are rejected
+    bool readKTX2(const std::string& path, KTX2Texture& texture);
+
+    // Supercompresses every mip with Zstandard at zstdLevel, or stores them as they are when it's 0
+    bool writeKTX2(const std::string& path, const KTX2Texture& texture, int zstdLevel = 0);
+} // namespace helper
@@ -0,0 +1,245 @@
+#include "../../pch.hpp"
+#include "Pixels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSSE3 and F16C in functions marked for them, MSVC takes the intrinsics
+// anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define PIXELS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define PIXELS_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define PIXELS_TARGET_SSSE3
+#define PIXELS_TARGET_F16C
+#endif
+
+constexpr float LARGEST_HALF = 65504.0f;
+
+#ifdef PIXELS_X86
+bool cpuSupportsSSSE3() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+// Returns where it stopped, the rest is left for the scalar loop
+PIXELS_TARGET_SSSE3
+size_t expandRGBToRGBASSSE3(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount) {
+    // Four pixels from the first twelve bytes of a load, a zero for every alpha
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    // The last four pixels are loaded from four bytes in, so the loads stay inside the 48 bytes
+    const __m128i spreadLast =
+        _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+    size_t i = 0;
+    for (; i + 16 <= pixelCount; i += 16) {
+        const unsigned char* source = rgb + i * 3;
+        unsigned char* destination  = rgba + i * 4;
+
+        __m128i first  = _mm_loadu_si128((const __m128i*)(source + 0));
+        __m128i second = _mm_loadu_si128((const __m128i*)(source + 12));
+        __m128i third  = _mm_loadu_si128((const __m128i*)(source + 24));
+        __m128i last   = _mm_loadu_si128((const __m128i*)(source + 32));
+
+        _mm_storeu_si128((__m128i*)(destination + 0),
+                         _mm_or_si128(_mm_shuffle_epi8(first, spread), alpha));
+        _mm_storeu_si128((__m128i*)(destination + 16),
+                         _mm_or_si128(_mm_shuffle_epi8(second, spread), alpha));
+        _mm_storeu_si128((__m128i*)(destination + 32),
+                         _mm_or_si128(_mm_shuffle_epi8(third, spread), alpha));
+        _mm_storeu_si128((__m128i*)(destination + 48),
+                         _mm_or_si128(_mm_shuffle_epi8(last, spreadLast), alpha));
+    }
+
+    return i;
+}
+
+// F16C is VEX encoded, so it also needs the OS to save the AVX registers
+bool cpuSupportsF16C() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesAVX = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    return osSavesAVX && (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 29)) != 0;
+#else
+    return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+}
+
+// Returns where it stopped, the rest is left for the scalar loop
+PIXELS_TARGET_F16C
+size_t floatToHalfF16C(const float* source, uint16_t* destination, size_t count) {
+    // The limit goes first, min and max return their second operand for NaNs
+    const __m256 largest  = _mm256_set1_ps(LARGEST_HALF);
+    const __m256 smallest = _mm256_set1_ps(-LARGEST_HALF);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 values = _mm256_loadu_ps(source + i);
+        values        = _mm256_max_ps(smallest, _mm256_min_ps(largest, values));
+        _mm_storeu_si128((__m128i*)(destination + i),
+                         _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+    }
+
+    return i;
+}
+
+PIXELS_TARGET_F16C
+size_t halfToFloatF16C(const uint16_t* source, float* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(destination + i,
+                         _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(source + i))));
+    }
+
+    return i;
+}
+#endif
+
+// Unsigned floats with a 5 bit exponent biased like a half's, which is what halves, the 11 bit
+// and the 10 bit floats of B10G11R11 all are apart from the sign. Round to nearest even
+uint32_t floatToSmallFloat(float value, uint32_t mantissaBits) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t shift = 23 - mantissaBits;
+
+    // Subnormal results line up with the mantissa of the magic number once added to it, the
+    // addition does the rounding
+    if ((bits & 0x7fffffff) < (113u << 23)) {
+        uint32_t magicBits = (127 - 15 + shift + 1) << 23;
+        float magic;
+        memcpy(&magic, &magicBits, sizeof(magic));
+
+        float sum = std::abs(value) + magic;
+        uint32_t sumBits;
+        memcpy(&sumBits, &sum, sizeof(sumBits));
+
+        return sumBits - magicBits;
+    }
+
+    // Rebias the exponent and add just under half a unit, plus one more when that unit is odd
+    uint32_t odd = (bits >> shift) & 1;
+    bits         = (bits & 0x7fffffff) - (112u << 23) + (1u << (shift - 1)) - 1 + odd;
+
+    return bits >> shift;
+}
+
+float smallFloatToFloat(uint32_t value, uint32_t mantissaBits) {
+    uint32_t exponent = value >> mantissaBits;
+    uint32_t mantissa = value & ((1u << mantissaBits) - 1);
+
+    if (exponent == 0) {
+        return std::ldexp((float)mantissa, -14 - (int)mantissaBits);
+    }
+    if (exponent == 31) {
+        return (mantissa == 0) ? INFINITY : NAN;
+    }
+
+    return std::ldexp(1.0f + (float)mantissa / (1u << mantissaBits), (int)exponent - 15);
+}
+
+uint16_t floatToHalfScalar(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+
+    // Quiet NaNs keeping the top of the payload, like F16C
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+        return sign | 0x7e00 | ((bits >> 13) & 0x3ff);
+    }
+
+    return sign | (uint16_t)floatToSmallFloat(std::min(std::abs(value), LARGEST_HALF), 10);
+}
+
+// Clamped to the largest finite value, NaNs stay NaNs
+uint32_t floatToUnsignedSmallFloat(float value, uint32_t mantissaBits) {
+    if (std::isnan(value)) {
+        return (31u << mantissaBits) | 1;
+    }
+    if (!(value > 0.0f)) {
+        return 0;
+    }
+
+    float largest = (2.0f - 1.0f / (1u << mantissaBits)) * 32768.0f;
+    return floatToSmallFloat(std::min(value, largest), mantissaBits);
+}
+
+void helper::expandRGBToRGBA(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount) {
+    size_t i = 0;
+
+#ifdef PIXELS_X86
+    static const bool supportsSSSE3 = cpuSupportsSSSE3();
+    if (supportsSSSE3) {
+        i = expandRGBToRGBASSSE3(rgb, rgba, pixelCount);
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        rgba[i * 4 + 0] = rgb[i * 3 + 0];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+void helper::floatToHalf(const float* source, uint16_t* destination, size_t count) {
+    size_t i = 0;
+
+#ifdef PIXELS_X86
+    static const bool supportsF16C = cpuSupportsF16C();
+    if (supportsF16C) {
+        i = floatToHalfF16C(source, destination, count);
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = floatToHalfScalar(source[i]);
+    }
+}
+
+void helper::halfToFloat(const uint16_t* source, float* destination, size_t count) {
+    size_t i = 0;
+
+#ifdef PIXELS_X86
+    static const bool supportsF16C = cpuSupportsF16C();
+    if (supportsF16C) {
+        i = halfToFloatF16C(source, destination, count);
+    }
+#endif
+
+    for (; i < count; i++) {
+        float value    = smallFloatToFloat(source[i] & 0x7fff, 10);
+        destination[i] = (source[i] & 0x8000) ? -value : value;
+    }
+}
+
+void helper::floatToB10G11R11(const float* rgba, uint32_t* destination, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        const float* pixel = rgba + i * 4;
+        destination[i]     = floatToUnsignedSmallFloat(pixel[0], 6) |
+                         (floatToUnsignedSmallFloat(pixel[1], 6) << 11) |
+                         (floatToUnsignedSmallFloat(pixel[2], 5) << 22);
+    }
+}
+
+void helper::b10g11r11ToFloat(const uint32_t* source, float* rgba, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        float* pixel = rgba + i * 4;
+        pixel[0]     = smallFloatToFloat(source[i] & 0x7ff, 6);
+        pixel[1]     = smallFloatToFloat((source[i] >> 11) & 0x7ff, 6);
+        pixel[2]     = smallFloatToFloat(source[i] >> 22, 5);
+        pixel[3]     = 1.0f;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "../../pch.hpp"
+
+namespace helper {
+    // Appends an opaque alpha to every pixel, rgba has to hold pixelCount * 4 bytes. Sixteen
+    // pixels at a time with SSSE3 when the CPU has it
+    void expandRGBToRGBA(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount);
+
+    // Rounds to nearest even like the GPU does. Values past the largest finite half are clamped
+    // to it so bright HDR texels don't become infinities. Eight at a time with F16C when the CPU
+    // has it
+    void floatToHalf(const float* source, uint16_t* destination, size_t count);
+
+    void halfToFloat(const uint16_t* source, float* destination, size_t count);
+
+    // Packs the RGB of every pixel as VK_FORMAT_B10G11R11_UFLOAT_PACK32, rounded to nearest even.
+    // Negative values become zero and values past the largest finite one are clamped to it
+    void floatToB10G11R11(const float* rgba, uint32_t* destination, size_t pixelCount);
+
+    // Alpha comes out as one
+    void b10g11r11ToFloat(const uint32_t* source, float* rgba, size_t pixelCount);
+} // namespace helper
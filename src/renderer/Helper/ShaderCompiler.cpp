@@ -0,0 +1,184 @@
+#include "../../pch.hpp"
+#include "ShaderCompiler.hpp"
+
+#include "../../Logger.hpp"
+
+// Resolves #include "..." relative to the including file and #include <...> relative to the
+// configured include directory. Files that were found are added to includedFiles, so hot reload
+// knows which shaders to recompile when one of them changes
+class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface {
+public:
+    ShaderIncluder(std::string includeDirectory, std::set<std::string>* includedFiles)
+        : includeDirectory(includeDirectory), includedFiles(includedFiles) {}
+
+    shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type,
+                                       const char* requestingSource,
+                                       size_t includeDepth) override {
+        std::filesystem::path includePath;
+        if (type == shaderc_include_type_relative) {
+            includePath = std::filesystem::path(requestingSource).parent_path() / requestedSource;
+        } else {
+            includePath = std::filesystem::path(includeDirectory) / requestedSource;
+        }
+
+        IncludeData* includeData = new IncludeData();
+        if (std::filesystem::exists(includePath)) {
+            includeData->sourceName = helper::normalizeShaderPath(includePath.string());
+            includeData->content    = helper::readFileToString(includeData->sourceName.c_str());
+            if (includedFiles) {
+                includedFiles->insert(includeData->sourceName);
+            }
+        } else {
+            // An empty source name tells shaderc the include failed, the content is the error
+            includeData->content = "Cannot find include file: " + includePath.string();
+        }
+
+        includeData->result.source_name        = includeData->sourceName.c_str();
+        includeData->result.source_name_length = includeData->sourceName.size();
+        includeData->result.content            = includeData->content.c_str();
+        includeData->result.content_length     = includeData->content.size();
+        includeData->result.user_data          = includeData;
+
+        return &includeData->result;
+    }
+
+    void ReleaseInclude(shaderc_include_result* data) override {
+        delete static_cast<IncludeData*>(data->user_data);
+    }
+
+private:
+    struct IncludeData {
+        std::string sourceName;
+        std::string content;
+        shaderc_include_result result;
+    };
+
+    std::string includeDirectory;
+    std::set<std::string>* includedFiles;
+};
+
+std::string helper::readFileToString(const char* filePath) {
+    std::ifstream inFile;
+    inFile.open(filePath);
+    if (!inFile.is_open()) {
+        Logger::renderer_logger->error("Shader file missing: {0}", filePath);
+    }
+
+    return std::string((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+}
+
+std::string helper::normalizeShaderPath(const std::string& shaderFilePath) {
+    return std::filesystem::path(shaderFilePath).lexically_normal().generic_string();
+}
+
+shaderc_shader_kind helper::shaderKindFromExtension(std::string& fileExtension) {
+    if (fileExtension == ".vert") {
+        return shaderc_shader_kind::shaderc_vertex_shader;
+    } else if (fileExtension == ".frag") {
+        return shaderc_shader_kind::shaderc_fragment_shader;
+    } else if (fileExtension == ".comp") {
+        return shaderc_shader_kind::shaderc_compute_shader;
+    } else {
+        Logger::renderer_logger->error("Invalid shader extension: {0}", fileExtension);
+        return shaderc_shader_kind::shaderc_vertex_shader;
+    }
+}
+
+const char* helper::shaderOptimizationAsString(ShaderOptimization optimization) {
+    switch (optimization) {
+    case ShaderOptimization::ZERO:
+        return "zero";
+    case ShaderOptimization::SIZE:
+        return "size";
+    case ShaderOptimization::PERFORMANCE:
+        return "performance";
+    default:
+        return "unknown";
+    }
+}
+
+uint32_t helper::countSpvInstructions(const std::vector<uint32_t>& spvBytes) {
+    const size_t headerWordCount = 5;
+
+    uint32_t instructionCount = 0;
+    for (size_t i = headerWordCount; i < spvBytes.size();) {
+        // The high half of an instruction's first word is its length in words
+        uint32_t wordCount = spvBytes[i] >> 16;
+        if (wordCount == 0) {
+            break;
+        }
+
+        i += wordCount;
+        instructionCount++;
+    }
+
+    return instructionCount;
+}
+
+void helper::configureCompileOptions(shaderc::CompileOptions& options,
+                                     const ShaderCompileOptions& compileOptions,
+                                     std::set<std::string>* includedFiles) {
+    options.SetTargetEnvironment(shaderc_target_env_vulkan,
+                                 compileOptions.targetEnvironmentVersion);
+
+    switch (compileOptions.optimization) {
+    case ShaderOptimization::ZERO:
+        options.SetOptimizationLevel(shaderc_optimization_level_zero);
+        break;
+    case ShaderOptimization::SIZE:
+        options.SetOptimizationLevel(shaderc_optimization_level_size);
+        break;
+    case ShaderOptimization::PERFORMANCE:
+        options.SetOptimizationLevel(shaderc_optimization_level_performance);
+        break;
+    }
+
+    // Pipeline layouts are built from reflection, so bindings the optimizer finds unused in one
+    // stage still need to show up in the layout
+    options.SetPreserveBindings(true);
+
+    if (compileOptions.debugInfo) {
+        options.SetGenerateDebugInfo();
+    }
+
+    options.SetIncluder(
+        std::make_unique<ShaderIncluder>(compileOptions.includeDirectory, includedFiles));
+}
+
+std::vector<uint32_t> helper::spvBytesFromGLSL(std::string& glsl, shaderc_shader_kind shaderKind,
+                                               const char* shaderFilePath,
+                                               const ShaderCompileOptions& compileOptions,
+                                               std::set<std::string>* includedFiles) {
+    shaderc::Compiler compiler;
+    shaderc::CompileOptions options;
+    configureCompileOptions(options, compileOptions, includedFiles);
+
+    // The real file name is needed to resolve relative includes and makes errors point at the file
+    shaderc::SpvCompilationResult spv_module =
+        compiler.CompileGlslToSpv(glsl, shaderKind, shaderFilePath, options);
+
+    if (spv_module.GetCompilationStatus() != shaderc_compilation_status_success) {
+        Logger::renderer_logger->error("Failed to compile shader: {0}, {1}", shaderFilePath,
+                                       spv_module.GetErrorMessage());
+        return std::vector<uint32_t>();
+    }
+
+    std::vector<uint32_t> spvBytes(spv_module.cbegin(), spv_module.cend());
+
+    Logger::renderer_logger->debug("Compiled shader: {0}, optimization: {1}, instructions: {2}",
+                                   shaderFilePath,
+                                   shaderOptimizationAsString(compileOptions.optimization),
+                                   countSpvInstructions(spvBytes));
+
+    return spvBytes;
+}
+
+std::vector<uint32_t> helper::compileShaderFile(const char* shaderFilePath,
+                                                const ShaderCompileOptions& compileOptions,
+                                                std::set<std::string>* includedFiles) {
+    std::string glslString         = readFileToString(shaderFilePath);
+    std::string extension          = std::filesystem::path(shaderFilePath).extension().string();
+    shaderc_shader_kind shaderKind = shaderKindFromExtension(extension);
+
+    return spvBytesFromGLSL(glslString, shaderKind, shaderFilePath, compileOptions, includedFiles);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "../../pch.hpp"
+
+enum class ShaderOptimization { ZERO, SIZE, PERFORMANCE };
+
+struct ShaderCompileOptions {
+    ShaderOptimization optimization = ShaderOptimization::PERFORMANCE;
+    shaderc_env_version targetEnvironmentVersion = shaderc_env_version_vulkan_1_1;
+    bool debugInfo                               = false;
+    std::string includeDirectory                 = "assets/shaders"; // Root for #include <...>
+};
+
+namespace helper {
+    std::string readFileToString(const char* filePath);
+
+    std::string normalizeShaderPath(const std::string& shaderFilePath);
+
+    shaderc_shader_kind shaderKindFromExtension(std::string& fileExtension);
+
+    const char* shaderOptimizationAsString(ShaderOptimization optimization);
+
+    // Number of instructions in a SPIR-V module, used to compare optimization levels
+    uint32_t countSpvInstructions(const std::vector<uint32_t>& spvBytes);
+
+    // Sets up options in place, shaderc doesn't carry the includer over when CompileOptions is
+    // copied or moved. The normalized path of every file the shader includes, nested ones too,
+    // goes into includedFiles when it isn't null
+    void configureCompileOptions(shaderc::CompileOptions& options,
+                                 const ShaderCompileOptions& compileOptions,
+                                 std::set<std::string>* includedFiles = nullptr);
+
+    std::vector<uint32_t> spvBytesFromGLSL(std::string& glsl, shaderc_shader_kind shaderKind,
+                                           const char* shaderFilePath,
+                                           const ShaderCompileOptions& compileOptions,
+                                           std::set<std::string>* includedFiles = nullptr);
+
+    // Reads and compiles a GLSL file. Returns no bytes if any step failed, includedFiles is filled
+    // either way. Safe to call from any thread
+    std::vector<uint32_t> compileShaderFile(const char* shaderFilePath,
+                                            const ShaderCompileOptions& compileOptions,
+                                            std::set<std::string>* includedFiles = nullptr);
+} // namespace helper
@@ -0,0 +1,51 @@
+#include "../../pch.hpp"
+#include "Sorting.hpp"
+
+constexpr uint32_t RADIX_BITS    = 8;
+constexpr uint32_t RADIX_BUCKETS = 1 << RADIX_BITS;
+constexpr uint32_t RADIX_PASSES  = 64 / RADIX_BITS;
+
+void helper::radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+                       std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& valueScratch) {
+    size_t count = keys.size();
+    if (count < 2) {
+        return;
+    }
+
+    // Every pass's histogram in one read over the keys
+    std::array<std::array<uint32_t, RADIX_BUCKETS>, RADIX_PASSES> histograms = {};
+    for (uint64_t key : keys) {
+        for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    keyScratch.resize(count);
+    valueScratch.resize(count);
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+        uint32_t shift      = pass * RADIX_BITS;
+        auto& bucketOffsets = histograms[pass];
+
+        // A byte every key shares wouldn't move anything
+        if (bucketOffsets[(keys[0] >> shift) & (RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : bucketOffsets) {
+            uint32_t bucketCount = bucket;
+            bucket               = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t destination      = bucketOffsets[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+            keyScratch[destination]   = keys[i];
+            valueScratch[destination] = values[i];
+        }
+
+        keys.swap(keyScratch);
+        values.swap(valueScratch);
+    }
+}
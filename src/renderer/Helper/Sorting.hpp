@@ -0,0 +1,10 @@
+#pragma once
+#include "../../pch.hpp"
+
+namespace helper {
+    // Stable ascending sort of keys, carrying values along. LSD radix sort over bytes, skipping
+    // the bytes every key shares, so keys that only use their low bits cost fewer passes. The
+    // scratch vectors are resized as needed, keeping them around avoids allocating every call
+    void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+                   std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& valueScratch);
+} // namespace helper
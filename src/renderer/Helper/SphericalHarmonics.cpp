@@ -0,0 +1,128 @@
+#include "../../pch.hpp"
+#include "SphericalHarmonics.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SH_USE_SSE
+#endif
+
+constexpr float SH_PI = 3.14159265359f;
+
+// Real SH basis for bands 0 to 2, in the order the coefficients are stored
+void shBasis(glm::vec3 direction, float basis[9]) {
+    float x = direction.x;
+    float y = direction.y;
+    float z = direction.z;
+
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * y;
+    basis[2] = 0.488603f * z;
+    basis[3] = 0.488603f * x;
+    basis[4] = 1.092548f * x * y;
+    basis[5] = 1.092548f * y * z;
+    basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+    basis[7] = 1.092548f * x * z;
+    basis[8] = 0.546274f * (x * x - y * y);
+}
+
+SphericalHarmonics helper::projectEquirectangularToSH(const float* data, int width, int height) {
+    // Every row shares the same longitudes
+    std::vector<float> cosLongitudes(width);
+    std::vector<float> sinLongitudes(width);
+    for (int x = 0; x < width; x++) {
+        float longitude  = ((x + 0.5f) / width - 0.5f) * 2.0f * SH_PI;
+        cosLongitudes[x] = std::cos(longitude);
+        sinLongitudes[x] = std::sin(longitude);
+    }
+
+    // Rows are summed in float and accumulated in double, a whole image in float loses the dim
+    // texels next to the bright ones
+    glm::dvec4 totals[9] = {};
+    for (int y = 0; y < height; y++) {
+        // The image is stored top row first, so the first row is +Y
+        float latitude    = (0.5f - (y + 0.5f) / height) * SH_PI;
+        float cosLatitude = std::cos(latitude);
+        float sinLatitude = std::sin(latitude);
+
+        // Texels near the poles cover less of the sphere
+        float solidAngle = cosLatitude * (2.0f * SH_PI / width) * (SH_PI / height);
+
+        const float* row = data + size_t(y) * width * 4;
+
+        float basis[9];
+#ifdef SH_USE_SSE
+        __m128 rowSums[9];
+        for (int i = 0; i < 9; i++) {
+            rowSums[i] = _mm_setzero_ps();
+        }
+
+        for (int x = 0; x < width; x++) {
+            shBasis(glm::vec3(cosLatitude * cosLongitudes[x], sinLatitude,
+                              cosLatitude * sinLongitudes[x]),
+                    basis);
+
+            // All four channels of a texel at once
+            __m128 radiance = _mm_loadu_ps(row + x * 4);
+            for (int i = 0; i < 9; i++) {
+                rowSums[i] = _mm_add_ps(rowSums[i], _mm_mul_ps(radiance, _mm_set1_ps(basis[i])));
+            }
+        }
+
+        for (int i = 0; i < 9; i++) {
+            alignas(16) float rowSum[4];
+            _mm_store_ps(rowSum, rowSums[i]);
+            totals[i] +=
+                glm::dvec4(rowSum[0], rowSum[1], rowSum[2], rowSum[3]) * double(solidAngle);
+        }
+#else
+        glm::vec4 rowSums[9] = {};
+        for (int x = 0; x < width; x++) {
+            shBasis(glm::vec3(cosLatitude * cosLongitudes[x], sinLatitude,
+                              cosLatitude * sinLongitudes[x]),
+                    basis);
+
+            glm::vec4 radiance = glm::vec4(row[x * 4], row[x * 4 + 1], row[x * 4 + 2], 0.0f);
+            for (int i = 0; i < 9; i++) {
+                rowSums[i] += radiance * basis[i];
+            }
+        }
+
+        for (int i = 0; i < 9; i++) {
+            totals[i] += glm::dvec4(rowSums[i]) * double(solidAngle);
+        }
+#endif
+    }
+
+    SphericalHarmonics sphericalHarmonics;
+    for (int i = 0; i < 9; i++) {
+        sphericalHarmonics.coefficients[i] = glm::vec4(glm::vec3(totals[i]), 0.0f);
+    }
+
+    return sphericalHarmonics;
+}
+
+SphericalHarmonics helper::irradianceSHFromRadiance(const SphericalHarmonics& radiance) {
+    // Clamped cosine lobe per band (pi, 2pi/3, pi/4), divided by pi
+    const float bandScales[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+
+    SphericalHarmonics irradiance;
+    for (int i = 0; i < 9; i++) {
+        int band                     = (i == 0) ? 0 : (i < 4) ? 1 : 2;
+        irradiance.coefficients[i]   = radiance.coefficients[i] * bandScales[band];
+        irradiance.coefficients[i].w = 0.0f;
+    }
+
+    return irradiance;
+}
+
+glm::vec3 helper::evaluateSH(const SphericalHarmonics& sphericalHarmonics, glm::vec3 direction) {
+    float basis[9];
+    shBasis(direction, basis);
+
+    glm::vec3 result(0.0f);
+    for (int i = 0; i < 9; i++) {
+        result += glm::vec3(sphericalHarmonics.coefficients[i]) * basis[i];
+    }
+
+    return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "../../pch.hpp"
+
+// L2 spherical harmonics, nine RGB coefficients stored as vec4s to match std140 uniform layout
+struct SphericalHarmonics {
+    glm::vec4 coefficients[9];
+};
+
+namespace helper {
+    // Projects an RGBA float equirectangular image onto SH, with directions mapped the way
+    // equiToCube.comp samples it
+    SphericalHarmonics projectEquirectangularToSH(const float* data, int width, int height);
+
+    // Convolves radiance SH with the clamped cosine lobe and divides by pi, so evaluating it gives
+    // the value the irradiance cubemap stores
+    SphericalHarmonics irradianceSHFromRadiance(const SphericalHarmonics& radiance);
+
+    glm::vec3 evaluateSH(const SphericalHarmonics& sphericalHarmonics, glm::vec3 direction);
+} // namespace helper
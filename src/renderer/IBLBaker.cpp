@@ -0,0 +1,405 @@
+#include "../pch.hpp"
+#include "IBLBaker.hpp"
+
+#include "RenderGraph.hpp"
+#include "Helper/Pixels.hpp"
+#include "../Logger.hpp"
+#include "../Structures/Mesh/mesh.hpp"
+#include "../Structures/Mesh/vertex.hpp"
+
+// Matches the roughness range pbr.frag samples, prefilter mips past it are fully rough
+constexpr uint32_t PREFILTER_ROUGHNESS_MIP_COUNT = 5;
+
+constexpr uint32_t IBL_WORKGROUP_SIZE = 8;
+
+uint32_t iblWorkgroupCount(uint32_t size) {
+    return (size + IBL_WORKGROUP_SIZE - 1) / IBL_WORKGROUP_SIZE;
+}
+
+// Capture views in cubemap layer order, +X, -X, +Y, -Y, +Z, -Z
+std::array<glm::mat4, 6> cubeFaceViewProjections() {
+    glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+    glm::vec3 origin            = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    return { captureProjection * glm::lookAt(origin, glm::vec3(1.0f, 0.0f, 0.0f),
+                                             glm::vec3(0.0f, -1.0f, 0.0f)),
+             captureProjection * glm::lookAt(origin, glm::vec3(-1.0f, 0.0f, 0.0f),
+                                             glm::vec3(0.0f, -1.0f, 0.0f)),
+             captureProjection * glm::lookAt(origin, glm::vec3(0.0f, 1.0f, 0.0f),
+                                             glm::vec3(0.0f, 0.0f, 1.0f)),
+             captureProjection * glm::lookAt(origin, glm::vec3(0.0f, -1.0f, 0.0f),
+                                             glm::vec3(0.0f, 0.0f, -1.0f)),
+             captureProjection * glm::lookAt(origin, glm::vec3(0.0f, 0.0f, 1.0f),
+                                             glm::vec3(0.0f, -1.0f, 0.0f)),
+             captureProjection * glm::lookAt(origin, glm::vec3(0.0f, 0.0f, -1.0f),
+                                             glm::vec3(0.0f, -1.0f, 0.0f)) };
+}
+
+IBLBaker::IBLBaker(GraphicsContext* graphicsContext) : graphicsContext(graphicsContext) {
+    equiToCubeComputePipeline =
+        graphicsContext->createComputePipeline("assets/shaders/equiToCube.comp");
+    irradianceComputePipeline =
+        graphicsContext->createComputePipeline("assets/shaders/irradiance.comp");
+    prefilterComputePipeline =
+        graphicsContext->createComputePipeline("assets/shaders/prefilter.comp");
+    brdfComputePipeline = graphicsContext->createComputePipeline("assets/shaders/brdf.comp");
+
+    equiToCubeSet = graphicsContext->createDescriptorSet(equiToCubeComputePipeline, 0);
+    irradianceSet = graphicsContext->createDescriptorSet(irradianceComputePipeline, 0);
+    brdfSet       = graphicsContext->createDescriptorSet(brdfComputePipeline, 0);
+}
+
+IBLBaker::~IBLBaker() { Logger::renderer_logger->info("Destroying IBL Baker"); }
+
+void IBLBaker::bake(std::shared_ptr<Texture> equirectangularTexture,
+                    std::shared_ptr<Texture> environmentMap,
+                    std::shared_ptr<Texture> irradianceMap, std::shared_ptr<Texture> prefilterMap) {
+    // The sets were last used by a submission that was waited on
+    graphicsContext->descriptorSetAddImage(equiToCubeSet, 0, equirectangularTexture);
+    graphicsContext->descriptorSetAddStorageImage(equiToCubeSet, 1, environmentMap);
+
+    graphicsContext->descriptorSetAddImage(irradianceSet, 0, environmentMap);
+    graphicsContext->descriptorSetAddStorageImage(irradianceSet, 1, irradianceMap);
+
+    // Each mip is a separate storage view, so it needs its own set
+    while (prefilterSets.size() < prefilterMap->mipLevels) {
+        prefilterSets.push_back(graphicsContext->createDescriptorSet(prefilterComputePipeline, 0));
+    }
+    for (uint32_t mipLevel = 0; mipLevel < prefilterMap->mipLevels; mipLevel++) {
+        graphicsContext->descriptorSetAddImage(prefilterSets[mipLevel], 0, environmentMap);
+        graphicsContext->descriptorSetAddStorageImage(prefilterSets[mipLevel], 1, prefilterMap,
+                                                      mipLevel);
+    }
+
+    // The cubemaps are only ever sampled by the PBR and skybox shaders afterwards
+    RenderGraph renderGraph;
+    renderGraph.importTexture("equirectangular", equirectangularTexture, ImageLayout::SHADER_READ);
+    renderGraph.importTexture("environment", environmentMap, ImageLayout::UNDEFINED);
+    renderGraph.importTexture("irradiance", irradianceMap, ImageLayout::UNDEFINED);
+    renderGraph.importTexture("prefilter", prefilterMap, ImageLayout::UNDEFINED);
+    renderGraph.exportTexture("environment", ResourceUsage::SAMPLED_FRAGMENT);
+    renderGraph.exportTexture("irradiance", ResourceUsage::SAMPLED_FRAGMENT);
+    renderGraph.exportTexture("prefilter", ResourceUsage::SAMPLED_FRAGMENT);
+
+    // Environment map, every face is a layer of the dispatch
+    renderGraph
+        .addPass("equiToCube",
+                 [&](std::shared_ptr<CommandBuffer> commandBuffer) {
+                     graphicsContext->bindPipeline(commandBuffer, equiToCubeComputePipeline);
+                     graphicsContext->bindDescriptorSet(commandBuffer, 0, equiToCubeSet);
+                     graphicsContext->dispatch(commandBuffer,
+                                               iblWorkgroupCount(environmentMap->width),
+                                               iblWorkgroupCount(environmentMap->height), 6);
+                 })
+        .read("equirectangular", ResourceUsage::SAMPLED_COMPUTE)
+        .write("environment", ResourceUsage::STORAGE_WRITE_COMPUTE);
+
+    // The convolutions sample the environment map as a cube
+    renderGraph
+        .addPass("irradiance",
+                 [&](std::shared_ptr<CommandBuffer> commandBuffer) {
+                     graphicsContext->bindPipeline(commandBuffer, irradianceComputePipeline);
+                     graphicsContext->bindDescriptorSet(commandBuffer, 0, irradianceSet);
+                     graphicsContext->dispatch(commandBuffer,
+                                               iblWorkgroupCount(irradianceMap->width),
+                                               iblWorkgroupCount(irradianceMap->height), 6);
+                 })
+        .read("environment", ResourceUsage::SAMPLED_COMPUTE)
+        .write("irradiance", ResourceUsage::STORAGE_WRITE_COMPUTE);
+
+    renderGraph
+        .addPass("prefilter",
+                 [&](std::shared_ptr<CommandBuffer> commandBuffer) {
+                     graphicsContext->bindPipeline(commandBuffer, prefilterComputePipeline);
+                     for (uint32_t mipLevel = 0; mipLevel < prefilterMap->mipLevels; mipLevel++) {
+                         float roughness = std::min(
+                             (float)mipLevel / (float)(PREFILTER_ROUGHNESS_MIP_COUNT - 1), 1.0f);
+                         uint32_t mipWidth  = std::max(prefilterMap->width >> mipLevel, 1u);
+                         uint32_t mipHeight = std::max(prefilterMap->height >> mipLevel, 1u);
+
+                         graphicsContext->bindDescriptorSet(commandBuffer, 0,
+                                                            prefilterSets[mipLevel]);
+                         graphicsContext->pushConstants(commandBuffer, prefilterComputePipeline,
+                                                        0, sizeof(float), &roughness);
+                         graphicsContext->dispatch(commandBuffer, iblWorkgroupCount(mipWidth),
+                                                   iblWorkgroupCount(mipHeight), 6);
+                     }
+                 })
+        .read("environment", ResourceUsage::SAMPLED_COMPUTE)
+        .write("prefilter", ResourceUsage::STORAGE_WRITE_COMPUTE);
+
+    auto commandBuffer = graphicsContext->createCommandBuffer();
+    graphicsContext->beginRecording(commandBuffer);
+    renderGraph.execute(commandBuffer);
+    graphicsContext->endRecording(commandBuffer);
+    graphicsContext->immediateSubmit(commandBuffer);
+}
+
+void IBLBaker::bakeBRDF(std::shared_ptr<Texture> brdfLUT) {
+    graphicsContext->descriptorSetAddStorageImage(brdfSet, 0, brdfLUT);
+
+    RenderGraph renderGraph;
+    renderGraph.importTexture("brdfLUT", brdfLUT, ImageLayout::UNDEFINED);
+    renderGraph.exportTexture("brdfLUT", ResourceUsage::SAMPLED_FRAGMENT);
+
+    renderGraph
+        .addPass("brdf",
+                 [&](std::shared_ptr<CommandBuffer> commandBuffer) {
+                     graphicsContext->bindPipeline(commandBuffer, brdfComputePipeline);
+                     graphicsContext->bindDescriptorSet(commandBuffer, 0, brdfSet);
+                     graphicsContext->dispatch(commandBuffer, iblWorkgroupCount(brdfLUT->width),
+                                               iblWorkgroupCount(brdfLUT->height), 1);
+                 })
+        .write("brdfLUT", ResourceUsage::STORAGE_WRITE_COMPUTE);
+
+    auto commandBuffer = graphicsContext->createCommandBuffer();
+    graphicsContext->beginRecording(commandBuffer);
+    renderGraph.execute(commandBuffer);
+    graphicsContext->endRecording(commandBuffer);
+    graphicsContext->immediateSubmit(commandBuffer);
+}
+
+std::vector<std::string> IBLBaker::shaderPaths() {
+    return { "assets/shaders/cubemap.glsl", "assets/shaders/equiToCube.comp",
+             "assets/shaders/irradiance.comp", "assets/shaders/prefilter.comp",
+             "assets/shaders/brdf.comp" };
+}
+
+void IBLBaker::bakeWithRenderPasses(std::shared_ptr<Texture> equirectangularTexture,
+                                    std::shared_ptr<Texture> environmentMap,
+                                    std::shared_ptr<Texture> irradianceMap,
+                                    std::shared_ptr<Texture> prefilterMap) {
+    Mesh cubeMesh                    = Mesh::loadFromObj("assets/models/cube.obj");
+    std::vector<Vertex> cubeVertices = std::vector<Vertex>();
+    for (auto vertex : cubeMesh.vertices) {
+        cubeVertices.push_back({ vertex.position, vertex.normal, vertex.uv });
+    }
+
+    auto cubeVertexBuffer = graphicsContext->createVertexBuffer(
+        cubeVertices.data(), uint32_t(cubeVertices.size() * sizeof(Vertex)));
+
+    std::array<glm::mat4, 6> faceViewProjections = cubeFaceViewProjections();
+
+    // The equirectangular image is stored top row first, flipping the cube puts its first row at +Y
+    std::array<glm::mat4, 6> equiToCubeViewProjections;
+    for (int face = 0; face < 6; face++) {
+        equiToCubeViewProjections[face] =
+            faceViewProjections[face] * glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+    }
+
+    auto commandBuffer = graphicsContext->createCommandBuffer();
+
+    // Environment Map
+    auto equiToCubeRenderPass = createCubeRenderPass(environmentMap, 0);
+    auto equiToCubePipeline   = createCubePipeline("assets/shaders/equiToCube.frag",
+                                                   equiToCubeRenderPass, environmentMap->width);
+    writeCubeDescriptorSet(equiToCubeCubeSet, equiToCubePipeline, equirectangularTexture,
+                           equiToCubeViewProjections);
+
+    graphicsContext->beginRecording(commandBuffer);
+    graphicsContext->beginRenderPass(commandBuffer, equiToCubeRenderPass, environmentMap->width,
+                                     environmentMap->height);
+    graphicsContext->bindPipeline(commandBuffer, equiToCubePipeline);
+    graphicsContext->bindDescriptorSet(commandBuffer, 0, equiToCubeCubeSet);
+    graphicsContext->bindVertexBuffer(commandBuffer, cubeVertexBuffer);
+    graphicsContext->draw(commandBuffer, (uint32_t)cubeVertices.size(), 1, 0, 0);
+    graphicsContext->endRenderPass(commandBuffer);
+    graphicsContext->endRecording(commandBuffer);
+    graphicsContext->immediateSubmit(commandBuffer);
+
+    // Irradiance Map
+    auto convolutionRenderPass = createCubeRenderPass(irradianceMap, 0);
+    auto convolutionPipeline   = createCubePipeline("assets/shaders/convolution.frag",
+                                                    convolutionRenderPass, irradianceMap->width);
+    writeCubeDescriptorSet(convolutionCubeSet, convolutionPipeline, environmentMap,
+                           faceViewProjections);
+
+    graphicsContext->beginRecording(commandBuffer);
+    graphicsContext->beginRenderPass(commandBuffer, convolutionRenderPass, irradianceMap->width,
+                                     irradianceMap->height);
+    graphicsContext->bindPipeline(commandBuffer, convolutionPipeline);
+    graphicsContext->bindDescriptorSet(commandBuffer, 0, convolutionCubeSet);
+    graphicsContext->bindVertexBuffer(commandBuffer, cubeVertexBuffer);
+    graphicsContext->draw(commandBuffer, (uint32_t)cubeVertices.size(), 1, 0, 0);
+    graphicsContext->endRenderPass(commandBuffer);
+    graphicsContext->endRecording(commandBuffer);
+    graphicsContext->immediateSubmit(commandBuffer);
+
+    // Prefilter Map, viewports are baked into pipelines so every mip needs its own
+    std::vector<std::shared_ptr<RenderPass>> prefilterRenderPasses;
+    std::vector<std::shared_ptr<Pipeline>> prefilterPipelines;
+    for (uint32_t mipLevel = 0; mipLevel < prefilterMap->mipLevels; mipLevel++) {
+        uint32_t mipSize = std::max(prefilterMap->width >> mipLevel, 1u);
+
+        prefilterRenderPasses.push_back(createCubeRenderPass(prefilterMap, mipLevel));
+        prefilterPipelines.push_back(createCubePipeline("assets/shaders/prefilter.frag",
+                                                        prefilterRenderPasses.back(), mipSize));
+    }
+
+    // The pipelines share a layout, so one set serves every mip
+    writeCubeDescriptorSet(prefilterCubeSet, prefilterPipelines[0], environmentMap,
+                           faceViewProjections);
+
+    graphicsContext->beginRecording(commandBuffer);
+    for (uint32_t mipLevel = 0; mipLevel < prefilterMap->mipLevels; mipLevel++) {
+        float roughness =
+            std::min((float)mipLevel / (float)(PREFILTER_ROUGHNESS_MIP_COUNT - 1), 1.0f);
+        uint32_t mipSize = std::max(prefilterMap->width >> mipLevel, 1u);
+
+        graphicsContext->beginRenderPass(commandBuffer, prefilterRenderPasses[mipLevel], mipSize,
+                                         mipSize);
+        graphicsContext->bindPipeline(commandBuffer, prefilterPipelines[mipLevel]);
+        graphicsContext->bindDescriptorSet(commandBuffer, 0, prefilterCubeSet);
+        graphicsContext->pushConstants(commandBuffer, prefilterPipelines[mipLevel], 0,
+                                       sizeof(float), &roughness);
+        graphicsContext->bindVertexBuffer(commandBuffer, cubeVertexBuffer);
+        graphicsContext->draw(commandBuffer, (uint32_t)cubeVertices.size(), 1, 0, 0);
+        graphicsContext->endRenderPass(commandBuffer);
+    }
+    graphicsContext->endRecording(commandBuffer);
+    graphicsContext->immediateSubmit(commandBuffer);
+}
+
+// Both read back from RGBA16 float cubemaps shaped like cubemap, alpha is left out
+CubemapDifference cubemapDifference(const Texture& cubemap,
+                                    const std::vector<unsigned char>& baked,
+                                    const std::vector<unsigned char>& reference) {
+    size_t count = std::min(baked.size(), reference.size()) / sizeof(uint16_t);
+    std::vector<float> bakedValues(count);
+    std::vector<float> referenceValues(count);
+    helper::halfToFloat(reinterpret_cast<const uint16_t*>(baked.data()), bakedValues.data(),
+                        count);
+    helper::halfToFloat(reinterpret_cast<const uint16_t*>(reference.data()),
+                        referenceValues.data(), count);
+
+    // Mip by mip, with the six faces of each one after the other
+    CubemapDifference difference        = {};
+    std::array<double, 6> errorSums     = {};
+    std::array<double, 6> magnitudeSums = {};
+    size_t value                        = 0;
+    for (uint32_t mip = 0; mip < cubemap.mipLevels; mip++) {
+        size_t faceValues = size_t(std::max(cubemap.width >> mip, 1u)) *
+                            std::max(cubemap.height >> mip, 1u) * 4;
+        for (uint32_t face = 0; face < 6 && value + faceValues <= count; face++) {
+            for (size_t i = value; i < value + faceValues; i++) {
+                if (i % 4 == 3) {
+                    continue;
+                }
+
+                float error         = std::abs(bakedValues[i] - referenceValues[i]);
+                difference.maxError = std::max(difference.maxError, error);
+                errorSums[face] += error;
+                magnitudeSums[face] += std::abs(referenceValues[i]);
+            }
+            value += faceValues;
+        }
+    }
+
+    double errorSum     = 0.0;
+    double magnitudeSum = 0.0;
+    for (uint32_t face = 0; face < 6; face++) {
+        difference.faceRelativeErrors[face] =
+            magnitudeSums[face] > 0.0 ? float(errorSums[face] / magnitudeSums[face]) : 0.0f;
+        errorSum += errorSums[face];
+        magnitudeSum += magnitudeSums[face];
+    }
+    difference.relativeError = magnitudeSum > 0.0 ? float(errorSum / magnitudeSum) : 0.0f;
+
+    return difference;
+}
+
+std::array<CubemapDifference, 3>
+IBLBaker::compareWithRenderPasses(std::shared_ptr<Texture> equirectangularTexture,
+                                  std::shared_ptr<Texture> environmentMap,
+                                  std::shared_ptr<Texture> irradianceMap,
+                                  std::shared_ptr<Texture> prefilterMap) {
+    std::array<std::shared_ptr<Texture>, 3> baked = { environmentMap, irradianceMap,
+                                                      prefilterMap };
+    std::array<std::shared_ptr<Texture>, 3> references;
+    for (size_t i = 0; i < baked.size(); i++) {
+        references[i] = graphicsContext->createCubemap(Format::RGBA16_FLOAT, baked[i]->width,
+                                                       baked[i]->height, baked[i]->mipLevels > 1);
+    }
+
+    bakeWithRenderPasses(equirectangularTexture, references[0], references[1], references[2]);
+
+    const char* names[]     = { "environment", "irradiance", "prefilter" };
+    const char* faceNames[] = { "+X", "-X", "+Y", "-Y", "+Z", "-Z" };
+    std::array<CubemapDifference, 3> differences;
+    for (size_t i = 0; i < baked.size(); i++) {
+        differences[i] = cubemapDifference(*baked[i], graphicsContext->readTexture(baked[i]),
+                                           graphicsContext->readTexture(references[i]));
+
+        std::string offFaces;
+        for (uint32_t face = 0; face < 6; face++) {
+            if (differences[i].faceRelativeErrors[face] > BAKE_COMPARISON_TOLERANCE) {
+                offFaces += offFaces.empty() ? "" : ", ";
+                offFaces += faceNames[face];
+            }
+        }
+
+        if (!offFaces.empty()) {
+            Logger::renderer_logger->warn(
+                "Compute baked {0} map is {1:.2f}% off the render pass bake, up to {2}, on {3}",
+                names[i], differences[i].relativeError * 100.0f, differences[i].maxError,
+                offFaces);
+        } else {
+            Logger::renderer_logger->info(
+                "Compute baked {0} map matches the render pass bake within {1:.2f}%, up to {2}",
+                names[i], differences[i].relativeError * 100.0f, differences[i].maxError);
+        }
+    }
+
+    return differences;
+}
+
+std::shared_ptr<RenderPass> IBLBaker::createCubeRenderPass(std::shared_ptr<Texture> cubemap,
+                                                           uint32_t mipLevel) {
+    std::vector<RenderPassAttachmentDescription> attachments;
+    RenderPassAttachmentDescription faceAttachment = {};
+    faceAttachment.loadOp                          = LoadOp::CLEAR;
+    faceAttachment.storeOp                         = StoreOp::STORE;
+    faceAttachment.initialLayout                   = ImageLayout::UNDEFINED;
+    faceAttachment.finalLayout                     = ImageLayout::SHADER_READ;
+    faceAttachment.format                          = Format::RGBA16_FLOAT;
+    faceAttachment.width                           = std::max(cubemap->width >> mipLevel, 1u);
+    faceAttachment.height                          = std::max(cubemap->height >> mipLevel, 1u);
+    faceAttachment.target                          = cubemap;
+    faceAttachment.targetMipLevel                  = mipLevel;
+    attachments.push_back(faceAttachment);
+
+    return graphicsContext->createRenderPass(attachments, false, {}, 6);
+}
+
+std::shared_ptr<Pipeline> IBLBaker::createCubePipeline(const char* fragmentShaderPath,
+                                                       std::shared_ptr<RenderPass> renderPass,
+                                                       uint32_t faceSize) {
+    PipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.vertexShaderPath   = "assets/shaders/cubeMultiview.vert";
+    pipelineCreateInfo.fragmentShaderPath = fragmentShaderPath;
+    pipelineCreateInfo.viewportWidth      = faceSize;
+    pipelineCreateInfo.viewportHeight     = faceSize;
+    pipelineCreateInfo.culling            = false;
+    pipelineCreateInfo.depthTesting       = false;
+    pipelineCreateInfo.depthWrite         = false;
+    pipelineCreateInfo.renderPass         = renderPass;
+
+    return graphicsContext->createPipeline(&pipelineCreateInfo);
+}
+
+void IBLBaker::writeCubeDescriptorSet(std::shared_ptr<DescriptorSet>& descriptorSet,
+                                      std::shared_ptr<Pipeline> pipeline,
+                                      std::shared_ptr<Texture> source,
+                                      const std::array<glm::mat4, 6>& viewProjections) {
+    // The pipelines of later calls are new but have the same layout
+    if (!descriptorSet) {
+        descriptorSet = graphicsContext->createDescriptorSet(pipeline, 0);
+        graphicsContext->descriptorSetAddBuffer(descriptorSet, 1, DescriptorType::UNIFORM_BUFFER,
+                                                sizeof(glm::mat4) * 6);
+    }
+    graphicsContext->descriptorSetAddImage(descriptorSet, 0, source);
+
+    void* data = graphicsContext->mapDescriptorBuffer(descriptorSet, 1);
+    memcpy(data, viewProjections.data(), sizeof(glm::mat4) * 6);
+    graphicsContext->unmapDescriptorBuffer(descriptorSet, 1);
+}
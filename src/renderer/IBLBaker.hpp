@@ -0,0 +1,87 @@
+#pragma once
+
+#include "GraphicsContext.hpp"
+
+// Both bakes take the same samples, what's left is half float rounding and where exactly the
+// rasterizer puts the texel centers
+constexpr float BAKE_COMPARISON_TOLERANCE = 0.02f;
+
+// How far a cubemap baked one way is from a reference, over the colour of every mip and face
+struct CubemapDifference {
+    float maxError;
+    // Mean absolute difference over the mean magnitude of the reference
+    float relativeError;
+    // The same per face in cubemap layer order, a face rendered upside down or in the place of
+    // another stands out even when the whole cubemap is close
+    std::array<float, 6> faceRelativeErrors;
+};
+
+// Bakes the image based lighting cubemaps from an equirectangular HDR texture
+class IBLBaker {
+public:
+    IBLBaker(GraphicsContext* graphicsContext);
+
+    ~IBLBaker();
+
+    // Writes every face and mip of the three cubemaps from compute shaders through storage image
+    // views, all in a single submission. The prefilter map gets one roughness per mip
+    void bake(std::shared_ptr<Texture> equirectangularTexture,
+              std::shared_ptr<Texture> environmentMap, std::shared_ptr<Texture> irradianceMap,
+              std::shared_ptr<Texture> prefilterMap);
+
+    // Writes the split sum BRDF lookup table into a storage texture of any size
+    void bakeBRDF(std::shared_ptr<Texture> brdfLUT);
+
+    // Every shader source the bake output depends on, including shared includes
+    static std::vector<std::string> shaderPaths();
+
+    // Rasterized reference to validate bake against. Each cubemap mip is filled by one multiview
+    // render pass drawing all six faces straight into the cubemap layers
+    void bakeWithRenderPasses(std::shared_ptr<Texture> equirectangularTexture,
+                              std::shared_ptr<Texture> environmentMap,
+                              std::shared_ptr<Texture> irradianceMap,
+                              std::shared_ptr<Texture> prefilterMap);
+
+    // Bakes the cubemaps bake already filled again with bakeWithRenderPasses, into scratch
+    // cubemaps, and warns about the ones too far from the rasterized bake, naming the faces that
+    // are. Environment, irradiance and prefilter differences in that order. Reads both back, so
+    // it's for tests/IBLBakeTest rather than startup
+    std::array<CubemapDifference, 3>
+    compareWithRenderPasses(std::shared_ptr<Texture> equirectangularTexture,
+                            std::shared_ptr<Texture> environmentMap,
+                            std::shared_ptr<Texture> irradianceMap,
+                            std::shared_ptr<Texture> prefilterMap);
+
+private:
+    std::shared_ptr<RenderPass> createCubeRenderPass(std::shared_ptr<Texture> cubemap,
+                                                     uint32_t mipLevel);
+
+    std::shared_ptr<Pipeline> createCubePipeline(const char* fragmentShaderPath,
+                                                 std::shared_ptr<RenderPass> renderPass,
+                                                 uint32_t faceSize);
+
+    // Binds the source texture and uploads the per face view projections for the vertex shader.
+    // Creates the set with its buffer the first time
+    void writeCubeDescriptorSet(std::shared_ptr<DescriptorSet>& descriptorSet,
+                                std::shared_ptr<Pipeline> pipeline, std::shared_ptr<Texture> source,
+                                const std::array<glm::mat4, 6>& viewProjections);
+
+    GraphicsContext* graphicsContext;
+
+    std::shared_ptr<ComputePipeline> equiToCubeComputePipeline;
+    std::shared_ptr<ComputePipeline> irradianceComputePipeline;
+    std::shared_ptr<ComputePipeline> prefilterComputePipeline;
+    std::shared_ptr<ComputePipeline> brdfComputePipeline;
+
+    // Rewritten by every bake, the descriptor pool can't free sets
+    std::shared_ptr<DescriptorSet> equiToCubeSet;
+    std::shared_ptr<DescriptorSet> irradianceSet;
+    // One per prefilter mip, only ever grows
+    std::vector<std::shared_ptr<DescriptorSet>> prefilterSets;
+    std::shared_ptr<DescriptorSet> brdfSet;
+
+    // Of bakeWithRenderPasses, created by its first call
+    std::shared_ptr<DescriptorSet> equiToCubeCubeSet;
+    std::shared_ptr<DescriptorSet> convolutionCubeSet;
+    std::shared_ptr<DescriptorSet> prefilterCubeSet;
+};
@@ -0,0 +1,229 @@
+#include "../pch.hpp"
+#include "IBLCache.hpp"
+
+#include "IBLBaker.hpp"
+#include "Helper/Conversions.hpp"
+#include "../Logger.hpp"
+
+// Bump when the bake changes in a way the hashed inputs don't capture
+constexpr uint32_t IBL_CACHE_VERSION = 4;
+
+constexpr uint32_t IBL_CACHE_MAGIC = 0x434c4249; // "IBLC" in file byte order
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+constexpr uint64_t FNV_PRIME        = 0x100000001b3;
+
+// Entry layout, all little endian: IBLCacheHeader, the values, then per texture an
+// IBLCacheTextureHeader followed by its data as GraphicsContext::readTexture lays it out
+struct IBLCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t textureCount;
+    uint32_t valueCount;
+};
+
+struct IBLCacheTextureHeader {
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint32_t arrayLayers;
+    uint32_t padding;
+    uint64_t dataSize;
+};
+
+uint64_t fnv1aHash(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint64_t fnv1aHashFile(const char* filePath, uint64_t hash) {
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (!inFile.is_open()) {
+        Logger::renderer_logger->error("Failed to open file for hashing: {0}", filePath);
+        return hash;
+    }
+
+    char buffer[64 * 1024];
+    while (inFile.read(buffer, sizeof(buffer)) || inFile.gcount() > 0) {
+        hash = fnv1aHash(buffer, (size_t)inFile.gcount(), hash);
+    }
+
+    return hash;
+}
+
+IBLCacheTextureHeader textureHeader(Texture& texture) {
+    IBLCacheTextureHeader header = {};
+    header.format                = texture.format;
+    header.width                 = texture.width;
+    header.height                = texture.height;
+    header.mipLevels             = texture.mipLevels;
+    header.arrayLayers           = texture.arrayLayers;
+
+    return header;
+}
+
+// Bytes GraphicsContext::readTexture returns for the texture, every mip with all its layers
+uint64_t textureDataSize(Texture& texture) {
+    uint64_t size = 0;
+    for (uint32_t mipLevel = 0; mipLevel < texture.mipLevels; mipLevel++) {
+        uint64_t mipWidth  = std::max(texture.width >> mipLevel, 1u);
+        uint64_t mipHeight = std::max(texture.height >> mipLevel, 1u);
+        size +=
+            mipWidth * mipHeight * texture.arrayLayers * helper::vkFormatAsBytes(texture.format);
+    }
+
+    return size;
+}
+
+IBLCache::IBLCache(GraphicsContext* graphicsContext, std::string directory)
+    : graphicsContext(graphicsContext), directory(directory) {}
+
+IBLCache::~IBLCache() { Logger::renderer_logger->info("Destroying IBL Cache"); }
+
+uint64_t IBLCache::key(const char* sourcePath,
+                       const std::vector<std::shared_ptr<Texture>>& textures) {
+    uint64_t hash = fnv1aHash(&IBL_CACHE_VERSION, sizeof(IBL_CACHE_VERSION));
+
+    hash = fnv1aHashFile(sourcePath, hash);
+
+    // Sample counts and the rest of the bake parameters live in the shaders
+    for (auto& shaderPath : IBLBaker::shaderPaths()) {
+        hash = fnv1aHashFile(shaderPath.c_str(), hash);
+    }
+
+    for (auto& texture : textures) {
+        IBLCacheTextureHeader header = textureHeader(*texture);
+        hash                         = fnv1aHash(&header, sizeof(header), hash);
+    }
+
+    return hash;
+}
+
+bool IBLCache::load(uint64_t key, const std::vector<std::shared_ptr<Texture>>& textures,
+                    std::vector<float>& values) {
+    std::string path = entryPath(key);
+
+    std::ifstream inFile(path, std::ios::binary);
+    if (!inFile.is_open()) {
+        Logger::renderer_logger->info("No cached IBL entry: {0}", path);
+        return false;
+    }
+
+    IBLCacheHeader header = {};
+    inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!inFile || header.magic != IBL_CACHE_MAGIC || header.version != IBL_CACHE_VERSION ||
+        header.key != key || header.textureCount != textures.size()) {
+        Logger::renderer_logger->warn("Ignoring stale or corrupt IBL cache entry: {0}", path);
+        return false;
+    }
+
+    std::vector<float> storedValues(header.valueCount);
+    inFile.read(reinterpret_cast<char*>(storedValues.data()), storedValues.size() * sizeof(float));
+    if (!inFile) {
+        Logger::renderer_logger->warn("Truncated IBL cache entry: {0}", path);
+        return false;
+    }
+
+    // Read everything before uploading so a truncated entry doesn't leave textures half written
+    std::vector<std::vector<unsigned char>> textureData(textures.size());
+    for (size_t i = 0; i < textures.size(); i++) {
+        IBLCacheTextureHeader expected = textureHeader(*textures[i]);
+
+        IBLCacheTextureHeader stored = {};
+        inFile.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+        if (!inFile || stored.format != expected.format || stored.width != expected.width ||
+            stored.height != expected.height || stored.mipLevels != expected.mipLevels ||
+            stored.arrayLayers != expected.arrayLayers ||
+            stored.dataSize != textureDataSize(*textures[i])) {
+            Logger::renderer_logger->warn("IBL cache entry does not match textures: {0}", path);
+            return false;
+        }
+
+        textureData[i].resize(stored.dataSize);
+        inFile.read(reinterpret_cast<char*>(textureData[i].data()), stored.dataSize);
+        if (!inFile) {
+            Logger::renderer_logger->warn("Truncated IBL cache entry: {0}", path);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < textures.size(); i++) {
+        graphicsContext->writeTexture(textures[i], textureData[i].data(), textureData[i].size());
+    }
+    values = storedValues;
+
+    Logger::renderer_logger->info("Loaded IBL textures from cache: {0}", path);
+
+    return true;
+}
+
+void IBLCache::store(uint64_t key, const std::vector<std::shared_ptr<Texture>>& textures,
+                     const std::vector<float>& values) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        Logger::renderer_logger->error("Failed to create IBL cache directory: {0}, {1}",
+                                       directory, error.message());
+        return;
+    }
+
+    std::string path          = entryPath(key);
+    std::string temporaryPath = path + ".tmp";
+
+    // Written to a temporary file and renamed so an interrupted write never leaves a valid
+    // looking entry behind
+    {
+        std::ofstream outFile(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            Logger::renderer_logger->error("Failed to open IBL cache entry for writing: {0}",
+                                           temporaryPath);
+            return;
+        }
+
+        IBLCacheHeader header = {};
+        header.magic          = IBL_CACHE_MAGIC;
+        header.version        = IBL_CACHE_VERSION;
+        header.key            = key;
+        header.textureCount   = (uint32_t)textures.size();
+        header.valueCount     = (uint32_t)values.size();
+        outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outFile.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+
+        for (auto& texture : textures) {
+            std::vector<unsigned char> data = graphicsContext->readTexture(texture);
+
+            IBLCacheTextureHeader entryHeader = textureHeader(*texture);
+            entryHeader.dataSize              = data.size();
+            outFile.write(reinterpret_cast<const char*>(&entryHeader), sizeof(entryHeader));
+            outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+        }
+
+        if (!outFile) {
+            Logger::renderer_logger->error("Failed to write IBL cache entry: {0}", temporaryPath);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        Logger::renderer_logger->error("Failed to write IBL cache entry: {0}, {1}", path,
+                                       error.message());
+        return;
+    }
+
+    Logger::renderer_logger->info("Stored IBL textures in cache: {0}", path);
+}
+
+std::string IBLCache::entryPath(uint64_t key) {
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.ibl", (unsigned long long)key);
+
+    return (std::filesystem::path(directory) / fileName).generic_string();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "GraphicsContext.hpp"
+
+// Stores baked image based lighting textures on disk so later launches upload them instead of
+// baking. An entry is keyed by the source image, the bake shaders and the texture dimensions
+class IBLCache {
+public:
+    IBLCache(GraphicsContext* graphicsContext, std::string directory = "cache/ibl");
+
+    ~IBLCache();
+
+    uint64_t key(const char* sourcePath, const std::vector<std::shared_ptr<Texture>>& textures);
+
+    // Uploads the entry into the textures and fills values with the floats stored alongside them.
+    // Returns false, leaving the textures untouched, when there is no entry or it does not match
+    // the textures
+    bool load(uint64_t key, const std::vector<std::shared_ptr<Texture>>& textures,
+              std::vector<float>& values);
+
+    // Reads the textures back from the GPU and writes them, and values computed on the CPU like SH
+    // coefficients, as the entry for key
+    void store(uint64_t key, const std::vector<std::shared_ptr<Texture>>& textures,
+               const std::vector<float>& values);
+
+private:
+    std::string entryPath(uint64_t key);
+
+    GraphicsContext* graphicsContext;
+
+    std::string directory;
+};
@@ -4,6 +4,7 @@
 
 #include "Window.hpp"
 #include "GraphicsContext.hpp"
+#include "Helper/SphericalHarmonics.hpp"
 
 class PBRRenderer {
 public:
@@ -12,9 +13,9 @@ public:
     ~PBRRenderer();
 
 private:
-    void processEnvironmentAndIrradianceMaps();
-
-    void processBRDF(std::shared_ptr<RenderPass> brdfRenderPass);
+    // Bakes the environment, irradiance, prefilter and BRDF textures and the SH irradiance, or
+    // loads them from the cache
+    void processImageBasedLighting();
 
     std::shared_ptr<Window> window;
 
@@ -29,4 +30,7 @@ private:
     std::shared_ptr<Texture> environmentMap;
     std::shared_ptr<Texture> irradianceMap;
     std::shared_ptr<Texture> prefilterMap;
+    std::shared_ptr<Texture> brdfLUT;
+
+    SphericalHarmonics irradianceSH;
 };
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "../pch.hpp"
+#include "RenderGraph.hpp"
+
+#include "../Logger.hpp"
+
+bool isDepthFormat(VkFormat format) {
+    return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D32_SFLOAT ||
+           format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+RenderGraph::RenderGraph()
+    : graphicsContext(nullptr), transientMemorySize(0), unaliasedTransientMemorySize(0) {}
+
+RenderGraph::~RenderGraph() {
+    Logger::renderer_logger->info("Destroying Render Graph");
+
+    // The images go before the memory they are bound to
+    for (auto& resource : resources) {
+        if (resource.transient) {
+            resource.texture = nullptr;
+        }
+    }
+
+    for (auto& allocation : transientAllocations) {
+        graphicsContext->freeTextureMemory(allocation);
+    }
+}
+
+void RenderGraph::allocate(GraphicsContext* graphicsContext) {
+    if (!compiled) {
+        compile();
+    }
+
+    if (!transientAllocations.empty()) {
+        Logger::renderer_logger->error("Render graph transients are already allocated");
+        return;
+    }
+
+    this->graphicsContext = graphicsContext;
+
+    // Transients that are only ever attachments can live in lazily allocated memory, which costs
+    // nothing on tiled GPUs. Those are kept out of the aliased block
+    std::vector<RenderGraphPlacement> placements;
+    VkDeviceSize unaliasedSize = 0;
+    uint32_t lazyCount         = 0;
+    for (uint32_t resource = 0; resource < resources.size(); resource++) {
+        RenderGraphResource& graphResource = resources[resource];
+        if (!graphResource.transient || graphResource.firstUse == -1) {
+            continue;
+        }
+
+        VkImageUsageFlags attachmentUsage =
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        bool attachmentOnly = (graphResource.usageFlags & ~attachmentUsage) == 0;
+
+        graphResource.texture = graphicsContext->createUnboundTexture(
+            graphResource.description.format, graphResource.description.width,
+            graphResource.description.height, graphResource.description.arrayLayers,
+            graphResource.usageFlags |
+                (attachmentOnly ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0));
+
+        VkMemoryRequirements requirements =
+            graphicsContext->getTextureMemoryRequirements(graphResource.texture);
+        unaliasedSize += requirements.size;
+
+        if (attachmentOnly) {
+            VmaAllocation lazyAllocation =
+                graphicsContext->allocateTextureMemory(requirements, true);
+            if (lazyAllocation != VK_NULL_HANDLE) {
+                graphicsContext->bindTextureMemory(graphResource.texture, lazyAllocation, 0);
+                transientAllocations.push_back(lazyAllocation);
+                lazyCount++;
+                continue;
+            }
+        }
+
+        placements.push_back({ resource, requirements, 0 });
+    }
+
+    VkMemoryRequirements blockRequirements = placeTransients(placements);
+
+    if (!placements.empty()) {
+        if (blockRequirements.memoryTypeBits == 0) {
+            Logger::renderer_logger->error("Render graph transients share no memory type");
+            return;
+        }
+
+        VmaAllocation blockAllocation =
+            graphicsContext->allocateTextureMemory(blockRequirements, false);
+        if (blockAllocation == VK_NULL_HANDLE) {
+            return;
+        }
+        transientAllocations.push_back(blockAllocation);
+
+        for (auto& placement : placements) {
+            graphicsContext->bindTextureMemory(resources[placement.resource].texture,
+                                               blockAllocation, placement.offset);
+        }
+    }
+
+    transientMemorySize          = blockRequirements.size;
+    unaliasedTransientMemorySize = unaliasedSize;
+
+    Logger::renderer_logger->info(
+        "Render graph transients: {0} KiB aliased, {1} KiB without aliasing, {2} lazily allocated",
+        transientMemorySize / 1024, unaliasedTransientMemorySize / 1024, lazyCount);
+}
+
+void RenderGraph::execute(std::shared_ptr<CommandBuffer> commandBuffer) {
+    if (!compiled) {
+        compile();
+    }
+
+    for (auto& resource : resources) {
+        if (resource.firstUse != -1 && !resource.texture) {
+            Logger::renderer_logger->error("Render graph executed without its texture: {0}",
+                                           resource.name);
+            return;
+        }
+    }
+
+    for (auto& compiledPass : compiledPasses) {
+        recordBarriers(commandBuffer, compiledPass.barrierBatch);
+        passes[compiledPass.pass].record(commandBuffer);
+    }
+
+    recordBarriers(commandBuffer, finalBarriers);
+}
+
+std::shared_ptr<Texture> RenderGraph::getTexture(const std::string& name) {
+    int resource = findResource(name);
+    if (resource == -1) {
+        Logger::renderer_logger->error("Unknown render graph resource: {0}", name);
+        return nullptr;
+    }
+
+    return resources[resource].texture;
+}
+
+VkDeviceSize RenderGraph::getTransientMemorySize() { return transientMemorySize; }
+
+VkDeviceSize RenderGraph::getUnaliasedTransientMemorySize() {
+    return unaliasedTransientMemorySize;
+}
+
+void RenderGraph::recordBarriers(std::shared_ptr<CommandBuffer> commandBuffer,
+                                 const RenderGraphBarrierBatch& barrierBatch) {
+    if (barrierBatch.barriers.empty()) {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    for (auto& barrier : barrierBatch.barriers) {
+        std::shared_ptr<Texture> texture = resources[barrier.resource].texture;
+
+        VkImageSubresourceRange range;
+        range.aspectMask =
+            isDepthFormat(texture->format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        range.baseMipLevel   = 0;
+        range.levelCount     = texture->mipLevels;
+        range.baseArrayLayer = 0;
+        range.layerCount     = texture->arrayLayers;
+
+        VkImageMemoryBarrier imageBarrier = {};
+        imageBarrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.pNext                = nullptr;
+        imageBarrier.srcAccessMask        = barrier.srcAccess;
+        imageBarrier.dstAccessMask        = barrier.dstAccess;
+        imageBarrier.oldLayout            = barrier.oldLayout;
+        imageBarrier.newLayout            = barrier.newLayout;
+        imageBarrier.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image                = texture->image;
+        imageBarrier.subresourceRange     = range;
+        imageBarriers.push_back(imageBarrier);
+    }
+
+    vkCmdPipelineBarrier(commandBuffer->commandBuffer, barrierBatch.srcStages,
+                         barrierBatch.dstStages, 0, 0, nullptr, 0, nullptr,
+                         (uint32_t)imageBarriers.size(), imageBarriers.data());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "GraphicsContext.hpp"
+#include "RenderGraphCompiler.hpp"
+
+// A compiled render graph recorded into a command buffer, with its transients created and bound
+class RenderGraph : public RenderGraphCompiler {
+public:
+    RenderGraph();
+
+    ~RenderGraph();
+
+    // Creates the transient textures of a compiled graph and binds them into shared memory.
+    // Needed before execute whenever the graph has transients
+    void allocate(GraphicsContext* graphicsContext);
+
+    // Records the surviving passes with their barriers, compiling first if needed
+    void execute(std::shared_ptr<CommandBuffer> commandBuffer);
+
+    // Null for a transient until the graph is allocated. Transients must not be used after the
+    // graph is destroyed, their memory goes with it
+    std::shared_ptr<Texture> getTexture(const std::string& name);
+
+    // Memory the transients take once aliased, and what they would take with one allocation each
+    VkDeviceSize getTransientMemorySize();
+
+    VkDeviceSize getUnaliasedTransientMemorySize();
+
+private:
+    void recordBarriers(std::shared_ptr<CommandBuffer> commandBuffer,
+                        const RenderGraphBarrierBatch& barrierBatch);
+
+    GraphicsContext* graphicsContext;
+    std::vector<VmaAllocation> transientAllocations;
+    VkDeviceSize transientMemorySize;
+    VkDeviceSize unaliasedTransientMemorySize;
+};
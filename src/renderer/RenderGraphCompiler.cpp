@@ -0,0 +1,434 @@
+#include "../pch.hpp"
+#include "RenderGraphCompiler.hpp"
+
+#include "Helper/Conversions.hpp"
+#include "../Logger.hpp"
+
+struct UsageState {
+    VkImageLayout layout;
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+};
+
+UsageState usageState(ResourceUsage usage) {
+    switch (usage) {
+    case ResourceUsage::SAMPLED_FRAGMENT:
+        return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT };
+    case ResourceUsage::SAMPLED_COMPUTE:
+        return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT };
+    case ResourceUsage::STORAGE_READ_COMPUTE:
+        return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT };
+    case ResourceUsage::STORAGE_WRITE_COMPUTE:
+        return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_SHADER_WRITE_BIT };
+    case ResourceUsage::COLOR_ATTACHMENT:
+        return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                 VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+    case ResourceUsage::DEPTH_ATTACHMENT:
+        return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                     VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+    case ResourceUsage::TRANSFER_SRC:
+        return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 VK_ACCESS_TRANSFER_READ_BIT };
+    case ResourceUsage::TRANSFER_DST:
+        return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 VK_ACCESS_TRANSFER_WRITE_BIT };
+    }
+
+    return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0 };
+}
+
+VkImageUsageFlags usageFlags(ResourceUsage usage) {
+    switch (usage) {
+    case ResourceUsage::SAMPLED_FRAGMENT:
+    case ResourceUsage::SAMPLED_COMPUTE:
+        return VK_IMAGE_USAGE_SAMPLED_BIT;
+    case ResourceUsage::STORAGE_READ_COMPUTE:
+    case ResourceUsage::STORAGE_WRITE_COMPUTE:
+        return VK_IMAGE_USAGE_STORAGE_BIT;
+    case ResourceUsage::COLOR_ATTACHMENT:
+        return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    case ResourceUsage::DEPTH_ATTACHMENT:
+        return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    case ResourceUsage::TRANSFER_SRC:
+        return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    case ResourceUsage::TRANSFER_DST:
+        return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+
+    return 0;
+}
+
+// What the barriers so far have done to a resource, in execution order
+struct TrackedState {
+    VkImageLayout layout;
+    VkPipelineStageFlags writeStages; // Last write, or the stages that waited on a transition
+    VkAccessFlags writeAccess;        // Not yet made visible to anything
+    VkPipelineStageFlags readStages;  // Reads since the last write
+    VkPipelineStageFlags visibleStages;
+};
+
+// Adds the barrier, if any, that orders an access after everything tracked so far
+void trackAccess(RenderGraphBarrierBatch& batch, uint32_t resource, TrackedState& state,
+                 UsageState usage, bool write) {
+    bool layoutChange = usage.layout != state.layout;
+
+    if (!layoutChange && !write) {
+        // Reads only wait on the last write, and only once per stage
+        if ((state.visibleStages & usage.stages) != usage.stages) {
+            batch.srcStages |= state.writeStages ? state.writeStages
+                                                 : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            batch.dstStages |= usage.stages;
+            batch.barriers.push_back(
+                { resource, state.layout, state.layout, state.writeAccess, usage.access });
+            state.visibleStages |= usage.stages;
+        }
+        state.readStages |= usage.stages;
+        return;
+    }
+
+    // Writes and layout transitions also have to wait for the reads before them
+    VkPipelineStageFlags srcStages = state.writeStages | state.readStages;
+    batch.srcStages |= srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    batch.dstStages |= usage.stages;
+    batch.barriers.push_back(
+        { resource, state.layout, usage.layout, state.writeAccess, usage.access });
+
+    state.layout      = usage.layout;
+    state.writeStages = usage.stages;
+    if (write) {
+        state.writeAccess   = usage.access;
+        state.readStages    = 0;
+        state.visibleStages = 0;
+    } else {
+        state.writeAccess   = 0;
+        state.readStages    = usage.stages;
+        state.visibleStages = usage.stages;
+    }
+}
+
+// Every access of a pass to one resource, tracked as a single access
+struct MergedAccess {
+    uint32_t resource;
+    UsageState usage;
+    bool write;
+};
+
+RenderGraphPass& RenderGraphPass::read(const std::string& resource, ResourceUsage usage) {
+    accesses.push_back({ resource, usage, false });
+
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::write(const std::string& resource, ResourceUsage usage) {
+    accesses.push_back({ resource, usage, true });
+
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::setSideEffects() {
+    sideEffects = true;
+
+    return *this;
+}
+
+RenderGraphCompiler::RenderGraphCompiler() : compiled(false), finalBarriers({ 0, 0, {} }) {}
+
+void RenderGraphCompiler::importTexture(const std::string& name,
+                                        std::shared_ptr<Texture> texture,
+                                        ImageLayout initialLayout) {
+    if (findResource(name) != -1) {
+        Logger::renderer_logger->error("Render graph resource imported twice: {0}", name);
+        return;
+    }
+
+    resources.push_back({ name, texture, helper::getVkImageLayout(initialLayout), false,
+                          ResourceUsage::SAMPLED_FRAGMENT, false, {}, -1, -1, 0 });
+    compiled = false;
+}
+
+void RenderGraphCompiler::createTexture(const std::string& name,
+                                        RenderGraphTextureDescription description) {
+    if (findResource(name) != -1) {
+        Logger::renderer_logger->error("Render graph resource created twice: {0}", name);
+        return;
+    }
+
+    resources.push_back({ name, nullptr, VK_IMAGE_LAYOUT_UNDEFINED, false,
+                          ResourceUsage::SAMPLED_FRAGMENT, true, description, -1, -1, 0 });
+    compiled = false;
+}
+
+void RenderGraphCompiler::exportTexture(const std::string& name, ResourceUsage finalUsage) {
+    int resource = findResource(name);
+    if (resource == -1) {
+        Logger::renderer_logger->error("Exporting unknown render graph resource: {0}", name);
+        return;
+    }
+
+    resources[resource].exported   = true;
+    resources[resource].finalUsage = finalUsage;
+    compiled                       = false;
+}
+
+RenderGraphPass&
+RenderGraphCompiler::addPass(const std::string& name,
+                             std::function<void(std::shared_ptr<CommandBuffer>)> record) {
+    passes.push_back({ name, {}, record, false });
+    compiled = false;
+
+    return passes.back();
+}
+
+bool RenderGraphCompiler::compile() {
+    compiledPasses.clear();
+    finalBarriers = { 0, 0, {} };
+
+    bool valid = true;
+
+    // Contents are only defined once written, so a pass reading a transient or an UNDEFINED
+    // import before any earlier pass wrote it was declared before its producer
+    std::vector<bool> writtenResources(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        writtenResources[i] = resources[i].initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    for (auto& pass : passes) {
+        for (auto& access : pass.accesses) {
+            int resource = findResource(access.resource);
+            if (resource != -1 && !access.write && !writtenResources[resource]) {
+                Logger::renderer_logger->error(
+                    "Render graph pass {0} reads {1} before any pass writes it", pass.name,
+                    access.resource);
+                valid = false;
+            }
+        }
+        for (auto& access : pass.accesses) {
+            int resource = findResource(access.resource);
+            if (resource != -1 && access.write) {
+                writtenResources[resource] = true;
+            }
+        }
+    }
+
+    // Walking backwards, a pass is needed when it writes something a later needed pass reads or
+    // that is exported. Writes are treated as partial, so they never end an earlier write's life
+    std::vector<bool> liveResources(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        liveResources[i] = resources[i].exported;
+    }
+
+    std::vector<bool> neededPasses(passes.size(), false);
+    for (int passIndex = (int)passes.size() - 1; passIndex >= 0; passIndex--) {
+        RenderGraphPass& pass = passes[passIndex];
+
+        bool needed = pass.sideEffects;
+        for (auto& access : pass.accesses) {
+            int resource = findResource(access.resource);
+            if (resource != -1 && access.write && liveResources[resource]) {
+                needed = true;
+            }
+        }
+
+        if (!needed) {
+            Logger::renderer_logger->debug("Culled render graph pass: {0}", pass.name);
+            continue;
+        }
+
+        neededPasses[passIndex] = true;
+        for (auto& access : pass.accesses) {
+            int resource = findResource(access.resource);
+            if (resource != -1 && !access.write) {
+                liveResources[resource] = true;
+            }
+        }
+    }
+
+    // Lifetimes over the surviving passes, exported textures live until the end of the graph
+    int compiledPassIndex = 0;
+    for (auto& resource : resources) {
+        resource.firstUse   = -1;
+        resource.lastUse    = -1;
+        resource.usageFlags = resource.exported ? usageFlags(resource.finalUsage) : 0;
+    }
+    for (uint32_t passIndex = 0; passIndex < passes.size(); passIndex++) {
+        if (!neededPasses[passIndex]) {
+            continue;
+        }
+
+        for (auto& access : passes[passIndex].accesses) {
+            int resource = findResource(access.resource);
+            if (resource == -1) {
+                continue;
+            }
+
+            if (resources[resource].firstUse == -1) {
+                resources[resource].firstUse = compiledPassIndex;
+            }
+            resources[resource].lastUse = compiledPassIndex;
+            resources[resource].usageFlags |= usageFlags(access.usage);
+        }
+        compiledPassIndex++;
+    }
+    for (auto& resource : resources) {
+        if (resource.exported && resource.firstUse != -1) {
+            resource.lastUse = compiledPassIndex;
+        }
+    }
+
+    // Imported contents are complete, so they are visible to every stage until written again
+    std::vector<TrackedState> states;
+    for (auto& resource : resources) {
+        states.push_back({ resource.initialLayout, 0, 0, 0, ~VkPipelineStageFlags(0) });
+    }
+
+    // Declaration order respects every read and write hazard when the check above passed, culling
+    // only removes passes that nothing depends on, so it stays a valid execution order
+    size_t barrierCount = 0;
+    for (uint32_t passIndex = 0; passIndex < passes.size(); passIndex++) {
+        if (!neededPasses[passIndex]) {
+            continue;
+        }
+
+        // A pass reading and writing the same texture gets one barrier covering both
+        std::vector<MergedAccess> mergedAccesses;
+        for (auto& access : passes[passIndex].accesses) {
+            int resource = findResource(access.resource);
+            if (resource == -1) {
+                Logger::renderer_logger->error("Render graph pass {0} uses unknown resource: {1}",
+                                               passes[passIndex].name, access.resource);
+                valid = false;
+                continue;
+            }
+
+            UsageState usage = usageState(access.usage);
+            auto merged      = std::find_if(mergedAccesses.begin(), mergedAccesses.end(),
+                                            [&](const MergedAccess& mergedAccess) {
+                                                return mergedAccess.resource == (uint32_t)resource;
+                                            });
+            if (merged == mergedAccesses.end()) {
+                mergedAccesses.push_back({ (uint32_t)resource, usage, access.write });
+                continue;
+            }
+
+            if (merged->usage.layout != usage.layout) {
+                Logger::renderer_logger->error(
+                    "Render graph pass {0} uses {1} in two layouts, keeping the first",
+                    passes[passIndex].name, access.resource);
+                valid = false;
+            }
+            merged->usage.stages |= usage.stages;
+            merged->usage.access |= usage.access;
+            merged->write = merged->write || access.write;
+        }
+
+        CompiledRenderGraphPass compiledPass = { passIndex, { 0, 0, {} } };
+        int currentPass                      = (int)compiledPasses.size();
+        for (auto& access : mergedAccesses) {
+            uint32_t resource = access.resource;
+
+            // A transient may be placed over any transient that is already dead, its first use
+            // waits on their last ones as if they were earlier writes of the same image
+            if (resources[resource].transient && resources[resource].firstUse == currentPass &&
+                states[resource].layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+                for (uint32_t other = 0; other < resources.size(); other++) {
+                    if (resources[other].transient && resources[other].lastUse != -1 &&
+                        resources[other].lastUse < currentPass) {
+                        states[resource].writeStages |=
+                            states[other].writeStages | states[other].readStages;
+                        states[resource].writeAccess |= states[other].writeAccess;
+                    }
+                }
+            }
+
+            trackAccess(compiledPass.barrierBatch, resource, states[resource], access.usage,
+                        access.write);
+        }
+
+        barrierCount += compiledPass.barrierBatch.barriers.size();
+        compiledPasses.push_back(compiledPass);
+    }
+
+    for (uint32_t resource = 0; resource < resources.size(); resource++) {
+        if (resources[resource].exported) {
+            trackAccess(finalBarriers, resource, states[resource],
+                        usageState(resources[resource].finalUsage), false);
+        }
+    }
+    barrierCount += finalBarriers.barriers.size();
+
+    Logger::renderer_logger->debug("Compiled render graph: {0} of {1} passes, {2} barriers",
+                                   compiledPasses.size(), passes.size(), barrierCount);
+
+    compiled = true;
+
+    return valid;
+}
+
+const std::vector<CompiledRenderGraphPass>& RenderGraphCompiler::getCompiledPasses() {
+    return compiledPasses;
+}
+
+const RenderGraphBarrierBatch& RenderGraphCompiler::getFinalBarriers() { return finalBarriers; }
+
+const RenderGraphResource* RenderGraphCompiler::getResource(const std::string& name) {
+    int resource = findResource(name);
+
+    return resource == -1 ? nullptr : &resources[resource];
+}
+
+VkMemoryRequirements
+RenderGraphCompiler::placeTransients(std::vector<RenderGraphPlacement>& placements) {
+    std::sort(placements.begin(), placements.end(),
+              [](const RenderGraphPlacement& a, const RenderGraphPlacement& b) {
+                  return a.requirements.size > b.requirements.size;
+              });
+
+    VkMemoryRequirements blockRequirements = { 0, 1, ~0u };
+    for (size_t i = 0; i < placements.size(); i++) {
+        RenderGraphResource& graphResource = resources[placements[i].resource];
+
+        VkDeviceSize alignment = placements[i].requirements.alignment;
+        VkDeviceSize offset    = 0;
+        bool moved             = true;
+        while (moved) {
+            moved = false;
+            for (size_t j = 0; j < i; j++) {
+                RenderGraphResource& placedResource = resources[placements[j].resource];
+                bool livesOverlap = graphResource.firstUse <= placedResource.lastUse &&
+                                    placedResource.firstUse <= graphResource.lastUse;
+                VkDeviceSize placedEnd = placements[j].offset + placements[j].requirements.size;
+                VkDeviceSize end       = offset + placements[i].requirements.size;
+                bool memoryOverlaps    = offset < placedEnd && placements[j].offset < end;
+                if (livesOverlap && memoryOverlaps) {
+                    offset = (placedEnd + alignment - 1) / alignment * alignment;
+                    moved  = true;
+                }
+            }
+        }
+
+        placements[i].offset = offset;
+        blockRequirements.size =
+            std::max(blockRequirements.size, offset + placements[i].requirements.size);
+        blockRequirements.alignment = std::max(blockRequirements.alignment, alignment);
+        blockRequirements.memoryTypeBits &= placements[i].requirements.memoryTypeBits;
+    }
+
+    return blockRequirements;
+}
+
+int RenderGraphCompiler::findResource(const std::string& name) {
+    for (int i = 0; i < resources.size(); i++) {
+        if (resources[i].name == name) {
+            return i;
+        }
+    }
+
+    return -1;
+}
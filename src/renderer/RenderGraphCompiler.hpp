@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../pch.hpp"
+
+#include "Types/Commands.hpp"
+#include "Types/Renderpass.hpp"
+
+// How a pass touches a texture, decides the layout, stages and access masks of its barriers
+enum class ResourceUsage {
+    SAMPLED_FRAGMENT,
+    SAMPLED_COMPUTE,
+    STORAGE_READ_COMPUTE,
+    STORAGE_WRITE_COMPUTE,
+    COLOR_ATTACHMENT,
+    DEPTH_ATTACHMENT,
+    TRANSFER_SRC,
+    TRANSFER_DST
+};
+
+struct RenderGraphAccess {
+    std::string resource;
+    ResourceUsage usage;
+    bool write;
+};
+
+struct RenderGraphPass {
+    std::string name;
+    std::vector<RenderGraphAccess> accesses;
+    std::function<void(std::shared_ptr<CommandBuffer>)> record;
+    bool sideEffects;
+
+    RenderGraphPass& read(const std::string& resource, ResourceUsage usage);
+
+    RenderGraphPass& write(const std::string& resource, ResourceUsage usage);
+
+    // Keeps the pass even when nothing exported depends on its writes
+    RenderGraphPass& setSideEffects();
+};
+
+struct RenderGraphTextureDescription {
+    Format format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t arrayLayers;
+};
+
+struct RenderGraphResource {
+    std::string name;
+    std::shared_ptr<Texture> texture;
+    VkImageLayout initialLayout;
+    bool exported;
+    ResourceUsage finalUsage;
+
+    bool transient;
+    RenderGraphTextureDescription description;
+
+    // Compiled pass indices of the first and last use, -1 when no surviving pass uses it
+    int firstUse;
+    int lastUse;
+    VkImageUsageFlags usageFlags;
+};
+
+struct RenderGraphBarrier {
+    uint32_t resource;
+    VkImageLayout oldLayout;
+    VkImageLayout newLayout;
+    VkAccessFlags srcAccess;
+    VkAccessFlags dstAccess;
+};
+
+// Everything a pass waits on, recorded as a single vkCmdPipelineBarrier
+struct RenderGraphBarrierBatch {
+    VkPipelineStageFlags srcStages;
+    VkPipelineStageFlags dstStages;
+    std::vector<RenderGraphBarrier> barriers;
+};
+
+struct CompiledRenderGraphPass {
+    uint32_t pass;
+    RenderGraphBarrierBatch barrierBatch;
+};
+
+// Where a transient goes in the memory the aliased transients share
+struct RenderGraphPlacement {
+    uint32_t resource;
+    VkMemoryRequirements requirements;
+    VkDeviceSize offset;
+};
+
+// Passes declare the named textures they read and write, the graph works out which passes are
+// needed, the barriers between them and how long each transient lives. Only touches CPU state, so
+// a graph can be compiled and inspected without a device, RenderGraph adds the GPU side
+class RenderGraphCompiler {
+public:
+    RenderGraphCompiler();
+
+    // The texture is assumed to be in initialLayout with every earlier write already finished,
+    // like after an immediateSubmit. UNDEFINED discards the contents
+    void importTexture(const std::string& name, std::shared_ptr<Texture> texture,
+                       ImageLayout initialLayout);
+
+    // A texture owned by the graph that only exists between its first and last use. Transients
+    // whose lifetimes don't overlap are placed in the same memory
+    void createTexture(const std::string& name, RenderGraphTextureDescription description);
+
+    // Marks a texture as a result of the graph, it is left ready for finalUsage once executed
+    void exportTexture(const std::string& name, ResourceUsage finalUsage);
+
+    // Passes run in the order they are added, minus the ones culled for having no effect
+    RenderGraphPass& addPass(const std::string& name,
+                             std::function<void(std::shared_ptr<CommandBuffer>)> record);
+
+    // Returns false, after logging why, when a pass reads a texture before any earlier pass
+    // writes it, uses one in two layouts or uses an unknown one. The graph compiles regardless
+    bool compile();
+
+    const std::vector<CompiledRenderGraphPass>& getCompiledPasses();
+
+    // Moves exported textures into the state of their final usage after the last pass
+    const RenderGraphBarrierBatch& getFinalBarriers();
+
+    // Null when no resource has the name
+    const RenderGraphResource* getResource(const std::string& name);
+
+    // Sets the offsets of compiled transients in one block. Largest first, each goes at the lowest
+    // offset that doesn't overlap the memory of a placed transient whose lifetime overlaps its own.
+    // Returns what the block needs, a memoryTypeBits of zero when they share no memory type
+    VkMemoryRequirements placeTransients(std::vector<RenderGraphPlacement>& placements);
+
+protected:
+    int findResource(const std::string& name);
+
+    std::vector<RenderGraphResource> resources;
+    std::deque<RenderGraphPass> passes;
+
+    bool compiled;
+    std::vector<CompiledRenderGraphPass> compiledPasses;
+    RenderGraphBarrierBatch finalBarriers;
+};
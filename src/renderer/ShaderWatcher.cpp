@@ -0,0 +1,168 @@
+#include "../pch.hpp"
+#include "ShaderWatcher.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "../Logger.hpp"
+
+bool isShaderSource(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+
+    return extension == ".vert" || extension == ".frag" || extension == ".comp";
+}
+
+ShaderWatcher::ShaderWatcher(std::string directory, ShaderCompileOptions compileOptions)
+    : directory(directory), compileOptions(compileOptions), running(true) {
+#ifdef __linux__
+    inotifyFd       = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watchDescriptor = -1;
+    if (inotifyFd < 0) {
+        Logger::renderer_logger->error("Failed to initialize inotify, shader hot reload disabled");
+        running = false;
+        return;
+    }
+
+    // Editors often save through a temporary file and a rename, so watch the directory rather than
+    // the individual files
+    watchDescriptor = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watchDescriptor < 0) {
+        Logger::renderer_logger->error("Failed to watch shader directory: {0}", directory);
+        running = false;
+        return;
+    }
+#else
+    // Included files are not shader sources, so every file is watched
+    for (auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file()) {
+            lastWriteTimes[entry.path().string()] = entry.last_write_time();
+        }
+    }
+#endif
+
+    Logger::renderer_logger->info("Watching shader directory for changes: {0}", directory);
+
+    thread = std::thread(&ShaderWatcher::watch, this);
+}
+
+ShaderWatcher::~ShaderWatcher() {
+    Logger::renderer_logger->info("Destroying Shader Watcher");
+
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        if (watchDescriptor >= 0) {
+            inotify_rm_watch(inotifyFd, watchDescriptor);
+        }
+        close(inotifyFd);
+    }
+#endif
+}
+
+std::vector<CompiledShader> ShaderWatcher::takeCompiledShaders() {
+    std::lock_guard<std::mutex> lock(compiledShadersMutex);
+
+    std::vector<CompiledShader> taken;
+    taken.swap(compiledShaders);
+
+    return taken;
+}
+
+void ShaderWatcher::setIncludedFiles(const std::string& shaderFilePath,
+                                     const std::set<std::string>& includedFiles) {
+    std::lock_guard<std::mutex> lock(includesMutex);
+    includedFilesByShader[helper::normalizeShaderPath(shaderFilePath)] = includedFiles;
+}
+
+std::set<std::string> ShaderWatcher::shadersToCompile(const std::filesystem::path& changedPath) {
+    std::string path = helper::normalizeShaderPath(changedPath.string());
+
+    std::set<std::string> shaders;
+    if (isShaderSource(changedPath)) {
+        shaders.insert(path);
+    }
+
+    std::lock_guard<std::mutex> lock(includesMutex);
+    for (auto& [shader, includedFiles] : includedFilesByShader) {
+        if (includedFiles.count(path)) {
+            shaders.insert(shader);
+        }
+    }
+
+    return shaders;
+}
+
+void ShaderWatcher::watch() {
+    while (running) {
+        std::set<std::string> changedShaders;
+
+#ifdef __linux__
+        pollfd pollInfo = { inotifyFd, POLLIN, 0 };
+        if (poll(&pollInfo, 1, 100) <= 0) {
+            continue;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+
+                if (event->len > 0) {
+                    std::filesystem::path changedPath =
+                        std::filesystem::path(directory) / event->name;
+                    for (auto& shader : shadersToCompile(changedPath)) {
+                        changedShaders.insert(shader);
+                    }
+                }
+
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        for (auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (!entry.is_regular_file()) {
+                continue;
+            }
+
+            std::string path = entry.path().string();
+            auto writeTime   = entry.last_write_time();
+            if (lastWriteTimes[path] != writeTime) {
+                lastWriteTimes[path] = writeTime;
+                for (auto& shader : shadersToCompile(entry.path())) {
+                    changedShaders.insert(shader);
+                }
+            }
+        }
+#endif
+
+        // A single save tends to produce several events, so every changed file is compiled once
+        for (auto& shaderFilePath : changedShaders) {
+            compile(shaderFilePath);
+        }
+    }
+}
+
+void ShaderWatcher::compile(const std::string& shaderFilePath) {
+    Logger::renderer_logger->info("Recompiling shader: {0}", shaderFilePath);
+
+    // The edit may have added or removed includes
+    std::set<std::string> includedFiles;
+    CompiledShader compiledShader;
+    compiledShader.path = helper::normalizeShaderPath(shaderFilePath);
+    compiledShader.spvBytes =
+        helper::compileShaderFile(shaderFilePath.c_str(), compileOptions, &includedFiles);
+    setIncludedFiles(compiledShader.path, includedFiles);
+
+    std::lock_guard<std::mutex> lock(compiledShadersMutex);
+    compiledShaders.push_back(compiledShader);
+}
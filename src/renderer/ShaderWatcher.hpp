@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../pch.hpp"
+
+#include "Helper/ShaderCompiler.hpp"
+
+struct CompiledShader {
+    std::string path;
+    std::vector<uint32_t> spvBytes; // Empty when the compile failed
+};
+
+// Watches a shader directory (inotify on Linux, polling elsewhere) and recompiles changed sources
+// on a background thread, along with the sources that include a changed file. Results are
+// collected on the main thread with takeCompiledShaders
+class ShaderWatcher {
+public:
+    ShaderWatcher(std::string directory, ShaderCompileOptions compileOptions);
+
+    ~ShaderWatcher();
+
+    std::vector<CompiledShader> takeCompiledShaders();
+
+    // The files a shader included when it was last compiled, as helper::compileShaderFile reports
+    // them. Shaders compiled outside of the watcher are registered with it
+    void setIncludedFiles(const std::string& shaderFilePath,
+                          const std::set<std::string>& includedFiles);
+
+private:
+    void watch();
+
+    // The changed file itself if it's a shader source, and every shader that includes it
+    std::set<std::string> shadersToCompile(const std::filesystem::path& changedPath);
+
+    void compile(const std::string& shaderFilePath);
+
+    std::string directory;
+    ShaderCompileOptions compileOptions;
+
+    std::atomic<bool> running;
+    std::thread thread;
+
+    std::mutex compiledShadersMutex;
+    std::vector<CompiledShader> compiledShaders;
+
+    // Normalized paths, from each included file to the shaders that include it
+    std::mutex includesMutex;
+    std::map<std::string, std::set<std::string>> includedFilesByShader;
+
+#ifdef __linux__
+    int inotifyFd;
+    int watchDescriptor;
+#else
+    std::map<std::string, std::filesystem::file_time_type> lastWriteTimes;
+#endif
+};
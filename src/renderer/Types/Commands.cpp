@@ -33,3 +33,11 @@ FrameBasedCommandBuffer::~FrameBasedCommandBuffer() {
         }
     }
 }
+
+FrameBasedSecondaryCommandBuffers::FrameBasedSecondaryCommandBuffers(
+    std::vector<std::array<std::shared_ptr<CommandBuffer>, FRAME_OVERLAP>> threadCommandBuffers)
+    : threadCommandBuffers(threadCommandBuffers) {}
+
+FrameBasedSecondaryCommandBuffers::~FrameBasedSecondaryCommandBuffers() {
+    Logger::renderer_logger->info("Destroying FrameBased Secondary Command Buffers");
+}
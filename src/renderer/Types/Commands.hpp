@@ -26,3 +26,15 @@ struct FrameBasedCommandBuffer {
 
     ~FrameBasedCommandBuffer();
 };
+
+// A secondary command buffer per recording thread and frame in flight. Each has its own pool, so
+// threads never allocate from or reset a pool another thread is using
+struct FrameBasedSecondaryCommandBuffers {
+    std::vector<std::array<std::shared_ptr<CommandBuffer>, FRAME_OVERLAP>> threadCommandBuffers;
+
+    FrameBasedSecondaryCommandBuffers(
+        std::vector<std::array<std::shared_ptr<CommandBuffer>, FRAME_OVERLAP>>
+            threadCommandBuffers);
+
+    ~FrameBasedSecondaryCommandBuffers();
+};
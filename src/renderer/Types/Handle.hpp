@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../../pch.hpp"
+
+// Trivially copyable reference to an object in a HandlePool. The slot's generation goes up every
+// time it is released, so a handle that outlived its object resolves to null rather than to
+// whatever took the slot next. A zeroed handle is never valid
+template <typename T> struct Handle {
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const Handle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Keeps its objects alive until their handle is released. Resolving only reads, so it is safe from
+// several recording threads as long as nothing is inserted or released at the same time
+template <typename T> class HandlePool {
+public:
+    Handle<T> insert(std::shared_ptr<T> object) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = (uint32_t)slots.size();
+            slots.push_back({ nullptr, 1 });
+        }
+
+        slots[index].object = object;
+
+        return { index, slots[index].generation };
+    }
+
+    void release(Handle<T> handle) {
+        if (get(handle) == nullptr) {
+            return;
+        }
+
+        slots[handle.index].object = nullptr;
+        slots[handle.index].generation++;
+        freeSlots.push_back(handle.index);
+    }
+
+    T* get(Handle<T> handle) const {
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+
+        return slots[handle.index].object.get();
+    }
+
+private:
+    struct Slot {
+        std::shared_ptr<T> object;
+        uint32_t generation;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
+
+struct Pipeline;
+struct DescriptorSet;
+struct VertexBuffer;
+
+using PipelineHandle      = Handle<Pipeline>;
+using DescriptorSetHandle = Handle<DescriptorSet>;
+using VertexBufferHandle  = Handle<VertexBuffer>;
@@ -20,20 +20,49 @@ ShaderModule::~ShaderModule() {
 }
 
 Pipeline::Pipeline(VkDevice device, VkPipeline pipeline, VkPipelineLayout layout,
-                   std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
+                   std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+                   std::vector<VkPushConstantRange> pushConstantRanges,
+                   PipelineCreateInfo createInfo)
     : device(device), pipeline(pipeline), layout(layout),
-      descriptorSetLayouts(descriptorSetLayouts) {}
+      descriptorSetLayouts(descriptorSetLayouts), pushConstantRanges(pushConstantRanges),
+      createInfo(createInfo),
+      vertexShaderPath(createInfo.vertexShaderPath),
+      fragmentShaderPath(createInfo.fragmentShaderPath) {
+    this->createInfo.vertexShaderPath   = vertexShaderPath.c_str();
+    this->createInfo.fragmentShaderPath = fragmentShaderPath.c_str();
+}
 
 Pipeline::~Pipeline() {
     Logger::renderer_logger->info("Destroying Pipeline");
 
     if (device != VK_NULL_HANDLE) {
-        for (auto& setLayout : descriptorSetLayouts) {
-            vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        if (pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, pipeline, nullptr);
         }
-        if (layout != VK_NULL_HANDLE) {
-            vkDestroyPipelineLayout(device, layout, nullptr);
+    }
+}
+
+VkShaderStageFlags pushConstantStages(const Pipeline& pipeline, uint32_t offset, uint32_t size) {
+    VkShaderStageFlags stages = 0;
+    for (auto& range : pipeline.pushConstantRanges) {
+        if (range.offset < offset + size && offset < range.offset + range.size) {
+            stages |= range.stageFlags;
         }
+    }
+
+    return stages;
+}
+
+ComputePipeline::ComputePipeline(VkDevice device, VkPipeline pipeline, VkPipelineLayout layout,
+                                 std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+                                 std::string computeShaderPath)
+    : device(device), pipeline(pipeline), layout(layout),
+      descriptorSetLayouts(descriptorSetLayouts), computeShaderPath(computeShaderPath) {}
+
+ComputePipeline::~ComputePipeline() {
+    Logger::renderer_logger->info("Destroying Compute Pipeline");
+
+    if (device != VK_NULL_HANDLE) {
         if (pipeline != VK_NULL_HANDLE) {
             vkDestroyPipeline(device, pipeline, nullptr);
         }
@@ -42,8 +71,9 @@ Pipeline::~Pipeline() {
 
 DescriptorSet::DescriptorSet(VmaAllocator allocator,
                              std::array<VkDescriptorSet, FRAME_OVERLAP> descriptorSets,
-                             VkPipelineLayout pipelineLayout)
-    : allocator(allocator), descriptorSets(descriptorSets), pipelineLayout(pipelineLayout) {}
+                             VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint)
+    : allocator(allocator), descriptorSets(descriptorSets), pipelineLayout(pipelineLayout),
+      bindPoint(bindPoint) {}
 
 DescriptorSet::~DescriptorSet() {
     Logger::renderer_logger->info("Destroying Descriptor Set");
@@ -51,28 +51,80 @@ struct Pipeline { // TODO: Support descriptor sets, push constants, etc.
 
     VkPipeline pipeline;
 
+    // Owned by the layout cache in GraphicsContext
     VkPipelineLayout layout;
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
 
+    // The stages pushed to depend on which shaders declare the bytes being written
+    std::vector<VkPushConstantRange> pushConstantRanges;
+
+    // Kept so the pipeline can be rebuilt in place when one of its shaders is hot reloaded. The
+    // shader paths are copied since the create info only borrows them
+    PipelineCreateInfo createInfo;
+    std::string vertexShaderPath;
+    std::string fragmentShaderPath;
+
     Pipeline(VkDevice device, VkPipeline pipeline, VkPipelineLayout layout,
-             std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+             std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+             std::vector<VkPushConstantRange> pushConstantRanges, PipelineCreateInfo createInfo);
 
     ~Pipeline();
 };
 
-enum class DescriptorType { UNIFORM_BUFFER, STORAGE_BUFFER };
+// Vulkan wants exactly the stages of every range overlapping the pushed bytes, a shader that only
+// runs in one stage can not be pushed to with both
+VkShaderStageFlags pushConstantStages(const Pipeline& pipeline, uint32_t offset, uint32_t size);
+
+struct ComputePipeline {
+    VkDevice device;
+
+    VkPipeline pipeline;
+
+    // Owned by the layout cache in GraphicsContext
+    VkPipelineLayout layout;
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+
+    std::string computeShaderPath;
+
+    ComputePipeline(VkDevice device, VkPipeline pipeline, VkPipelineLayout layout,
+                    std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+                    std::string computeShaderPath);
+
+    ~ComputePipeline();
+};
+
+// An indirect buffer is a storage buffer that draws can also read their parameters from
+enum class DescriptorType { UNIFORM_BUFFER, STORAGE_BUFFER, INDIRECT_BUFFER };
+
+struct DescriptorSet;
+
+// A binding of another set that binds one of this set's buffers
+struct DescriptorBufferShare {
+    std::weak_ptr<DescriptorSet> descriptorSet;
+    uint32_t binding;
+    uint32_t sourceBinding;
+    DescriptorType type;
+    int frameOffset;
+};
 
 struct DescriptorSet {
     VmaAllocator allocator;
 
     std::array<VkDescriptorSet, FRAME_OVERLAP> descriptorSets;
     VkPipelineLayout pipelineLayout;
+    VkPipelineBindPoint bindPoint;
 
     std::array<std::map<unsigned int, VkBuffer>, FRAME_OVERLAP> buffers;
     std::array<std::map<unsigned int, VmaAllocation>, FRAME_OVERLAP> allocations;
+    std::map<unsigned int, uint32_t> bufferSizes;
+
+    // Sets whose buffers are also bound here, kept alive since they own the buffers
+    std::vector<std::shared_ptr<DescriptorSet>> sharedBufferSources;
+    // Rebound when a buffer of this set grows
+    std::vector<DescriptorBufferShare> bufferShares;
 
     DescriptorSet(VmaAllocator allocator, std::array<VkDescriptorSet, FRAME_OVERLAP> descriptorSets,
-                  VkPipelineLayout pipelineLayout);
+                  VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint);
 
     ~DescriptorSet();
 };
@@ -5,9 +5,10 @@
 
 RenderPass::RenderPass(VkDevice device, VmaAllocator allocator, VkRenderPass renderPass,
                        VkFramebuffer framebuffer, std::vector<VkImage> images,
-                       std::vector<VmaAllocation> allocations, std::vector<VkImageView> imageViews)
+                       std::vector<VmaAllocation> allocations, std::vector<VkImageView> imageViews,
+                       std::vector<std::shared_ptr<Texture>> targets)
     : device(device), allocator(allocator), renderPass(renderPass), framebuffer(framebuffer),
-      images(images), allocations(allocations), imageViews(imageViews) {}
+      images(images), allocations(allocations), imageViews(imageViews), targets(targets) {}
 
 RenderPass::~RenderPass() {
     Logger::renderer_logger->info("Destroying RenderPass");
@@ -26,7 +27,9 @@ RenderPass::~RenderPass() {
         }
 
         for (int i = 0; i < images.size(); i++) {
-            vmaDestroyImage(allocator, images[i], allocations[i]);
+            if (allocations[i] != VK_NULL_HANDLE) {
+                vmaDestroyImage(allocator, images[i], allocations[i]);
+            }
         }
     }
 }
\ No newline at end of file
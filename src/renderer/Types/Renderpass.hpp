@@ -1,8 +1,18 @@
 #pragma once
 
+#include "Texture.hpp"
+
 enum class AccessType { SRC, DST };
 
-enum class ImageLayout { UNDEFINED, ATTACHMENT, SHADER_READ, PRESENT, TRANSFER_SRC, TRANSFER_DST };
+enum class ImageLayout {
+    UNDEFINED,
+    ATTACHMENT,
+    SHADER_READ,
+    PRESENT,
+    TRANSFER_SRC,
+    TRANSFER_DST,
+    GENERAL // Storage image access from compute
+};
 
 enum class LoadOp { DONT_CARE, LOAD, CLEAR };
 
@@ -18,7 +28,17 @@ enum class Format {
     RGB16_FLOAT,
     RGB32_FLOAT,
     RGBA16_FLOAT,
-    RGBA32_FLOAT
+    RGBA32_FLOAT,
+    // Unsigned 11 bit red and green and 10 bit blue floats, for HDR colour without alpha
+    B10G11R11_UFLOAT,
+    // Block compressed, only for sampled textures, see createCompressedTexture
+    BC1_UNORM,
+    BC1_SRGB,
+    BC4_UNORM,
+    BC5_UNORM,
+    BC6H_UFLOAT,
+    BC7_UNORM,
+    BC7_SRGB
 };
 
 struct RenderPassAttachmentDescription {
@@ -29,6 +49,11 @@ struct RenderPassAttachmentDescription {
     Format format;
     uint32_t width;
     uint32_t height;
+
+    // Renders straight into one mip of an existing texture instead of an image owned by the render
+    // pass. With multiview each view writes the array layer of the same index
+    std::shared_ptr<Texture> target;
+    uint32_t targetMipLevel;
 };
 
 struct RenderPass {
@@ -42,9 +67,13 @@ struct RenderPass {
     std::vector<VmaAllocation> allocations;
     std::vector<VkImageView> imageViews;
 
+    // Textures rendered into directly, their images have no allocation of their own here
+    std::vector<std::shared_ptr<Texture>> targets;
+
     RenderPass(VkDevice device, VmaAllocator allocator, VkRenderPass renderPass,
                VkFramebuffer framebuffer, std::vector<VkImage> images,
-               std::vector<VmaAllocation> allocations, std::vector<VkImageView> imageViews);
+               std::vector<VmaAllocation> allocations, std::vector<VkImageView> imageViews,
+               std::vector<std::shared_ptr<Texture>> targets);
 
     ~RenderPass();
 };
@@ -4,9 +4,11 @@
 #include "../../Logger.hpp"
 
 Texture::Texture(VkDevice device, VmaAllocator allocator, VmaAllocation allocation, VkImage image,
-                 VkImageView imageView)
+                 VkImageView imageView, VkFormat format, uint32_t width, uint32_t height,
+                 uint32_t mipLevels, uint32_t arrayLayers)
     : device(device), allocator(allocator), allocation(allocation), image(image),
-      imageView(imageView) {}
+      imageView(imageView), format(format), width(width), height(height), mipLevels(mipLevels),
+      arrayLayers(arrayLayers) {}
 
 Texture::~Texture() {
     Logger::renderer_logger->info("Destroying Texture");
@@ -16,9 +18,16 @@ Texture::~Texture() {
             vkDestroyImageView(device, imageView, nullptr);
         }
 
+        for (auto& storageImageView : storageImageViews) {
+            vkDestroyImageView(device, storageImageView.second, nullptr);
+        }
+
         if (allocator != VK_NULL_HANDLE && image != VK_NULL_HANDLE &&
             allocation != VK_NULL_HANDLE) {
             vmaDestroyImage(allocator, image, allocation);
+        } else if (image != VK_NULL_HANDLE) {
+            // Bound into memory owned elsewhere, like render graph transients
+            vkDestroyImage(device, image, nullptr);
         }
     }
 }
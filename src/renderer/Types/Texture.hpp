@@ -8,8 +8,18 @@ struct Texture {
     VkImage image;
     VkImageView imageView;
 
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint32_t arrayLayers;
+
+    // Single mip views over every layer, created the first time a mip is bound as a storage image
+    std::map<uint32_t, VkImageView> storageImageViews;
+
     Texture(VkDevice device, VmaAllocator allocator, VmaAllocation allocation, VkImage image,
-            VkImageView imageView);
+            VkImageView imageView, VkFormat format, uint32_t width, uint32_t height,
+            uint32_t mipLevels, uint32_t arrayLayers);
 
     ~Texture();
 };
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/BlockCompression.hpp"
+#include "../src/renderer/Helper/Pixels.hpp"
+
+#include "Check.hpp"
+
+#include <random>
+
+// Of each kind, the PSNR is over all of them together
+constexpr int BLOCK_COUNT = 64;
+
+// Below them the encoders got worse. A single pair of endpoints can't follow random texels, so the
+// floors of the noise blocks are far lower than those of the gradients
+constexpr double BC1_GRADIENT_PSNR  = 37.0;
+constexpr double BC1_NOISE_PSNR     = 12.0;
+constexpr double BC4_GRADIENT_PSNR  = 45.0;
+constexpr double BC4_NOISE_PSNR     = 26.0;
+constexpr double BC7_GRADIENT_PSNR  = 46.0;
+constexpr double BC7_NOISE_PSNR     = 12.0;
+constexpr double BC6H_GRADIENT_PSNR = 45.0;
+constexpr double BC6H_NOISE_PSNR    = 10.0;
+
+// Of the bright block, whose texels span four octaves between two 10 bit endpoints
+constexpr float BC6H_BRIGHT_RELATIVE_ERROR = 0.08f;
+
+using Block = std::array<std::array<unsigned char, 4>, 16>;
+
+// A ramp in one direction across the block that every channel follows at its own rate, the kind
+// of block photos and normal maps are mostly made of
+std::vector<Block> gradientBlocks(std::mt19937& random) {
+    std::uniform_real_distribution<float> start(0.0f, 255.0f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> rate(-12.0f, 12.0f);
+
+    std::vector<Block> blocks(BLOCK_COUNT);
+    for (Block& block : blocks) {
+        float directionX = direction(random), directionY = direction(random);
+        for (int c = 0; c < 4; c++) {
+            float base = start(random), channelRate = rate(random);
+            for (int i = 0; i < 16; i++) {
+                float along = directionX * (i % 4) + directionY * (i / 4);
+                long value  = std::lround(base + channelRate * along);
+                block[i][c] = (unsigned char)std::clamp(value, 0l, 255l);
+            }
+        }
+    }
+
+    return blocks;
+}
+
+std::vector<Block> noiseBlocks(std::mt19937& random) {
+    std::uniform_int_distribution<int> value(0, 255);
+
+    std::vector<Block> blocks(BLOCK_COUNT);
+    for (Block& block : blocks) {
+        for (auto& texel : block) {
+            for (unsigned char& channel : texel) {
+                channel = (unsigned char)value(random);
+            }
+        }
+    }
+
+    return blocks;
+}
+
+double psnr(double squaredError, size_t valueCount, double peak) {
+    double meanSquaredError = std::max(squaredError / valueCount, 1e-12);
+    return 10.0 * std::log10(peak * peak / meanSquaredError);
+}
+
+// Encodes and decodes every block and compares the channels from first to last
+template <typename Encode, typename Decode>
+double roundTripPSNR(const std::vector<Block>& blocks, size_t blockBytes, int firstChannel,
+                     int lastChannel, Encode encode, Decode decode) {
+    double squaredError = 0.0;
+    for (const Block& block : blocks) {
+        unsigned char texels[16][4];
+        std::memcpy(texels, block.data(), sizeof(texels));
+
+        std::vector<unsigned char> encoded(blockBytes, 0);
+        encode(texels, encoded.data());
+        unsigned char decoded[16][4] = {};
+        decode(encoded.data(), decoded);
+
+        for (int i = 0; i < 16; i++) {
+            for (int c = firstChannel; c <= lastChannel; c++) {
+                double error  = double(decoded[i][c]) - double(texels[i][c]);
+                squaredError += error * error;
+            }
+        }
+    }
+
+    return psnr(squaredError, blocks.size() * 16 * (lastChannel - firstChannel + 1), 255.0);
+}
+
+void testLDRFormats() {
+    std::mt19937 random(5);
+    std::vector<Block> gradients = gradientBlocks(random);
+    std::vector<Block> noise     = noiseBlocks(random);
+
+    auto bc1 = [&](const std::vector<Block>& blocks) {
+        return roundTripPSNR(blocks, 8, 0, 2, helper::encodeBC1, helper::decodeBC1);
+    };
+    CHECK(bc1(gradients) >= BC1_GRADIENT_PSNR);
+    CHECK(bc1(noise) >= BC1_NOISE_PSNR);
+
+    // Each channel on its own, the one given is the one compared
+    for (int channel = 0; channel < 4; channel++) {
+        auto encode = [channel](const unsigned char texels[16][4], unsigned char* block) {
+            helper::encodeBC4(texels, block, channel);
+        };
+        auto decode = [channel](const unsigned char* block, unsigned char texels[16][4]) {
+            helper::decodeBC4(block, texels, channel);
+        };
+        CHECK(roundTripPSNR(gradients, 8, channel, channel, encode, decode) >= BC4_GRADIENT_PSNR);
+        CHECK(roundTripPSNR(noise, 8, channel, channel, encode, decode) >= BC4_NOISE_PSNR);
+    }
+
+    // Two BC4 blocks, so the same floors
+    auto bc5 = [&](const std::vector<Block>& blocks) {
+        return roundTripPSNR(blocks, 16, 0, 1, helper::encodeBC5, helper::decodeBC5);
+    };
+    CHECK(bc5(gradients) >= BC4_GRADIENT_PSNR);
+    CHECK(bc5(noise) >= BC4_NOISE_PSNR);
+
+    auto bc7 = [&](const std::vector<Block>& blocks) {
+        return roundTripPSNR(blocks, 16, 0, 3, helper::encodeBC7, helper::decodeBC7);
+    };
+    CHECK(bc7(gradients) >= BC7_GRADIENT_PSNR);
+    CHECK(bc7(noise) >= BC7_NOISE_PSNR);
+
+    // A single colour comes back exactly from the formats with enough endpoint bits
+    Block solid;
+    for (auto& texel : solid) {
+        texel = { 200, 100, 50, 255 };
+    }
+    auto bc4 = [](const unsigned char texels[16][4], unsigned char* block) {
+        helper::encodeBC4(texels, block);
+    };
+    auto bc4Decode = [](const unsigned char* block, unsigned char texels[16][4]) {
+        helper::decodeBC4(block, texels);
+    };
+    CHECK(roundTripPSNR({ solid }, 8, 0, 0, bc4, bc4Decode) >= 99.0);
+    CHECK(roundTripPSNR({ solid }, 16, 0, 1, helper::encodeBC5, helper::decodeBC5) >= 99.0);
+}
+
+// PSNR of the decoded floats against the encoded ones, peak being the brightest value encoded
+double bc6hRoundTripPSNR(const std::vector<std::array<float, 48>>& blocks) {
+    double squaredError = 0.0;
+    float peak          = 0.0f;
+    for (const auto& block : blocks) {
+        uint16_t texels[16][3];
+        helper::floatToHalf(block.data(), &texels[0][0], 48);
+
+        // What the half floats hold, that's what BC6H starts from
+        float source[48];
+        helper::halfToFloat(&texels[0][0], source, 48);
+
+        unsigned char encoded[16] = {};
+        helper::encodeBC6H(texels, encoded);
+        uint16_t decodedHalves[16][3];
+        helper::decodeBC6H(encoded, decodedHalves);
+        float decoded[48];
+        helper::halfToFloat(&decodedHalves[0][0], decoded, 48);
+
+        for (int i = 0; i < 48; i++) {
+            double error  = double(decoded[i]) - double(source[i]);
+            squaredError += error * error;
+            peak          = std::max(peak, source[i]);
+        }
+    }
+
+    return psnr(squaredError, blocks.size() * 48, peak);
+}
+
+void testBC6H() {
+    std::mt19937 random(11);
+
+    // Light falls off by a factor across the block, so the gradients are ramps of the exponent.
+    // They reach well past 1, like the sky around the sun in an environment map
+    std::uniform_real_distribution<float> start(-2.0f, 4.0f);
+    std::uniform_real_distribution<float> direction(-0.3f, 0.3f);
+    std::vector<std::array<float, 48>> gradients(BLOCK_COUNT);
+    for (auto& block : gradients) {
+        float directionX = direction(random), directionY = direction(random);
+        for (int c = 0; c < 3; c++) {
+            float base = start(random);
+            for (int i = 0; i < 16; i++) {
+                float along      = directionX * (i % 4) + directionY * (i / 4);
+                block[i * 3 + c] = std::exp2(base + along);
+            }
+        }
+    }
+    CHECK(bc6hRoundTripPSNR(gradients) >= BC6H_GRADIENT_PSNR);
+
+    std::uniform_real_distribution<float> value(0.0f, 8.0f);
+    std::vector<std::array<float, 48>> noise(BLOCK_COUNT);
+    for (auto& block : noise) {
+        for (float& channel : block) {
+            channel = value(random);
+        }
+    }
+    CHECK(bc6hRoundTripPSNR(noise) >= BC6H_NOISE_PSNR);
+
+    // Values above 1 keep their magnitude instead of being clamped like a UNORM format would
+    std::array<float, 48> bright;
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            bright[i * 3 + c] = std::exp2(1.0f + 0.2f * i + 0.5f * c);
+        }
+    }
+    uint16_t texels[16][3];
+    helper::floatToHalf(bright.data(), &texels[0][0], 48);
+    unsigned char encoded[16] = {};
+    helper::encodeBC6H(texels, encoded);
+    uint16_t decodedHalves[16][3];
+    helper::decodeBC6H(encoded, decodedHalves);
+    float decoded[48];
+    helper::halfToFloat(&decodedHalves[0][0], decoded, 48);
+
+    float maxRelativeError = 0.0f;
+    for (int i = 0; i < 48; i++) {
+        maxRelativeError = std::max(maxRelativeError, std::abs(decoded[i] - bright[i]) / bright[i]);
+    }
+    CHECK(maxRelativeError <= BC6H_BRIGHT_RELATIVE_ERROR);
+    CHECK(decoded[47] > 16.0f);
+
+    // Negative values become zero
+    std::array<float, 48> negative;
+    negative.fill(-3.0f);
+    helper::floatToHalf(negative.data(), &texels[0][0], 48);
+    std::memset(encoded, 0, sizeof(encoded));
+    helper::encodeBC6H(texels, encoded);
+    helper::decodeBC6H(encoded, decodedHalves);
+    bool allZero = true;
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            allZero = allZero && decodedHalves[i][c] == 0;
+        }
+    }
+    CHECK(allZero);
+}
+
+int main() {
+    testLDRFormats();
+    testBC6H();
+
+    return checkResult("BlockCompressionTest");
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Failed checks are counted instead of ending the test, so one run reports all of them
+inline int checkFailures = 0;
+
+#define CHECK(condition)                                                                     \
+    do {                                                                                     \
+        if (!(condition)) {                                                                  \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);        \
+            checkFailures++;                                                                 \
+        }                                                                                    \
+    } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                              \
+    do {                                                                                     \
+        double checkActual   = (double)(actual);                                             \
+        double checkExpected = (double)(expected);                                           \
+        if (!(std::abs(checkActual - checkExpected) <= (double)(tolerance))) {               \
+            std::printf("%s:%d: check failed: %s is %g, expected %g within %g\n", __FILE__,  \
+                        __LINE__, #actual, checkActual, checkExpected, (double)(tolerance)); \
+            checkFailures++;                                                                 \
+        }                                                                                    \
+    } while (false)
+
+// The exit code of the test, non zero when any check failed
+inline int checkResult(const char* test) {
+    if (checkFailures > 0) {
+        std::printf("%s: %d checks failed\n", test, checkFailures);
+        return 1;
+    }
+
+    std::printf("%s: passed\n", test);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/Culling.hpp"
+
+#include "Check.hpp"
+
+// Not a multiple of the SIMD widths, so the scalar loop finishes every path
+constexpr uint32_t OBJECT_COUNT = 10007;
+
+// Spheres placed right against each frustum plane, where the paths would disagree first
+constexpr uint32_t TANGENT_COUNT = 600;
+
+std::vector<CullObject> randomObjects(std::mt19937& random) {
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+    std::uniform_real_distribution<float> radius(0.01f, 3.0f);
+
+    std::vector<CullObject> objects(OBJECT_COUNT);
+    for (CullObject& object : objects) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f),
+                                         glm::vec3(position(random), position(random),
+                                                   position(random)));
+        model = glm::scale(model, glm::vec3(scale(random), scale(random), scale(random)));
+
+        object.model          = model;
+        object.boundingSphere = glm::vec4(position(random) * 0.01f, position(random) * 0.01f,
+                                          position(random) * 0.01f, radius(random));
+    }
+
+    return objects;
+}
+
+// Untransformed, so the world sphere is the bounding sphere exactly. Each sits just inside, on or
+// just outside one of the planes
+std::vector<CullObject> tangentObjects(std::mt19937& random,
+                                       const std::array<glm::vec4, 6>& planes) {
+    std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> radius(0.01f, 2.0f);
+    // Units in the last place the center is moved by
+    std::uniform_int_distribution<int> nudge(-2, 2);
+
+    std::vector<CullObject> objects(TANGENT_COUNT);
+    for (uint32_t i = 0; i < TANGENT_COUNT; i++) {
+        const glm::vec4& plane = planes[i % 6];
+        glm::vec3 normal       = glm::vec3(plane);
+
+        // Onto the plane, then moved out by the radius
+        glm::vec3 point(position(random), position(random), -position(random) - 25.0f);
+        point -= normal * (glm::dot(normal, point) + plane.w);
+        float sphereRadius = radius(random);
+        glm::vec3 center   = point - normal * sphereRadius;
+        for (int c = 0; c < 3; c++) {
+            int steps = nudge(random);
+            for (int step = 0; step < std::abs(steps); step++) {
+                center[c] = std::nextafter(center[c], (steps > 0) ? INFINITY : -INFINITY);
+            }
+        }
+
+        objects[i].model          = glm::mat4(1.0f);
+        objects[i].boundingSphere = glm::vec4(center, sphereRadius);
+    }
+
+    return objects;
+}
+
+void testPathsMatchSphereInFrustum() {
+    std::mt19937 random(11);
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view       = glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f, 0.0f, -20.0f),
+                                       glm::vec3(0.0f, 1.0f, 0.0f));
+    std::array<glm::vec4, 6> planes = helper::frustumPlanes(projection * view);
+
+    std::vector<CullObject> objects = randomObjects(random);
+    std::vector<CullObject> tangent = tangentObjects(random, planes);
+    objects.insert(objects.end(), tangent.begin(), tangent.end());
+    uint32_t objectCount = (uint32_t)objects.size();
+
+    CullSpheres spheres;
+    spheres.centerX.resize(objectCount);
+    spheres.centerY.resize(objectCount);
+    spheres.centerZ.resize(objectCount);
+    spheres.radius.resize(objectCount);
+    helper::worldSpheres(objects, 0, objectCount, spheres);
+
+    // Whole, and starting and ending off the SIMD widths
+    for (auto [first, count] : { std::pair<uint32_t, uint32_t>(0, objectCount),
+                                 std::pair<uint32_t, uint32_t>(5, objectCount - 12) }) {
+        std::vector<uint32_t> expected;
+        for (uint32_t i = first; i < first + count; i++) {
+            if (helper::sphereInFrustum(planes, objects[i].model, objects[i].boundingSphere)) {
+                expected.push_back(i);
+            }
+        }
+        CHECK(!expected.empty() && expected.size() < count);
+
+        for (CullInstructions instructions :
+             { CullInstructions::SCALAR, CullInstructions::SSE, CullInstructions::AVX2 }) {
+            if (instructions > helper::supportedCullInstructions()) {
+                continue;
+            }
+
+            std::vector<uint32_t> visible;
+            helper::cullSpheres(spheres, planes, first, count, visible, instructions);
+            CHECK(visible == expected);
+        }
+    }
+
+    // The tangent spheres land on both sides
+    uint32_t tangentVisible = 0;
+    for (uint32_t i = OBJECT_COUNT; i < objectCount; i++) {
+        if (helper::sphereInFrustum(planes, objects[i].model, objects[i].boundingSphere)) {
+            tangentVisible++;
+        }
+    }
+    CHECK(tangentVisible > 0 && tangentVisible < TANGENT_COUNT);
+}
+
+int main() {
+    testPathsMatchSphereInFrustum();
+
+    return checkResult("CullingTest");
+}
@@ -0,0 +1,121 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/Batching.hpp"
+
+#include "Check.hpp"
+
+CullObject batchObject(uint32_t meshIndex, uint32_t materialIndex) {
+    CullObject object    = {};
+    object.meshIndex     = meshIndex;
+    object.materialIndex = materialIndex;
+    return object;
+}
+
+void testKeys() {
+    CHECK(helper::drawBatchKey(batchObject(5, 2)) == ((2ull << 32) | 5));
+
+    // The material outweighs any mesh
+    CHECK(helper::drawBatchKey(batchObject(1000000, 1)) < helper::drawBatchKey(batchObject(0, 2)));
+    CHECK(helper::drawBatchKey(batchObject(3, 7)) < helper::drawBatchKey(batchObject(4, 7)));
+    CHECK(helper::drawBatchKey(batchObject(0xFFFFFFFF, 0)) <
+          helper::drawBatchKey(batchObject(0, 1)));
+}
+
+void testBatches() {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint32_t> mesh(0, 6);
+    std::uniform_int_distribution<uint32_t> material(0, 4);
+
+    std::vector<CullObject> objects;
+    for (int i = 0; i < 5000; i++) {
+        objects.push_back(batchObject(mesh(random), material(random)));
+    }
+
+    // Every third object culled
+    std::vector<uint32_t> visibleIndices;
+    for (uint32_t i = 0; i < objects.size(); i++) {
+        if (i % 3 != 0) {
+            visibleIndices.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> sortedObjects;
+    std::vector<DrawBatch> batches;
+    std::vector<uint64_t> keys, keyScratch;
+    std::vector<uint32_t> objectScratch;
+    helper::buildDrawBatches(objects, visibleIndices, sortedObjects, batches, keys, keyScratch,
+                             objectScratch);
+
+    // The visible objects, each once
+    std::vector<uint32_t> sortedIndices = sortedObjects;
+    std::sort(sortedIndices.begin(), sortedIndices.end());
+    CHECK(sortedIndices == visibleIndices);
+
+    // The batches cover sortedObjects back to back, with a key each, ascending
+    CHECK(batches.size() <= 7 * 5);
+    uint32_t nextInstance = 0;
+    for (size_t b = 0; b < batches.size(); b++) {
+        const DrawBatch& batch = batches[b];
+        CHECK(batch.firstInstance == nextInstance);
+        CHECK(batch.instanceCount > 0);
+        nextInstance += batch.instanceCount;
+
+        if (b > 0) {
+            const DrawBatch& previous = batches[b - 1];
+            CHECK(batch.materialIndex > previous.materialIndex ||
+                  (batch.materialIndex == previous.materialIndex &&
+                   batch.meshIndex > previous.meshIndex));
+        }
+
+        for (uint32_t i = batch.firstInstance; i < nextInstance; i++) {
+            const CullObject& object = objects[sortedObjects[i]];
+            CHECK(object.meshIndex == batch.meshIndex);
+            CHECK(object.materialIndex == batch.materialIndex);
+
+            // Stable, the visible indices came in ascending
+            if (i > batch.firstInstance) {
+                CHECK(sortedObjects[i] > sortedObjects[i - 1]);
+            }
+        }
+    }
+    CHECK(nextInstance == visibleIndices.size());
+}
+
+void testEdgeCases() {
+    std::vector<uint32_t> sortedObjects;
+    std::vector<DrawBatch> batches;
+    std::vector<uint64_t> keys, keyScratch;
+    std::vector<uint32_t> objectScratch;
+
+    std::vector<CullObject> objects = { batchObject(1, 1), batchObject(0, 3), batchObject(1, 1) };
+
+    // Nothing visible leaves no batches behind from an earlier call
+    helper::buildDrawBatches(objects, { 0, 1, 2 }, sortedObjects, batches, keys, keyScratch,
+                             objectScratch);
+    CHECK(batches.size() == 2);
+    helper::buildDrawBatches(objects, {}, sortedObjects, batches, keys, keyScratch, objectScratch);
+    CHECK(batches.empty());
+    CHECK(sortedObjects.empty());
+
+    helper::buildDrawBatches(objects, { 2 }, sortedObjects, batches, keys, keyScratch,
+                             objectScratch);
+    CHECK(batches.size() == 1);
+    CHECK(batches[0].meshIndex == 1 && batches[0].materialIndex == 1);
+    CHECK(batches[0].firstInstance == 0 && batches[0].instanceCount == 1);
+    CHECK(sortedObjects == std::vector<uint32_t>{ 2 });
+
+    // Visible order needn't be ascending, the batch keeps it
+    helper::buildDrawBatches(objects, { 2, 1, 0 }, sortedObjects, batches, keys, keyScratch,
+                             objectScratch);
+    CHECK(batches.size() == 2);
+    CHECK(sortedObjects == (std::vector<uint32_t>{ 2, 0, 1 }));
+    CHECK(batches[0].instanceCount == 2 && batches[1].firstInstance == 2);
+}
+
+int main() {
+    testKeys();
+    testBatches();
+    testEdgeCases();
+
+    return checkResult("DrawBatchingTest");
+}
@@ -0,0 +1,127 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/GPUCuller.hpp"
+#include "../src/renderer/GraphicsContext.hpp"
+#include "../src/renderer/Helper/Culling.hpp"
+#include "../src/Logger.hpp"
+
+#include "Check.hpp"
+
+// Not a multiple of the workgroup size, so the last workgroup is partly out of range
+constexpr uint32_t OBJECT_COUNT = 3001;
+
+// Enough for every frame's buffers to have been read back at least once
+constexpr uint32_t FRAMES = 2 * FRAME_OVERLAP + 1;
+
+std::vector<CullObject> randomObjects(std::mt19937& random, uint32_t meshCount) {
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+    std::uniform_real_distribution<float> radius(0.01f, 3.0f);
+    std::uniform_int_distribution<uint32_t> mesh(0, meshCount - 1);
+
+    std::vector<CullObject> objects(OBJECT_COUNT);
+    for (CullObject& object : objects) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f),
+                                         glm::vec3(position(random), position(random),
+                                                   position(random)));
+        model = glm::scale(model, glm::vec3(scale(random), scale(random), scale(random)));
+
+        object.model          = model;
+        object.boundingSphere = glm::vec4(position(random) * 0.01f, position(random) * 0.01f,
+                                          position(random) * 0.01f, radius(random));
+        object.meshIndex      = mesh(random);
+    }
+
+    return objects;
+}
+
+bool sameDraw(const VkDrawIndirectCommand& a, const VkDrawIndirectCommand& b) {
+    return a.vertexCount == b.vertexCount && a.instanceCount == b.instanceCount &&
+           a.firstVertex == b.firstVertex && a.firstInstance == b.firstInstance;
+}
+
+// Runs cull.comp through GPUCuller for a few frames of the same objects and compares the draws of
+// both phases with helper::cullObjects. Nothing is drawn, so the depth pyramid stays at the far
+// plane and occludes nothing, which makes the frustum test the whole result. Needs a device, a
+// software one like lavapipe works too
+int main() {
+    Logger::init();
+
+    auto graphicsContext = GraphicsContext::createHeadless(640, 360);
+
+    auto renderFence      = graphicsContext->createFrameBasedFence(false);
+    auto renderSemaphore  = graphicsContext->createFrameBasedSemaphore();
+    auto presentSemaphore = graphicsContext->createFrameBasedSemaphore();
+    auto commandBuffer    = graphicsContext->createFrameBasedCommandBuffer();
+
+    std::vector<CullMesh> meshes = { { 36, 0 }, { 240, 36 }, { 6, 276 } };
+
+    std::mt19937 random(5);
+    std::vector<CullObject> objects = randomObjects(random, (uint32_t)meshes.size());
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view       = glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f, 0.0f, -20.0f),
+                                       glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    std::vector<VkDrawIndirectCommand> expected =
+        helper::cullObjects(objects, meshes, helper::frustumPlanes(viewProjection));
+
+    // Only the object buffer of the set is used, cull.comp's own layout has it at binding 0.
+    // Starts out too small, so the buffers grow during the first frame
+    auto objectsPipeline      = graphicsContext->createComputePipeline("assets/shaders/cull.comp");
+    auto objectsDescriptorSet = graphicsContext->createDescriptorSet(objectsPipeline, 0);
+    GPUCuller gpuCuller(graphicsContext.get(), objectsDescriptorSet, 0, 64, meshes);
+
+    glm::vec4 clearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    for (uint32_t frame = 0; frame < FRAMES; frame++) {
+        uint32_t frameIndex = graphicsContext->newFrame(presentSemaphore);
+
+        // What this frame's buffers held the last time, the same objects culled the same way
+        if (frame >= FRAME_OVERLAP) {
+            std::vector<VkDrawIndirectCommand> draws = gpuCuller.readBackDraws();
+
+            CHECK(draws.size() == expected.size());
+            bool drawsMatch = draws.size() == expected.size();
+            for (size_t i = 0; drawsMatch && i < draws.size(); i++) {
+                drawsMatch = sameDraw(draws[i], expected[i]);
+            }
+            CHECK(drawsMatch);
+        }
+
+        graphicsContext->beginRecording(commandBuffer);
+        gpuCuller.cull(commandBuffer, objects, viewProjection);
+        graphicsContext->beginSwapchainRenderPass(commandBuffer, frameIndex, clearColor);
+        gpuCuller.draw(commandBuffer);
+        graphicsContext->endRenderPass(commandBuffer);
+        graphicsContext->buildDepthPyramid(commandBuffer);
+        gpuCuller.cullLate(commandBuffer);
+        graphicsContext->continueSwapchainRenderPass(commandBuffer, frameIndex);
+        gpuCuller.drawLate(commandBuffer);
+        graphicsContext->endRenderPass(commandBuffer);
+        graphicsContext->endRecording(commandBuffer);
+
+        graphicsContext->submit(commandBuffer, presentSemaphore, renderSemaphore, renderFence);
+        graphicsContext->present(frameIndex, renderSemaphore);
+
+        // present moved on to the next frame, the fence is the one of the frame just drawn
+        graphicsContext->waitOnFence(renderFence, -1);
+    }
+
+    // Read back by the cull of the last frame
+    GPUCullStats stats = gpuCuller.getStats();
+    CHECK(stats.objectCount == OBJECT_COUNT);
+    CHECK(stats.frustumVisibleCount == expected.size());
+    CHECK(stats.occludedCount == 0);
+    CHECK(stats.earlyDrawCount + stats.lateDrawCount == expected.size());
+
+    // Every later frame draws the same objects early, they were visible the frame before
+    CHECK(stats.lateDrawCount == 0);
+
+    // Some of each, or the comparison says little
+    CHECK(!expected.empty() && expected.size() < OBJECT_COUNT);
+
+    graphicsContext->waitIdle();
+
+    return checkResult("GPUCullingTest");
+}
@@ -0,0 +1,89 @@
+// mesh.cpp's glTF loader needs them, main.cpp defines them for the application
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "../src/pch.hpp"
+
+#include "../src/renderer/GraphicsContext.hpp"
+#include "../src/renderer/IBLBaker.hpp"
+#include "../src/Logger.hpp"
+
+#include "Check.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+constexpr int EQUIRECTANGULAR_WIDTH  = 256;
+constexpr int EQUIRECTANGULAR_HEIGHT = 128;
+
+// A sky over a ground with a warm horizon and a broad bright patch above one, brighter than one
+// like a real HDR but smooth enough that where a texel center lands doesn't decide the result
+std::vector<float> syntheticEquirectangular() {
+    std::vector<float> pixels(EQUIRECTANGULAR_WIDTH * EQUIRECTANGULAR_HEIGHT * 4);
+    for (int y = 0; y < EQUIRECTANGULAR_HEIGHT; y++) {
+        float theta = glm::pi<float>() * (y + 0.5f) / EQUIRECTANGULAR_HEIGHT;
+        float up    = std::cos(theta);
+        for (int x = 0; x < EQUIRECTANGULAR_WIDTH; x++) {
+            float phi = glm::two_pi<float>() * (x + 0.5f) / EQUIRECTANGULAR_WIDTH;
+
+            glm::vec3 sky      = glm::vec3(0.3f, 0.5f, 1.0f) * (0.5f + std::max(up, 0.0f));
+            glm::vec3 ground   = glm::vec3(0.35f, 0.3f, 0.2f) * (0.5f + std::max(-up, 0.0f));
+            float horizon      = std::exp(-up * up * 20.0f);
+            float patch        = std::max(std::cos(phi - 1.0f) * std::sin(theta), 0.0f);
+            glm::vec3 radiance = glm::mix(ground, sky, up * 0.5f + 0.5f) +
+                                 glm::vec3(1.0f, 0.6f, 0.3f) * horizon +
+                                 glm::vec3(3.0f, 2.8f, 2.5f) * std::pow(patch, 4.0f);
+
+            float* pixel = &pixels[(y * EQUIRECTANGULAR_WIDTH + x) * 4];
+            pixel[0]     = radiance.r;
+            pixel[1]     = radiance.g;
+            pixel[2]     = radiance.b;
+            pixel[3]     = 1.0f;
+        }
+    }
+
+    return pixels;
+}
+
+// Bakes the cubemaps with the compute shaders and the rasterized multiview reference, and holds
+// every map and face to the tolerance compareWithRenderPasses warns at. Needs a device, a software
+// one like lavapipe works too
+int main() {
+    Logger::init();
+
+    auto graphicsContext = GraphicsContext::createHeadless(64, 64);
+
+    std::vector<float> pixels   = syntheticEquirectangular();
+    auto equirectangularTexture = graphicsContext->createHDRTexture(
+        EQUIRECTANGULAR_WIDTH, EQUIRECTANGULAR_HEIGHT, 4, pixels.data());
+
+    // Smaller than the application's, the comparison doesn't depend on the size
+    auto environmentMap = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 64, 64);
+    auto irradianceMap  = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 16, 16);
+    auto prefilterMap   = graphicsContext->createCubemap(Format::RGBA16_FLOAT, 32, 32, true);
+
+    IBLBaker iblBaker(graphicsContext.get());
+    iblBaker.bake(equirectangularTexture, environmentMap, irradianceMap, prefilterMap);
+    std::array<CubemapDifference, 3> differences = iblBaker.compareWithRenderPasses(
+        equirectangularTexture, environmentMap, irradianceMap, prefilterMap);
+
+    // A second bake through the same sets has to come out the same
+    iblBaker.bake(equirectangularTexture, environmentMap, irradianceMap, prefilterMap);
+    std::array<CubemapDifference, 3> rebakedDifferences = iblBaker.compareWithRenderPasses(
+        equirectangularTexture, environmentMap, irradianceMap, prefilterMap);
+
+    for (size_t i = 0; i < differences.size(); i++) {
+        CHECK(differences[i].relativeError <= BAKE_COMPARISON_TOLERANCE);
+        for (float faceRelativeError : differences[i].faceRelativeErrors) {
+            CHECK(faceRelativeError <= BAKE_COMPARISON_TOLERANCE);
+        }
+
+        CHECK_NEAR(rebakedDifferences[i].relativeError, differences[i].relativeError, 1e-6);
+    }
+
+    graphicsContext->waitIdle();
+
+    return checkResult("IBLBakeTest");
+}
@@ -0,0 +1,160 @@
+#include "../src/pch.hpp"
+
+#include "../src/Jobs/JobSystem.hpp"
+#include "../src/Logger.hpp"
+
+#include "Check.hpp"
+
+// Every test runs this many times on each system, races rarely show up on the first run
+constexpr int REPEATS = 20;
+
+// Every outer range runs its own parallelFor from whichever thread picked it up
+void testNestedParallelFor(JobSystem& jobSystem) {
+    constexpr uint32_t OUTER_COUNT = 64;
+    constexpr uint32_t INNER_COUNT = 1000;
+
+    std::vector<std::atomic<uint32_t>> visits(OUTER_COUNT * INNER_COUNT);
+    jobSystem.parallelFor(OUTER_COUNT, 1, [&](uint32_t first, uint32_t count) {
+        for (uint32_t outer = first; outer < first + count; outer++) {
+            jobSystem.parallelFor(INNER_COUNT, 16, [&](uint32_t innerFirst, uint32_t innerCount) {
+                for (uint32_t inner = innerFirst; inner < innerFirst + innerCount; inner++) {
+                    visits[outer * INNER_COUNT + inner]++;
+                }
+            });
+        }
+    });
+
+    bool visitedOnce = true;
+    for (auto& visit : visits) {
+        visitedOnce = visitedOnce && visit.load() == 1;
+    }
+    CHECK(visitedOnce);
+}
+
+void testRunAfterChains(JobSystem& jobSystem) {
+    constexpr uint32_t CHAIN_COUNT  = 16;
+    constexpr uint32_t CHAIN_LENGTH = 200;
+
+    // Every link appends to its chain once the link before it is done
+    std::vector<std::vector<uint32_t>> chains(CHAIN_COUNT);
+    std::vector<std::unique_ptr<JobCounter>> links;
+    for (uint32_t i = 0; i < CHAIN_COUNT * CHAIN_LENGTH; i++) {
+        links.push_back(std::make_unique<JobCounter>());
+    }
+
+    for (uint32_t link = 0; link < CHAIN_LENGTH; link++) {
+        for (uint32_t chain = 0; chain < CHAIN_COUNT; chain++) {
+            auto job            = [&chains, chain, link]() { chains[chain].push_back(link); };
+            JobCounter* counter = links[chain * CHAIN_LENGTH + link].get();
+            if (link == 0) {
+                jobSystem.run(job, counter);
+            } else {
+                jobSystem.runAfter(*links[chain * CHAIN_LENGTH + link - 1], job, counter);
+            }
+        }
+    }
+
+    bool inOrder = true;
+    for (uint32_t chain = 0; chain < CHAIN_COUNT; chain++) {
+        jobSystem.wait(*links[chain * CHAIN_LENGTH + CHAIN_LENGTH - 1]);
+
+        inOrder = inOrder && chains[chain].size() == CHAIN_LENGTH;
+        for (uint32_t link = 0; inOrder && link < CHAIN_LENGTH; link++) {
+            inOrder = chains[chain][link] == link;
+        }
+    }
+    CHECK(inOrder);
+
+    // Waits for every job of the dependency, and runs right away once it's done
+    constexpr uint32_t FAN_IN = 100;
+    std::atomic<uint32_t> finished(0);
+    JobCounter stage;
+    for (uint32_t i = 0; i < FAN_IN; i++) {
+        jobSystem.run([&finished]() { finished++; }, &stage);
+    }
+
+    uint32_t finishedBefore = 0;
+    JobCounter after;
+    jobSystem.runAfter(stage, [&]() { finishedBefore = finished.load(); }, &after);
+    jobSystem.wait(after);
+    CHECK(finishedBefore == FAN_IN);
+
+    bool ranAgain = false;
+    jobSystem.runAfter(stage, [&]() { ranAgain = true; }, &after);
+    jobSystem.wait(after);
+    CHECK(ranAgain);
+}
+
+// Handed to the main thread from the workers, they only run while it waits
+void testMainThreadJobs(JobSystem& jobSystem) {
+    constexpr uint32_t JOB_COUNT = 256;
+
+    uint32_t ran = 0;
+    std::atomic<uint32_t> offMainThread(0);
+    JobCounter counter;
+    jobSystem.parallelFor(JOB_COUNT, 1, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            jobSystem.runOnMainThread(
+                [&]() {
+                    if (!jobSystem.isMainThread()) {
+                        offMainThread++;
+                    }
+                    ran++;
+                },
+                &counter);
+        }
+    });
+    jobSystem.wait(counter);
+
+    CHECK(ran == JOB_COUNT);
+    CHECK(offMainThread == 0);
+}
+
+// Threads outside of the system push jobs that start more jobs on the workers
+void testForeignThreadPushes(JobSystem& jobSystem) {
+    constexpr uint32_t THREAD_COUNT = 4;
+    constexpr uint32_t JOB_COUNT    = 1000;
+
+    std::atomic<uint32_t> ran(0);
+    JobCounter counter;
+    std::vector<std::thread> threads;
+    for (uint32_t thread = 0; thread < THREAD_COUNT; thread++) {
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < JOB_COUNT; i++) {
+                jobSystem.run(
+                    [&]() {
+                        ran++;
+                        jobSystem.run([&]() { ran++; }, &counter);
+                    },
+                    &counter);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    jobSystem.wait(counter);
+
+    CHECK(ran == 2 * THREAD_COUNT * JOB_COUNT);
+}
+
+void testJobSystem(uint32_t workerCount) {
+    JobSystem jobSystem(workerCount);
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        testNestedParallelFor(jobSystem);
+        testRunAfterChains(jobSystem);
+        testMainThreadJobs(jobSystem);
+        testForeignThreadPushes(jobSystem);
+    }
+}
+
+int main() {
+    Logger::init();
+
+    // Just the main thread, a single worker and as many as the machine has
+    testJobSystem(0);
+    testJobSystem(1);
+    testJobSystem(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    return checkResult("JobSystemTest");
+}
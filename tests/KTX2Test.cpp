@@ -0,0 +1,200 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/KTX2.hpp"
+#include "../src/Logger.hpp"
+
+#include "Check.hpp"
+
+#include <random>
+
+// Neither side a power of two, so the mips round their sizes down and their blocks up
+constexpr uint32_t WIDTH  = 37;
+constexpr uint32_t HEIGHT = 20;
+
+// Where the fields the tests corrupt are in the file, the level index follows the header
+constexpr size_t LAYER_COUNT_OFFSET = 32;
+constexpr size_t FACE_COUNT_OFFSET  = 36;
+constexpr size_t LEVEL_COUNT_OFFSET = 40;
+constexpr size_t LEVEL_INDEX_OFFSET = 80;
+constexpr size_t LEVEL_INDEX_SIZE   = 24;
+
+struct LevelIndex {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+std::vector<unsigned char> readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), {});
+}
+
+void writeFile(const std::filesystem::path& path, const std::vector<unsigned char>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+LevelIndex levelIndexOf(const std::vector<unsigned char>& file, uint32_t level) {
+    LevelIndex levelIndex = {};
+    memcpy(&levelIndex, file.data() + LEVEL_INDEX_OFFSET + level * LEVEL_INDEX_SIZE,
+           sizeof(levelIndex));
+    return levelIndex;
+}
+
+void setLevelIndex(std::vector<unsigned char>& file, uint32_t level, const LevelIndex& levelIndex) {
+    memcpy(file.data() + LEVEL_INDEX_OFFSET + level * LEVEL_INDEX_SIZE, &levelIndex,
+           sizeof(levelIndex));
+}
+
+void setUint32(std::vector<unsigned char>& file, size_t offset, uint32_t value) {
+    memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+// Every mip down to 1x1 of BC7 blocks. Half of each mip repeats one block, so Zstandard has
+// something to compress
+KTX2Texture testTexture() {
+    std::mt19937 random(13);
+
+    KTX2Texture texture = {};
+    texture.format      = Format::BC7_UNORM;
+    texture.width       = WIDTH;
+    texture.height      = HEIGHT;
+    for (uint32_t level = 0; std::max(WIDTH, HEIGHT) >> level > 0; level++) {
+        uint32_t blocksX = (std::max(WIDTH >> level, 1u) + 3) / 4;
+        uint32_t blocksY = (std::max(HEIGHT >> level, 1u) + 3) / 4;
+
+        std::vector<unsigned char> mip(blocksX * blocksY * 16);
+        for (size_t i = 0; i < mip.size(); i++) {
+            mip[i] = (i < mip.size() / 2) ? (unsigned char)random() : (unsigned char)(i % 16);
+        }
+        texture.mips.push_back(mip);
+    }
+
+    return texture;
+}
+
+// Reading has to fail on the file with the change made to it
+bool rejects(const std::filesystem::path& path, const std::vector<unsigned char>& file,
+             const std::function<void(std::vector<unsigned char>&)>& corrupt) {
+    std::vector<unsigned char> corrupted = file;
+    corrupt(corrupted);
+    writeFile(path, corrupted);
+
+    KTX2Texture texture = {};
+    return !helper::readKTX2(path.string(), texture);
+}
+
+void testRoundTrip(const std::filesystem::path& directory, int zstdLevel) {
+    KTX2Texture texture = testTexture();
+    CHECK(texture.mips.size() == 6);
+
+    std::filesystem::path path = directory / "texture.ktx2";
+    CHECK(helper::writeKTX2(path.string(), texture, zstdLevel));
+
+    KTX2Texture readTexture = {};
+    CHECK(helper::readKTX2(path.string(), readTexture));
+    CHECK(readTexture.format == texture.format);
+    CHECK(readTexture.width == WIDTH && readTexture.height == HEIGHT);
+    CHECK(readTexture.mips == texture.mips);
+
+    // The smallest mip comes first, each one inside the file and after the one before
+    std::vector<unsigned char> file = readFile(path);
+    bool levelsInOrder              = true;
+    uint64_t previousEnd            = LEVEL_INDEX_OFFSET + texture.mips.size() * LEVEL_INDEX_SIZE;
+    for (uint32_t level = (uint32_t)texture.mips.size(); level-- > 0;) {
+        LevelIndex levelIndex = levelIndexOf(file, level);
+        levelsInOrder         = levelsInOrder && levelIndex.byteOffset >= previousEnd &&
+                        levelIndex.uncompressedByteLength == texture.mips[level].size();
+        previousEnd = levelIndex.byteOffset + levelIndex.byteLength;
+
+        // Stored mips are the bytes given, aligned to a block
+        if (zstdLevel == 0) {
+            const unsigned char* stored = file.data() + levelIndex.byteOffset;
+            levelsInOrder = levelsInOrder && levelIndex.byteOffset % 16 == 0 &&
+                            levelIndex.byteLength == texture.mips[level].size() &&
+                            std::equal(stored, stored + levelIndex.byteLength,
+                                       texture.mips[level].begin());
+        }
+    }
+    CHECK(levelsInOrder);
+    CHECK(previousEnd == file.size());
+
+    // Writing what was read gives back the same file, level index included
+    std::filesystem::path rewrittenPath = directory / "rewritten.ktx2";
+    CHECK(helper::writeKTX2(rewrittenPath.string(), readTexture, zstdLevel));
+    CHECK(readFile(rewrittenPath) == file);
+
+    std::filesystem::path corruptPath = directory / "corrupt.ktx2";
+    uint32_t lastLevel                = (uint32_t)texture.mips.size() - 1;
+
+    // The full size mip is the last thing in the file
+    CHECK(rejects(corruptPath, file, [](auto& bytes) { bytes.pop_back(); }));
+    CHECK(rejects(corruptPath, file, [](auto& bytes) {
+        bytes.resize(LEVEL_INDEX_OFFSET + LEVEL_INDEX_SIZE / 2);
+    }));
+
+    // Level entries reaching past the file or disagreeing with the size of their mip
+    CHECK(rejects(corruptPath, file, [](auto& bytes) {
+        LevelIndex levelIndex = levelIndexOf(bytes, 0);
+        levelIndex.byteLength++;
+        setLevelIndex(bytes, 0, levelIndex);
+    }));
+    CHECK(rejects(corruptPath, file, [](auto& bytes) {
+        LevelIndex levelIndex = levelIndexOf(bytes, 1);
+        levelIndex.byteOffset = bytes.size() + 16;
+        setLevelIndex(bytes, 1, levelIndex);
+    }));
+    CHECK(rejects(corruptPath, file, [](auto& bytes) {
+        LevelIndex levelIndex = levelIndexOf(bytes, 2);
+        levelIndex.uncompressedByteLength += 16;
+        setLevelIndex(bytes, 2, levelIndex);
+    }));
+    CHECK(rejects(corruptPath, file, [&](auto& bytes) {
+        LevelIndex levelIndex = levelIndexOf(bytes, lastLevel);
+        levelIndex.uncompressedByteLength -= 16;
+        setLevelIndex(bytes, lastLevel, levelIndex);
+    }));
+
+    // Stored mips have to be exactly their size, even when the bytes after them are in the file
+    if (zstdLevel == 0) {
+        CHECK(rejects(corruptPath, file, [&](auto& bytes) {
+            LevelIndex levelIndex = levelIndexOf(bytes, lastLevel);
+            levelIndex.byteLength += 16;
+            setLevelIndex(bytes, lastLevel, levelIndex);
+        }));
+    }
+
+    // Arrays and cubemaps aren't read as their first layer or face, and mips past 1x1 don't
+    // exist
+    CHECK(rejects(corruptPath, file, [](auto& bytes) { setUint32(bytes, LAYER_COUNT_OFFSET, 2); }));
+    CHECK(rejects(corruptPath, file, [](auto& bytes) { setUint32(bytes, FACE_COUNT_OFFSET, 6); }));
+    CHECK(rejects(corruptPath, file, [&](auto& bytes) {
+        setUint32(bytes, LEVEL_COUNT_OFFSET, (uint32_t)texture.mips.size() + 1);
+    }));
+
+    // The writer checks the sizes too
+    KTX2Texture wrongSize = texture;
+    wrongSize.mips[1].resize(wrongSize.mips[1].size() - 16);
+    CHECK(!helper::writeKTX2((directory / "wrong_size.ktx2").string(), wrongSize, zstdLevel));
+}
+
+int main() {
+    Logger::init();
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "ktx2_test";
+    std::filesystem::create_directories(directory);
+
+    testRoundTrip(directory, 0);
+    testRoundTrip(directory, 3);
+
+    // Half of every mip is one block repeated, so supercompressing has to shrink the file
+    KTX2Texture texture = testTexture();
+    CHECK(helper::writeKTX2((directory / "stored.ktx2").string(), texture, 0));
+    CHECK(helper::writeKTX2((directory / "zstd.ktx2").string(), texture, 19));
+    CHECK(std::filesystem::file_size(directory / "zstd.ktx2") <
+          std::filesystem::file_size(directory / "stored.ktx2"));
+
+    std::filesystem::remove_all(directory);
+
+    return checkResult("KTX2Test");
+}
@@ -0,0 +1,135 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/Pixels.hpp"
+
+#include "Check.hpp"
+
+#include <random>
+
+// Not a multiple of the SIMD widths, so the scalar loops finish every conversion
+constexpr size_t PIXEL_COUNT = 4099;
+
+// Below it both formats lose mantissa bits, errors are measured against it instead
+const float SMALLEST_NORMAL = std::ldexp(1.0f, -14);
+
+// Every exponent the formats have and some past them, with random mantissas and signs
+std::vector<float> hdrValues(bool withNegatives) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> mantissa(1.0f, 2.0f);
+    std::uniform_int_distribution<int> exponent(-26, 17);
+
+    std::vector<float> values(PIXEL_COUNT * 4);
+    for (float& value : values) {
+        value = std::ldexp(mantissa(random), exponent(random));
+        if (withNegatives && (random() & 1)) {
+            value = -value;
+        }
+    }
+
+    // Exactly representable in both
+    values[0] = 0.0f;
+    values[1] = 1.0f;
+    values[2] = 0.5f;
+    values[3] = 1024.0f;
+
+    return values;
+}
+
+// Relative to the value, or to the smallest normal closer to zero. Rounding to nearest keeps that
+// under half a unit in the last place of the mantissa, bound. Values past largest are clamped
+float maxErrorToBound(const std::vector<float>& values, const std::vector<float>& decoded,
+                      std::array<float, 3> bounds, std::array<float, 3> largest, bool isHalf) {
+    float maxRatio = 0.0f;
+    for (size_t pixel = 0; pixel < PIXEL_COUNT; pixel++) {
+        for (int c = 0; c < 3; c++) {
+            float value = std::clamp(values[pixel * 4 + c], isHalf ? -largest[c] : 0.0f,
+                                     largest[c]);
+            float error = std::abs(decoded[pixel * 4 + c] - value) /
+                          std::max(std::abs(value), SMALLEST_NORMAL);
+            maxRatio = std::max(maxRatio, error / bounds[c]);
+        }
+    }
+
+    return maxRatio;
+}
+
+void testHalfConversion() {
+    std::vector<float> values = hdrValues(true);
+
+    std::vector<uint16_t> halves(values.size());
+    helper::floatToHalf(values.data(), halves.data(), values.size());
+    std::vector<float> decoded(values.size());
+    helper::halfToFloat(halves.data(), decoded.data(), halves.size());
+
+    float bound = std::ldexp(1.0f, -11);
+    CHECK(maxErrorToBound(values, decoded, { bound, bound, bound },
+                          { 65504.0f, 65504.0f, 65504.0f }, true) <= 1.0f);
+
+    // Alpha goes through like the other channels
+    bool alphaWithinBound = true;
+    for (size_t pixel = 0; pixel < PIXEL_COUNT; pixel++) {
+        float alpha      = std::clamp(values[pixel * 4 + 3], -65504.0f, 65504.0f);
+        float error      = std::abs(decoded[pixel * 4 + 3] - alpha);
+        alphaWithinBound = alphaWithinBound &&
+                           error <= bound * std::max(std::abs(alpha), SMALLEST_NORMAL);
+    }
+    CHECK(alphaWithinBound);
+
+    CHECK(halves[1] == 0x3C00);
+    CHECK(decoded[3] == 1024.0f);
+
+    // Clamped to the largest finite half instead of becoming infinite
+    float huge = 1.0e6f;
+    uint16_t clamped;
+    helper::floatToHalf(&huge, &clamped, 1);
+    CHECK(clamped == 0x7BFF);
+}
+
+void testB10G11R11Conversion() {
+    std::vector<float> values = hdrValues(true);
+
+    std::vector<uint32_t> packed(PIXEL_COUNT);
+    helper::floatToB10G11R11(values.data(), packed.data(), PIXEL_COUNT);
+    std::vector<float> decoded(values.size());
+    helper::b10g11r11ToFloat(packed.data(), decoded.data(), PIXEL_COUNT);
+
+    // Six mantissa bits for red and green, five for blue
+    CHECK(maxErrorToBound(values, decoded,
+                          { std::ldexp(1.0f, -7), std::ldexp(1.0f, -7), std::ldexp(1.0f, -6) },
+                          { 65024.0f, 65024.0f, 64512.0f }, false) <= 1.0f);
+
+    bool opaque = true;
+    for (size_t pixel = 0; pixel < PIXEL_COUNT; pixel++) {
+        opaque = opaque && decoded[pixel * 4 + 3] == 1.0f;
+    }
+    CHECK(opaque);
+
+    // Zero, one, a half and 1024 in red, green, blue and the alpha that's dropped
+    CHECK(decoded[0] == 0.0f && decoded[1] == 1.0f && decoded[2] == 0.5f);
+}
+
+void testExpandRGBToRGBA() {
+    std::vector<unsigned char> rgb(PIXEL_COUNT * 3);
+    for (size_t i = 0; i < rgb.size(); i++) {
+        rgb[i] = (unsigned char)(i * 31);
+    }
+
+    std::vector<unsigned char> rgba(PIXEL_COUNT * 4);
+    helper::expandRGBToRGBA(rgb.data(), rgba.data(), PIXEL_COUNT);
+
+    bool matches = true;
+    for (size_t pixel = 0; pixel < PIXEL_COUNT; pixel++) {
+        matches = matches && rgba[pixel * 4 + 0] == rgb[pixel * 3 + 0] &&
+                  rgba[pixel * 4 + 1] == rgb[pixel * 3 + 1] &&
+                  rgba[pixel * 4 + 2] == rgb[pixel * 3 + 2] && rgba[pixel * 4 + 3] == 255;
+    }
+    CHECK(matches);
+}
+
+int main() {
+    testHalfConversion();
+    testB10G11R11Conversion();
+    testExpandRGBToRGBA();
+
+    return checkResult("PixelsTest");
+}
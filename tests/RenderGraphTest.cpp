@@ -0,0 +1,316 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/RenderGraphCompiler.hpp"
+#include "../src/Logger.hpp"
+
+#include "Check.hpp"
+
+void recordNothing(std::shared_ptr<CommandBuffer> commandBuffer) {}
+
+std::vector<uint32_t> compiledPassIndices(RenderGraphCompiler& graph) {
+    std::vector<uint32_t> indices;
+    for (auto& compiledPass : graph.getCompiledPasses()) {
+        indices.push_back(compiledPass.pass);
+    }
+
+    return indices;
+}
+
+void testPassCulling() {
+    RenderGraphCompiler graph;
+    graph.importTexture("output", nullptr, ImageLayout::UNDEFINED);
+    graph.createTexture("scene", { Format::RGBA16_FLOAT, 64, 64, 1 });
+    graph.createTexture("debug", { Format::RGBA16_FLOAT, 64, 64, 1 });
+    graph.createTexture("debugBlurred", { Format::RGBA16_FLOAT, 64, 64, 1 });
+    graph.createTexture("readback", { Format::RGBA16_FLOAT, 64, 64, 1 });
+
+    graph.addPass("scene", recordNothing).write("scene", ResourceUsage::COLOR_ATTACHMENT);
+    // Nothing exported depends on either, the second only keeps the first alive
+    graph.addPass("debug", recordNothing).write("debug", ResourceUsage::COLOR_ATTACHMENT);
+    graph.addPass("debugBlur", recordNothing)
+        .read("debug", ResourceUsage::SAMPLED_COMPUTE)
+        .write("debugBlurred", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    graph.addPass("tonemap", recordNothing)
+        .read("scene", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    graph.addPass("readback", recordNothing)
+        .read("output", ResourceUsage::TRANSFER_SRC)
+        .write("readback", ResourceUsage::TRANSFER_DST)
+        .setSideEffects();
+    graph.exportTexture("output", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(graph.compile());
+
+    CHECK((compiledPassIndices(graph) == std::vector<uint32_t>{ 0, 3, 4 }));
+
+    // Lifetimes are in compiled passes, exported textures live until the end
+    const RenderGraphResource* scene = graph.getResource("scene");
+    CHECK(scene->firstUse == 0 && scene->lastUse == 1);
+    CHECK(scene->usageFlags ==
+          (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
+    CHECK(graph.getResource("debug")->firstUse == -1);
+    CHECK(graph.getResource("debugBlurred")->firstUse == -1);
+    const RenderGraphResource* output = graph.getResource("output");
+    CHECK(output->firstUse == 1 && output->lastUse == 3);
+    CHECK(graph.getResource("missing") == nullptr);
+}
+
+void testBarrierBatching() {
+    RenderGraphCompiler graph;
+    graph.importTexture("output", nullptr, ImageLayout::UNDEFINED);
+    graph.createTexture("albedo", { Format::RGBA16_FLOAT, 64, 64, 1 });
+    graph.createTexture("normal", { Format::RGBA16_FLOAT, 64, 64, 1 });
+    graph.createTexture("depth", { Format::R32_FLOAT, 64, 64, 1 });
+
+    graph.addPass("gbuffer", recordNothing)
+        .write("albedo", ResourceUsage::COLOR_ATTACHMENT)
+        .write("normal", ResourceUsage::COLOR_ATTACHMENT)
+        .write("depth", ResourceUsage::DEPTH_ATTACHMENT);
+    graph.addPass("lighting", recordNothing)
+        .read("albedo", ResourceUsage::SAMPLED_FRAGMENT)
+        .read("normal", ResourceUsage::SAMPLED_FRAGMENT)
+        .read("depth", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    // Reads what the lighting pass already waited for in the same stage
+    graph.addPass("outline", recordNothing)
+        .read("normal", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    graph.exportTexture("output", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(graph.compile());
+
+    const std::vector<CompiledRenderGraphPass>& passes = graph.getCompiledPasses();
+    CHECK(passes.size() == 3);
+
+    // The three transitions out of UNDEFINED wait on nothing
+    const RenderGraphBarrierBatch& gbuffer = passes[0].barrierBatch;
+    CHECK(gbuffer.barriers.size() == 3);
+    CHECK(gbuffer.srcStages == VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    CHECK(gbuffer.dstStages == (VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT));
+
+    // Every gbuffer texture and the output in a single batch, the output waits on nothing
+    const RenderGraphBarrierBatch& lighting = passes[1].barrierBatch;
+    CHECK(lighting.barriers.size() == 4);
+    CHECK(lighting.srcStages == (VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT |
+                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT));
+    CHECK(lighting.dstStages == (VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT));
+    // Resources are numbered in declaration order
+    for (auto& barrier : lighting.barriers) {
+        if (barrier.resource == 2) {
+            CHECK(barrier.oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+            CHECK(barrier.newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            CHECK(barrier.srcAccess == (VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT));
+            CHECK(barrier.dstAccess == VK_ACCESS_SHADER_READ_BIT);
+        }
+    }
+
+    // Only the output, written again by the outline pass
+    const RenderGraphBarrierBatch& outline = passes[2].barrierBatch;
+    CHECK(outline.barriers.size() == 1);
+    CHECK(outline.barriers[0].resource == 0);
+    CHECK(outline.barriers[0].oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    CHECK(outline.barriers[0].newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+}
+
+void testFinalBarriers() {
+    RenderGraphCompiler graph;
+    graph.importTexture("environment", nullptr, ImageLayout::UNDEFINED);
+    graph.importTexture("lut", nullptr, ImageLayout::UNDEFINED);
+    graph.importTexture("equirectangular", nullptr, ImageLayout::SHADER_READ);
+
+    graph.addPass("equiToCube", recordNothing)
+        .read("equirectangular", ResourceUsage::SAMPLED_COMPUTE)
+        .write("environment", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    graph.addPass("brdfLut", recordNothing).write("lut", ResourceUsage::COLOR_ATTACHMENT);
+    graph.addPass("sampleLut", recordNothing)
+        .read("lut", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("environment", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    graph.exportTexture("environment", ResourceUsage::SAMPLED_FRAGMENT);
+    graph.exportTexture("lut", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(graph.compile());
+
+    // An imported texture already in its layout doesn't need a transition before being read
+    CHECK(graph.getCompiledPasses()[0].barrierBatch.barriers.size() == 1);
+
+    // The environment leaves GENERAL, the LUT is already readable by fragment shaders
+    const RenderGraphBarrierBatch& finalBarriers = graph.getFinalBarriers();
+    CHECK(finalBarriers.barriers.size() == 1);
+    CHECK(finalBarriers.barriers[0].resource == 0);
+    CHECK(finalBarriers.barriers[0].oldLayout == VK_IMAGE_LAYOUT_GENERAL);
+    CHECK(finalBarriers.barriers[0].newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    CHECK(finalBarriers.barriers[0].srcAccess == VK_ACCESS_SHADER_WRITE_BIT);
+    CHECK(finalBarriers.barriers[0].dstAccess == VK_ACCESS_SHADER_READ_BIT);
+    CHECK(finalBarriers.srcStages == VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    CHECK(finalBarriers.dstStages == VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void testDeclarationOrder() {
+    // The tonemap pass is declared before the pass writing the scene it reads
+    RenderGraphCompiler reversed;
+    reversed.importTexture("output", nullptr, ImageLayout::UNDEFINED);
+    reversed.createTexture("scene", { Format::RGBA16_FLOAT, 64, 64, 1 });
+
+    reversed.addPass("tonemap", recordNothing)
+        .read("scene", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    reversed.addPass("scene", recordNothing).write("scene", ResourceUsage::COLOR_ATTACHMENT);
+    reversed.exportTexture("output", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(!reversed.compile());
+
+    // An import with contents has no producer in the graph, the UNDEFINED one has none at all
+    RenderGraphCompiler imports;
+    imports.importTexture("history", nullptr, ImageLayout::SHADER_READ);
+    imports.importTexture("discarded", nullptr, ImageLayout::UNDEFINED);
+    imports.importTexture("output", nullptr, ImageLayout::UNDEFINED);
+
+    imports.addPass("resolve", recordNothing)
+        .read("history", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    imports.exportTexture("output", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(imports.compile());
+
+    imports.addPass("garbage", recordNothing)
+        .read("discarded", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    CHECK(!imports.compile());
+}
+
+void testMergedUsage() {
+    RenderGraphCompiler graph;
+    graph.importTexture("particles", nullptr, ImageLayout::UNDEFINED);
+
+    graph.addPass("spawn", recordNothing)
+        .write("particles", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    // Updates the image in place
+    graph.addPass("simulate", recordNothing)
+        .read("particles", ResourceUsage::STORAGE_READ_COMPUTE)
+        .write("particles", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    graph.exportTexture("particles", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(graph.compile());
+
+    // One barrier for the read and the write, waiting on the spawn pass
+    const RenderGraphBarrierBatch& simulate = graph.getCompiledPasses()[1].barrierBatch;
+    CHECK(simulate.barriers.size() == 1);
+    CHECK(simulate.barriers[0].oldLayout == VK_IMAGE_LAYOUT_GENERAL);
+    CHECK(simulate.barriers[0].newLayout == VK_IMAGE_LAYOUT_GENERAL);
+    CHECK(simulate.barriers[0].srcAccess == VK_ACCESS_SHADER_WRITE_BIT);
+    CHECK(simulate.barriers[0].dstAccess ==
+          (VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+    CHECK(simulate.srcStages == VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    CHECK(simulate.dstStages == VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    // Sampled and storage layouts can't both hold during one pass
+    RenderGraphCompiler conflicting;
+    conflicting.importTexture("image", nullptr, ImageLayout::SHADER_READ);
+
+    conflicting.addPass("blur", recordNothing)
+        .read("image", ResourceUsage::SAMPLED_COMPUTE)
+        .write("image", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    conflicting.exportTexture("image", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(!conflicting.compile());
+}
+
+// What allocate would place for the transients declared first, sizes in declaration order
+std::vector<RenderGraphPlacement> placements(const std::vector<VkDeviceSize>& sizes) {
+    std::vector<RenderGraphPlacement> result;
+    for (uint32_t resource = 0; resource < sizes.size(); resource++) {
+        result.push_back({ resource, { sizes[resource], 64 * 1024, 0b0110 }, 0 });
+    }
+
+    return result;
+}
+
+VkDeviceSize placedOffset(const std::vector<RenderGraphPlacement>& placements,
+                          uint32_t resource) {
+    for (auto& placement : placements) {
+        if (placement.resource == resource) {
+            return placement.offset;
+        }
+    }
+
+    return ~VkDeviceSize(0);
+}
+
+void testTransientAliasing() {
+    constexpr VkDeviceSize MB = 1024 * 1024;
+
+    // A chain of blurs, each transient dies once the next one is written. The first and the last
+    // never live at the same time, the middle one overlaps both
+    RenderGraphCompiler chain;
+    chain.createTexture("first", { Format::RGBA16_FLOAT, 1024, 1024, 1 });
+    chain.createTexture("middle", { Format::RGBA16_FLOAT, 512, 512, 1 });
+    chain.createTexture("last", { Format::RGBA16_FLOAT, 1024, 768, 1 });
+    chain.importTexture("output", nullptr, ImageLayout::UNDEFINED);
+
+    chain.addPass("first", recordNothing).write("first", ResourceUsage::COLOR_ATTACHMENT);
+    chain.addPass("middle", recordNothing)
+        .read("first", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("middle", ResourceUsage::COLOR_ATTACHMENT);
+    chain.addPass("last", recordNothing)
+        .read("middle", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("last", ResourceUsage::COLOR_ATTACHMENT);
+    chain.addPass("resolve", recordNothing)
+        .read("last", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    chain.exportTexture("output", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(chain.compile());
+
+    std::vector<RenderGraphPlacement> chainPlacements = placements({ 8 * MB, 2 * MB, 6 * MB + 1 });
+    VkMemoryRequirements chainBlock = chain.placeTransients(chainPlacements);
+
+    // The last goes over the first, the middle after the larger of the two, aligned
+    CHECK(placedOffset(chainPlacements, 0) == 0);
+    CHECK(placedOffset(chainPlacements, 2) == 0);
+    CHECK(placedOffset(chainPlacements, 1) == 8 * MB);
+    CHECK(chainBlock.size == 10 * MB);
+    CHECK(chainBlock.alignment == 64 * 1024);
+    CHECK(chainBlock.memoryTypeBits == 0b0110);
+
+    // All three read by the last pass, so none of them can share memory
+    RenderGraphCompiler gbuffer;
+    gbuffer.createTexture("albedo", { Format::RGBA16_FLOAT, 1024, 1024, 1 });
+    gbuffer.createTexture("normal", { Format::RGBA16_FLOAT, 1024, 1024, 1 });
+    gbuffer.createTexture("depth", { Format::R32_FLOAT, 1024, 1024, 1 });
+    gbuffer.importTexture("output", nullptr, ImageLayout::UNDEFINED);
+
+    gbuffer.addPass("gbuffer", recordNothing)
+        .write("albedo", ResourceUsage::COLOR_ATTACHMENT)
+        .write("normal", ResourceUsage::COLOR_ATTACHMENT)
+        .write("depth", ResourceUsage::DEPTH_ATTACHMENT);
+    gbuffer.addPass("lighting", recordNothing)
+        .read("albedo", ResourceUsage::SAMPLED_FRAGMENT)
+        .read("normal", ResourceUsage::SAMPLED_FRAGMENT)
+        .read("depth", ResourceUsage::SAMPLED_FRAGMENT)
+        .write("output", ResourceUsage::COLOR_ATTACHMENT);
+    gbuffer.exportTexture("output", ResourceUsage::SAMPLED_FRAGMENT);
+    CHECK(gbuffer.compile());
+
+    std::vector<RenderGraphPlacement> gbufferPlacements =
+        placements({ 8 * MB, 8 * MB, 4 * MB + 1 });
+    VkMemoryRequirements gbufferBlock = gbuffer.placeTransients(gbufferPlacements);
+
+    CHECK(placedOffset(gbufferPlacements, 2) == 16 * MB);
+    CHECK(gbufferBlock.size == 20 * MB + 1);
+
+    // No memory type every transient can use
+    std::vector<RenderGraphPlacement> mismatched = gbufferPlacements;
+    mismatched[0].requirements.memoryTypeBits    = 0b1000;
+    CHECK(gbuffer.placeTransients(mismatched).memoryTypeBits == 0);
+}
+
+int main() {
+    Logger::init();
+
+    testPassCulling();
+    testBarrierBatching();
+    testFinalBarriers();
+    testDeclarationOrder();
+    testMergedUsage();
+    testTransientAliasing();
+
+    return checkResult("RenderGraphTest");
+}
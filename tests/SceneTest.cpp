@@ -0,0 +1,166 @@
+#include "../src/pch.hpp"
+
+#include "../src/Jobs/JobSystem.hpp"
+#include "../src/Scene/Scene.hpp"
+#include "../src/Logger.hpp"
+
+#include "Check.hpp"
+
+// Built independently of the scene's own local matrix
+glm::mat4 expectedLocal(const TransformComponent& transform) {
+    return glm::translate(glm::mat4(1.0f), transform.position) *
+           glm::mat4_cast(transform.rotation) * glm::scale(glm::mat4(1.0f), transform.scale);
+}
+
+bool matricesNear(const glm::mat4& a, const glm::mat4& b) {
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            float tolerance = 1e-4f * std::max(1.0f, std::abs(b[column][row]));
+            if (std::abs(a[column][row] - b[column][row]) > tolerance) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+glm::mat4 worldMatrix(Scene& scene, entt::entity entity) {
+    return scene.getRegistry().get<WorldTransformComponent>(entity).matrix;
+}
+
+// Every entity's world matrix is its parent's times its local one, roots use their local one
+bool hierarchyConsistent(Scene& scene, const std::vector<entt::entity>& entities) {
+    bool consistent = true;
+    for (entt::entity entity : entities) {
+        entt::entity parent = scene.getRegistry().get<HierarchyComponent>(entity).parent;
+        glm::mat4 parentWorld =
+            (parent == entt::null) ? glm::mat4(1.0f) : worldMatrix(scene, parent);
+        glm::mat4 expected = parentWorld * expectedLocal(scene.getTransform(entity));
+        consistent         = consistent && matricesNear(worldMatrix(scene, entity), expected);
+    }
+
+    return consistent;
+}
+
+TransformComponent transformAt(glm::vec3 position, float angle, glm::vec3 scale) {
+    glm::vec3 axis = glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f));
+
+    TransformComponent transform = {};
+    transform.position           = position;
+    transform.rotation           = glm::angleAxis(angle, axis);
+    transform.scale              = scale;
+    return transform;
+}
+
+void testParentMove(JobSystem& jobSystem) {
+    Scene scene(&jobSystem);
+
+    entt::entity root = scene.createEntity(transformAt({ 1, 2, 3 }, 0.3f, glm::vec3(2.0f)));
+    entt::entity parent =
+        scene.createEntity(transformAt({ 0, 5, 0 }, 1.1f, { 1.0f, 0.5f, 2.0f }), root);
+    entt::entity child = scene.createEntity(transformAt({ 4, 0, 0 }, -0.7f, glm::vec3(1.0f)),
+                                            parent);
+    entt::entity grandchild =
+        scene.createEntity(transformAt({ 0, 0, -2 }, 2.0f, glm::vec3(0.25f)), child);
+    entt::entity sibling = scene.createEntity(transformAt({ -3, 0, 0 }, 0.0f, glm::vec3(1.0f)),
+                                              root);
+    entt::entity otherRoot = scene.createEntity(transformAt({ 9, 9, 9 }, 0.5f, glm::vec3(1.0f)));
+    std::vector<entt::entity> entities = { root, parent, child, grandchild, sibling, otherRoot };
+
+    scene.addRenderable(child, 1, 2, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    scene.addRenderable(grandchild, 3, 4, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    scene.propagateTransforms();
+    CHECK(scene.getTransformStats().updatedCount == entities.size());
+    CHECK(hierarchyConsistent(scene, entities));
+
+    // Nothing moved, nothing to do
+    scene.propagateTransforms();
+    CHECK(scene.getTransformStats().updatedCount == 0);
+
+    // The parent and everything below it, but not its sibling or the other root
+    glm::mat4 siblingWorld   = worldMatrix(scene, sibling);
+    glm::mat4 otherRootWorld = worldMatrix(scene, otherRoot);
+    scene.setTransform(parent, transformAt({ 7, -1, 2 }, -0.4f, { 3.0f, 1.0f, 1.0f }));
+    scene.propagateTransforms();
+    CHECK(scene.getTransformStats().updatedCount == 3);
+    CHECK(hierarchyConsistent(scene, entities));
+    CHECK(matricesNear(worldMatrix(scene, child),
+                       worldMatrix(scene, parent) * expectedLocal(scene.getTransform(child))));
+    CHECK(worldMatrix(scene, sibling) == siblingWorld);
+    CHECK(worldMatrix(scene, otherRoot) == otherRootWorld);
+
+    // The objects carry the world matrices the cullers upload
+    const std::vector<CullObject>& objects = scene.getObjects();
+    CHECK(objects.size() == 2);
+    CHECK(objects[0].model == worldMatrix(scene, child));
+    CHECK(objects[1].model == worldMatrix(scene, grandchild));
+    CHECK(objects[1].meshIndex == 3 && objects[1].materialIndex == 4);
+
+    // A leaf only updates itself
+    scene.setTransform(grandchild, transformAt({ 1, 1, 1 }, 0.1f, glm::vec3(1.0f)));
+    scene.propagateTransforms();
+    CHECK(scene.getTransformStats().updatedCount == 1);
+    CHECK(hierarchyConsistent(scene, entities));
+    CHECK(objects[1].model == worldMatrix(scene, grandchild));
+
+    // A parent and its descendant moved in the same frame, the descendant counted once
+    scene.setTransform(child, transformAt({ 2, 0, 0 }, 0.9f, glm::vec3(1.5f)));
+    scene.setTransform(root, transformAt({ 0, 0, 0 }, 0.0f, glm::vec3(1.0f)));
+    scene.propagateTransforms();
+    CHECK(scene.getTransformStats().updatedCount == 5);
+    CHECK(hierarchyConsistent(scene, entities));
+}
+
+// Enough entities and roots for propagation to split them over jobs
+void testParallelPropagation(JobSystem& jobSystem) {
+    constexpr uint32_t ROOT_COUNT   = 256;
+    constexpr uint32_t ENTITY_COUNT = 40000;
+
+    std::mt19937 random(9);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+    auto randomTransform = [&]() {
+        return transformAt({ position(random), position(random), position(random) },
+                           angle(random), { scale(random), scale(random), scale(random) });
+    };
+
+    Scene scene(&jobSystem);
+    std::vector<entt::entity> entities;
+    for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+        entt::entity parent = entt::null;
+        if (i >= ROOT_COUNT) {
+            parent = entities[std::uniform_int_distribution<uint32_t>(0, i - 1)(random)];
+        }
+        entities.push_back(scene.createEntity(randomTransform(), parent));
+    }
+
+    scene.propagateTransforms();
+    CHECK(scene.getTransformStats().updatedCount == ENTITY_COUNT);
+    CHECK(hierarchyConsistent(scene, entities));
+
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 500; i++) {
+            entt::entity entity =
+                entities[std::uniform_int_distribution<uint32_t>(0, ENTITY_COUNT - 1)(random)];
+            scene.setTransform(entity, randomTransform());
+        }
+        scene.propagateTransforms();
+        CHECK(scene.getTransformStats().updatedCount >= 1);
+        CHECK(hierarchyConsistent(scene, entities));
+    }
+}
+
+int main() {
+    Logger::init();
+
+    // More than one worker, so the subtrees really are propagated concurrently
+    JobSystem jobSystem(4);
+
+    testParentMove(jobSystem);
+    testParallelPropagation(jobSystem);
+
+    return checkResult("SceneTest");
+}
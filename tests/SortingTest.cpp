@@ -0,0 +1,93 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/Sorting.hpp"
+
+#include "Check.hpp"
+
+#include <numeric>
+
+// Radix sorts keys with their indices as values, and compares against std::stable_sort
+bool sortsLikeStableSort(const std::vector<uint64_t>& keys, std::vector<uint64_t>& keyScratch,
+                         std::vector<uint32_t>& valueScratch) {
+    std::vector<uint64_t> sortedKeys = keys;
+    std::vector<uint32_t> values(keys.size());
+    std::iota(values.begin(), values.end(), 0);
+    helper::radixSort(sortedKeys, values, keyScratch, valueScratch);
+
+    std::vector<uint32_t> expected(keys.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(),
+                     [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+    bool matches = sortedKeys.size() == keys.size() && values == expected;
+    for (size_t i = 0; matches && i < keys.size(); i++) {
+        matches = sortedKeys[i] == keys[expected[i]];
+    }
+
+    return matches;
+}
+
+// Laid out like the keys of DrawQueue, with few pipelines and materials so most keys repeat
+std::vector<uint64_t> drawKeys(std::mt19937_64& random, size_t count) {
+    std::uniform_int_distribution<uint64_t> pass(0, 2);
+    std::uniform_int_distribution<uint64_t> pipeline(0, 5);
+    std::uniform_int_distribution<uint64_t> material(0, 20);
+    std::uniform_int_distribution<uint64_t> mesh(0, 8);
+    std::uniform_int_distribution<uint64_t> depth(0, 3);
+
+    std::vector<uint64_t> keys(count);
+    for (uint64_t& key : keys) {
+        key = (pass(random) << 60) | (pipeline(random) << 48) | (material(random) << 32) |
+              (mesh(random) << 16) | depth(random);
+    }
+
+    return keys;
+}
+
+void testStability() {
+    std::mt19937_64 random(3);
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> valueScratch;
+
+    CHECK(sortsLikeStableSort(drawKeys(random, 50000), keyScratch, valueScratch));
+
+    // Only a handful of distinct keys in the low byte, each pass but the first is skipped
+    std::vector<uint64_t> lowKeys(10000);
+    for (uint64_t& key : lowKeys) {
+        key = random() % 7;
+    }
+    CHECK(sortsLikeStableSort(lowKeys, keyScratch, valueScratch));
+
+    // Differing only in the top byte, the one pass that runs is the last
+    std::vector<uint64_t> highKeys(10000);
+    for (uint64_t& key : highKeys) {
+        key = ((random() % 5) << 56) | 0x00123456789abcdeull;
+    }
+    CHECK(sortsLikeStableSort(highKeys, keyScratch, valueScratch));
+
+    // Every byte differs, with the scratch vectors left larger by the calls above
+    std::vector<uint64_t> randomKeys(1000);
+    for (uint64_t& key : randomKeys) {
+        key = random();
+    }
+    CHECK(sortsLikeStableSort(randomKeys, keyScratch, valueScratch));
+}
+
+void testEdgeCases() {
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> valueScratch;
+
+    CHECK(sortsLikeStableSort({}, keyScratch, valueScratch));
+    CHECK(sortsLikeStableSort({ 42 }, keyScratch, valueScratch));
+    // All equal, nothing moves
+    CHECK(sortsLikeStableSort(std::vector<uint64_t>(300, 0xfedcba9876543210ull), keyScratch,
+                              valueScratch));
+    CHECK(sortsLikeStableSort({ ~0ull, 0, ~0ull, 1, 0 }, keyScratch, valueScratch));
+}
+
+int main() {
+    testStability();
+    testEdgeCases();
+
+    return checkResult("SortingTest");
+}
@@ -0,0 +1,151 @@
+#include "../src/pch.hpp"
+
+#include "../src/renderer/Helper/SphericalHarmonics.hpp"
+
+#include "Check.hpp"
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr int IMAGE_WIDTH  = 512;
+constexpr int IMAGE_HEIGHT = 256;
+
+// Directions spread evenly over the sphere for the brute force integrals, each standing for the
+// same solid angle
+constexpr uint32_t SAMPLE_COUNT = 1 << 18;
+
+// The real SH basis written out again, so the projection isn't checked against itself
+std::array<double, 9> referenceBasis(glm::dvec3 direction) {
+    double x = direction.x;
+    double y = direction.y;
+    double z = direction.z;
+
+    return { 0.5 * std::sqrt(1.0 / PI),
+             std::sqrt(3.0 / (4.0 * PI)) * y,
+             std::sqrt(3.0 / (4.0 * PI)) * z,
+             std::sqrt(3.0 / (4.0 * PI)) * x,
+             0.5 * std::sqrt(15.0 / PI) * x * y,
+             0.5 * std::sqrt(15.0 / PI) * y * z,
+             0.25 * std::sqrt(5.0 / PI) * (3.0 * z * z - 1.0),
+             0.5 * std::sqrt(15.0 / PI) * x * z,
+             0.25 * std::sqrt(15.0 / PI) * (x * x - y * y) };
+}
+
+// The sample'th point of a Fibonacci lattice, from +Y down to -Y
+glm::dvec3 sampleDirection(uint32_t sample) {
+    double y         = 1.0 - (sample + 0.5) * 2.0 / SAMPLE_COUNT;
+    double radius    = std::sqrt(1.0 - y * y);
+    double longitude = PI * (3.0 - std::sqrt(5.0)) * sample;
+
+    return { std::cos(longitude) * radius, y, std::sin(longitude) * radius };
+}
+
+// A sun, a sky gradient and a different mix in every channel
+glm::dvec3 skyRadiance(glm::dvec3 direction) {
+    glm::dvec3 sunDirection = glm::normalize(glm::dvec3(0.3, 0.8, 0.5));
+    double sun              = std::pow(std::max(glm::dot(direction, sunDirection), 0.0), 16.0);
+    double sky              = 0.5 + 0.5 * direction.y;
+
+    return { 0.2 + 4.0 * sun + sky, 0.3 + 3.0 * sun + 0.5 * sky,
+             0.5 + 1.5 * sky + 0.25 * direction.x };
+}
+
+// Only bands 0 to 2, so SH holds it exactly
+glm::dvec3 bandLimitedRadiance(glm::dvec3 direction) {
+    double value = 1.0 + 0.5 * direction.y + 0.75 * direction.x * direction.z;
+
+    return { value, 2.0 * value, 0.5 * value };
+}
+
+// Samples radiance at every texel center, with directions mapped the way equiToCube.comp does
+template <typename Radiance> std::vector<float> equirectangularImage(Radiance radiance) {
+    std::vector<float> image(size_t(IMAGE_WIDTH) * IMAGE_HEIGHT * 4);
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+        double latitude = (0.5 - (y + 0.5) / IMAGE_HEIGHT) * PI;
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            double longitude = ((x + 0.5) / IMAGE_WIDTH - 0.5) * 2.0 * PI;
+            glm::dvec3 direction(std::cos(latitude) * std::cos(longitude), std::sin(latitude),
+                                 std::cos(latitude) * std::sin(longitude));
+
+            glm::dvec3 value = radiance(direction);
+            float* texel     = &image[(size_t(y) * IMAGE_WIDTH + x) * 4];
+            texel[0]         = (float)value.x;
+            texel[1]         = (float)value.y;
+            texel[2]         = (float)value.z;
+            texel[3]         = 1.0f;
+        }
+    }
+
+    return image;
+}
+
+// Integral of radiance times every basis function over the sphere
+template <typename Radiance> std::array<glm::dvec3, 9> bruteForceSH(Radiance radiance) {
+    std::array<glm::dvec3, 9> coefficients = {};
+    for (uint32_t sample = 0; sample < SAMPLE_COUNT; sample++) {
+        glm::dvec3 direction        = sampleDirection(sample);
+        glm::dvec3 value            = radiance(direction);
+        std::array<double, 9> basis = referenceBasis(direction);
+        for (int i = 0; i < 9; i++) {
+            coefficients[i] += value * (basis[i] * 4.0 * PI / SAMPLE_COUNT);
+        }
+    }
+
+    return coefficients;
+}
+
+void testProjection() {
+    std::vector<float> image = equirectangularImage(skyRadiance);
+    SphericalHarmonics projected =
+        helper::projectEquirectangularToSH(image.data(), IMAGE_WIDTH, IMAGE_HEIGHT);
+    std::array<glm::dvec3, 9> reference = bruteForceSH(skyRadiance);
+
+    // Against the largest coefficient, the DC one
+    for (int i = 0; i < 9; i++) {
+        for (int c = 0; c < 3; c++) {
+            CHECK_NEAR(projected.coefficients[i][c], reference[i][c], 2e-3 * reference[0][c]);
+        }
+        CHECK(projected.coefficients[i].w == 0.0f);
+    }
+}
+
+void testBandLimitedReconstruction() {
+    std::vector<float> image = equirectangularImage(bandLimitedRadiance);
+    SphericalHarmonics projected =
+        helper::projectEquirectangularToSH(image.data(), IMAGE_WIDTH, IMAGE_HEIGHT);
+
+    // Evaluating gives the radiance back
+    for (uint32_t sample = 0; sample < SAMPLE_COUNT; sample += SAMPLE_COUNT / 64) {
+        glm::dvec3 direction = sampleDirection(sample);
+        glm::vec3 evaluated  = helper::evaluateSH(projected, glm::vec3(direction));
+        glm::dvec3 expected  = bandLimitedRadiance(direction);
+        for (int c = 0; c < 3; c++) {
+            CHECK_NEAR(evaluated[c], expected[c], 2e-3 * expected[c]);
+        }
+    }
+
+    // The cosine weighted integral over the hemisphere around the normal, divided by pi
+    SphericalHarmonics irradiance = helper::irradianceSHFromRadiance(projected);
+    for (uint32_t normalSample = 0; normalSample < SAMPLE_COUNT;
+         normalSample += SAMPLE_COUNT / 16) {
+        glm::dvec3 normal = sampleDirection(normalSample);
+
+        glm::dvec3 expected(0.0);
+        for (uint32_t sample = 0; sample < SAMPLE_COUNT; sample++) {
+            glm::dvec3 direction = sampleDirection(sample);
+            double cosine        = std::max(glm::dot(direction, normal), 0.0);
+            expected += bandLimitedRadiance(direction) * (cosine * 4.0 / SAMPLE_COUNT);
+        }
+
+        glm::vec3 evaluated = helper::evaluateSH(irradiance, glm::vec3(normal));
+        for (int c = 0; c < 3; c++) {
+            CHECK_NEAR(evaluated[c], expected[c], 2e-3 * expected[c]);
+        }
+    }
+}
+
+int main() {
+    testProjection();
+    testBandLimitedReconstruction();
+
+    return checkResult("SphericalHarmonicsTest");
+}
@@ -0,0 +1,270 @@
+#include "../src/pch.hpp"
+
+#include "../src/Assets/TextureResidency.hpp"
+
+#include "Check.hpp"
+
+#include <numeric>
+
+constexpr uint64_t MB = 1024 * 1024;
+
+// What the device local heaps report as left, the configured budgets are always lower
+constexpr uint64_t AVAILABLE_BYTES = 1ull << 40;
+
+// Updates a replaced image stays alive for, as the descriptor sets of the frames in flight drop it
+constexpr uint32_t RELEASE_DELAY = 3;
+
+// BC7 mips of a square texture, 16 bytes a 4x4 block
+std::vector<uint64_t> blockCompressedMipSizes(uint32_t size) {
+    std::vector<uint64_t> mipSizes;
+    for (uint32_t mipSize = size;; mipSize /= 2) {
+        uint64_t blocks = std::max((mipSize + 3) / 4, 1u);
+        mipSizes.push_back(blocks * blocks * 16);
+        if (mipSize == 1) {
+            break;
+        }
+    }
+
+    return mipSizes;
+}
+
+// Plays the streamer and the device. An image takes its memory once its upload starts, uploads
+// finish on the next update and replaced images are freed RELEASE_DELAY updates after that.
+// Images that would go past capacity fail to be created
+struct SimulatedDevice {
+    struct Upload {
+        uint32_t texture;
+        uint64_t bytes;
+    };
+
+    struct RetiredImage {
+        uint32_t texture;
+        uint64_t bytes;
+        uint32_t freedUpdate;
+    };
+
+    SimulatedDevice(uint64_t budgetBytes, uint64_t capacity)
+        : residency(budgetBytes), capacity(capacity) {}
+
+    uint32_t add(uint32_t size) {
+        textureMipSizes.push_back(blockCompressedMipSizes(size));
+        imageBytes.push_back(0);
+        return residency.add(size, size, textureMipSizes.back());
+    }
+
+    uint64_t bytesFrom(uint32_t texture, uint32_t mip) {
+        const std::vector<uint64_t>& mipSizes = textureMipSizes[texture];
+        return std::accumulate(mipSizes.begin() + mip, mipSizes.end(), (uint64_t)0);
+    }
+
+    // Like TextureStreamer::update, returns the uploads started
+    uint32_t update() {
+        for (const Upload& upload : uploads) {
+            if (imageBytes[upload.texture] > 0) {
+                retired.push_back(
+                    { upload.texture, imageBytes[upload.texture], updateIndex + RELEASE_DELAY });
+            }
+            imageBytes[upload.texture] = upload.bytes;
+            residency.uploaded(upload.texture);
+        }
+        uploads.clear();
+
+        for (auto image = retired.begin(); image != retired.end();) {
+            if (image->freedUpdate <= updateIndex) {
+                usedBytes -= image->bytes;
+                residency.released(image->texture);
+                image = retired.erase(image);
+            } else {
+                image++;
+            }
+        }
+
+        uint32_t started = 0;
+        for (const ResidencyChange& change : residency.update(AVAILABLE_BYTES)) {
+            uint64_t bytes = bytesFrom(change.texture, change.residentMip);
+            if (usedBytes + bytes > capacity) {
+                residency.uploadFailed(change.texture);
+                continue;
+            }
+
+            usedBytes += bytes;
+            peakBytes = std::max(peakBytes, usedBytes);
+            uploads.push_back({ change.texture, bytes });
+            started++;
+        }
+        updateIndex++;
+
+        // Every image alive is counted
+        TextureStreamStats stats = residency.getStats();
+        CHECK(stats.residentBytes + stats.uploadingBytes + stats.retiredBytes == usedBytes);
+
+        return started;
+    }
+
+    TextureResidency residency;
+    uint64_t capacity;
+
+    std::vector<std::vector<uint64_t>> textureMipSizes;
+    // Of the image in each asset, zero for the placeholder
+    std::vector<uint64_t> imageBytes;
+    std::vector<Upload> uploads;
+    std::vector<RetiredImage> retired;
+
+    uint64_t usedBytes   = 0;
+    uint64_t peakBytes   = 0;
+    uint32_t updateIndex = 0;
+};
+
+void testSmallBudget() {
+    // A full 1024x1024 texture takes 1.33 MB, two of them never fit
+    const uint64_t budget = 2 * MB;
+    SimulatedDevice device(budget, AVAILABLE_BYTES);
+    for (uint32_t texture = 0; texture < 3; texture++) {
+        device.add(1024);
+    }
+
+    // The tails go in first, the mips of at most 64 texels
+    device.update();
+    CHECK(device.residency.getResidentMip(0) == 11);
+    device.update();
+    CHECK(device.residency.getResidentMip(0) == 4);
+
+    // Every texture wants everything, no one is used less recently so none is evicted
+    for (uint32_t frame = 0; frame < 60; frame++) {
+        for (uint32_t texture = 0; texture < 3; texture++) {
+            device.residency.requestTexels(texture, 1024.0f);
+        }
+        device.update();
+        CHECK(device.usedBytes <= budget);
+    }
+    CHECK(device.residency.getStats().deferredCount > 0);
+    CHECK(device.residency.getStats().evictionCount == 0);
+
+    // Only the last one is used from now on, the others make room for its full size mip
+    for (uint32_t frame = 0; frame < 60; frame++) {
+        device.residency.requestTexels(2, 1024.0f);
+        device.update();
+        CHECK(device.usedBytes <= budget);
+    }
+    CHECK(device.residency.getResidentMip(2) == 0);
+    CHECK(device.residency.getStats().evictionCount > 0);
+    CHECK(device.peakBytes <= budget);
+
+    // Nothing in flight once it settled
+    TextureStreamStats stats = device.residency.getStats();
+    CHECK(stats.uploadingBytes == 0 && stats.retiredBytes == 0);
+    CHECK(stats.residentBytes == device.usedBytes);
+}
+
+void testRetiredImagesThrottle() {
+    SimulatedDevice device(16 * MB, AVAILABLE_BYTES);
+    device.add(1024);
+    device.update();
+    device.update();
+
+    // The tail was swapped in for the placeholder, nothing to free
+    CHECK(!device.residency.isRetiring(0));
+
+    device.residency.requestTexels(0, 1024.0f);
+    CHECK(device.update() == 1);
+    CHECK(device.residency.getResidentMip(0) == 4);
+
+    // Swapped in, the old tail is alive until the sets drop it and the texture waits for that
+    device.residency.requestTexels(0, 1024.0f);
+    CHECK(device.update() == 0);
+    CHECK(device.residency.getResidentMip(0) == 3);
+    CHECK(device.residency.isRetiring(0));
+    CHECK(device.residency.getStats().retiredBytes == device.bytesFrom(0, 4));
+
+    uint32_t waited = 0;
+    while (device.residency.isRetiring(0)) {
+        device.residency.requestTexels(0, 1024.0f);
+        device.update();
+        waited++;
+    }
+    CHECK(waited == RELEASE_DELAY);
+}
+
+void testShrinkingBudget() {
+    SimulatedDevice device(8 * MB, AVAILABLE_BYTES);
+    for (uint32_t texture = 0; texture < 4; texture++) {
+        device.add(1024);
+    }
+    for (uint32_t frame = 0; frame < 80; frame++) {
+        for (uint32_t texture = 0; texture < 4; texture++) {
+            device.residency.requestTexels(texture, 1024.0f);
+        }
+        device.update();
+    }
+    for (uint32_t texture = 0; texture < 4; texture++) {
+        CHECK(device.residency.getResidentMip(texture) == 0);
+    }
+
+    // Over the new budget evictions are started one at a time, memory only goes up by the image
+    // of one of them
+    const uint64_t budget = 1 * MB;
+    device.residency.setBudget(budget);
+    uint64_t before      = device.usedBytes;
+    uint64_t largestRise = 0;
+    device.peakBytes     = before;
+    for (uint32_t frame = 0; frame < 200; frame++) {
+        uint64_t used = device.usedBytes;
+        CHECK(device.update() <= 1);
+        if (device.usedBytes > used) {
+            largestRise = std::max(largestRise, device.usedBytes - used);
+        }
+    }
+    CHECK(device.peakBytes <= before + device.bytesFrom(0, 1));
+    CHECK(largestRise <= device.bytesFrom(0, 1));
+    CHECK(device.usedBytes <= budget);
+}
+
+void testFailedUploads() {
+    // The budget allows the full size mip but the device refuses anything past the tail's mip
+    SimulatedDevice device(16 * MB, 0);
+    uint32_t texture = device.add(1024);
+    device.capacity  = device.bytesFrom(texture, 4);
+
+    device.update();
+    device.update();
+    CHECK(device.residency.getResidentMip(texture) == 4);
+
+    for (uint32_t frame = 0; frame < 10; frame++) {
+        device.residency.requestTexels(texture, 1024.0f);
+        device.update();
+    }
+
+    // Asked for again every update, the texture keeps its tail
+    TextureStreamStats stats = device.residency.getStats();
+    CHECK(device.residency.getResidentMip(texture) == 4);
+    CHECK(stats.failedCount == 10);
+    CHECK(stats.uploadingBytes == 0);
+    CHECK(stats.residentBytes == device.bytesFrom(texture, 4));
+
+    // Once there's room the upload goes through
+    device.capacity = AVAILABLE_BYTES;
+    device.residency.requestTexels(texture, 1024.0f);
+    device.update();
+    device.update();
+    CHECK(device.residency.getResidentMip(texture) == 3);
+
+    // A tail that can't be created is tried again regardless of the budget
+    SimulatedDevice full(16 * MB, 0);
+    full.add(1024);
+    full.update();
+    full.update();
+    CHECK(full.residency.getResidentMip(0) == 11);
+    full.capacity = AVAILABLE_BYTES;
+    full.update();
+    full.update();
+    CHECK(full.residency.getResidentMip(0) == 4);
+}
+
+int main() {
+    testSmallBudget();
+    testRetiredImagesThrottle();
+    testShrinkingBudget();
+    testFailedUploads();
+
+    return checkResult("TextureResidencyTest");
+}